@@ -0,0 +1,29 @@
+#include <lockpick/bits.h>
+
+
+inline uint8_t lp_bittestandreset(uint32_t *bitmap, uint32_t bit_offset)
+{
+    uint32_t *word = bitmap+(bit_offset >> 5);
+    uint32_t mask = (uint32_t)1 << (bit_offset & 31);
+    uint8_t result = (*word & mask) != 0;
+    *word &= ~mask;
+
+    return result;
+}
+
+
+inline uint8_t lp_bittestandset(uint32_t *bitmap, uint32_t bit_offset)
+{
+    uint32_t *word = bitmap+(bit_offset >> 5);
+    uint32_t mask = (uint32_t)1 << (bit_offset & 31);
+    uint8_t result = (*word & mask) != 0;
+    *word |= mask;
+
+    return result;
+}
+
+
+uint8_t lp_bittest(const uint32_t *bitmap, uint32_t bit_offset)
+{
+    return (bitmap[bit_offset >> 5] >> (bit_offset & 31)) & 1;
+}
@@ -0,0 +1,60 @@
+#include <lockpick/graph/inference/host/infer.h>
+#include <lockpick/affirmf.h>
+
+
+/**
+ * lpg_inference_host_isa_supported - checks if instruction set can be used by host inference engine
+ * @isa:        instruction set to check
+ *
+ * Portable build provides no wide kernels, so only LPG_INFERENCE_HOST_ISA_AUTO and
+ * LPG_INFERENCE_HOST_ISA_SCALAR are supported.
+ *
+ * Return: True if @isa can be passed to host inference engine
+*/
+bool lpg_inference_host_isa_supported(lpg_inference_host_isa_t isa)
+{
+    switch(isa)
+    {
+        case LPG_INFERENCE_HOST_ISA_AUTO:
+        case LPG_INFERENCE_HOST_ISA_SCALAR:
+            return true;
+
+        case LPG_INFERENCE_HOST_ISA_AVX2:
+        case LPG_INFERENCE_HOST_ISA_AVX512:
+            return false;
+
+        default:
+            errorf("Unknown instruction set: %d",(uint32_t)isa);
+    }
+}
+
+
+/**
+ * __lpg_inference_host_batch_kernel - selects bit-sliced kernel for given instruction set
+ * @isa:        requested instruction set
+ * @narrow:     whether the kernel evaluates 'lpg_node_packed_narrow' array
+ *
+ * Return: Pointer to the portable scalar kernel
+*/
+__lpg_inference_host_batch_kernel_t __lpg_inference_host_batch_kernel(lpg_inference_host_isa_t isa, bool narrow)
+{
+    affirmf(lpg_inference_host_isa_supported(isa),
+        "Instruction set %d is not supported by the running CPU",(uint32_t)isa);
+
+    return narrow ? __lpg_inference_graph_infer_host_batch_nodes_scalar_narrow : __lpg_inference_graph_infer_host_batch_nodes_scalar;
+}
+
+
+/**
+ * __lpg_inference_host_soa_kernel - selects structure-of-arrays kernel for given instruction set
+ * @isa:        requested instruction set
+ *
+ * Return: Pointer to the portable scalar kernel
+*/
+__lpg_inference_host_soa_kernel_t __lpg_inference_host_soa_kernel(lpg_inference_host_isa_t isa)
+{
+    affirmf(lpg_inference_host_isa_supported(isa),
+        "Instruction set %d is not supported by the running CPU",(uint32_t)isa);
+
+    return __lpg_inference_graph_infer_host_soa_groups_scalar;
+}
@@ -0,0 +1,19 @@
+#include <lockpick/sync/bits.h>
+
+
+inline uint8_t lp_atomic_bittestandreset(uint32_t *bitmap, uint32_t bit_offset)
+{
+    uint32_t mask = (uint32_t)1 << (bit_offset & 31);
+    uint32_t prev = __atomic_fetch_and(bitmap+(bit_offset >> 5),~mask,__ATOMIC_SEQ_CST);
+
+    return (prev & mask) != 0;
+}
+
+
+inline uint8_t lp_atomic_bittestandset(uint32_t *bitmap, uint32_t bit_offset)
+{
+    uint32_t mask = (uint32_t)1 << (bit_offset & 31);
+    uint32_t prev = __atomic_fetch_or(bitmap+(bit_offset >> 5),mask,__ATOMIC_SEQ_CST);
+
+    return (prev & mask) != 0;
+}
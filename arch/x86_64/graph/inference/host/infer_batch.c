@@ -0,0 +1,689 @@
+#include <lockpick/graph/inference/host/infer.h>
+#include <lockpick/graph/inference/soa.h>
+#include <lockpick/affirmf.h>
+#include <immintrin.h>
+#include <string.h>
+
+
+/*
+    Generates kernel applying binary operation to bit-sliced values of two operands.
+    Words which do not fill the whole vector register are processed with scalar operation.
+*/
+#define __LPG_INFERENCE_HOST_BINARY_OP(name,isa,vec_t,vec_words,vec_load,vec_store,vec_op,scalar_op)   \
+static inline __attribute__((target(isa)))                                                              \
+void name(uint64_t *dest, const uint64_t *a, const uint64_t *b, size_t words_num)                       \
+{                                                                                                       \
+    size_t word_i = 0;                                                                                  \
+    for(; word_i+(vec_words) <= words_num; word_i += (vec_words))                                       \
+    {                                                                                                   \
+        vec_t a_vec = vec_load((const vec_t*)(a+word_i));                                               \
+        vec_t b_vec = vec_load((const vec_t*)(b+word_i));                                               \
+        vec_store((vec_t*)(dest+word_i),vec_op(a_vec,b_vec));                                           \
+    }                                                                                                   \
+    for(; word_i < words_num; ++word_i)                                                                 \
+        dest[word_i] = scalar_op(a[word_i],b[word_i]);                                                  \
+}
+
+
+/*
+    Generates kernel applying ternary operation to bit-sliced values of three operands.
+*/
+#define __LPG_INFERENCE_HOST_TERNARY_OP(name,isa,vec_t,vec_words,vec_load,vec_store,vec_op,scalar_op)  \
+static inline __attribute__((target(isa)))                                                              \
+void name(uint64_t *dest, const uint64_t *a, const uint64_t *b, const uint64_t *c, size_t words_num)    \
+{                                                                                                       \
+    size_t word_i = 0;                                                                                  \
+    for(; word_i+(vec_words) <= words_num; word_i += (vec_words))                                       \
+    {                                                                                                   \
+        vec_t a_vec = vec_load((const vec_t*)(a+word_i));                                               \
+        vec_t b_vec = vec_load((const vec_t*)(b+word_i));                                               \
+        vec_t c_vec = vec_load((const vec_t*)(c+word_i));                                               \
+        vec_store((vec_t*)(dest+word_i),vec_op(a_vec,b_vec,c_vec));                                     \
+    }                                                                                                   \
+    for(; word_i < words_num; ++word_i)                                                                 \
+        dest[word_i] = scalar_op(a[word_i],b[word_i],c[word_i]);                                        \
+}
+
+
+/*
+    Fused gates have no dedicated AVX2 instruction, so the negation is applied with XOR against all ones.
+*/
+static inline __attribute__((target("avx2")))
+__m256i __lpg_inference_host_avx2_nand_vec(__m256i a, __m256i b)
+{
+    return _mm256_xor_si256(_mm256_and_si256(a,b),_mm256_set1_epi64x(-1));
+}
+
+
+static inline __attribute__((target("avx2")))
+__m256i __lpg_inference_host_avx2_nor_vec(__m256i a, __m256i b)
+{
+    return _mm256_xor_si256(_mm256_or_si256(a,b),_mm256_set1_epi64x(-1));
+}
+
+
+static inline __attribute__((target("avx2")))
+__m256i __lpg_inference_host_avx2_xnor_vec(__m256i a, __m256i b)
+{
+    return _mm256_xor_si256(_mm256_xor_si256(a,b),_mm256_set1_epi64x(-1));
+}
+
+
+static inline __attribute__((target("avx2")))
+__m256i __lpg_inference_host_avx2_andnot_vec(__m256i a, __m256i b)
+{
+    // Intrinsic negates its first operand
+    return _mm256_andnot_si256(b,a);
+}
+
+
+static inline __attribute__((target("avx2")))
+__m256i __lpg_inference_host_avx2_ornot_vec(__m256i a, __m256i b)
+{
+    return _mm256_or_si256(a,_mm256_xor_si256(b,_mm256_set1_epi64x(-1)));
+}
+
+
+static inline __attribute__((target("avx2")))
+__m256i __lpg_inference_host_avx2_xor3_vec(__m256i a, __m256i b, __m256i c)
+{
+    return _mm256_xor_si256(_mm256_xor_si256(a,b),c);
+}
+
+
+static inline __attribute__((target("avx2")))
+__m256i __lpg_inference_host_avx2_maj_vec(__m256i a, __m256i b, __m256i c)
+{
+    return _mm256_or_si256(_mm256_and_si256(a,b),_mm256_and_si256(c,_mm256_or_si256(a,b)));
+}
+
+
+static inline __attribute__((target("avx2")))
+__m256i __lpg_inference_host_avx2_mux_vec(__m256i a, __m256i b, __m256i c)
+{
+    return _mm256_xor_si256(a,_mm256_and_si256(_mm256_xor_si256(a,b),c));
+}
+
+
+/*
+    Every fused gate is a single ternary logic instruction. Operands are passed as (a,b,b), so only
+    bits 0, 3, 4 and 7 of the truth table matter, the remaining ones repeat them.
+*/
+static inline __attribute__((target("avx512f")))
+__m512i __lpg_inference_host_avx512_nand_vec(__m512i a, __m512i b)
+{
+    return _mm512_ternarylogic_epi64(a,b,b,0x3F);
+}
+
+
+static inline __attribute__((target("avx512f")))
+__m512i __lpg_inference_host_avx512_nor_vec(__m512i a, __m512i b)
+{
+    return _mm512_ternarylogic_epi64(a,b,b,0x03);
+}
+
+
+static inline __attribute__((target("avx512f")))
+__m512i __lpg_inference_host_avx512_xnor_vec(__m512i a, __m512i b)
+{
+    return _mm512_ternarylogic_epi64(a,b,b,0xC3);
+}
+
+
+static inline __attribute__((target("avx512f")))
+__m512i __lpg_inference_host_avx512_andnot_vec(__m512i a, __m512i b)
+{
+    return _mm512_ternarylogic_epi64(a,b,b,0x30);
+}
+
+
+static inline __attribute__((target("avx512f")))
+__m512i __lpg_inference_host_avx512_ornot_vec(__m512i a, __m512i b)
+{
+    return _mm512_ternarylogic_epi64(a,b,b,0xF3);
+}
+
+
+/*
+    Ternary gates map onto the full truth table, bit '(a<<2)|(b<<1)|c' holds the result for operand bits a, b and c.
+*/
+static inline __attribute__((target("avx512f")))
+__m512i __lpg_inference_host_avx512_xor3_vec(__m512i a, __m512i b, __m512i c)
+{
+    return _mm512_ternarylogic_epi64(a,b,c,0x96);
+}
+
+
+static inline __attribute__((target("avx512f")))
+__m512i __lpg_inference_host_avx512_maj_vec(__m512i a, __m512i b, __m512i c)
+{
+    return _mm512_ternarylogic_epi64(a,b,c,0xE8);
+}
+
+
+static inline __attribute__((target("avx512f")))
+__m512i __lpg_inference_host_avx512_mux_vec(__m512i a, __m512i b, __m512i c)
+{
+    return _mm512_ternarylogic_epi64(a,b,c,0xD8);
+}
+
+
+#define __LPG_INFERENCE_HOST_AVX2_BINARY_OP(name,op,vec_op)   \
+    __LPG_INFERENCE_HOST_BINARY_OP(__lpg_inference_host_avx2_##name,"avx2",__m256i,4,_mm256_loadu_si256,_mm256_storeu_si256,vec_op,__LPG_INFERENCE_HOST_OP_##op)
+
+#define __LPG_INFERENCE_HOST_AVX512_BINARY_OP(name,op,vec_op)   \
+    __LPG_INFERENCE_HOST_BINARY_OP(__lpg_inference_host_avx512_##name,"avx512f",__m512i,8,_mm512_loadu_si512,_mm512_storeu_si512,vec_op,__LPG_INFERENCE_HOST_OP_##op)
+
+#define __LPG_INFERENCE_HOST_AVX2_TERNARY_OP(name,op,vec_op)   \
+    __LPG_INFERENCE_HOST_TERNARY_OP(__lpg_inference_host_avx2_##name,"avx2",__m256i,4,_mm256_loadu_si256,_mm256_storeu_si256,vec_op,__LPG_INFERENCE_HOST_OP_##op)
+
+#define __LPG_INFERENCE_HOST_AVX512_TERNARY_OP(name,op,vec_op)   \
+    __LPG_INFERENCE_HOST_TERNARY_OP(__lpg_inference_host_avx512_##name,"avx512f",__m512i,8,_mm512_loadu_si512,_mm512_storeu_si512,vec_op,__LPG_INFERENCE_HOST_OP_##op)
+
+
+__LPG_INFERENCE_HOST_AVX2_BINARY_OP(and,AND,_mm256_and_si256)
+__LPG_INFERENCE_HOST_AVX2_BINARY_OP(or,OR,_mm256_or_si256)
+__LPG_INFERENCE_HOST_AVX2_BINARY_OP(xor,XOR,_mm256_xor_si256)
+__LPG_INFERENCE_HOST_AVX2_BINARY_OP(nand,NAND,__lpg_inference_host_avx2_nand_vec)
+__LPG_INFERENCE_HOST_AVX2_BINARY_OP(nor,NOR,__lpg_inference_host_avx2_nor_vec)
+__LPG_INFERENCE_HOST_AVX2_BINARY_OP(xnor,XNOR,__lpg_inference_host_avx2_xnor_vec)
+__LPG_INFERENCE_HOST_AVX2_BINARY_OP(andnot,ANDNOT,__lpg_inference_host_avx2_andnot_vec)
+__LPG_INFERENCE_HOST_AVX2_BINARY_OP(ornot,ORNOT,__lpg_inference_host_avx2_ornot_vec)
+__LPG_INFERENCE_HOST_AVX2_TERNARY_OP(xor3,XOR3,__lpg_inference_host_avx2_xor3_vec)
+__LPG_INFERENCE_HOST_AVX2_TERNARY_OP(maj,MAJ,__lpg_inference_host_avx2_maj_vec)
+__LPG_INFERENCE_HOST_AVX2_TERNARY_OP(mux,MUX,__lpg_inference_host_avx2_mux_vec)
+
+__LPG_INFERENCE_HOST_AVX512_BINARY_OP(and,AND,_mm512_and_si512)
+__LPG_INFERENCE_HOST_AVX512_BINARY_OP(or,OR,_mm512_or_si512)
+__LPG_INFERENCE_HOST_AVX512_BINARY_OP(xor,XOR,_mm512_xor_si512)
+__LPG_INFERENCE_HOST_AVX512_BINARY_OP(nand,NAND,__lpg_inference_host_avx512_nand_vec)
+__LPG_INFERENCE_HOST_AVX512_BINARY_OP(nor,NOR,__lpg_inference_host_avx512_nor_vec)
+__LPG_INFERENCE_HOST_AVX512_BINARY_OP(xnor,XNOR,__lpg_inference_host_avx512_xnor_vec)
+__LPG_INFERENCE_HOST_AVX512_BINARY_OP(andnot,ANDNOT,__lpg_inference_host_avx512_andnot_vec)
+__LPG_INFERENCE_HOST_AVX512_BINARY_OP(ornot,ORNOT,__lpg_inference_host_avx512_ornot_vec)
+__LPG_INFERENCE_HOST_AVX512_TERNARY_OP(xor3,XOR3,__lpg_inference_host_avx512_xor3_vec)
+__LPG_INFERENCE_HOST_AVX512_TERNARY_OP(maj,MAJ,__lpg_inference_host_avx512_maj_vec)
+__LPG_INFERENCE_HOST_AVX512_TERNARY_OP(mux,MUX,__lpg_inference_host_avx512_mux_vec)
+
+
+static inline __attribute__((target("avx2")))
+void __lpg_inference_host_avx2_not(uint64_t *dest, const uint64_t *a, size_t words_num)
+{
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    size_t word_i = 0;
+    for(; word_i+4 <= words_num; word_i += 4)
+    {
+        __m256i a_vec = _mm256_loadu_si256((const __m256i*)(a+word_i));
+        _mm256_storeu_si256((__m256i*)(dest+word_i),_mm256_xor_si256(a_vec,ones));
+    }
+    for(; word_i < words_num; ++word_i)
+        dest[word_i] = ~a[word_i];
+}
+
+
+static inline __attribute__((target("avx512f")))
+void __lpg_inference_host_avx512_not(uint64_t *dest, const uint64_t *a, size_t words_num)
+{
+    size_t word_i = 0;
+    for(; word_i+8 <= words_num; word_i += 8)
+    {
+        __m512i a_vec = _mm512_loadu_si512((const __m512i*)(a+word_i));
+        // Truth table 0x55 selects negation of the third operand
+        _mm512_storeu_si512((__m512i*)(dest+word_i),_mm512_ternarylogic_epi64(a_vec,a_vec,a_vec,0x55));
+    }
+    for(; word_i < words_num; ++word_i)
+        dest[word_i] = ~a[word_i];
+}
+
+
+/*
+    Dispatches binary packed node to the kernel of its operation.
+*/
+#define __LPG_INFERENCE_HOST_BATCH_BINARY_CASE(type,op)                                              \
+            case LPG_NODE_PACKED_TYPE_##type:                                                       \
+                op(dest,                                                                            \
+                    values+node_slots[(lpg_inference_graph_uindex_t)node->parents[0]]*words_num,    \
+                    values+node_slots[(lpg_inference_graph_uindex_t)node->parents[1]]*words_num,    \
+                    words_num);                                                                     \
+                break;
+
+
+/*
+    Dispatches ternary packed node to the kernel of its operation.
+*/
+#define __LPG_INFERENCE_HOST_BATCH_TERNARY_CASE(type,op)                                             \
+            case LPG_NODE_PACKED_TYPE_##type:                                                       \
+                op(dest,                                                                            \
+                    values+node_slots[(lpg_inference_graph_uindex_t)node->parents[0]]*words_num,    \
+                    values+node_slots[(lpg_inference_graph_uindex_t)node->parents[1]]*words_num,    \
+                    values+node_slots[(lpg_inference_graph_uindex_t)node->parents[2]]*words_num,    \
+                    words_num);                                                                     \
+                break;
+
+
+/*
+    Generates kernel evaluating range of packed nodes of the given layout with the set of operations named
+    with the given prefix.
+*/
+#define __LPG_INFERENCE_HOST_BATCH_NODES(name,isa,ops,packed_t,load)                                \
+__attribute__((target(isa)))                                                                        \
+void name(const void *sorted_nodes,                                                                 \
+            const lpg_inference_graph_uindex_t *node_slots,                                         \
+            size_t nodes_begin, size_t nodes_end, uint64_t *values, size_t words_num)               \
+{                                                                                                   \
+    const packed_t *packed_nodes = (const packed_t*)sorted_nodes;                                   \
+    for(size_t node_i = nodes_begin; node_i < nodes_end; ++node_i)                                  \
+    {                                                                                               \
+        lpg_node_packed_t node_value = load(packed_nodes[node_i]);                                  \
+        const lpg_node_packed_t *node = &node_value;                                                \
+        uint64_t *dest = values+node_slots[node_i]*words_num;                                       \
+        cl_char type = lpg_node_packed_type(node);                                                  \
+        switch(type)                                                                                \
+        {                                                                                           \
+            __LPG_INFERENCE_HOST_BATCH_BINARY_CASE(AND,ops##_and)                                   \
+            __LPG_INFERENCE_HOST_BATCH_BINARY_CASE(OR,ops##_or)                                     \
+            case LPG_NODE_PACKED_TYPE_NOT:                                                          \
+                ops##_not(dest,                                                                     \
+                    values+node_slots[(lpg_inference_graph_uindex_t)node->parents[0]]*words_num,    \
+                    words_num);                                                                     \
+                break;                                                                              \
+            __LPG_INFERENCE_HOST_BATCH_BINARY_CASE(XOR,ops##_xor)                                   \
+            case LPG_NODE_PACKED_TYPE_TRUE:                                                         \
+                memset(dest,0xff,words_num*sizeof(uint64_t));                                       \
+                break;                                                                              \
+            case LPG_NODE_PACKED_TYPE_FALSE:                                                        \
+                memset(dest,0,words_num*sizeof(uint64_t));                                          \
+                break;                                                                              \
+            __LPG_INFERENCE_HOST_BATCH_BINARY_CASE(NAND,ops##_nand)                                 \
+            __LPG_INFERENCE_HOST_BATCH_BINARY_CASE(NOR,ops##_nor)                                   \
+            __LPG_INFERENCE_HOST_BATCH_BINARY_CASE(XNOR,ops##_xnor)                                 \
+            __LPG_INFERENCE_HOST_BATCH_BINARY_CASE(ANDNOT,ops##_andnot)                             \
+            __LPG_INFERENCE_HOST_BATCH_BINARY_CASE(ORNOT,ops##_ornot)                               \
+            __LPG_INFERENCE_HOST_BATCH_TERNARY_CASE(XOR3,ops##_xor3)                                \
+            __LPG_INFERENCE_HOST_BATCH_TERNARY_CASE(MAJ,ops##_maj)                                  \
+            __LPG_INFERENCE_HOST_BATCH_TERNARY_CASE(MUX,ops##_mux)                                  \
+            default:                                                                                \
+                errorf("Unknown type: %d",(uint32_t)type);                                          \
+        }                                                                                           \
+    }                                                                                               \
+}
+
+
+__LPG_INFERENCE_HOST_BATCH_NODES(__lpg_inference_graph_infer_host_batch_nodes_avx2,"avx2",__lpg_inference_host_avx2,
+    lpg_node_packed_t,__LPG_INFERENCE_HOST_LOAD_WIDE)
+__LPG_INFERENCE_HOST_BATCH_NODES(__lpg_inference_graph_infer_host_batch_nodes_avx2_narrow,"avx2",__lpg_inference_host_avx2,
+    lpg_node_packed_narrow_t,__LPG_INFERENCE_HOST_LOAD_NARROW)
+
+__LPG_INFERENCE_HOST_BATCH_NODES(__lpg_inference_graph_infer_host_batch_nodes_avx512,"avx512f",__lpg_inference_host_avx512,
+    lpg_node_packed_t,__LPG_INFERENCE_HOST_LOAD_WIDE)
+__LPG_INFERENCE_HOST_BATCH_NODES(__lpg_inference_graph_infer_host_batch_nodes_avx512_narrow,"avx512f",__lpg_inference_host_avx512,
+    lpg_node_packed_narrow_t,__LPG_INFERENCE_HOST_LOAD_NARROW)
+
+
+/*
+    Evaluates all binary gates of a group with the given operation.
+*/
+#define __LPG_INFERENCE_HOST_SOA_BINARY_CASE(type,op)                                                       \
+            case LPG_NODE_PACKED_TYPE_##type:                                                               \
+                for(size_t gate_i = gates_begin; gate_i < gates_end; ++gate_i)                              \
+                    op(values+soa->dests[gate_i]*words_num,values+soa->parents_a[gate_i]*words_num,         \
+                        values+soa->parents_b[gate_i]*words_num,words_num);                                 \
+                break;
+
+
+/*
+    Evaluates all ternary gates of a group with the given operation.
+*/
+#define __LPG_INFERENCE_HOST_SOA_TERNARY_CASE(type,op)                                                      \
+            case LPG_NODE_PACKED_TYPE_##type:                                                               \
+                for(size_t gate_i = gates_begin; gate_i < gates_end; ++gate_i)                              \
+                    op(values+soa->dests[gate_i]*words_num,values+soa->parents_a[gate_i]*words_num,         \
+                        values+soa->parents_b[gate_i]*words_num,values+soa->parents_c[gate_i]*words_num,    \
+                        words_num);                                                                         \
+                break;
+
+
+/*
+    Generates kernel evaluating groups of structure-of-arrays layout with the set of operations named with the given prefix.
+    Operations are dispatched once per group, gates of a group are evaluated without branches.
+*/
+#define __LPG_INFERENCE_HOST_SOA_GROUPS(name,isa,ops)                                                       \
+__attribute__((target(isa)))                                                                                \
+void name(const lpg_inference_soa_t *soa, uint64_t *values, size_t words_num)                               \
+{                                                                                                           \
+    for(size_t group_i = 0; group_i < soa->groups_num; ++group_i)                                           \
+    {                                                                                                       \
+        size_t gates_begin = soa->group_offsets[group_i];                                                   \
+        size_t gates_end = soa->group_offsets[group_i+1];                                                   \
+        cl_char type = soa->group_types[group_i];                                                           \
+        switch(type)                                                                                        \
+        {                                                                                                   \
+            __LPG_INFERENCE_HOST_SOA_BINARY_CASE(AND,ops##_and)                                             \
+            __LPG_INFERENCE_HOST_SOA_BINARY_CASE(OR,ops##_or)                                               \
+            case LPG_NODE_PACKED_TYPE_NOT:                                                                  \
+                for(size_t gate_i = gates_begin; gate_i < gates_end; ++gate_i)                              \
+                    ops##_not(values+soa->dests[gate_i]*words_num,values+soa->parents_a[gate_i]*words_num,  \
+                        words_num);                                                                         \
+                break;                                                                                      \
+            __LPG_INFERENCE_HOST_SOA_BINARY_CASE(XOR,ops##_xor)                                             \
+            case LPG_NODE_PACKED_TYPE_TRUE:                                                                 \
+                for(size_t gate_i = gates_begin; gate_i < gates_end; ++gate_i)                              \
+                    memset(values+soa->dests[gate_i]*words_num,0xff,words_num*sizeof(uint64_t));            \
+                break;                                                                                      \
+            case LPG_NODE_PACKED_TYPE_FALSE:                                                                \
+                for(size_t gate_i = gates_begin; gate_i < gates_end; ++gate_i)                              \
+                    memset(values+soa->dests[gate_i]*words_num,0,words_num*sizeof(uint64_t));               \
+                break;                                                                                      \
+            __LPG_INFERENCE_HOST_SOA_BINARY_CASE(NAND,ops##_nand)                                           \
+            __LPG_INFERENCE_HOST_SOA_BINARY_CASE(NOR,ops##_nor)                                             \
+            __LPG_INFERENCE_HOST_SOA_BINARY_CASE(XNOR,ops##_xnor)                                           \
+            __LPG_INFERENCE_HOST_SOA_BINARY_CASE(ANDNOT,ops##_andnot)                                       \
+            __LPG_INFERENCE_HOST_SOA_BINARY_CASE(ORNOT,ops##_ornot)                                         \
+            __LPG_INFERENCE_HOST_SOA_TERNARY_CASE(XOR3,ops##_xor3)                                          \
+            __LPG_INFERENCE_HOST_SOA_TERNARY_CASE(MAJ,ops##_maj)                                            \
+            __LPG_INFERENCE_HOST_SOA_TERNARY_CASE(MUX,ops##_mux)                                            \
+            default:                                                                                        \
+                errorf("Unknown type: %d",(uint32_t)type);                                                  \
+        }                                                                                                   \
+    }                                                                                                       \
+}
+
+
+__LPG_INFERENCE_HOST_SOA_GROUPS(__lpg_inference_graph_infer_host_soa_groups_avx2,"avx2",__lpg_inference_host_avx2)
+
+static __LPG_INFERENCE_HOST_SOA_GROUPS(__lpg_inference_host_avx512_soa_groups_words,"avx512f",__lpg_inference_host_avx512)
+
+
+/*
+    Loads eight consecutive value slots as 32-bit gather indices.
+*/
+static inline __attribute__((target("avx512f")))
+__m256i __lpg_inference_host_avx512_load_slots(const lpg_inference_graph_uindex_t *slots)
+{
+    return _mm256_loadu_si256((const __m256i*)slots);
+}
+
+
+/*
+    Generates loop evaluating binary gates of a group with single word per node, eight gates at a time.
+    Gates of a group do not depend on each other, so all operands of eight gates can be gathered before
+    any result is scattered.
+*/
+#define __LPG_INFERENCE_HOST_AVX512_SOA_GATHER_BINARY(name,vec_op,scalar_op)                                \
+static inline __attribute__((target("avx512f")))                                                            \
+void name(const lpg_inference_soa_t *soa, size_t gates_begin, size_t gates_end, uint64_t *values)           \
+{                                                                                                           \
+    size_t gate_i = gates_begin;                                                                            \
+    for(; gate_i+8 <= gates_end; gate_i += 8)                                                               \
+    {                                                                                                       \
+        __m512i a_vec = _mm512_i32gather_epi64(__lpg_inference_host_avx512_load_slots(soa->parents_a+gate_i),values,8);   \
+        __m512i b_vec = _mm512_i32gather_epi64(__lpg_inference_host_avx512_load_slots(soa->parents_b+gate_i),values,8);   \
+        _mm512_i32scatter_epi64(values,__lpg_inference_host_avx512_load_slots(soa->dests+gate_i),vec_op(a_vec,b_vec),8);  \
+    }                                                                                                       \
+    for(; gate_i < gates_end; ++gate_i)                                                                     \
+        values[soa->dests[gate_i]] = scalar_op(values[soa->parents_a[gate_i]],values[soa->parents_b[gate_i]]);  \
+}
+
+
+/*
+    Generates loop evaluating ternary gates of a group with single word per node, eight gates at a time.
+*/
+#define __LPG_INFERENCE_HOST_AVX512_SOA_GATHER_TERNARY(name,vec_op,scalar_op)                               \
+static inline __attribute__((target("avx512f")))                                                            \
+void name(const lpg_inference_soa_t *soa, size_t gates_begin, size_t gates_end, uint64_t *values)           \
+{                                                                                                           \
+    size_t gate_i = gates_begin;                                                                            \
+    for(; gate_i+8 <= gates_end; gate_i += 8)                                                               \
+    {                                                                                                       \
+        __m512i a_vec = _mm512_i32gather_epi64(__lpg_inference_host_avx512_load_slots(soa->parents_a+gate_i),values,8);   \
+        __m512i b_vec = _mm512_i32gather_epi64(__lpg_inference_host_avx512_load_slots(soa->parents_b+gate_i),values,8);   \
+        __m512i c_vec = _mm512_i32gather_epi64(__lpg_inference_host_avx512_load_slots(soa->parents_c+gate_i),values,8);   \
+        _mm512_i32scatter_epi64(values,__lpg_inference_host_avx512_load_slots(soa->dests+gate_i),vec_op(a_vec,b_vec,c_vec),8);  \
+    }                                                                                                       \
+    for(; gate_i < gates_end; ++gate_i)                                                                     \
+        values[soa->dests[gate_i]] = scalar_op(values[soa->parents_a[gate_i]],values[soa->parents_b[gate_i]],   \
+            values[soa->parents_c[gate_i]]);                                                                \
+}
+
+
+__LPG_INFERENCE_HOST_AVX512_SOA_GATHER_BINARY(__lpg_inference_host_avx512_soa_gather_and,_mm512_and_si512,__LPG_INFERENCE_HOST_OP_AND)
+__LPG_INFERENCE_HOST_AVX512_SOA_GATHER_BINARY(__lpg_inference_host_avx512_soa_gather_or,_mm512_or_si512,__LPG_INFERENCE_HOST_OP_OR)
+__LPG_INFERENCE_HOST_AVX512_SOA_GATHER_BINARY(__lpg_inference_host_avx512_soa_gather_xor,_mm512_xor_si512,__LPG_INFERENCE_HOST_OP_XOR)
+__LPG_INFERENCE_HOST_AVX512_SOA_GATHER_BINARY(__lpg_inference_host_avx512_soa_gather_nand,__lpg_inference_host_avx512_nand_vec,__LPG_INFERENCE_HOST_OP_NAND)
+__LPG_INFERENCE_HOST_AVX512_SOA_GATHER_BINARY(__lpg_inference_host_avx512_soa_gather_nor,__lpg_inference_host_avx512_nor_vec,__LPG_INFERENCE_HOST_OP_NOR)
+__LPG_INFERENCE_HOST_AVX512_SOA_GATHER_BINARY(__lpg_inference_host_avx512_soa_gather_xnor,__lpg_inference_host_avx512_xnor_vec,__LPG_INFERENCE_HOST_OP_XNOR)
+__LPG_INFERENCE_HOST_AVX512_SOA_GATHER_BINARY(__lpg_inference_host_avx512_soa_gather_andnot,__lpg_inference_host_avx512_andnot_vec,__LPG_INFERENCE_HOST_OP_ANDNOT)
+__LPG_INFERENCE_HOST_AVX512_SOA_GATHER_BINARY(__lpg_inference_host_avx512_soa_gather_ornot,__lpg_inference_host_avx512_ornot_vec,__LPG_INFERENCE_HOST_OP_ORNOT)
+__LPG_INFERENCE_HOST_AVX512_SOA_GATHER_TERNARY(__lpg_inference_host_avx512_soa_gather_xor3,__lpg_inference_host_avx512_xor3_vec,__LPG_INFERENCE_HOST_OP_XOR3)
+__LPG_INFERENCE_HOST_AVX512_SOA_GATHER_TERNARY(__lpg_inference_host_avx512_soa_gather_maj,__lpg_inference_host_avx512_maj_vec,__LPG_INFERENCE_HOST_OP_MAJ)
+__LPG_INFERENCE_HOST_AVX512_SOA_GATHER_TERNARY(__lpg_inference_host_avx512_soa_gather_mux,__lpg_inference_host_avx512_mux_vec,__LPG_INFERENCE_HOST_OP_MUX)
+
+
+static inline __attribute__((target("avx512f")))
+void __lpg_inference_host_avx512_soa_gather_not(const lpg_inference_soa_t *soa, size_t gates_begin, size_t gates_end, uint64_t *values)
+{
+    size_t gate_i = gates_begin;
+    for(; gate_i+8 <= gates_end; gate_i += 8)
+    {
+        __m512i a_vec = _mm512_i32gather_epi64(__lpg_inference_host_avx512_load_slots(soa->parents_a+gate_i),values,8);
+        // Truth table 0x55 selects negation of the third operand
+        _mm512_i32scatter_epi64(values,__lpg_inference_host_avx512_load_slots(soa->dests+gate_i),_mm512_ternarylogic_epi64(a_vec,a_vec,a_vec,0x55),8);
+    }
+    for(; gate_i < gates_end; ++gate_i)
+        values[soa->dests[gate_i]] = ~values[soa->parents_a[gate_i]];
+}
+
+
+/**
+ * __lpg_inference_graph_infer_host_soa_groups_avx512 - AVX-512 kernel for grouped gates
+ * @soa:            pointer to structure-of-arrays object
+ * @values:         bit-sliced values of all slots with values of input nodes already in place
+ * @words_num:      number of bit-sliced words per node
+ *
+ * With several words per node every gate is evaluated with vector operations over its words. With a single
+ * word per node a gate occupies only a lane of the register, so eight gates of a group are evaluated at once
+ * with operands gathered by their slots and results scattered into slots of gates.
+ *
+ * Return: None
+*/
+__attribute__((target("avx512f")))
+void __lpg_inference_graph_infer_host_soa_groups_avx512(const lpg_inference_soa_t *soa, uint64_t *values, size_t words_num)
+{
+    if(words_num > 1)
+    {
+        __lpg_inference_host_avx512_soa_groups_words(soa,values,words_num);
+        return;
+    }
+
+    for(size_t group_i = 0; group_i < soa->groups_num; ++group_i)
+    {
+        size_t gates_begin = soa->group_offsets[group_i];
+        size_t gates_end = soa->group_offsets[group_i+1];
+
+        cl_char type = soa->group_types[group_i];
+        switch(type)
+        {
+            case LPG_NODE_PACKED_TYPE_AND:
+                __lpg_inference_host_avx512_soa_gather_and(soa,gates_begin,gates_end,values);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_OR:
+                __lpg_inference_host_avx512_soa_gather_or(soa,gates_begin,gates_end,values);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NOT:
+                __lpg_inference_host_avx512_soa_gather_not(soa,gates_begin,gates_end,values);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XOR:
+                __lpg_inference_host_avx512_soa_gather_xor(soa,gates_begin,gates_end,values);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_TRUE:
+                for(size_t gate_i = gates_begin; gate_i < gates_end; ++gate_i)
+                    values[soa->dests[gate_i]] = ~(uint64_t)0;
+                break;
+
+            case LPG_NODE_PACKED_TYPE_FALSE:
+                for(size_t gate_i = gates_begin; gate_i < gates_end; ++gate_i)
+                    values[soa->dests[gate_i]] = 0;
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NAND:
+                __lpg_inference_host_avx512_soa_gather_nand(soa,gates_begin,gates_end,values);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NOR:
+                __lpg_inference_host_avx512_soa_gather_nor(soa,gates_begin,gates_end,values);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XNOR:
+                __lpg_inference_host_avx512_soa_gather_xnor(soa,gates_begin,gates_end,values);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_ANDNOT:
+                __lpg_inference_host_avx512_soa_gather_andnot(soa,gates_begin,gates_end,values);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_ORNOT:
+                __lpg_inference_host_avx512_soa_gather_ornot(soa,gates_begin,gates_end,values);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XOR3:
+                __lpg_inference_host_avx512_soa_gather_xor3(soa,gates_begin,gates_end,values);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_MAJ:
+                __lpg_inference_host_avx512_soa_gather_maj(soa,gates_begin,gates_end,values);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_MUX:
+                __lpg_inference_host_avx512_soa_gather_mux(soa,gates_begin,gates_end,values);
+                break;
+
+            default:
+                errorf("Unknown type: %d",(uint32_t)type);
+        }
+    }
+}
+
+
+/**
+ * lpg_inference_host_isa_supported - checks if instruction set can be used by host inference engine
+ * @isa:        instruction set to check
+ *
+ * LPG_INFERENCE_HOST_ISA_AUTO and LPG_INFERENCE_HOST_ISA_SCALAR are supported everywhere,
+ * while wide instruction sets are probed on the running CPU.
+ *
+ * Return: True if @isa can be passed to host inference engine
+*/
+bool lpg_inference_host_isa_supported(lpg_inference_host_isa_t isa)
+{
+    switch(isa)
+    {
+        case LPG_INFERENCE_HOST_ISA_AUTO:
+        case LPG_INFERENCE_HOST_ISA_SCALAR:
+            return true;
+
+        case LPG_INFERENCE_HOST_ISA_AVX2:
+            return __builtin_cpu_supports("avx2");
+
+        case LPG_INFERENCE_HOST_ISA_AVX512:
+            return __builtin_cpu_supports("avx512f");
+
+        default:
+            errorf("Unknown instruction set: %d",(uint32_t)isa);
+    }
+}
+
+
+/**
+ * __lpg_inference_host_batch_kernel - selects bit-sliced kernel for given instruction set
+ * @isa:        requested instruction set
+ * @narrow:     whether the kernel evaluates 'lpg_node_packed_narrow' array
+ *
+ * For LPG_INFERENCE_HOST_ISA_AUTO the widest instruction set supported by the running CPU is selected
+ * once and reused on subsequent calls. Explicitly requested @isa must be supported by the CPU.
+ *
+ * Return: Pointer to the kernel function
+*/
+__lpg_inference_host_batch_kernel_t __lpg_inference_host_batch_kernel(lpg_inference_host_isa_t isa, bool narrow)
+{
+    static lpg_inference_host_isa_t auto_isa = LPG_INFERENCE_HOST_ISA_AUTO;
+
+    affirmf(lpg_inference_host_isa_supported(isa),
+        "Instruction set %d is not supported by the running CPU",(uint32_t)isa);
+
+    if(isa == LPG_INFERENCE_HOST_ISA_AUTO)
+    {
+        if(auto_isa == LPG_INFERENCE_HOST_ISA_AUTO)
+        {
+            if(lpg_inference_host_isa_supported(LPG_INFERENCE_HOST_ISA_AVX512))
+                auto_isa = LPG_INFERENCE_HOST_ISA_AVX512;
+            else if(lpg_inference_host_isa_supported(LPG_INFERENCE_HOST_ISA_AVX2))
+                auto_isa = LPG_INFERENCE_HOST_ISA_AVX2;
+            else
+                auto_isa = LPG_INFERENCE_HOST_ISA_SCALAR;
+        }
+        isa = auto_isa;
+    }
+
+    switch(isa)
+    {
+        case LPG_INFERENCE_HOST_ISA_SCALAR:
+            return narrow ? __lpg_inference_graph_infer_host_batch_nodes_scalar_narrow : __lpg_inference_graph_infer_host_batch_nodes_scalar;
+
+        case LPG_INFERENCE_HOST_ISA_AVX2:
+            return narrow ? __lpg_inference_graph_infer_host_batch_nodes_avx2_narrow : __lpg_inference_graph_infer_host_batch_nodes_avx2;
+
+        case LPG_INFERENCE_HOST_ISA_AVX512:
+            return narrow ? __lpg_inference_graph_infer_host_batch_nodes_avx512_narrow : __lpg_inference_graph_infer_host_batch_nodes_avx512;
+
+        default:
+            errorf("Unknown instruction set: %d",(uint32_t)isa);
+    }
+}
+
+
+/**
+ * __lpg_inference_host_soa_kernel - selects structure-of-arrays kernel for given instruction set
+ * @isa:        requested instruction set
+ *
+ * Same as '__lpg_inference_host_batch_kernel', but for kernels evaluating 'lpg_inference_soa'.
+ *
+ * Return: Pointer to the kernel function
+*/
+__lpg_inference_host_soa_kernel_t __lpg_inference_host_soa_kernel(lpg_inference_host_isa_t isa)
+{
+    static __lpg_inference_host_soa_kernel_t auto_kernel = NULL;
+
+    affirmf(lpg_inference_host_isa_supported(isa),
+        "Instruction set %d is not supported by the running CPU",(uint32_t)isa);
+
+    switch(isa)
+    {
+        case LPG_INFERENCE_HOST_ISA_AUTO:
+            if(!auto_kernel)
+            {
+                if(lpg_inference_host_isa_supported(LPG_INFERENCE_HOST_ISA_AVX512))
+                    auto_kernel = __lpg_inference_graph_infer_host_soa_groups_avx512;
+                else if(lpg_inference_host_isa_supported(LPG_INFERENCE_HOST_ISA_AVX2))
+                    auto_kernel = __lpg_inference_graph_infer_host_soa_groups_avx2;
+                else
+                    auto_kernel = __lpg_inference_graph_infer_host_soa_groups_scalar;
+            }
+            return auto_kernel;
+
+        case LPG_INFERENCE_HOST_ISA_SCALAR:
+            return __lpg_inference_graph_infer_host_soa_groups_scalar;
+
+        case LPG_INFERENCE_HOST_ISA_AVX2:
+            return __lpg_inference_graph_infer_host_soa_groups_avx2;
+
+        case LPG_INFERENCE_HOST_ISA_AVX512:
+            return __lpg_inference_graph_infer_host_soa_groups_avx512;
+
+        default:
+            errorf("Unknown instruction set: %d",(uint32_t)isa);
+    }
+}
@@ -2,6 +2,7 @@
 #define _LOCKPICK_GRAPH_COUNT_H
 
 #include <lockpick/graph/graph.h>
+#include <lockpick/graph/frozen.h>
 
 
 size_t lpg_graph_nodes_count_super(lpg_graph_t *graph);
@@ -13,4 +14,7 @@ size_t lpg_graph_count_dangling_nodes(lpg_graph_t *graph);
 
 size_t lpg_graph_count_redundant_inputs(lpg_graph_t *graph);
 
+size_t lpg_frozen_graph_nodes_count(const lpg_frozen_graph_t *frozen);
+size_t lpg_frozen_graph_count_dangling_nodes(const lpg_frozen_graph_t *frozen);
+
 #endif // _LOCKPICK_GRAPH_COUNT_H
\ No newline at end of file
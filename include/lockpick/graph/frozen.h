@@ -0,0 +1,73 @@
+#ifndef _LOCKPICK_GRAPH_FROZEN_H
+#define _LOCKPICK_GRAPH_FROZEN_H
+
+#include <lockpick/graph/graph.h>
+#include <lockpick/bitset.h>
+#include <stdint.h>
+
+// Type of free slots, which hold no node
+#define LPG_FROZEN_SLOT_FREE ((uint8_t)0xff)
+#define LPG_FROZEN_NO_SLOT ((lpg_frozen_index_t)UINT32_MAX)
+#define LPG_FROZEN_MAX_SLOTS_NUM ((size_t)UINT32_MAX/2)
+
+typedef uint32_t lpg_frozen_index_t;
+
+
+/**
+ * lpg_frozen_graph - compact read-only representation of general-purpose graph
+ * @graph:              graph the frozen form was built from
+ * @slots_num:          number of slots, which equals capacity of the slab of @graph
+ * @types:              types of nodes indexed by slot, LPG_FROZEN_SLOT_FREE for free slots
+ * @values:             values of nodes indexed by slot as they were at the moment of freezing
+ * @parents_offsets:    indices within @parents where parents of each slot begin, followed by the total number of parents
+ * @parents:            slots of parents of all nodes in order of slots
+ * @children_offsets:   indices within @children where children of each slot begin, followed by the total number of children
+ * @children:           slots of children of all nodes in order of slots
+ * @inputs:             slots of input nodes in order of inputs of @graph
+ * @inputs_size:        number of input nodes
+ * @outputs:            slots of output nodes in order of outputs of @graph
+ * @outputs_size:       number of output nodes
+ * @is_input:           slots of input nodes
+ * @is_output:          slots of nodes serving at least one output
+ * @literals:           slots of literals of @graph indexed by their value or LPG_FROZEN_NO_SLOT if not allocated
+ *
+ * Nodes of 'lpg_graph_t' are linked with separately allocated arrays of parents and vectors of children, so every
+ * step of traversal loads a node, then its adjacency from another place of the heap. Frozen graph keeps adjacency
+ * in compressed sparse row form instead: parents of slot 'i' are '@parents[@parents_offsets[i]..@parents_offsets[i+1])'
+ * and similarly for children. Slots are indices of nodes within the slab of @graph, see 'lp_slab_index', so the node
+ * itself is always at hand, see 'lpg_frozen_graph_node', and flat arrays indexed by slot replace hash tables of
+ * visited nodes. Traversal, counting and topological sorting of the frozen form only stream through a few
+ * contiguous arrays.
+ *
+ * Frozen graph is a snapshot: it must be rebuilt with 'lpg_graph_freeze' once @graph is modified.
+*/
+typedef struct lpg_frozen_graph
+{
+    lpg_graph_t *graph;
+    size_t slots_num;
+    uint8_t *types;
+    lp_bitset_t *values;
+    lpg_frozen_index_t *parents_offsets;
+    lpg_frozen_index_t *parents;
+    lpg_frozen_index_t *children_offsets;
+    lpg_frozen_index_t *children;
+    lpg_frozen_index_t *inputs;
+    size_t inputs_size;
+    lpg_frozen_index_t *outputs;
+    size_t outputs_size;
+    lp_bitset_t *is_input;
+    lp_bitset_t *is_output;
+    lpg_frozen_index_t literals[2];
+} lpg_frozen_graph_t;
+
+
+lpg_frozen_graph_t *lpg_graph_freeze(lpg_graph_t *graph);
+void lpg_frozen_graph_release(lpg_frozen_graph_t *frozen);
+
+lpg_node_t *lpg_frozen_graph_node(const lpg_frozen_graph_t *frozen, lpg_frozen_index_t slot);
+lpg_frozen_index_t lpg_frozen_graph_slot(const lpg_frozen_graph_t *frozen, const lpg_node_t *node);
+
+size_t lpg_frozen_graph_get_parents_num(const lpg_frozen_graph_t *frozen, lpg_frozen_index_t slot);
+size_t lpg_frozen_graph_get_children_num(const lpg_frozen_graph_t *frozen, lpg_frozen_index_t slot);
+
+#endif // _LOCKPICK_GRAPH_FROZEN_H
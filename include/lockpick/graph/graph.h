@@ -7,6 +7,7 @@
 #include <stdbool.h>
 #include <lockpick/dlist.h>
 #include <lockpick/define.h>
+#include <lockpick/htable.h>
 #include <lockpick/slab/slab.h>
 #include <lockpick/vector.h>
 
@@ -23,14 +24,14 @@ typedef enum lpg_node_types
 } lpg_node_type_t;
 
 
-#define __LPG_NODE_PARENTS_MASK ((uintptr_t)(~0b1))
-#define __LPG_NODE_VALUE_MASK ((uintptr_t)(0b1))
+#define LPG_NODE_MAX_PARENTS_NUM 2
 
 
 /**
  * lpg_node - basic general-purpose node structure for computational graphs in lpg_graph
  * @type:               underlying type of node operation
- * @__parents_value:    array of operands (parents) and value
+ * @__value:            value of node
+ * @__parents:          operands (parents) of node, only first 'lpg_node_get_parents_num' are valid
  * @children:           array of dependend nodes (children)
  * 
  * This is a general-purpose node structure designed to be versatile for effective graph
@@ -44,19 +45,22 @@ typedef enum lpg_node_types
  * as an operand argument when creating another node automatically records the latter as
  * a dependent (child) of the former.
  * 
- * The @value field is unspecified until explicitly assigned by a graph operation, such as
+ * Node has at most two operands, so they are stored inline rather than in a separately allocated
+ * array. @__value fills padding after @type, so it costs no space either.
+ * 
+ * The @__value field is unspecified until explicitly assigned by a graph operation, such as
  * lpg_graph_compute, which computes the values of all nodes from inputs to outputs.
 */
 typedef struct lpg_node
 {
     lpg_node_type_t type;
-    uintptr_t __parents_value;
+    bool __value;
+    struct lpg_node *__parents[LPG_NODE_MAX_PARENTS_NUM];
     lp_vector_t *children;
-} __aligned(2) lpg_node_t;
+} lpg_node_t;
 
 
 lpg_node_t **lpg_node_parents(const lpg_node_t *node);
-void __lpg_node_set_parents(lpg_node_t *node, lpg_node_t **parents);
 
 bool lpg_node_value(const lpg_node_t *node);
 void __lpg_node_set_value(lpg_node_t *node, bool value);
@@ -68,6 +72,9 @@ lpg_node_t *lpg_node_or(lpg_graph_t *graph, lpg_node_t *a, lpg_node_t *b);
 lpg_node_t *lpg_node_not(lpg_graph_t *graph, lpg_node_t *a);
 lpg_node_t *lpg_node_xor(lpg_graph_t *graph, lpg_node_t *a, lpg_node_t *b);
 lpg_node_t *lpg_node_const(lpg_graph_t *graph, bool value);
+lpg_node_t *lpg_node_literal(lpg_graph_t *graph, bool value);
+bool __lpg_node_is_literal(const lpg_graph_t *graph, const lpg_node_t *node, bool value);
+lpg_node_t *__lpg_node_fold(lpg_graph_t *graph, lpg_node_type_t type, lpg_node_t *a, lpg_node_t *b);
 
 size_t lpg_node_get_parents_num(const lpg_node_t *node);
 size_t lpg_node_get_children_num(const lpg_node_t *node);
@@ -88,6 +95,8 @@ void __lpg_node_release_internals(lpg_node_t *node);
  * @outputs:        array of pointers to output nodes
  * @outputs_size:   number of output nodes
  * @max_node:       max nodes that graph may contain
+ * @__strash:       structural hash table of nodes or NULL if structural hashing is disabled
+ * @__literals:     literal constant nodes indexed by their value or NULL if not allocated yet
  * 
  * This structure serves the purpose of storing and manipulating computational graph information and structure
  * in a way that allows easy access, inspection, and modification.
@@ -114,6 +123,9 @@ void __lpg_node_release_internals(lpg_node_t *node);
  * rule. In the example above, input nodes are mapped to special uint objects that can be used to perform various
  * arithmetic operations, and the result can be stored in a result uint object whose buffer is mapped to a part of
  * the @outputs array.
+ * 
+ * Structural hashing is disabled by default, see 'lpg_graph_enable_strash'. Literal constants, which node
+ * constructors fold, are allocated on demand, see 'lpg_node_literal'.
 */
 struct lpg_graph
 {
@@ -124,6 +136,8 @@ struct lpg_graph
     lpg_node_t **outputs;
     size_t outputs_size;
     size_t max_nodes;
+    lp_htable_t *__strash;
+    lpg_node_t *__literals[2];
 };
 
 lp_slab_t *__lpg_graph_slab(const lpg_graph_t *graph);
@@ -139,6 +153,16 @@ void lpg_graph_release_node(lpg_graph_t *graph, lpg_node_t *node);
 
 bool __lpg_graph_is_native_node(const lpg_graph_t *graph, const lpg_node_t *node);
 
+void lpg_graph_enable_strash(lpg_graph_t *graph);
+bool lpg_graph_is_strash_enabled(const lpg_graph_t *graph);
+
+lpg_node_t *__lpg_graph_strash_find(lpg_graph_t *graph, lpg_node_type_t type, lpg_node_t *a, lpg_node_t *b);
+void __lpg_graph_strash_insert(lpg_graph_t *graph, lpg_node_t *node);
+void __lpg_graph_strash_remove(lpg_graph_t *graph, lpg_node_t *node);
+
+lp_htable_t *__lpg_graph_strash_table_create(size_t nodes_num);
+lpg_node_t *__lpg_graph_strash_table_insert(lp_htable_t *table, lpg_node_t *node);
+
 size_t __lpg_graph_nodes_hsh(const lpg_node_t **node);
 bool __lpg_graph_nodes_eq(const lpg_node_t **a, const lpg_node_t **b);
 
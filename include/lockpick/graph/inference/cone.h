@@ -0,0 +1,47 @@
+#ifndef _LOCKPICK_GRAPH_INFERENCE_CONE_H
+#define _LOCKPICK_GRAPH_INFERENCE_CONE_H
+
+#include <lockpick/graph/inference/inference_graph.h>
+#include <lockpick/bitset.h>
+#include <stdint.h>
+
+
+/**
+ * lpg_inference_cone - transitive fan-in cone of a subset of outputs of inference graph
+ * @outputs_mask:   outputs of the underlying graph, cone of which is represented
+ * @nodes_num:      number of nodes inside the cone
+ * @sorted_nodes:   topologically sorted array of packed nodes of the cone
+ * @narrow_nodes:   same as @sorted_nodes with 16-bit indices, NULL if the cone exceeds LPG_INFERENCE_GRAPH_NARROW_MAX_NODES_NUM
+ * @output_nodes:   index within @sorted_nodes of the node of each selected output, zero for the rest
+ * @slots_num:      number of value slots sufficient to evaluate @sorted_nodes sequentially
+ * @node_slots:     index of value slot assigned to each node within @sorted_nodes
+ *
+ * The cone is a compacted copy of the inference graph's sorted array holding only the nodes which
+ * the outputs selected by @outputs_mask depend on. Parents are reindexed within @sorted_nodes and @output_nodes
+ * refer to the selected outputs only, so any engine evaluating packed arrays can evaluate the cone in place
+ * of the whole graph.
+ *
+ * All input nodes are kept at the beginning of @sorted_nodes, even if some of them do not belong to the
+ * cone, so that the layout of input values remains the same as for the whole graph.
+ *
+ * Width of indices is selected per cone the same way as for inference graphs, so cones of a wide graph
+ * may still be evaluated from @narrow_nodes.
+*/
+struct lpg_inference_cone
+{
+    lp_bitset_t *outputs_mask;
+    size_t nodes_num;
+    lpg_node_packed_t *sorted_nodes;
+    lpg_node_packed_narrow_t *narrow_nodes;
+    lpg_inference_graph_uindex_t *output_nodes;
+    size_t slots_num;
+    lpg_inference_graph_uindex_t *node_slots;
+};
+
+
+lpg_inference_cone_t *__lpg_inference_cone_create(const lpg_inference_graph_t *inference_graph, const lp_bitset_t *outputs_mask);
+void __lpg_inference_cone_release(lpg_inference_cone_t *cone);
+
+lpg_inference_cone_t *lpg_inference_graph_cone(lpg_inference_graph_t *inference_graph, const lp_bitset_t *outputs_mask);
+
+#endif // _LOCKPICK_GRAPH_INFERENCE_CONE_H
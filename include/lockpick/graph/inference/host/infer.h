@@ -2,9 +2,104 @@
 #define _LOCKPICK_GRAPH_INFERENCE_HOST_INFER_H
 
 #include <lockpick/graph/inference/inference_graph.h>
+#include <lockpick/define.h>
 #include <lockpick/bitset.h>
+#include <stdint.h>
+
+// Number of independent input vectors packed into single bit-sliced word
+#define LPG_INFERENCE_HOST_BATCH_WORD_WIDTH lp_sizeof_bits(uint64_t)
+// Alignment of bit-sliced values buffers, enough for the widest vector registers
+#define LPG_INFERENCE_HOST_BATCH_ALIGNMENT 64
+
+/*
+    Word-wide operations of two- and three-operand gate types shared by bit-sliced kernels.
+*/
+#define __LPG_INFERENCE_HOST_OP_AND(a,b)        ((a) & (b))
+#define __LPG_INFERENCE_HOST_OP_OR(a,b)         ((a) | (b))
+#define __LPG_INFERENCE_HOST_OP_XOR(a,b)        ((a) ^ (b))
+#define __LPG_INFERENCE_HOST_OP_NAND(a,b)       (~((a) & (b)))
+#define __LPG_INFERENCE_HOST_OP_NOR(a,b)        (~((a) | (b)))
+#define __LPG_INFERENCE_HOST_OP_XNOR(a,b)       (~((a) ^ (b)))
+#define __LPG_INFERENCE_HOST_OP_ANDNOT(a,b)     ((a) & ~(b))
+#define __LPG_INFERENCE_HOST_OP_ORNOT(a,b)      ((a) | ~(b))
+#define __LPG_INFERENCE_HOST_OP_XOR3(a,b,c)     ((a) ^ (b) ^ (c))
+#define __LPG_INFERENCE_HOST_OP_MAJ(a,b,c)      (((a) & (b)) | ((c) & ((a) | (b))))
+#define __LPG_INFERENCE_HOST_OP_MUX(a,b,c)      ((a) ^ (((a) ^ (b)) & (c)))
+
+/*
+    Loads packed node of either layout as 'lpg_node_packed_t', so kernels are generated once per layout
+    from the same evaluation code, see 'lpg_node_packed_narrow'.
+*/
+#define __LPG_INFERENCE_HOST_LOAD_WIDE(node)    (node)
+#define __LPG_INFERENCE_HOST_LOAD_NARROW(node)  __LPG_NODE_PACKED_WIDEN(node)
+
+
+/*
+    Instruction set used to evaluate bit-sliced batches.
+    LPG_INFERENCE_HOST_ISA_AUTO selects the widest one supported by the running CPU.
+*/
+typedef enum lpg_inference_host_isa
+{
+    LPG_INFERENCE_HOST_ISA_AUTO,
+    LPG_INFERENCE_HOST_ISA_SCALAR,
+    LPG_INFERENCE_HOST_ISA_AVX2,
+    LPG_INFERENCE_HOST_ISA_AVX512
+} lpg_inference_host_isa_t;
+
+/**
+ * lpg_inference_host_context - reusable buffers for host inference
+ * @inference_graph:    pointer to inference graph object
+ * @values:             buffer for values of all nodes
+ * @output:             buffer for values of output nodes
+*/
+typedef struct lpg_inference_host_context
+{
+    lpg_inference_graph_t *inference_graph;
+    lp_bitset_t *values;
+    lp_bitset_t *output;
+} lpg_inference_host_context_t;
+
+typedef void (*__lpg_inference_host_soa_kernel_t)(const lpg_inference_soa_t *soa, uint64_t *values, size_t words_num);
+typedef void (*__lpg_inference_host_batch_kernel_t)(const void *sorted_nodes, const lpg_inference_graph_uindex_t *node_slots, size_t nodes_begin, size_t nodes_end, uint64_t *values, size_t words_num);
 
 
 lp_bitset_t *lpg_inference_graph_infer_host(lpg_inference_graph_t *inference_graph, const lp_bitset_t *input_values);
 
-#endif // _LOCKPICK_GRAPH_INFERENCE_HOST_INFER_H
\ No newline at end of file
+lpg_inference_host_context_t *lpg_inference_host_context_create(lpg_inference_graph_t *inference_graph);
+void lpg_inference_host_context_release(lpg_inference_host_context_t *context);
+
+const lp_bitset_t *lpg_inference_graph_infer_host_ctx(lpg_inference_host_context_t *context, const lp_bitset_t *input_values);
+void lpg_inference_graph_infer_host_into(lpg_inference_host_context_t *context, const lp_bitset_t *input_values, lp_bitset_t *output);
+
+uint64_t *lpg_inference_graph_infer_host_batch(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num);
+uint64_t *lpg_inference_graph_infer_host_batch_isa(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, lpg_inference_host_isa_t isa);
+uint64_t *lpg_inference_graph_infer_host_batch_masked(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, const lp_bitset_t *outputs_mask);
+
+uint64_t *lpg_inference_graph_infer_host_soa(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num);
+uint64_t *lpg_inference_graph_infer_host_soa_isa(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, lpg_inference_host_isa_t isa);
+
+uint64_t *lpg_inference_graph_infer_host_stream(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num);
+
+uint64_t *lpg_inference_graph_infer_host_batch_mt(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num);
+uint64_t *__lpg_inference_graph_infer_host_batch_mt(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, uint32_t threads_num);
+
+bool lpg_inference_host_isa_supported(lpg_inference_host_isa_t isa);
+
+__lpg_inference_host_batch_kernel_t __lpg_inference_host_batch_kernel(lpg_inference_host_isa_t isa, bool narrow);
+__lpg_inference_host_soa_kernel_t __lpg_inference_host_soa_kernel(lpg_inference_host_isa_t isa);
+
+void __lpg_inference_graph_infer_host_batch_nodes_scalar(const void *sorted_nodes, const lpg_inference_graph_uindex_t *node_slots, size_t nodes_begin, size_t nodes_end, uint64_t *values, size_t words_num);
+void __lpg_inference_graph_infer_host_batch_nodes_scalar_narrow(const void *sorted_nodes, const lpg_inference_graph_uindex_t *node_slots, size_t nodes_begin, size_t nodes_end, uint64_t *values, size_t words_num);
+void __lpg_inference_graph_infer_host_batch_nodes_avx2(const void *sorted_nodes, const lpg_inference_graph_uindex_t *node_slots, size_t nodes_begin, size_t nodes_end, uint64_t *values, size_t words_num);
+void __lpg_inference_graph_infer_host_batch_nodes_avx2_narrow(const void *sorted_nodes, const lpg_inference_graph_uindex_t *node_slots, size_t nodes_begin, size_t nodes_end, uint64_t *values, size_t words_num);
+void __lpg_inference_graph_infer_host_batch_nodes_avx512(const void *sorted_nodes, const lpg_inference_graph_uindex_t *node_slots, size_t nodes_begin, size_t nodes_end, uint64_t *values, size_t words_num);
+void __lpg_inference_graph_infer_host_batch_nodes_avx512_narrow(const void *sorted_nodes, const lpg_inference_graph_uindex_t *node_slots, size_t nodes_begin, size_t nodes_end, uint64_t *values, size_t words_num);
+
+void __lpg_inference_graph_infer_host_soa_groups_scalar(const lpg_inference_soa_t *soa, uint64_t *values, size_t words_num);
+void __lpg_inference_graph_infer_host_soa_groups_avx2(const lpg_inference_soa_t *soa, uint64_t *values, size_t words_num);
+void __lpg_inference_graph_infer_host_soa_groups_avx512(const lpg_inference_soa_t *soa, uint64_t *values, size_t words_num);
+
+uint64_t *__lpg_inference_host_batch_values_alloc(size_t nodes_num, size_t words_num);
+void __lpg_inference_graph_infer_host_batch_gather_outputs(const lpg_inference_graph_t *inference_graph, const lpg_inference_graph_uindex_t *node_slots, const lpg_inference_graph_uindex_t *output_nodes, const lp_bitset_t *outputs_mask, const uint64_t *values, size_t words_num, uint64_t *output);
+
+#endif // _LOCKPICK_GRAPH_INFERENCE_HOST_INFER_H
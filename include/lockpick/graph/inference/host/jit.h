@@ -0,0 +1,49 @@
+#ifndef _LOCKPICK_GRAPH_INFERENCE_HOST_JIT_H
+#define _LOCKPICK_GRAPH_INFERENCE_HOST_JIT_H
+
+#include <lockpick/graph/inference/inference_graph.h>
+#include <stdint.h>
+
+// Compiler used to build generated sources, can be overridden at build time
+#ifndef LPG_INFERENCE_JIT_CC
+#define LPG_INFERENCE_JIT_CC "cc"
+#endif
+
+#ifndef LPG_INFERENCE_JIT_CFLAGS
+#define LPG_INFERENCE_JIT_CFLAGS "-O2 -march=native -shared -fPIC -w"
+#endif
+
+#define LPG_INFERENCE_JIT_KERNEL_NAME "lpg_inference_jit_kernel"
+
+
+typedef void (*lpg_inference_jit_kernel_t)(const uint64_t *input_values, uint64_t *output, size_t words_num);
+
+/**
+ * lpg_inference_jit - natively compiled inference graph
+ * @handle:     handle of loaded shared object
+ * @kernel:     compiled straight-line evaluation function, NULL if compilation has failed
+ *
+ * The whole topologically sorted array is translated into a single C function, where every packed node
+ * turns into a single word-wide operation on a local variable. The function is built by the system compiler
+ * into a shared object, which is loaded in place. Generated code has neither type dispatch nor memory
+ * traffic for intermediate nodes, so the compiler is free to keep them in registers.
+ *
+ * The @kernel takes and produces bit-sliced values in the same layout as 'lpg_inference_graph_infer_host_batch'.
+ * Hosts without a working compiler get no @kernel, in which case JIT engines fall back to the interpreter.
+*/
+struct lpg_inference_jit
+{
+    void *handle;
+    lpg_inference_jit_kernel_t kernel;
+};
+
+
+lpg_inference_jit_t *__lpg_inference_jit_compile(const lpg_inference_graph_t *inference_graph);
+void __lpg_inference_jit_release(lpg_inference_jit_t *jit);
+
+lpg_inference_jit_t *lpg_inference_graph_jit(lpg_inference_graph_t *inference_graph);
+
+uint64_t *lpg_inference_graph_infer_host_jit(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num);
+void lpg_inference_graph_infer_host_jit_into(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, uint64_t *output);
+
+#endif // _LOCKPICK_GRAPH_INFERENCE_HOST_JIT_H
@@ -0,0 +1,50 @@
+#ifndef _LOCKPICK_GRAPH_INFERENCE_HOST_SESSION_H
+#define _LOCKPICK_GRAPH_INFERENCE_HOST_SESSION_H
+
+#include <lockpick/graph/inference/inference_graph.h>
+#include <lockpick/bitset.h>
+#include <stdint.h>
+
+
+/**
+ * lpg_inference_host_session - stateful incremental inference of inference graph
+ * @inference_graph:    pointer to inference graph object
+ * @values:             values of all nodes for the current input vector
+ * @output:             values of output nodes for the current input vector
+ * @scheduled:          nodes currently waiting for re-evaluation
+ * @queue:              min-heap of indices of scheduled nodes
+ * @queue_size:         number of nodes inside @queue
+ * @node_outputs_offsets: indices within @node_outputs where outputs of each node begin, followed by number of outputs
+ * @node_outputs:       indices of outputs grouped by nodes serving them
+ * 
+ * Session keeps the values of all nodes computed for the last input vector. When only a few inputs
+ * change, it re-evaluates nodes of their fan-out cone in topological order and stops propagation
+ * at nodes, values of which did not change.
+ * 
+ * Since children always follow their parents inside @sorted_nodes, popping scheduled nodes in
+ * ascending order of their indices guarantees that every node is re-evaluated only after all its
+ * parents are final. Every node is scheduled at most once, so @queue never exceeds the number of nodes.
+ * 
+ * Changed nodes update all outputs they serve, see '__lpg_inference_graph_build_node_outputs', so
+ * @output never requires a separate pass over all outputs.
+*/
+typedef struct lpg_inference_host_session
+{
+    lpg_inference_graph_t *inference_graph;
+    lp_bitset_t *values;
+    lp_bitset_t *output;
+    lp_bitset_t *scheduled;
+    lpg_inference_graph_uindex_t *queue;
+    size_t queue_size;
+    size_t *node_outputs_offsets;
+    size_t *node_outputs;
+} lpg_inference_host_session_t;
+
+
+lpg_inference_host_session_t *lpg_inference_host_session_create(lpg_inference_graph_t *inference_graph, const lp_bitset_t *input_values);
+void lpg_inference_host_session_release(lpg_inference_host_session_t *session);
+
+const lp_bitset_t *lpg_inference_host_session_update(lpg_inference_host_session_t *session, const size_t *changed_inputs, size_t changed_inputs_num);
+const lp_bitset_t *lpg_inference_host_session_output(const lpg_inference_host_session_t *session);
+
+#endif // _LOCKPICK_GRAPH_INFERENCE_HOST_SESSION_H
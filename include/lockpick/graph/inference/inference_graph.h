@@ -3,37 +3,69 @@
 
 #include <lockpick/graph/inference/packed_node.h>
 #include <lockpick/graph/graph.h>
-#include <lockpick/htable.h>
+#include <lockpick/vector.h>
 #include <lockpick/bitset.h>
 #include <CL/opencl.h>
 #include <stdbool.h>
 
 
-#define LPG_INFERENCE_GRAPH_MAX_NODES_NUM 65536
-#define LPG_INFERENCE_GRAPH_MAX_OUTPUTS_NUM 8191
-
 typedef struct lpg_inference_graph lpg_inference_graph_t;
+typedef struct lpg_inference_jit lpg_inference_jit_t;
+typedef struct lpg_inference_cone lpg_inference_cone_t;
+typedef struct lpg_inference_soa lpg_inference_soa_t;
+typedef struct lpg_inference_stream lpg_inference_stream_t;
+struct __lpg_tsort_levels;
+
+/*
+    Strategy of ordering nodes inside the topologically sorted array.
+    LPG_INFERENCE_ORDER_LEVELS groups nodes by levels, nodes within a level keep their DFS post-order from outputs.
+    LPG_INFERENCE_ORDER_LEVELS_LOCALITY additionally sorts every level by position of the latest parent of nodes.
+    LPG_INFERENCE_ORDER_DFS places nodes in DFS post-order from outputs, right after their operands.
+*/
+typedef enum lpg_inference_order
+{
+    LPG_INFERENCE_ORDER_LEVELS,
+    LPG_INFERENCE_ORDER_LEVELS_LOCALITY,
+    LPG_INFERENCE_ORDER_DFS
+} lpg_inference_order_t;
 
 cl_char lpg_node_packed_type(const lpg_node_packed_t *node);
 void __lpg_node_packed_set_type(lpg_node_packed_t *node, cl_char type);
 
-lpg_inference_graph_index_t lpg_node_packed_output(const lpg_node_packed_t *node);
-void __lpg_node_packed_set_output(lpg_node_packed_t *node, lpg_inference_graph_index_t output);
-
 uint16_t lpg_node_packed_get_parents_num(const lpg_node_packed_t *node);
 
 cl_char __lpg_node_packed_type_from_node(const lpg_node_t *node);
 
-lpg_node_packed_t __lpg_node_packed_from_node(lpg_inference_graph_t *inference_graph, lpg_node_t *node, lpg_inference_graph_index_t output_index);
-lpg_node_packed_t __lpg_node_packed_from_const_node(const lpg_node_t *node, lpg_inference_graph_index_t output_index);
-lpg_node_packed_t __lpg_node_packed_from_input_node(const lpg_node_t *node, lpg_inference_graph_index_t output_index);
+lpg_node_packed_t __lpg_node_packed_from_node(lpg_inference_graph_t *inference_graph, lpg_node_t *node);
+lpg_node_packed_t __lpg_node_packed_from_const_node(const lpg_node_t *node);
+lpg_node_packed_t __lpg_node_packed_from_input_node(const lpg_node_t *node);
+lpg_node_packed_narrow_t *__lpg_node_packed_narrow(const lpg_node_packed_t *sorted_nodes, size_t nodes_num);
 
 /**
  * lpg_inference_graph - interface graph structure bridging general and efficient graph representations
- * @graph:          pointer to general-purpose graph object
- * @index_map:      map between nodes and their indices within the topologically sorted array
- * @inv_index_map:  map between indices within the topologically sorted array and their corresponding node structures
+ * @graph:          pointer to general-purpose graph object, NULL for graphs loaded from file or derived by passes
+ * @id:             identifier of the graph, unique within the process, see '__lpg_inference_graph_next_id'
+ * @inputs_size:    number of input nodes of the graph
+ * @outputs_size:   number of output nodes of the graph
+ * @index_map:      indices of nodes within the topologically sorted array, addressed by slab slots of nodes
+ * @inv_index_map:  nodes corresponding to indices within the topologically sorted array, NULL unless requested
+ * @nodes_num:      number of nodes in the graph
  * @sorted_node:    topologically sorted array of packed nodes
+ * @narrow_nodes:   same as @sorted_nodes with 16-bit indices, NULL for graphs exceeding LPG_INFERENCE_GRAPH_NARROW_MAX_NODES_NUM
+ * @levels_num:     number of levels in @sorted_nodes
+ * @level_offsets:  indices within @sorted_nodes where each level begins, followed by @nodes_num
+ * @output_nodes:   index within @sorted_nodes of the node of each output, addressed by output index
+ * @children_offsets:   indices within @children where children of each node begin, followed by total number of edges
+ * @children:       indices of children of all nodes within @sorted_nodes, grouped by parent
+ * @slots_num:      number of value slots sufficient to evaluate @sorted_nodes sequentially
+ * @node_slots:     index of value slot assigned to each node within @sorted_nodes
+ * @identity_slots: identity map of value slots for engines, which keep value of every node, NULL until first requested
+ * @jit:            natively compiled version of the graph, NULL until first requested
+ * @cones:          cached fan-in cones of output subsets requested so far, NULL until first requested
+ * @soa:            structure-of-arrays version of the graph grouped by gate type, NULL until first requested
+ * @stream:         compressed stream of packed nodes, NULL until first requested
+ * @mapping:        read-only memory mapping of the file the graph was loaded from, NULL for created graphs
+ * @mapping_size:   size of @mapping in bytes
  * 
  * This structure serves as an interface between the optimized graph inference engine and the general-purpose
  * graph object.
@@ -48,45 +80,97 @@ lpg_node_packed_t __lpg_node_packed_from_input_node(const lpg_node_t *node, lpg_
  * @nodes_num. While populating the array, it saves the correspondence between nodes and their indices within
  * @sorted_nodes and, on demand, can build the inverse map @inv_index_map.
  * 
- * Due to memory efficiency concerns, this struct applies relatively strict constraints on the size of the @graph:
- * the number of nodes inside the graph cannot exceed LPG_INFERENCE_GRAPH_MAX_NODES_NUM; the number of output nodes
- * cannot exceed LPG_INFERENCE_GRAPH_MAX_OUTPUTS_NUM
+ * Since all nodes of the @graph are allocated within its slab, the slab slot of a node serves as a dense key:
+ * @index_map is a flat array of slab capacity size, so neither construction nor lookups hash node pointers.
+ * 
+ * Nodes inside @sorted_nodes are grouped by their levels. Input and constant nodes form the zero level and
+ * every other node belongs to the level right after the deepest level among its parents. Nodes of the same
+ * level do not depend on each other, so the level 'l' occupies the range [@level_offsets[l], @level_offsets[l+1])
+ * and can be evaluated in parallel once all previous levels are computed.
+ * 
+ * The order of nodes is selected on creation, see 'lpg_inference_order_t'. Orders, which interleave levels
+ * for the sake of locality, split @sorted_nodes into maximal runs of mutually independent consecutive nodes
+ * instead, which preserves the above property of @level_offsets.
+ * 
+ * Packed nodes do not store indices of outputs they serve: engines locate values of outputs through @output_nodes,
+ * so the order of outputs does not depend on the order of @sorted_nodes and the same node may serve several outputs.
+ * 
+ * Besides parents stored inside packed nodes, the structure keeps the adjacency of children in compressed form:
+ * children of the node 'i' are stored in @children within the range [@children_offsets[i], @children_offsets[i+1]).
+ * Engines use it to propagate changes of node values forward without scanning the whole @sorted_nodes array.
+ * 
+ * Sequential engines do not need to keep values of all nodes at once: a value is dead after its last child is
+ * evaluated. Thus, every node is assigned one of @slots_num value slots, which is reused by later nodes once the
+ * value stored inside becomes dead. Input nodes always occupy slots [0, inputs_size) in order. Slots of output
+ * nodes are never reused, so engines gather output values through @output_nodes after evaluating all nodes.
+ * 
+ * The number of nodes inside the graph cannot exceed LPG_INFERENCE_GRAPH_MAX_NODES_NUM. The number of outputs is not
+ * limited, since outputs are located through @output_nodes rather than stored inside packed nodes.
+ * 
+ * Width of indices inside packed nodes is selected per graph on creation. Passes building and transforming
+ * the graph work on @sorted_nodes with 32-bit indices. Graphs with at most LPG_INFERENCE_GRAPH_NARROW_MAX_NODES_NUM
+ * nodes also keep @narrow_nodes with 16-bit indices, which engines evaluate instead, see '__lpg_inference_graph_select_index'.
  * 
  * The engines are expected to compute the requested information only for the @graph's output nodes, provided with
  * the @sorted_nodes array.
+ * 
+ * Engines rely only on the fields derived from @graph, so the structure can be saved to file and loaded without
+ * the general-purpose graph, see 'lpg_inference_graph_load'. For loaded graphs @sorted_nodes, @level_offsets and
+ * @output_nodes point directly into the read-only @mapping, while @index_map and @inv_index_map are not available.
 */
 struct lpg_inference_graph
 {
     lpg_graph_t *graph;
-    lp_htable_t *index_map,*inv_index_map;
+    uint64_t id;
+    size_t inputs_size;
+    size_t outputs_size;
+    lpg_inference_graph_index_t *index_map;
+    lpg_node_t **inv_index_map;
     size_t nodes_num;
     lpg_node_packed_t *sorted_nodes;
+    lpg_node_packed_narrow_t *narrow_nodes;
+    size_t levels_num;
+    size_t *level_offsets;
+    lpg_inference_graph_uindex_t *output_nodes;
+    size_t *children_offsets;
+    lpg_inference_graph_index_t *children;
+    size_t slots_num;
+    lpg_inference_graph_uindex_t *node_slots;
+    lpg_inference_graph_uindex_t *identity_slots;
+    lpg_inference_jit_t *jit;
+    lp_vector_t *cones;
+    lpg_inference_soa_t *soa;
+    lpg_inference_stream_t *stream;
+    void *mapping;
+    size_t mapping_size;
 };
 
 lpg_inference_graph_t *lpg_inference_graph_create(lpg_graph_t *graph, bool gen_inverse_index);
+lpg_inference_graph_t *lpg_inference_graph_create_mt(lpg_graph_t *graph, bool gen_inverse_index, lpg_inference_order_t order);
+lpg_inference_graph_t *lpg_inference_graph_create_ordered(lpg_graph_t *graph, bool gen_inverse_index, lpg_inference_order_t order);
+lpg_inference_graph_t *lpg_inference_graph_create_cone(lpg_graph_t *graph, bool gen_inverse_index, lpg_inference_order_t order);
+lpg_inference_graph_t *__lpg_inference_graph_create_mt(lpg_graph_t *graph, bool gen_inverse_index, lpg_inference_order_t order, uint32_t threads_num);
+lpg_inference_graph_t *lpg_inference_graph_fuse(const lpg_inference_graph_t *inference_graph);
 
 void lpg_inference_graph_release(lpg_inference_graph_t *inference_graph);
+uint64_t __lpg_inference_graph_next_id();
 
 
-typedef struct __lpg_inference_graph_index_map_entry
-{
-    lpg_node_t *node;
-    lpg_inference_graph_index_t index;
-} __lpg_inference_graph_index_map_entry_t;
-
-size_t __lpg_inference_graph_index_map_hsh(const __lpg_inference_graph_index_map_entry_t *entry);
-bool __lpg_inference_graph_index_map_eq(const __lpg_inference_graph_index_map_entry_t *a, const __lpg_inference_graph_index_map_entry_t *b);
-
-void __lpg_inference_graph_index_map_insert(lpg_inference_graph_t *inference_graph, lpg_node_t *node, lpg_inference_graph_index_t index);
-void lpg_inference_graph_index_map_find(lpg_inference_graph_t *inference_graph, lpg_node_t *node, lpg_inference_graph_index_t *result);
+void lpg_inference_graph_index_map_find(const lpg_inference_graph_t *inference_graph, const lpg_node_t *node, lpg_inference_graph_index_t *result);
+void lpg_inference_graph_inv_index_map_find(const lpg_inference_graph_t *inference_graph, lpg_inference_graph_index_t index, lpg_node_t **result);
 
-size_t __lpg_inference_graph_inv_index_map_hsh(const __lpg_inference_graph_index_map_entry_t *entry);
-bool __lpg_inference_graph_inv_index_map_eq(const __lpg_inference_graph_index_map_entry_t *a, const __lpg_inference_graph_index_map_entry_t *b);
 
-void __lpg_inference_graph_inv_index_map_insert(lpg_inference_graph_t *inference_graph, lpg_node_t *node, lpg_inference_graph_index_t index);
-void lpg_inference_graph_inv_index_map_find(lpg_inference_graph_t *inference_graph, lpg_inference_graph_index_t index, lpg_node_t **result);
+double lpg_inference_graph_avg_parent_distance(const lpg_inference_graph_t *inference_graph);
 
 
-void __lpg_inference_graph_tsort_packed(lpg_inference_graph_t *inference_graph, bool gen_inverse_index);
+void __lpg_inference_graph_tsort_packed(lpg_inference_graph_t *inference_graph, bool gen_inverse_index, lpg_inference_order_t order, uint32_t threads_num);
+void __lpg_inference_graph_reorder(lpg_graph_t *graph, lpg_inference_order_t order, struct __lpg_tsort_levels *levels);
+void __lpg_inference_graph_split_runs(lpg_inference_graph_t *inference_graph);
+void __lpg_inference_graph_build_children(lpg_inference_graph_t *inference_graph);
+void __lpg_inference_graph_build_node_outputs(const lpg_inference_graph_t *inference_graph, size_t **node_outputs_offsets, size_t **node_outputs);
+lpg_inference_graph_uindex_t *__lpg_node_packed_alloc_slots_grouped(const lpg_node_packed_t *sorted_nodes, size_t nodes_num, size_t inputs_size, const lpg_inference_graph_uindex_t *output_nodes, size_t outputs_size, const lp_bitset_t *outputs_mask, const size_t *group_offsets, size_t groups_num, size_t *slots_num);
+lpg_inference_graph_uindex_t *__lpg_node_packed_alloc_slots(const lpg_node_packed_t *sorted_nodes, size_t nodes_num, size_t inputs_size, const lpg_inference_graph_uindex_t *output_nodes, size_t outputs_size, const lp_bitset_t *outputs_mask, size_t *slots_num);
+void __lpg_inference_graph_alloc_slots(lpg_inference_graph_t *inference_graph);
+void __lpg_inference_graph_select_index(lpg_inference_graph_t *inference_graph);
 
 #endif // _LOCKPICK_GRAPH_INFERENCE_INFERENCE_GRAPH_H
\ No newline at end of file
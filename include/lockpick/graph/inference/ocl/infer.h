@@ -2,9 +2,89 @@
 #define _LOCKPICK_GRAPH_INFERENCE_OCL_INFER_H
 
 #include <lockpick/graph/inference/inference_graph.h>
-#include <lockpick/bitset.h>
+#include <lockpick/vector.h>
+#include <CL/cl.h>
+#include <stdint.h>
 
+#define LPG_INFERENCE_OCL_SOURCE_PATH LOCKPICK_PROJECT_DIR "/lockpick/graph/inference/ocl/infer.cl"
+#define LPG_INFERENCE_OCL_BUILD_OPTIONS "-I " LOCKPICK_PROJECT_DIR "/include"
+#define LPG_INFERENCE_OCL_KERNEL_NAME "lpg_inference_graph_infer_ocl"
+#define LPG_INFERENCE_OCL_NARROW_KERNEL_NAME "lpg_inference_graph_infer_ocl_narrow"
 
-void lpg_inference_graph_infer_random_inputs_ocl(lpg_inference_graph_t *inference_graph);
 
-#endif // _LOCKPICK_GRAPH_INFERENCE_OCL_INFER_H
\ No newline at end of file
+/**
+ * lpg_inference_ocl_graph - device-resident copy of inference graph
+ * @inference_graph_id: identifier of host inference graph object
+ * @narrow:             whether @sorted_nodes hold narrow packed nodes of the graph
+ * @sorted_nodes:       device copy of topologically sorted array of packed nodes
+ * @node_slots:         device copy of value slots assigned to nodes
+ * @output_nodes:       device copy of indices of output nodes
+*/
+typedef struct lpg_inference_ocl_graph
+{
+    uint64_t inference_graph_id;
+    bool narrow;
+    cl_mem sorted_nodes;
+    cl_mem node_slots;
+    cl_mem output_nodes;
+} lpg_inference_ocl_graph_t;
+
+
+/**
+ * lpg_inference_ocl_session - persistent OpenCL inference session
+ * @context:            OpenCL context session is created in
+ * @device:             device evaluating graphs
+ * @queue:              command queue of @device
+ * @program:            built inference program
+ * @kernel:             inference kernel for packed nodes with 32-bit indices
+ * @narrow_kernel:      inference kernel for packed nodes with 16-bit indices, see 'lpg_node_packed_narrow'
+ * @graphs:             vector of pointers to device-resident graphs uploaded so far
+ * @input_values:       device buffer for bit-sliced input values
+ * @values:             device buffer for bit-sliced values of slots
+ * @output:             device buffer for bit-sliced output values
+ * @input_values_size:  size of @input_values buffer in bytes
+ * @values_size:        size of @values buffer in bytes
+ * @output_size:        size of @output buffer in bytes
+ *
+ * Everything that does not depend on particular batch is set up once: the program is built on session
+ * creation, using binaries cached on disk by 'lp_ocl_build_program_cached', and every graph is uploaded
+ * to the device on its first evaluation. Batch buffers are only reallocated when they are too small for
+ * the next batch, so repeated evaluation transfers only input and output values.
+ *
+ * Every work-item evaluates the whole graph for a single bit-sliced word, i.e. for 64 input vectors,
+ * so a single launch covers as many input vectors as there are words in the batch. Intermediate values
+ * are kept in reusable value slots of the graph.
+*/
+typedef struct lpg_inference_ocl_session
+{
+    cl_context context;
+    cl_device_id device;
+    cl_command_queue queue;
+    cl_program program;
+    cl_kernel kernel;
+    cl_kernel narrow_kernel;
+    lp_vector_t *graphs;
+    cl_mem input_values;
+    cl_mem values;
+    cl_mem output;
+    size_t input_values_size;
+    size_t values_size;
+    size_t output_size;
+} lpg_inference_ocl_session_t;
+
+
+lpg_inference_ocl_session_t *lpg_inference_ocl_session_create(cl_context context);
+void lpg_inference_ocl_session_release(lpg_inference_ocl_session_t *session);
+
+const lpg_inference_ocl_graph_t *lpg_inference_ocl_session_upload(lpg_inference_ocl_session_t *session, const lpg_inference_graph_t *inference_graph);
+void lpg_inference_ocl_session_evict(lpg_inference_ocl_session_t *session, const lpg_inference_graph_t *inference_graph);
+
+void lpg_inference_graph_infer_ocl_into(
+    lpg_inference_ocl_session_t *session,
+    const lpg_inference_graph_t *inference_graph,
+    const uint64_t *input_values,
+    size_t words_num,
+    uint64_t *output);
+uint64_t *lpg_inference_graph_infer_ocl(lpg_inference_ocl_session_t *session, const lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num);
+
+#endif // _LOCKPICK_GRAPH_INFERENCE_OCL_INFER_H
@@ -1,14 +1,26 @@
 #ifndef _LOCKPICK_GRAPH_INFERENCE_PACKED_NODE_H
 #define _LOCKPICK_GRAPH_INFERENCE_PACKED_NODE_H
 
-#define LPG_INFERENCE_GRAPH_MAX_NODES_NUM 65536
-#define LPG_INFERENCE_GRAPH_MAX_OUTPUTS_NUM 8191
+/*
+    Width of node indices is chosen per inference graph on its creation. Graphs with at most
+    LPG_INFERENCE_GRAPH_NARROW_MAX_NODES_NUM nodes additionally keep their packed nodes with 16-bit
+    indices, which halves the memory traffic of engines, see 'lpg_node_packed_narrow'.
+*/
+#define LPG_INFERENCE_GRAPH_MAX_NODES_NUM 4294967296ULL
+#define LPG_INFERENCE_GRAPH_NARROW_MAX_NODES_NUM 65536
 
 typedef struct lpg_inference_graph lpg_inference_graph_t;
 
 /*
     WARNING: Do not rearange fields of this enum,
     their order is used for fast conversion from regular 'node_type'
+
+    Types following LPG_NODE_PACKED_TYPE_INPUT never come from regular nodes, they are produced
+    by fusing several gates into one, see 'lpg_inference_graph_fuse'.
+    LPG_NODE_PACKED_TYPE_ANDNOT and LPG_NODE_PACKED_TYPE_ORNOT negate the second parent.
+    Ternary types read all three parents: LPG_NODE_PACKED_TYPE_XOR3 is their parity,
+    LPG_NODE_PACKED_TYPE_MAJ is their majority and LPG_NODE_PACKED_TYPE_MUX selects
+    the second parent if the third one is set and the first parent otherwise.
 */
 enum lpg_node_packed_types
 {
@@ -18,42 +30,59 @@ enum lpg_node_packed_types
     LPG_NODE_PACKED_TYPE_XOR,
     LPG_NODE_PACKED_TYPE_TRUE,
     LPG_NODE_PACKED_TYPE_FALSE,
-    LPG_NODE_PACKED_TYPE_INPUT
+    LPG_NODE_PACKED_TYPE_INPUT,
+    LPG_NODE_PACKED_TYPE_NAND,
+    LPG_NODE_PACKED_TYPE_NOR,
+    LPG_NODE_PACKED_TYPE_XNOR,
+    LPG_NODE_PACKED_TYPE_ANDNOT,
+    LPG_NODE_PACKED_TYPE_ORNOT,
+    LPG_NODE_PACKED_TYPE_XOR3,
+    LPG_NODE_PACKED_TYPE_MAJ,
+    LPG_NODE_PACKED_TYPE_MUX
 };
 
+#define LPG_NODE_PACKED_TYPES_NUM       (LPG_NODE_PACKED_TYPE_MUX+1)
+#define LPG_NODE_PACKED_MAX_PARENTS_NUM 3
 
-#define __LPG_NODE_PACKED_TYPE_MASK     0b0000000000000111
-#define __LPG_NODE_PACKED_OUTPUT_MASK   0b1111111111111000
 
-#define LPG_NODE_PACKED_NOT_OUTPUT      0b0001111111111111
+#define __LPG_NODE_PACKED_TYPE_BITS     4
+#define __LPG_NODE_PACKED_TYPE_MASK     0b0000000000001111
 
+/*
+    Indices are stored as signed values for compatibility with OpenCL kernels. Cast them
+    to 'lpg_inference_graph_uindex_t' before using as array subscripts.
+*/
 #ifndef __OPENCL_C_VERSION__
 #include <CL/cl.h>
 
-typedef cl_short lpg_inference_graph_index_t;
+typedef cl_int lpg_inference_graph_index_t;
+typedef cl_uint lpg_inference_graph_uindex_t;
+typedef cl_short lpg_inference_graph_narrow_index_t;
+typedef cl_ushort lpg_inference_graph_narrow_uindex_t;
 #else
-typedef short lpg_inference_graph_index_t;
+typedef int lpg_inference_graph_index_t;
+typedef uint lpg_inference_graph_uindex_t;
+typedef short lpg_inference_graph_narrow_index_t;
+typedef ushort lpg_inference_graph_narrow_uindex_t;
 #endif // __OPENCL_C_VERSION__
 
 
-
-
 /**
  * lpg_node_packed - computational graph node object specialized for efficient inference
- * @parents:        arrary of indices containing up to 2 operands (parents)
- * @__output_type:  index of this node inside outputs buffer and type of operation
+ * @parents:        arrary of indices containing up to 3 operands (parents)
+ * @__type:        type of operation
  * 
  * This specialized node structure is designed for efficient inference of the corresponding computational graph,
  * which is stored as an array of such nodes sorted in topological order.
  * 
  * The @parents array contains the indices of the operand nodes within the topologically sorted array. The number
- * of parents can be efficiently derived from the node's type at runtime.
+ * of parents can be efficiently derived from the node's type at runtime. Only ternary types produced by fusion
+ * use the third parent, other types keep it zero, as well as their other unused parents. The node is 16 bytes
+ * wide, so nodes never straddle cache lines.
  * 
- * The @__output_type word is a packed value that contains the index of the corresponding lpg_node_t within the
- * regular lpg_graph_t outputs buffer, as well as the node's operation type.
- * 
- * If a node does not belong to the outputs buffer, the output index value is set to LPG_NODE_PACKED_NOT_OUTPUT.
- * Otherwise, the index value is less than LPG_INFERENCE_GRAPH_MAX_OUTPUTS_NUM.
+ * The @__type word contains the node's operation type within its lower __LPG_NODE_PACKED_TYPE_BITS bits.
+ * Nodes do not store their indices within the outputs buffer, engines gather output values through the
+ * 'output_nodes' table of the inference graph instead.
  * 
  * Among the common types of node operations, there is a special LPG_NODE_PACKED_TYPE_INPUT type, which indicates
  * that the current node is an input node and its value is a variable. This is appropriate because the
@@ -63,9 +92,38 @@ typedef short lpg_inference_graph_index_t;
 */
 typedef struct lpg_node_packed
 {
-    lpg_inference_graph_index_t parents[2];
-    lpg_inference_graph_index_t __output_type;
+    lpg_inference_graph_index_t parents[LPG_NODE_PACKED_MAX_PARENTS_NUM];
+    lpg_inference_graph_index_t __type;
 } __attribute__((packed)) lpg_node_packed_t;
 
 
+/**
+ * lpg_node_packed_narrow - packed node with 16-bit indices
+ * @parents:        array of indices containing up to 3 operands (parents)
+ * @__type:        type of operation
+ *
+ * Same as 'lpg_node_packed', but for graphs with at most LPG_INFERENCE_GRAPH_NARROW_MAX_NODES_NUM nodes.
+ * The node is 8 bytes wide, so engines evaluating such graphs load half as much per node. Indices use
+ * the whole 16-bit range, so they must be widened as unsigned values, see '__LPG_NODE_PACKED_WIDEN'.
+*/
+typedef struct lpg_node_packed_narrow
+{
+    lpg_inference_graph_narrow_index_t parents[LPG_NODE_PACKED_MAX_PARENTS_NUM];
+    lpg_inference_graph_narrow_index_t __type;
+} __attribute__((packed)) lpg_node_packed_narrow_t;
+
+
+/*
+    Converts narrow packed node into regular one. Engines widen every node right after its load,
+    so a single implementation of gates serves graphs of both index widths.
+*/
+#define __LPG_NODE_PACKED_WIDEN_INDEX(index) ((lpg_inference_graph_index_t)(lpg_inference_graph_narrow_uindex_t)(index))
+#define __LPG_NODE_PACKED_WIDEN(narrow_node)                                \
+    ((lpg_node_packed_t){{                                                  \
+        __LPG_NODE_PACKED_WIDEN_INDEX((narrow_node).parents[0]),            \
+        __LPG_NODE_PACKED_WIDEN_INDEX((narrow_node).parents[1]),            \
+        __LPG_NODE_PACKED_WIDEN_INDEX((narrow_node).parents[2])},           \
+        __LPG_NODE_PACKED_WIDEN_INDEX((narrow_node).__type)})
+
+
 #endif // _LOCKPICK_GRAPH_INFERENCE_PACKED_NODE_H
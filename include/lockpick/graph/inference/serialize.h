@@ -0,0 +1,51 @@
+#ifndef _LOCKPICK_GRAPH_INFERENCE_SERIALIZE_H
+#define _LOCKPICK_GRAPH_INFERENCE_SERIALIZE_H
+
+#include <lockpick/graph/inference/inference_graph.h>
+#include <stdint.h>
+
+#define LPG_INFERENCE_FILE_MAGIC "LPGINFER"
+#define LPG_INFERENCE_FILE_MAGIC_SIZE 8
+// Must be increased on every change of the layout of the file
+#define LPG_INFERENCE_FILE_VERSION 6
+
+
+/**
+ * lpg_inference_file_header - header of inference graph file
+ * @magic:                  LPG_INFERENCE_FILE_MAGIC without terminating zero
+ * @version:                version of the layout, LPG_INFERENCE_FILE_VERSION
+ * @index_size:             size of node indices in bytes, always that of 'lpg_inference_graph_index_t'
+ * @nodes_num:              number of packed nodes
+ * @inputs_size:            number of input nodes
+ * @outputs_size:           number of output nodes
+ * @levels_num:             number of levels
+ * @level_offsets_offset:   offset of @levels_num+1 level offsets from the beginning of the file
+ * @output_nodes_offset:    offset of @outputs_size indices of output nodes from the beginning of the file
+ * @sorted_nodes_offset:    offset of @nodes_num packed nodes from the beginning of the file
+ * @file_size:              total size of the file in bytes
+ *
+ * The file consists of the header followed by level offsets stored as 64-bit words, indices of output nodes
+ * and the topologically sorted array of packed nodes, exactly as they are laid out in memory. Sections are aligned, so that the
+ * file can be mapped and its arrays used in place. All values are stored in the native byte order, files
+ * are meant to be shared between processes of a single machine rather than across architectures.
+*/
+typedef struct lpg_inference_file_header
+{
+    char magic[LPG_INFERENCE_FILE_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t index_size;
+    uint64_t nodes_num;
+    uint64_t inputs_size;
+    uint64_t outputs_size;
+    uint64_t levels_num;
+    uint64_t level_offsets_offset;
+    uint64_t output_nodes_offset;
+    uint64_t sorted_nodes_offset;
+    uint64_t file_size;
+} lpg_inference_file_header_t;
+
+
+void lpg_inference_graph_save(const lpg_inference_graph_t *inference_graph, const char *path);
+lpg_inference_graph_t *lpg_inference_graph_load(const char *path);
+
+#endif // _LOCKPICK_GRAPH_INFERENCE_SERIALIZE_H
@@ -0,0 +1,54 @@
+#ifndef _LOCKPICK_GRAPH_INFERENCE_SOA_H
+#define _LOCKPICK_GRAPH_INFERENCE_SOA_H
+
+#include <lockpick/graph/inference/inference_graph.h>
+#include <stdint.h>
+
+// Number of packed types, which are grouped separately; input nodes are not evaluated, so their group is always empty
+#define LPG_INFERENCE_SOA_GATE_TYPES_NUM LPG_NODE_PACKED_TYPES_NUM
+
+
+/**
+ * lpg_inference_soa - structure-of-arrays layout of inference graph grouped by gate type
+ * @gates_num:      number of evaluated nodes, i.e. all nodes except for input ones
+ * @groups_num:     number of groups of gates
+ * @group_types:    packed type shared by all gates of each group
+ * @group_offsets:  indices within gate arrays where each group begins, followed by @gates_num
+ * @parents_a:      value slots of the first operands of gates
+ * @parents_b:      value slots of the second operands of gates, same as @parents_a for unary gates
+ * @parents_c:      value slots of the third operands of gates, same as @parents_b for non-ternary gates
+ * @dests:          value slots of gates
+ * @output_slots:   value slot of the node of each output, addressed by output index
+ * @slots_num:      number of value slots sufficient to evaluate groups sequentially
+ *
+ * Gates of every level of the inference graph are split into groups by their packed type, so the group 'g'
+ * occupies the range [@group_offsets[g], @group_offsets[g+1]) of the gate arrays and all of its gates perform
+ * the same operation. Since gates of a single level do not depend on each other, groups are evaluated one
+ * after another with a single type dispatch per group and a branch-free gather/op/scatter loop over its gates.
+ *
+ * Operands and results are addressed by value slots directly, instead of indices of nodes. Slots are allocated
+ * for the grouped order of gates, see '__lpg_node_packed_alloc_slots_grouped', so slots of nodes without
+ * children stay alive until the end of their group and slots of output nodes are never reused. Thus, values
+ * of all outputs are gathered through @output_slots once all groups are evaluated.
+*/
+struct lpg_inference_soa
+{
+    size_t gates_num;
+    size_t groups_num;
+    cl_char *group_types;
+    size_t *group_offsets;
+    lpg_inference_graph_uindex_t *parents_a;
+    lpg_inference_graph_uindex_t *parents_b;
+    lpg_inference_graph_uindex_t *parents_c;
+    lpg_inference_graph_uindex_t *dests;
+    lpg_inference_graph_uindex_t *output_slots;
+    size_t slots_num;
+};
+
+
+lpg_inference_soa_t *__lpg_inference_soa_create(const lpg_inference_graph_t *inference_graph);
+void __lpg_inference_soa_release(lpg_inference_soa_t *soa);
+
+lpg_inference_soa_t *lpg_inference_graph_soa(lpg_inference_graph_t *inference_graph);
+
+#endif // _LOCKPICK_GRAPH_INFERENCE_SOA_H
@@ -0,0 +1,54 @@
+#ifndef _LOCKPICK_GRAPH_INFERENCE_STREAM_H
+#define _LOCKPICK_GRAPH_INFERENCE_STREAM_H
+
+#include <lockpick/graph/inference/inference_graph.h>
+#include <lockpick/define.h>
+#include <stdint.h>
+
+/*
+    Layout of the first byte of every encoded node.
+    Bits [0, 4) hold packed type, the flag tells whether indices of outputs follow.
+*/
+#define LPG_INFERENCE_STREAM_TYPE_MASK          0x0F
+#define LPG_INFERENCE_STREAM_OUTPUT_FLAG        0x10
+
+// Maximal number of bytes in a single varint-encoded index
+#define LPG_INFERENCE_STREAM_VARINT_MAX_SIZE    ((lp_sizeof_bits(uint64_t)+6)/7)
+
+
+/**
+ * lpg_inference_stream - compressed stream of topologically sorted packed nodes
+ * @nodes_num:      number of encoded nodes
+ * @inputs_size:    number of input nodes at the beginning of the stream
+ * @size:           size of @data in bytes
+ * @data:           encoded nodes
+ *
+ * Every node of the inference graph's @sorted_nodes is encoded as a header byte followed by varints:
+ * value slot of the node, one slot per parent and, for output nodes, the number of outputs served by the
+ * node followed by their indices inside the graph's outputs buffer. Varints hold 7 bits per byte, least
+ * significant first, with the high bit set on all bytes but the last one. Input nodes keep slots equal
+ * to their indices, so their slots are not stored.
+ *
+ * Nodes refer to values through slots rather than indices, see '__lpg_inference_graph_alloc_slots',
+ * so evaluation reads neither @sorted_nodes nor @node_slots. The number of slots is bounded by the
+ * number of simultaneously live values, which is small for graphs ordered with LPG_INFERENCE_ORDER_DFS,
+ * so most slots are encoded with a single byte.
+ *
+ * Typical gates take 4 to 5 bytes instead of sizeof(lpg_node_packed_t) plus the slots of the node and
+ * its parents, so an evaluation pass over the stream moves fewer bytes and more of the graph stays cache-resident.
+*/
+struct lpg_inference_stream
+{
+    size_t nodes_num;
+    size_t inputs_size;
+    size_t size;
+    uint8_t *data;
+};
+
+
+lpg_inference_stream_t *__lpg_inference_stream_create(const lpg_inference_graph_t *inference_graph);
+void __lpg_inference_stream_release(lpg_inference_stream_t *stream);
+
+lpg_inference_stream_t *lpg_inference_graph_stream(lpg_inference_graph_t *inference_graph);
+
+#endif // _LOCKPICK_GRAPH_INFERENCE_STREAM_H
@@ -0,0 +1,35 @@
+#ifndef _LOCKPICK_GRAPH_OPTIMIZE_H
+#define _LOCKPICK_GRAPH_OPTIMIZE_H
+
+#include <lockpick/graph/graph.h>
+
+
+/**
+ * lpg_graph_pass - optimization passes of general-purpose graph
+ * @LPG_GRAPH_PASS_SWEEP:               releases nodes unreachable from outputs, see 'lpg_graph_sweep'
+ * @LPG_GRAPH_PASS_CONST_PROP:          propagates literals, see 'lpg_graph_propagate_constants'
+ * @LPG_GRAPH_PASS_DOUBLE_NEGATION:     removes double negations, see 'lpg_graph_remove_double_negations'
+ * @LPG_GRAPH_PASS_DEDUP:               merges structurally identical nodes, see 'lpg_graph_dedup'
+ * @LPG_GRAPH_PASS_FREEZE_CONSTANTS:    replaces placeholder constants with literals, see 'lpg_graph_freeze_constants'
+ * @LPG_GRAPH_PASSES_NUM:               number of passes
+*/
+typedef enum lpg_graph_pass
+{
+    LPG_GRAPH_PASS_SWEEP,
+    LPG_GRAPH_PASS_CONST_PROP,
+    LPG_GRAPH_PASS_DOUBLE_NEGATION,
+    LPG_GRAPH_PASS_DEDUP,
+    LPG_GRAPH_PASS_FREEZE_CONSTANTS,
+    LPG_GRAPH_PASSES_NUM
+} lpg_graph_pass_t;
+
+
+size_t lpg_graph_sweep(lpg_graph_t *graph);
+size_t lpg_graph_propagate_constants(lpg_graph_t *graph);
+size_t lpg_graph_remove_double_negations(lpg_graph_t *graph);
+size_t lpg_graph_dedup(lpg_graph_t *graph);
+size_t lpg_graph_freeze_constants(lpg_graph_t *graph);
+
+size_t lpg_graph_optimize(lpg_graph_t *graph, const lpg_graph_pass_t *passes, size_t passes_num, size_t *removed);
+
+#endif // _LOCKPICK_GRAPH_OPTIMIZE_H
@@ -2,6 +2,7 @@
 #define _LOCKPICK_GRAPH_TRAVERSE_H
 
 #include <lockpick/graph/graph.h>
+#include <lockpick/graph/frozen.h>
 
 
 typedef void (*lpg_traverse_cb_t)(lpg_graph_t *graph, lpg_node_t *node, bool is_input, void *args);
@@ -10,4 +11,8 @@ void lpg_graph_traverse(lpg_graph_t *graph, lpg_traverse_cb_t enter_cb, void *en
 void lpg_graph_traverse_once(lpg_graph_t *graph, lpg_traverse_cb_t cb, void *cb_args);
 void lpg_graph_traverse_once_sync(lpg_graph_t *graph, lpg_traverse_cb_t cb, void *cb_args);
 
+typedef void (*lpg_frozen_traverse_cb_t)(const lpg_frozen_graph_t *frozen, lpg_frozen_index_t slot, bool is_input, void *args);
+void lpg_frozen_graph_traverse(const lpg_frozen_graph_t *frozen, lpg_frozen_traverse_cb_t enter_cb, void *enter_cb_args, lpg_frozen_traverse_cb_t leave_cb, void *leave_cb_args);
+void lpg_frozen_graph_traverse_once(const lpg_frozen_graph_t *frozen, lpg_frozen_traverse_cb_t cb, void *cb_args);
+
 #endif // _LOCKPICK_GRAPH_TRAVERSE_H
\ No newline at end of file
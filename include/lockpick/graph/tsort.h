@@ -2,6 +2,8 @@
 #define _LOCKPICK_GRAPH_TSORT_H
 
 #include <lockpick/graph/graph.h>
+#include <lockpick/bitset.h>
+#include <lockpick/graph/frozen.h>
 #include <lockpick/graph/inference/inference_graph.h>
 
 
@@ -15,8 +17,34 @@ typedef struct __tsort_init_state
 
 void __lpg_tsort_init_state_cb(lpg_graph_t *graph, lpg_node_t *node, bool is_input, void *args);
 
+lpg_node_t **__lpg_graph_collect_post_order(lpg_graph_t *graph, const lp_bitset_t *inputs, lp_bitset_t *visited, size_t *nodes_num);
+
+
+/**
+ * __lpg_tsort_levels - nodes reachable from graph outputs sorted by levels
+ * @sorted_nodes:           topologically sorted nodes grouped by levels, inputs come first in their order
+ * @nodes_num:              number of nodes inside @sorted_nodes
+ * @level_offsets:          indices within @sorted_nodes where each level begins, followed by @nodes_num
+ * @levels_num:             number of levels
+ * @redundant_inputs_num:   number of input nodes not reachable from outputs
+*/
+typedef struct __lpg_tsort_levels
+{
+    lpg_node_t **sorted_nodes;
+    size_t nodes_num;
+    size_t *level_offsets;
+    size_t levels_num;
+    size_t redundant_inputs_num;
+} __lpg_tsort_levels_t;
+
+void __lpg_graph_tsort_levels(lpg_graph_t *graph, bool keep_post_order, __lpg_tsort_levels_t *levels);
+
 void lpg_graph_tsort(lpg_graph_t *graph, lpg_node_t ***sorted_nodes);
 
+void lpg_graph_tsort_levels(lpg_graph_t *graph, lpg_node_t ***sorted_nodes, size_t *nodes_num, uint32_t **node_levels);
+
 void lpg_graph_tsort_packed(lpg_graph_t *graph, lpg_node_packed_t **sorted_nodes);
 
+void lpg_frozen_graph_tsort(const lpg_frozen_graph_t *frozen, lpg_frozen_index_t **sorted_slots, size_t *nodes_num);
+
 #endif // _LOCKPICK_GRAPH_TSORT_H
\ No newline at end of file
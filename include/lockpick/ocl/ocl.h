@@ -5,6 +5,8 @@
 #include <CL/cl_ext.h>
 
 #define LP_OCL_DEVICE_UUID_ENV_NAME "LP_OCL_DEVICE_UUID"
+#define LP_OCL_CACHE_DIR_ENV_NAME "LP_OCL_CACHE_DIR"
+#define LP_OCL_CACHE_SUBDIR_NAME "lockpick_ocl"
 
 typedef void (*device_cb_t)(cl_platform_id, cl_device_id, cl_uint, void *);
 typedef void (*platform_cb_t)(cl_platform_id, cl_uint, void *);
@@ -14,5 +16,9 @@ void __lp_ocl_device_uuid_to_hex_str(const cl_uchar *uuid, char *hex_str, size_t
 void __lp_ocl_device_hex_str_to_device_uuid(const char *hex_str, cl_uchar *uuid);
 
 cl_context lp_ocl_create_context();
+cl_device_id lp_ocl_context_device(cl_context context);
+
+cl_program lp_ocl_build_program(cl_context context, cl_device_id device, const char *source_path, const char *options);
+cl_program lp_ocl_build_program_cached(cl_context context, cl_device_id device, const char *source_path, const char *options);
 
 #endif // _LOCKPICK_OCL_OCL_H
\ No newline at end of file
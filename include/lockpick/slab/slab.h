@@ -36,6 +36,9 @@ void lp_slab_free(lp_slab_t *slab, void *node_ptr);
 
 void lp_slab_exec(lp_slab_t *slab, void (*callback)(void *entry_ptr, void *args), void *args);
 
+size_t lp_slab_capacity(const lp_slab_t *slab);
+size_t lp_slab_index(const lp_slab_t *slab, const void *entry_ptr);
+
 #define lp_slab_foreach_fb(slab,fb)     \
         lp_dlist_foreach(&(slab)->__fb_head->__node,fb,__lp_slab_block_list_t,__node);
 
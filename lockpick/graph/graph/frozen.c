@@ -0,0 +1,207 @@
+#include <lockpick/graph/frozen.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/define.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+typedef struct __lpg_graph_freeze_args
+{
+    lpg_frozen_graph_t *frozen;
+    const lp_slab_t *slab;
+    size_t next_slot;
+    size_t adjacency_capacity;
+    size_t parents_num;
+    size_t children_num;
+} __lpg_graph_freeze_args_t;
+
+
+/**
+ * __lpg_graph_freeze_cb - appends node to adjacency arrays of frozen graph
+ * @entry_ptr:  pointer to allocated node
+ * @args:       pointer to '__lpg_graph_freeze_args_t'
+ *
+ * Slab is iterated in order of slots, so offsets of the node and of free slots preceding it are known
+ * as soon as it is reached and both adjacency arrays are filled within a single pass.
+ *
+ * Return: None
+*/
+static void __lpg_graph_freeze_cb(void *entry_ptr, void *args)
+{
+    lpg_node_t *node = (lpg_node_t*)entry_ptr;
+    __lpg_graph_freeze_args_t *args_struct = (__lpg_graph_freeze_args_t*)args;
+    lpg_frozen_graph_t *frozen = args_struct->frozen;
+
+    size_t slot = lp_slab_index(args_struct->slab,node);
+    for(; args_struct->next_slot <= slot; ++args_struct->next_slot)
+    {
+        frozen->parents_offsets[args_struct->next_slot] = args_struct->parents_num;
+        frozen->children_offsets[args_struct->next_slot] = args_struct->children_num;
+    }
+
+    frozen->types[slot] = node->type;
+    lp_bitset_update(frozen->values,slot,lpg_node_value(node));
+
+    lpg_node_t **parents = lpg_node_parents(node);
+    size_t parents_num = lpg_node_get_parents_num(node);
+    for(size_t parent_i = 0; parent_i < parents_num; ++parent_i)
+        frozen->parents[args_struct->parents_num++] = lp_slab_index(args_struct->slab,parents[parent_i]);
+
+    size_t children_num = lpg_node_get_children_num(node);
+    affirmf(args_struct->children_num+children_num <= args_struct->adjacency_capacity,
+        "Graph has more children records than parent ones, it is not well-formed");
+    for(size_t child_i = 0; child_i < children_num; ++child_i)
+    {
+        lpg_node_t *child = lp_vector_at_type(node->children,child_i,lpg_node_t*);
+        frozen->children[args_struct->children_num++] = lp_slab_index(args_struct->slab,child);
+    }
+}
+
+
+/**
+ * lpg_graph_freeze - builds frozen form of graph
+ * @graph:      graph object
+ *
+ * See 'lpg_frozen_graph' for the layout. All nodes allocated within the slab of @graph are frozen, including
+ * ones not reachable from its outputs, with a single pass over the slab. Memory of the frozen form is allocated
+ * with a fixed number of calls regardless of the size of @graph.
+ *
+ * @graph is not modified, so it may be used and released independently, but the frozen form must
+ * be rebuilt to reflect any changes of it.
+ *
+ * Return: Pointer to frozen graph object
+*/
+lpg_frozen_graph_t *lpg_graph_freeze(lpg_graph_t *graph)
+{
+    affirm_nullptr(graph,"graph");
+
+    lp_slab_t *slab = __lpg_graph_slab(graph);
+    size_t slots_num = lp_slab_capacity(slab);
+    affirmf(slots_num <= LPG_FROZEN_MAX_SLOTS_NUM,
+        "Graph can hold %zd nodes, which exceeds limit of frozen graphs %zd",slots_num,LPG_FROZEN_MAX_SLOTS_NUM);
+
+    size_t frozen_size = sizeof(lpg_frozen_graph_t);
+    lpg_frozen_graph_t *frozen = (lpg_frozen_graph_t*)malloc(frozen_size);
+    affirm_bad_malloc(frozen,"frozen graph",frozen_size);
+
+    frozen->graph = graph;
+    frozen->slots_num = slots_num;
+
+    size_t types_size = MAX(1,slots_num)*sizeof(uint8_t);
+    frozen->types = (uint8_t*)malloc(types_size);
+    affirm_bad_malloc(frozen->types,"frozen types array",types_size);
+    memset(frozen->types,LPG_FROZEN_SLOT_FREE,types_size);
+
+    frozen->values = lp_bitset_create(MAX(1,slots_num));
+
+    size_t offsets_size = (slots_num+1)*sizeof(lpg_frozen_index_t);
+    frozen->parents_offsets = (lpg_frozen_index_t*)malloc(offsets_size);
+    affirm_bad_malloc(frozen->parents_offsets,"frozen parents offsets array",offsets_size);
+    frozen->children_offsets = (lpg_frozen_index_t*)malloc(offsets_size);
+    affirm_bad_malloc(frozen->children_offsets,"frozen children offsets array",offsets_size);
+
+    // Every node has at most two parents, so there are at most two adjacency records per slot
+    size_t adjacency_capacity = MAX(1,2*(slots_num-slab->__total_free));
+    size_t adjacency_size = adjacency_capacity*sizeof(lpg_frozen_index_t);
+    frozen->parents = (lpg_frozen_index_t*)malloc(adjacency_size);
+    affirm_bad_malloc(frozen->parents,"frozen parents array",adjacency_size);
+    frozen->children = (lpg_frozen_index_t*)malloc(adjacency_size);
+    affirm_bad_malloc(frozen->children,"frozen children array",adjacency_size);
+
+    __lpg_graph_freeze_args_t args;
+    args.frozen = frozen;
+    args.slab = slab;
+    args.next_slot = 0;
+    args.adjacency_capacity = adjacency_capacity;
+    args.parents_num = 0;
+    args.children_num = 0;
+    lp_slab_exec(slab,__lpg_graph_freeze_cb,&args);
+
+    for(; args.next_slot <= slots_num; ++args.next_slot)
+    {
+        frozen->parents_offsets[args.next_slot] = args.parents_num;
+        frozen->children_offsets[args.next_slot] = args.children_num;
+    }
+
+    affirmf(args.parents_num == args.children_num,
+        "Graph has %zd parent records, but %zd children ones, it is not well-formed",args.parents_num,args.children_num);
+
+    frozen->inputs_size = graph->inputs_size;
+    size_t inputs_size = MAX(1,graph->inputs_size)*sizeof(lpg_frozen_index_t);
+    frozen->inputs = (lpg_frozen_index_t*)malloc(inputs_size);
+    affirm_bad_malloc(frozen->inputs,"frozen inputs array",inputs_size);
+    frozen->is_input = lp_bitset_create(MAX(1,slots_num));
+    for(size_t in_i = 0; in_i < graph->inputs_size; ++in_i)
+    {
+        frozen->inputs[in_i] = lp_slab_index(slab,graph->inputs[in_i]);
+        lp_bitset_set(frozen->is_input,frozen->inputs[in_i]);
+    }
+
+    frozen->outputs_size = graph->outputs_size;
+    size_t outputs_size = MAX(1,graph->outputs_size)*sizeof(lpg_frozen_index_t);
+    frozen->outputs = (lpg_frozen_index_t*)malloc(outputs_size);
+    affirm_bad_malloc(frozen->outputs,"frozen outputs array",outputs_size);
+    frozen->is_output = lp_bitset_create(MAX(1,slots_num));
+    for(size_t out_i = 0; out_i < graph->outputs_size; ++out_i)
+    {
+        affirmf(graph->outputs[out_i],"Output %zd of graph is not assigned",out_i);
+        frozen->outputs[out_i] = lp_slab_index(slab,graph->outputs[out_i]);
+        lp_bitset_set(frozen->is_output,frozen->outputs[out_i]);
+    }
+
+    for(uint32_t literal_i = 0; literal_i < 2; ++literal_i)
+        frozen->literals[literal_i] = graph->__literals[literal_i] ? lp_slab_index(slab,graph->__literals[literal_i]) : LPG_FROZEN_NO_SLOT;
+
+    return frozen;
+}
+
+
+void lpg_frozen_graph_release(lpg_frozen_graph_t *frozen)
+{
+    affirm_nullptr(frozen,"frozen graph");
+
+    free(frozen->types);
+    lp_bitset_release(frozen->values);
+    free(frozen->parents_offsets);
+    free(frozen->parents);
+    free(frozen->children_offsets);
+    free(frozen->children);
+    free(frozen->inputs);
+    free(frozen->outputs);
+    lp_bitset_release(frozen->is_input);
+    lp_bitset_release(frozen->is_output);
+    free(frozen);
+}
+
+
+/**
+ * lpg_frozen_graph_node - returns node of underlying graph residing in slot
+ * @frozen:     frozen graph object
+ * @slot:       slot of allocated node
+ *
+ * Return: Pointer to node within the slab of the underlying graph
+*/
+inline lpg_node_t *lpg_frozen_graph_node(const lpg_frozen_graph_t *frozen, lpg_frozen_index_t slot)
+{
+    affirmf_debug(slot < frozen->slots_num && frozen->types[slot] != LPG_FROZEN_SLOT_FREE,"Slot %u holds no node",slot);
+
+    return (lpg_node_t*)__lpg_graph_slab(frozen->graph)->__buffer+slot;
+}
+
+
+inline lpg_frozen_index_t lpg_frozen_graph_slot(const lpg_frozen_graph_t *frozen, const lpg_node_t *node)
+{
+    return lp_slab_index(__lpg_graph_slab(frozen->graph),node);
+}
+
+
+inline size_t lpg_frozen_graph_get_parents_num(const lpg_frozen_graph_t *frozen, lpg_frozen_index_t slot)
+{
+    return frozen->parents_offsets[slot+1]-frozen->parents_offsets[slot];
+}
+
+
+inline size_t lpg_frozen_graph_get_children_num(const lpg_frozen_graph_t *frozen, lpg_frozen_index_t slot)
+{
+    return frozen->children_offsets[slot+1]-frozen->children_offsets[slot];
+}
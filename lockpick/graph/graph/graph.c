@@ -103,7 +103,8 @@ void __lpg_graph_set_super(lpg_graph_t *graph, bool super)
  * not enforced. All node allocations must come from the slab so 
  * @max_nodes limits overall graph size.
  * 
- * The input buffer is prepopulated with constant 0 nodes. The output  
+ * The input buffer is prepopulated with constant 0 nodes. These are placeholders
+ * rather than literals, so node constructors never fold them, see 'lpg_node_literal'. The output  
  * buffer is initialized to NULL and must be set by user after
  * assembling graph operations.
  * Typically this should be done by creating views on certain output
@@ -140,6 +141,9 @@ lpg_graph_t *lpg_graph_create(const char *name, size_t inputs_size, size_t outpu
         graph->inputs[in_i] = lpg_node_const(graph,false);
     
     graph->max_nodes = max_nodes;
+    graph->__strash = NULL;
+    graph->__literals[false] = NULL;
+    graph->__literals[true] = NULL;
 
     return graph;
 }
@@ -189,6 +193,8 @@ void lpg_graph_release(lpg_graph_t *graph)
         lp_slab_exec(slab,__lpg_graph_release_slab_callback,NULL);
         lp_slab_release(slab);
     }
+    if(graph->__strash)
+        lp_htable_release(graph->__strash);
     free(graph->name);
     free(graph->inputs);
     free(graph->outputs);
@@ -217,9 +223,13 @@ void lpg_graph_release_node(lpg_graph_t *graph, lpg_node_t *node)
 
     for(size_t out_node_i = 0; out_node_i < graph->outputs_size; ++out_node_i)
         lp_htable_insert(release_black_list,&graph->outputs[out_node_i]);
+
+    for(uint32_t literal_i = 0; literal_i < 2; ++literal_i)
+        if(graph->__literals[literal_i])
+            lp_htable_insert(release_black_list,&graph->__literals[literal_i]);
     
     affirmf(!lp_htable_find(release_black_list,&node,NULL),
-        "Can't release node which is either input or output");
+        "Can't release node which is either input, output or literal");
     
     lp_vector_t *release_stack = lp_vector_create(0,sizeof(lpg_node_t*));
     lp_vector_push_back(release_stack,&node);
@@ -257,6 +267,9 @@ void lpg_graph_release_node(lpg_graph_t *graph, lpg_node_t *node)
                 lp_vector_push_back(release_stack,&parent);
         }
 
+        if(graph->__strash)
+            __lpg_graph_strash_remove(graph,curr_node);
+
         __lpg_node_release_internals(curr_node);
         lp_slab_free(slab,curr_node);
     }
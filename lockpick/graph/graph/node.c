@@ -4,37 +4,23 @@
 
 inline lpg_node_t **lpg_node_parents(const lpg_node_t *node)
 {
-    return (lpg_node_t**)(node->__parents_value & __LPG_NODE_PARENTS_MASK);
-}
-
-inline void __lpg_node_set_parents(lpg_node_t *node, lpg_node_t **parents)
-{
-    node->__parents_value = (uintptr_t)parents | 
-            (node->__parents_value & (~__LPG_NODE_PARENTS_MASK));
+    return (lpg_node_t**)node->__parents;
 }
 
 
 inline bool lpg_node_value(const lpg_node_t *node)
 {
-    return node->__parents_value & __LPG_NODE_VALUE_MASK;
+    return node->__value;
 }
 
 inline void __lpg_node_set_value(lpg_node_t *node, bool value)
 {
-    if(value)
-        node->__parents_value |= __LPG_NODE_VALUE_MASK;
-    else
-        node->__parents_value &= ~__LPG_NODE_VALUE_MASK;
+    node->__value = value;
 }
 
 
 inline void __lpg_node_release_internals(lpg_node_t *node)
 {
-    lpg_node_t **parents = lpg_node_parents(node);
-
-    if(parents)
-        free(parents);
-    
     lp_vector_release(node->children);
 }
 
@@ -24,14 +24,9 @@ void __lpg_node_record_child(lpg_node_t *parent, lpg_node_t *child)
 
 void __lpg_node_init(lpg_node_t *node)
 {
-    size_t parents_num = lpg_node_get_parents_num(node);
-    lpg_node_t **parents_ptr;
-    if(parents_num > 0)
-        parents_ptr = (lpg_node_t**)malloc(sizeof(lpg_node_t*)*parents_num);
-    else
-        parents_ptr = NULL;
-
-    __lpg_node_set_parents(node,parents_ptr);
+    node->__value = false;
+    for(size_t parent_i = 0; parent_i < LPG_NODE_MAX_PARENTS_NUM; ++parent_i)
+        node->__parents[parent_i] = NULL;
 
     node->children = lp_vector_create(0,sizeof(lpg_node_t*));
 }
@@ -58,12 +53,164 @@ lpg_node_t *__lpg_node_alloc(lp_slab_t *slab)
 }
 
 
+/**
+ * __lpg_node_is_literal - checks if node is a literal constant of graph
+ * @graph:      graph object
+ * @node:       node to check
+ * @value:      value of literal
+ *
+ * Only literals returned by 'lpg_node_literal' are folded: constant nodes created with 'lpg_node_const',
+ * like input nodes, are placeholders, values of which may be assigned after they are used as operands.
+ * Unlike 'lpg_node_literal', this never allocates the literal.
+ *
+ * Return: True if @node is the literal of @value in @graph
+*/
+inline bool __lpg_node_is_literal(const lpg_graph_t *graph, const lpg_node_t *node, bool value)
+{
+    return node == graph->__literals[value];
+}
+
+
+static inline bool __lpg_node_is_negation_of(const lpg_node_t *node, const lpg_node_t *other)
+{
+    return node->type == LPG_NODE_TYPE_NOT && lpg_node_parents(node)[0] == other;
+}
+
+
+static inline bool __lpg_node_are_complementary(const lpg_node_t *a, const lpg_node_t *b)
+{
+    return __lpg_node_is_negation_of(a,b) || __lpg_node_is_negation_of(b,a);
+}
+
+
+/**
+ * __lpg_node_fold_and - folds conjunction with literal or trivially related operands
+ * @graph:      graph object
+ * @a:          left-side operand
+ * @b:          right-side operand
+ *
+ * Return: Node equivalent to conjunction of @a and @b or NULL if it can't be folded
+*/
+static lpg_node_t *__lpg_node_fold_and(lpg_graph_t *graph, lpg_node_t *a, lpg_node_t *b)
+{
+    if(__lpg_node_is_literal(graph,a,false) || __lpg_node_is_literal(graph,b,true) || a == b)
+        return a;
+    if(__lpg_node_is_literal(graph,b,false) || __lpg_node_is_literal(graph,a,true))
+        return b;
+    if(__lpg_node_are_complementary(a,b))
+        return lpg_node_literal(graph,false);
+    return NULL;
+}
+
+
+/**
+ * __lpg_node_fold_or - folds disjunction with literal or trivially related operands
+ * @graph:      graph object
+ * @a:          left-side operand
+ * @b:          right-side operand
+ *
+ * Return: Node equivalent to disjunction of @a and @b or NULL if it can't be folded
+*/
+static lpg_node_t *__lpg_node_fold_or(lpg_graph_t *graph, lpg_node_t *a, lpg_node_t *b)
+{
+    if(__lpg_node_is_literal(graph,a,true) || __lpg_node_is_literal(graph,b,false) || a == b)
+        return a;
+    if(__lpg_node_is_literal(graph,b,true) || __lpg_node_is_literal(graph,a,false))
+        return b;
+    if(__lpg_node_are_complementary(a,b))
+        return lpg_node_literal(graph,true);
+    return NULL;
+}
+
+
+/**
+ * __lpg_node_fold_xor - folds exclusive disjunction with literal or trivially related operands
+ * @graph:      graph object
+ * @a:          left-side operand
+ * @b:          right-side operand
+ *
+ * Exclusive disjunction with true literal is folded into negation of the other operand, which is
+ * folded further if possible.
+ *
+ * Return: Node equivalent to exclusive disjunction of @a and @b or NULL if it can't be folded
+*/
+static lpg_node_t *__lpg_node_fold_xor(lpg_graph_t *graph, lpg_node_t *a, lpg_node_t *b)
+{
+    if(__lpg_node_is_literal(graph,b,false))
+        return a;
+    if(__lpg_node_is_literal(graph,a,false))
+        return b;
+    if(__lpg_node_is_literal(graph,b,true))
+        return lpg_node_not(graph,a);
+    if(__lpg_node_is_literal(graph,a,true))
+        return lpg_node_not(graph,b);
+    if(a == b)
+        return lpg_node_literal(graph,false);
+    if(__lpg_node_are_complementary(a,b))
+        return lpg_node_literal(graph,true);
+    return NULL;
+}
+
+
+/**
+ * __lpg_node_fold_not - folds negation of literal or of another negation
+ * @graph:      graph object
+ * @a:          operand
+ *
+ * Return: Node equivalent to negation of @a or NULL if it can't be folded
+*/
+static lpg_node_t *__lpg_node_fold_not(lpg_graph_t *graph, lpg_node_t *a)
+{
+    if(__lpg_node_is_literal(graph,a,false))
+        return lpg_node_literal(graph,true);
+    if(__lpg_node_is_literal(graph,a,true))
+        return lpg_node_literal(graph,false);
+    if(a->type == LPG_NODE_TYPE_NOT)
+        return lpg_node_parents(a)[0];
+    return NULL;
+}
+
+
+/**
+ * __lpg_node_fold - folds gate of given type with literal or trivially related operands
+ * @graph:      graph object
+ * @type:       type of the gate
+ * @a:          first operand
+ * @b:          second operand, ignored for negation
+ *
+ * Return: Node equivalent to the gate or NULL if it can't be folded
+*/
+lpg_node_t *__lpg_node_fold(lpg_graph_t *graph, lpg_node_type_t type, lpg_node_t *a, lpg_node_t *b)
+{
+    switch(type)
+    {
+        case LPG_NODE_TYPE_AND: return __lpg_node_fold_and(graph,a,b);
+        case LPG_NODE_TYPE_OR:  return __lpg_node_fold_or(graph,a,b);
+        case LPG_NODE_TYPE_XOR: return __lpg_node_fold_xor(graph,a,b);
+        case LPG_NODE_TYPE_NOT: return __lpg_node_fold_not(graph,a);
+        default:
+            errorf("Can't fold node of type: %d",type);
+    }
+}
+
+
 lpg_node_t *lpg_node_and(lpg_graph_t *graph, lpg_node_t *a, lpg_node_t *b)
 {
     affirm_nullptr(graph,"graph");
     affirm_nullptr(a,"left-side node operand");
     affirm_nullptr(b,"right-side node operand");
 
+    lpg_node_t *folded = __lpg_node_fold_and(graph,a,b);
+    if(folded)
+        return folded;
+
+    if(graph->__strash)
+    {
+        lpg_node_t *existing = __lpg_graph_strash_find(graph,LPG_NODE_TYPE_AND,a,b);
+        if(existing)
+            return existing;
+    }
+
     lp_slab_t *slab = __lpg_graph_slab(graph);
     lpg_node_t *node = __lpg_node_alloc(slab);
 
@@ -75,6 +222,9 @@ lpg_node_t *lpg_node_and(lpg_graph_t *graph, lpg_node_t *a, lpg_node_t *b)
     lpg_node_parents(node)[1] = b;
     __lpg_node_record_child(b,node);
 
+    if(graph->__strash)
+        __lpg_graph_strash_insert(graph,node);
+
     return node;
 }
 
@@ -84,6 +234,17 @@ lpg_node_t *lpg_node_or(lpg_graph_t *graph, lpg_node_t *a, lpg_node_t *b)
     affirm_nullptr(a,"left-side node operand");
     affirm_nullptr(b,"right-side node operand");
 
+    lpg_node_t *folded = __lpg_node_fold_or(graph,a,b);
+    if(folded)
+        return folded;
+
+    if(graph->__strash)
+    {
+        lpg_node_t *existing = __lpg_graph_strash_find(graph,LPG_NODE_TYPE_OR,a,b);
+        if(existing)
+            return existing;
+    }
+
     lp_slab_t *slab = __lpg_graph_slab(graph);
     lpg_node_t *node = __lpg_node_alloc(slab);
 
@@ -95,6 +256,9 @@ lpg_node_t *lpg_node_or(lpg_graph_t *graph, lpg_node_t *a, lpg_node_t *b)
     lpg_node_parents(node)[1] = b;
     __lpg_node_record_child(b,node);
 
+    if(graph->__strash)
+        __lpg_graph_strash_insert(graph,node);
+
     return node;
 }
 
@@ -103,6 +267,17 @@ lpg_node_t *lpg_node_not(lpg_graph_t *graph, lpg_node_t *a)
     affirm_nullptr(graph,"graph");
     affirm_nullptr(a,"node operand");
 
+    lpg_node_t *folded = __lpg_node_fold_not(graph,a);
+    if(folded)
+        return folded;
+
+    if(graph->__strash)
+    {
+        lpg_node_t *existing = __lpg_graph_strash_find(graph,LPG_NODE_TYPE_NOT,a,NULL);
+        if(existing)
+            return existing;
+    }
+
     lp_slab_t *slab = __lpg_graph_slab(graph);
     lpg_node_t *node = __lpg_node_alloc(slab);
 
@@ -112,6 +287,9 @@ lpg_node_t *lpg_node_not(lpg_graph_t *graph, lpg_node_t *a)
     lpg_node_parents(node)[0] = a;
     __lpg_node_record_child(a,node);
 
+    if(graph->__strash)
+        __lpg_graph_strash_insert(graph,node);
+
     return node;
 }
 
@@ -121,6 +299,17 @@ lpg_node_t *lpg_node_xor(lpg_graph_t *graph, lpg_node_t *a, lpg_node_t *b)
     affirm_nullptr(a,"left-side node operand");
     affirm_nullptr(b,"right-side node operand");
 
+    lpg_node_t *folded = __lpg_node_fold_xor(graph,a,b);
+    if(folded)
+        return folded;
+
+    if(graph->__strash)
+    {
+        lpg_node_t *existing = __lpg_graph_strash_find(graph,LPG_NODE_TYPE_XOR,a,b);
+        if(existing)
+            return existing;
+    }
+
     lp_slab_t *slab = __lpg_graph_slab(graph);
     lpg_node_t *node = __lpg_node_alloc(slab);
 
@@ -132,6 +321,9 @@ lpg_node_t *lpg_node_xor(lpg_graph_t *graph, lpg_node_t *a, lpg_node_t *b)
     lpg_node_parents(node)[1] = b;
     __lpg_node_record_child(b,node);
 
+    if(graph->__strash)
+        __lpg_graph_strash_insert(graph,node);
+
     return node;
 }
 
@@ -148,3 +340,32 @@ lpg_node_t *lpg_node_const(lpg_graph_t *graph, bool value)
 
     return node;
 }
+
+
+/**
+ * lpg_node_literal - returns literal constant node of graph
+ * @graph:      graph object
+ * @value:      value of literal
+ *
+ * Unlike 'lpg_node_const', which allocates a new node on every call, @graph holds a single node
+ * per value, which is allocated on the first call. Value of literal must never be changed.
+ *
+ * Node constructors fold literal operands: conjunction with false and disjunction with true
+ * yield the respective literal, while conjunction with true, disjunction and exclusive
+ * disjunction with false yield the other operand. Exclusive disjunction with true becomes negation
+ * and negation of literal yields the opposite one. Regardless of literals, constructors also fold
+ * identical and complementary operands, e.g. 'x^x' and 'x&~x', as well as double negation.
+ * Folded gates are never allocated, so graphs assembled with literals instead of placeholder
+ * constants need no further cleanup.
+ *
+ * Return: Literal node of @value
+*/
+lpg_node_t *lpg_node_literal(lpg_graph_t *graph, bool value)
+{
+    affirm_nullptr(graph,"graph");
+
+    if(!graph->__literals[value])
+        graph->__literals[value] = lpg_node_const(graph,value);
+
+    return graph->__literals[value];
+}
@@ -0,0 +1,529 @@
+#include <lockpick/graph/optimize.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/bitset.h>
+#include <lockpick/define.h>
+#include <lockpick/htable.h>
+#include <lockpick/vector.h>
+#include <stdlib.h>
+
+
+/**
+ * __lpg_graph_optimize_state - nodes of graph reachable from its outputs
+ * @graph:          super-graph being optimized
+ * @slab:           slab of @graph, slot indices of which address bitsets
+ * @order:          reachable nodes in topological order except for inputs and literals
+ * @order_size:     number of nodes inside @order
+ * @kept:           slots of reachable nodes, inputs and literals, all other nodes are dead
+ * @is_output:      slots of nodes serving at least one output
+*/
+typedef struct __lpg_graph_optimize_state
+{
+    lpg_graph_t *graph;
+    lp_slab_t *slab;
+    lpg_node_t **order;
+    size_t order_size;
+    lp_bitset_t *kept;
+    lp_bitset_t *is_output;
+} __lpg_graph_optimize_state_t;
+
+
+/**
+ * __lpg_graph_rewrite_cb_t - rewriting rule of optimization pass
+ *
+ * Called for every reachable node in topological order, so parents of the node are already rewritten.
+ * Returns equivalent node to replace the given one with or NULL if the node must be left as is.
+*/
+typedef lpg_node_t *(*__lpg_graph_rewrite_cb_t)(lpg_graph_t *graph, lpg_node_t *node, void *args);
+
+
+static inline size_t __lpg_graph_optimize_slot(const __lpg_graph_optimize_state_t *state, const lpg_node_t *node)
+{
+    return lp_slab_index(state->slab,node);
+}
+
+
+static inline size_t __lpg_graph_optimize_used_entries(const lp_slab_t *slab)
+{
+    return slab->__total_entries-slab->__total_free;
+}
+
+
+/**
+ * __lpg_graph_optimize_state_init - finds nodes reachable from outputs of graph
+ * @state:      state to initialize
+ * @graph:      super-graph object
+ *
+ * Nodes are ordered with iterative depth-first traversal over parents, which appends a node once
+ * all of its parents are appended. Inputs and literals are marked as kept in advance, so they are
+ * neither traversed nor released even if no output depends on them.
+ *
+ * Return: None
+*/
+static void __lpg_graph_optimize_state_init(__lpg_graph_optimize_state_t *state, lpg_graph_t *graph)
+{
+    affirm_nullptr(graph,"graph");
+    affirmf(lpg_graph_is_super(graph),"Only super-graphs can be optimized, as sub-graphs share nodes of their super-graph");
+
+    lp_slab_t *slab = __lpg_graph_slab(graph);
+    size_t capacity = lp_slab_capacity(slab);
+
+    state->graph = graph;
+    state->slab = slab;
+    state->kept = lp_bitset_create(MAX(1,capacity));
+    state->is_output = lp_bitset_create(MAX(1,capacity));
+
+    size_t order_size = MAX(1,__lpg_graph_optimize_used_entries(slab))*sizeof(lpg_node_t*);
+    state->order = (lpg_node_t**)malloc(order_size);
+    affirm_bad_malloc(state->order,"optimization order array",order_size);
+    state->order_size = 0;
+
+    for(size_t in_i = 0; in_i < graph->inputs_size; ++in_i)
+        lp_bitset_set(state->kept,__lpg_graph_optimize_slot(state,graph->inputs[in_i]));
+
+    for(uint32_t literal_i = 0; literal_i < 2; ++literal_i)
+        if(graph->__literals[literal_i])
+            lp_bitset_set(state->kept,__lpg_graph_optimize_slot(state,graph->__literals[literal_i]));
+
+    // Outputs are pushed in reverse, so nodes of the first one come first
+    lp_vector_t *stack = lp_vector_create(0,sizeof(lpg_node_t*));
+    for(size_t out_i = graph->outputs_size; out_i-- > 0;)
+    {
+        lpg_node_t *output = graph->outputs[out_i];
+        affirmf(output,"Output %zd of graph is not assigned",out_i);
+
+        lp_bitset_set(state->is_output,__lpg_graph_optimize_slot(state,output));
+        lp_vector_push_back(stack,&output);
+    }
+
+    while(!lp_vector_empty(stack))
+    {
+        lpg_node_t *node = lp_vector_back_type(stack,lpg_node_t*);
+        size_t slot = __lpg_graph_optimize_slot(state,node);
+        if(lp_bitset_test(state->kept,slot))
+        {
+            lp_vector_pop_back(stack);
+            continue;
+        }
+
+        bool parents_ordered = true;
+        lpg_node_t **parents = lpg_node_parents(node);
+        size_t parents_num = lpg_node_get_parents_num(node);
+        for(size_t parent_i = 0; parent_i < parents_num; ++parent_i)
+        {
+            if(!lp_bitset_test(state->kept,__lpg_graph_optimize_slot(state,parents[parent_i])))
+            {
+                lp_vector_push_back(stack,&parents[parent_i]);
+                parents_ordered = false;
+            }
+        }
+
+        if(parents_ordered)
+        {
+            lp_bitset_set(state->kept,slot);
+            state->order[state->order_size++] = node;
+            lp_vector_pop_back(stack);
+        }
+    }
+
+    lp_vector_release(stack);
+}
+
+
+static void __lpg_graph_optimize_state_release(__lpg_graph_optimize_state_t *state)
+{
+    free(state->order);
+    lp_bitset_release(state->kept);
+    lp_bitset_release(state->is_output);
+}
+
+
+typedef struct __lpg_graph_optimize_sweep_args
+{
+    const __lpg_graph_optimize_state_t *state;
+    lp_vector_t *dead;
+} __lpg_graph_optimize_sweep_args_t;
+
+
+static void __lpg_graph_optimize_collect_dead_cb(void *entry_ptr, void *args)
+{
+    lpg_node_t *node = (lpg_node_t*)entry_ptr;
+    __lpg_graph_optimize_sweep_args_t *args_struct = (__lpg_graph_optimize_sweep_args_t*)args;
+
+    if(!lp_bitset_test(args_struct->state->kept,__lpg_graph_optimize_slot(args_struct->state,node)))
+        lp_vector_push_back(args_struct->dead,&node);
+}
+
+
+/**
+ * __lpg_graph_optimize_sweep - releases all nodes, which are not kept
+ * @state:      initialized state of graph
+ *
+ * Dead nodes are collected with a single pass over the slab, as releasing them while the slab is
+ * being iterated is not safe. A dead node is unlinked only from kept parents, since children of dead
+ * parents are released along with them.
+ *
+ * Return: Number of released nodes
+*/
+static size_t __lpg_graph_optimize_sweep(__lpg_graph_optimize_state_t *state)
+{
+    lpg_graph_t *graph = state->graph;
+
+    __lpg_graph_optimize_sweep_args_t args;
+    args.state = state;
+    args.dead = lp_vector_create(0,sizeof(lpg_node_t*));
+    lp_slab_exec(state->slab,__lpg_graph_optimize_collect_dead_cb,&args);
+
+    size_t dead_num = args.dead->size;
+    for(size_t dead_i = 0; dead_i < dead_num; ++dead_i)
+    {
+        lpg_node_t *node = lp_vector_at_type(args.dead,dead_i,lpg_node_t*);
+
+        lpg_node_t **parents = lpg_node_parents(node);
+        size_t parents_num = lpg_node_get_parents_num(node);
+        for(size_t parent_i = 0; parent_i < parents_num; ++parent_i)
+        {
+            lpg_node_t *parent = parents[parent_i];
+            if(!lp_bitset_test(state->kept,__lpg_graph_optimize_slot(state,parent)))
+                continue;
+
+            size_t parent_children_num = lpg_node_get_children_num(parent);
+            size_t child_i = 0;
+            for(; child_i < parent_children_num; ++child_i)
+                if(lp_vector_at_type(parent->children,child_i,lpg_node_t*) == node)
+                    break;
+
+            affirmf_debug(child_i < parent_children_num,
+                "Failed to find dead node inside its parent children vector");
+
+            lp_vector_remove_i(parent->children,child_i);
+        }
+
+        if(graph->__strash)
+            __lpg_graph_strash_remove(graph,node);
+
+        __lpg_node_release_internals(node);
+        lp_slab_free(state->slab,node);
+    }
+
+    lp_vector_release(args.dead);
+
+    return dead_num;
+}
+
+
+/**
+ * __lpg_graph_optimize_replace - redirects children and outputs of node to its equivalent
+ * @state:          state of graph
+ * @node:           node to replace
+ * @replacement:    node computing the same function as @node
+ *
+ * @node is left without children and outputs, so it is released with the following sweep unless
+ * it is an input or literal. Children are rehashed if structural hashing is enabled for the graph.
+ *
+ * Return: None
+*/
+static void __lpg_graph_optimize_replace(__lpg_graph_optimize_state_t *state, lpg_node_t *node, lpg_node_t *replacement)
+{
+    lpg_graph_t *graph = state->graph;
+
+    size_t children_num = lpg_node_get_children_num(node);
+    for(size_t child_i = 0; child_i < children_num; ++child_i)
+    {
+        lpg_node_t *child = lp_vector_at_type(node->children,child_i,lpg_node_t*);
+
+        if(graph->__strash)
+            __lpg_graph_strash_remove(graph,child);
+
+        lpg_node_t **parents = lpg_node_parents(child);
+        size_t parents_num = lpg_node_get_parents_num(child);
+        for(size_t parent_i = 0; parent_i < parents_num; ++parent_i)
+        {
+            if(parents[parent_i] != node)
+                continue;
+
+            parents[parent_i] = replacement;
+            lp_vector_push_back(replacement->children,&child);
+        }
+
+        if(graph->__strash)
+            __lpg_graph_strash_insert(graph,child);
+    }
+    lp_vector_clear(node->children);
+
+    // Replacement takes over the entry of @node, if it had one, so it is found by constructors
+    if(graph->__strash)
+    {
+        __lpg_graph_strash_remove(graph,node);
+        __lpg_graph_strash_insert(graph,replacement);
+    }
+
+    if(!lp_bitset_test(state->is_output,__lpg_graph_optimize_slot(state,node)))
+        return;
+
+    for(size_t out_i = 0; out_i < graph->outputs_size; ++out_i)
+        if(graph->outputs[out_i] == node)
+            graph->outputs[out_i] = replacement;
+
+    lp_bitset_set(state->is_output,__lpg_graph_optimize_slot(state,replacement));
+}
+
+
+/**
+ * __lpg_graph_optimize_rewrite - runs rewriting pass over graph
+ * @graph:      super-graph object
+ * @rewrite:    rewriting rule of the pass
+ * @args:       arguments of @rewrite
+ *
+ * Reachable nodes are rewritten in topological order, then nodes left unreachable are released with
+ * a single sweep. Nodes, which had been dead before the pass, are released as well, but are not counted.
+ *
+ * Return: Number of nodes removed by the pass
+*/
+static size_t __lpg_graph_optimize_rewrite(lpg_graph_t *graph, __lpg_graph_rewrite_cb_t rewrite, void *args)
+{
+    __lpg_graph_optimize_state_t state;
+    __lpg_graph_optimize_state_init(&state,graph);
+
+    size_t dead_before = __lpg_graph_optimize_used_entries(state.slab)-lp_bitset_count(state.kept);
+    for(size_t node_i = 0; node_i < state.order_size; ++node_i)
+    {
+        lpg_node_t *node = state.order[node_i];
+        lpg_node_t *replacement = rewrite(graph,node,args);
+        if(replacement && replacement != node)
+            __lpg_graph_optimize_replace(&state,node,replacement);
+    }
+    __lpg_graph_optimize_state_release(&state);
+
+    __lpg_graph_optimize_state_init(&state,graph);
+    size_t released = __lpg_graph_optimize_sweep(&state);
+    __lpg_graph_optimize_state_release(&state);
+
+    return released-dead_before;
+}
+
+
+/**
+ * lpg_graph_sweep - releases nodes, which can't be reached from outputs of graph
+ * @graph:      super-graph object
+ *
+ * Unlike 'lpg_graph_release_node', which releases nodes one by one, unreachable nodes are
+ * found with a single traversal from outputs and released with a single pass over the slab,
+ * regardless of whether they have children. Inputs and literals are never released.
+ *
+ * Return: Number of released nodes
+*/
+size_t lpg_graph_sweep(lpg_graph_t *graph)
+{
+    __lpg_graph_optimize_state_t state;
+    __lpg_graph_optimize_state_init(&state,graph);
+    size_t released = __lpg_graph_optimize_sweep(&state);
+    __lpg_graph_optimize_state_release(&state);
+
+    return released;
+}
+
+
+static lpg_node_t *__lpg_graph_propagate_constants_rewrite(lpg_graph_t *graph, lpg_node_t *node, void *args)
+{
+    // Placeholder constants may be reassigned later, so only literals are folded
+    if(node->type == LPG_NODE_TYPE_CONST)
+        return NULL;
+
+    lpg_node_t **parents = lpg_node_parents(node);
+    lpg_node_t *b = lpg_node_get_parents_num(node) > 1 ? parents[1] : NULL;
+    bool has_literal = __lpg_node_is_literal(graph,parents[0],false) || __lpg_node_is_literal(graph,parents[0],true) ||
+                       (b && (__lpg_node_is_literal(graph,b,false) || __lpg_node_is_literal(graph,b,true)));
+
+    return has_literal ? __lpg_node_fold(graph,node->type,parents[0],b) : NULL;
+}
+
+
+/**
+ * lpg_graph_propagate_constants - propagates literals through graph
+ * @graph:      super-graph object
+ *
+ * Gates over literals of @graph are folded the same way node constructors fold them, see 'lpg_node_literal',
+ * so literals propagate down to outputs in a single pass. Placeholder constants, e.g. ones created with
+ * 'lpg_uint_update_from_hex_str', are left as is, so their values may still be changed afterwards.
+ * Use 'lpg_graph_freeze_constants' first to fold them as well.
+ *
+ * Return: Number of nodes removed by the pass
+*/
+size_t lpg_graph_propagate_constants(lpg_graph_t *graph)
+{
+    return __lpg_graph_optimize_rewrite(graph,__lpg_graph_propagate_constants_rewrite,NULL);
+}
+
+
+static lpg_node_t *__lpg_graph_freeze_constants_rewrite(lpg_graph_t *graph, lpg_node_t *node, void *args)
+{
+    // Inputs and literals are never rewritten, so the node is a placeholder constant
+    return node->type == LPG_NODE_TYPE_CONST ? lpg_node_literal(graph,lpg_node_value(node)) : NULL;
+}
+
+
+/**
+ * lpg_graph_freeze_constants - replaces placeholder constants with literals
+ * @graph:      super-graph object
+ *
+ * Placeholder constants reachable from outputs are assumed to hold their final values, so their children
+ * and outputs are redirected to literals of @graph and the placeholders are released. The pass is never
+ * run by the default pipeline of 'lpg_graph_optimize', since values of placeholders can't be changed
+ * once they are frozen. Run 'lpg_graph_propagate_constants' afterwards to fold gates over them.
+ *
+ * Return: Number of nodes removed by the pass
+*/
+size_t lpg_graph_freeze_constants(lpg_graph_t *graph)
+{
+    return __lpg_graph_optimize_rewrite(graph,__lpg_graph_freeze_constants_rewrite,NULL);
+}
+
+
+static lpg_node_t *__lpg_graph_remove_double_negations_rewrite(lpg_graph_t *graph, lpg_node_t *node, void *args)
+{
+    if(node->type != LPG_NODE_TYPE_NOT)
+        return NULL;
+
+    lpg_node_t *parent = lpg_node_parents(node)[0];
+    return parent->type == LPG_NODE_TYPE_NOT ? lpg_node_parents(parent)[0] : NULL;
+}
+
+
+/**
+ * lpg_graph_remove_double_negations - replaces double negations with their operands
+ * @graph:      super-graph object
+ *
+ * 'lpg_node_not' never builds double negations, but they may appear once other passes rewire negations,
+ * e.g. when constant propagation drops conjunction with true between two of them.
+ *
+ * Return: Number of nodes removed by the pass
+*/
+size_t lpg_graph_remove_double_negations(lpg_graph_t *graph)
+{
+    return __lpg_graph_optimize_rewrite(graph,__lpg_graph_remove_double_negations_rewrite,NULL);
+}
+
+
+static lpg_node_t *__lpg_graph_dedup_rewrite(lpg_graph_t *graph, lpg_node_t *node, void *args)
+{
+    // Placeholder constants are never shared, see 'lpg_graph_enable_strash'
+    if(node->type == LPG_NODE_TYPE_CONST)
+        return NULL;
+
+    lpg_node_t **parents = lpg_node_parents(node);
+    lpg_node_t *b = lpg_node_get_parents_num(node) > 1 ? parents[1] : NULL;
+    lpg_node_t *folded = __lpg_node_fold(graph,node->type,parents[0],b);
+    if(folded)
+        return folded;
+
+    return __lpg_graph_strash_table_insert((lp_htable_t*)args,node);
+}
+
+
+/**
+ * lpg_graph_dedup - merges structurally identical nodes of graph
+ * @graph:      super-graph object
+ *
+ * Nodes are hashed by their types and operands in topological order, so once operands of two nodes are
+ * merged, the nodes themselves are merged as well and whole duplicated subgraphs collapse in a single pass.
+ * Gates, operands of which become identical or complementary after merging, are folded, see 'lpg_node_literal'.
+ *
+ * This catches sharing missed during assembly, e.g. when structural hashing was not enabled, see
+ * 'lpg_graph_enable_strash', or when subexpressions became identical only after other passes.
+ *
+ * Return: Number of nodes removed by the pass
+*/
+size_t lpg_graph_dedup(lpg_graph_t *graph)
+{
+    affirm_nullptr(graph,"graph");
+
+    lp_htable_t *table = __lpg_graph_strash_table_create(__lpg_graph_optimize_used_entries(__lpg_graph_slab(graph)));
+    size_t removed = __lpg_graph_optimize_rewrite(graph,__lpg_graph_dedup_rewrite,table);
+    lp_htable_release(table);
+
+    return removed;
+}
+
+
+static size_t __lpg_graph_optimize_run_pass(lpg_graph_t *graph, lpg_graph_pass_t pass)
+{
+    switch(pass)
+    {
+        case LPG_GRAPH_PASS_SWEEP:              return lpg_graph_sweep(graph);
+        case LPG_GRAPH_PASS_CONST_PROP:         return lpg_graph_propagate_constants(graph);
+        case LPG_GRAPH_PASS_DOUBLE_NEGATION:    return lpg_graph_remove_double_negations(graph);
+        case LPG_GRAPH_PASS_DEDUP:              return lpg_graph_dedup(graph);
+        case LPG_GRAPH_PASS_FREEZE_CONSTANTS:   return lpg_graph_freeze_constants(graph);
+        default:
+            errorf("Unknown optimization pass: %d",pass);
+    }
+}
+
+
+/**
+ * lpg_graph_optimize - runs pipeline of optimization passes over graph
+ * @graph:          super-graph object
+ * @passes:         passes to run in the given order or NULL for the default pipeline
+ * @passes_num:     number of passes inside @passes, ignored if @passes is NULL
+ * @removed:        array of LPG_GRAPH_PASSES_NUM counters indexed by pass, which is filled with numbers of
+ *                  nodes removed by each pass, or NULL
+ *
+ * The default pipeline sweeps dead nodes, propagates literals, removes double negations and merges duplicates,
+ * repeating the passes until none of them removes anything, as every pass may expose work for the others.
+ * Placeholder constants are kept by the default pipeline, list LPG_GRAPH_PASS_FREEZE_CONSTANTS in @passes
+ * to fold them as well.
+ * The same pass may occur in @passes several times, then its counter accumulates all of its runs.
+ *
+ * Optimization keeps function of every output, but not identity of nodes: outputs may be redirected to other
+ * nodes, including inputs and literals, and any node, which is neither input nor literal, may be released,
+ * so pointers to nodes held outside of @graph, e.g. in uint objects, must not be used afterwards. The pipeline
+ * is meant to be run once the graph is assembled, before it is converted into inference graph.
+ *
+ * Return: Total number of removed nodes
+*/
+size_t lpg_graph_optimize(lpg_graph_t *graph, const lpg_graph_pass_t *passes, size_t passes_num, size_t *removed)
+{
+    affirm_nullptr(graph,"graph");
+
+    size_t pass_removed[LPG_GRAPH_PASSES_NUM] = {0};
+    size_t total_removed = 0;
+    if(passes)
+    {
+        for(size_t pass_i = 0; pass_i < passes_num; ++pass_i)
+        {
+            affirmf(passes[pass_i] < LPG_GRAPH_PASSES_NUM,"Unknown optimization pass: %d",passes[pass_i]);
+
+            size_t curr_removed = __lpg_graph_optimize_run_pass(graph,passes[pass_i]);
+            pass_removed[passes[pass_i]] += curr_removed;
+            total_removed += curr_removed;
+        }
+    }
+    else
+    {
+        static const lpg_graph_pass_t default_passes[] = {
+            LPG_GRAPH_PASS_SWEEP,
+            LPG_GRAPH_PASS_CONST_PROP,
+            LPG_GRAPH_PASS_DOUBLE_NEGATION,
+            LPG_GRAPH_PASS_DEDUP
+        };
+
+        size_t round_removed;
+        do
+        {
+            round_removed = 0;
+            for(size_t pass_i = 0; pass_i < sizeof(default_passes)/sizeof(default_passes[0]); ++pass_i)
+            {
+                size_t curr_removed = __lpg_graph_optimize_run_pass(graph,default_passes[pass_i]);
+                pass_removed[default_passes[pass_i]] += curr_removed;
+                round_removed += curr_removed;
+            }
+            total_removed += round_removed;
+        } while(round_removed > 0);
+    }
+
+    if(removed)
+        for(uint32_t pass = 0; pass < LPG_GRAPH_PASSES_NUM; ++pass)
+            removed[pass] = pass_removed[pass];
+
+    return total_removed;
+}
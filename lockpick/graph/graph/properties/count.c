@@ -88,3 +88,30 @@ size_t lpg_graph_nodes_count(lpg_graph_t *graph)
 
     return count;
 }
+
+
+static void __lpg_frozen_graph_nodes_count_cb(const lpg_frozen_graph_t *frozen, lpg_frozen_index_t slot, bool is_input, void *args)
+{
+    size_t *count = args;
+    ++(*count);
+}
+
+
+/**
+ * lpg_frozen_graph_nodes_count - counts nodes of frozen graph
+ * @frozen:     pointer to the frozen graph object
+ * 
+ * Counterpart of 'lpg_graph_nodes_count' for frozen graphs: counts nodes reachable from outputs
+ * including the input nodes where the traversal terminates, see 'lpg_frozen_graph_traverse_once'.
+ * 
+ * Return: total number of nodes in the graph.
+*/
+size_t lpg_frozen_graph_nodes_count(const lpg_frozen_graph_t *frozen)
+{
+    affirm_nullptr(frozen,"frozen graph");
+
+    size_t count = 0;
+    lpg_frozen_graph_traverse_once(frozen,__lpg_frozen_graph_nodes_count_cb,&count);
+
+    return count;
+}
@@ -30,7 +30,7 @@ static inline void __lpg_graph_count_dangling_slab_callback(void *entry_ptr, voi
  * @graph:      pointer to the graph object
  * 
  * Efficiently counts number of nodes that do not have children
- * and are neither input nor output nodes. Such nodes can't be reached
+ * and are neither input, output nor literal nodes. Such nodes can't be reached
  * by traversal algorithms and may be considered lost.
  * 
  * Function intended to track ill-formation of graphs, which contain
@@ -58,6 +58,10 @@ size_t lpg_graph_count_dangling_nodes(lpg_graph_t *graph)
     for(size_t out_node_i = 0; out_node_i < graph->outputs_size; ++out_node_i)
         lp_htable_insert(dangling_black_list,&graph->outputs[out_node_i]);
 
+    for(uint32_t literal_i = 0; literal_i < 2; ++literal_i)
+        if(graph->__literals[literal_i])
+            lp_htable_insert(dangling_black_list,&graph->__literals[literal_i]);
+
     __lpg_dangling_slab_callback_args_t args;
     args.counter = 0;
     args.dangling_black_list = dangling_black_list;
@@ -68,4 +72,35 @@ size_t lpg_graph_count_dangling_nodes(lpg_graph_t *graph)
     lp_htable_release(dangling_black_list);
 
     return args.counter;
-}
\ No newline at end of file
+}
+
+
+/**
+ * lpg_frozen_graph_count_dangling_nodes - counts dangling nodes in a frozen graph
+ * @frozen:     pointer to the frozen graph object
+ * 
+ * Counterpart of 'lpg_graph_count_dangling_nodes' for frozen graphs. Numbers of children and
+ * flags of inputs and outputs are indexed by slot, so the count is a single linear scan
+ * over the slots without any hash tables.
+ * 
+ * Return: number of dangling nodes
+*/
+size_t lpg_frozen_graph_count_dangling_nodes(const lpg_frozen_graph_t *frozen)
+{
+    affirm_nullptr(frozen,"frozen graph");
+
+    size_t counter = 0;
+    for(size_t slot = 0; slot < frozen->slots_num; ++slot)
+    {
+        if(frozen->types[slot] == LPG_FROZEN_SLOT_FREE || frozen->children_offsets[slot+1] != frozen->children_offsets[slot])
+            continue;
+
+        if(lp_bitset_test(frozen->is_input,slot) || lp_bitset_test(frozen->is_output,slot) ||
+           slot == frozen->literals[false] || slot == frozen->literals[true])
+            continue;
+
+        ++counter;
+    }
+
+    return counter;
+}
@@ -0,0 +1,248 @@
+#include <lockpick/graph/graph.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/htable.h>
+
+
+/**
+ * lpg_graph_strash_entry - entry of structural hash table
+ * @parents:    operands of the node ordered by address, second one is NULL for unary nodes
+ * @type:       type of the node
+ * @node:       node computing @type over @parents
+*/
+typedef struct lpg_graph_strash_entry
+{
+    lpg_node_t *parents[2];
+    lpg_node_type_t type;
+    lpg_node_t *node;
+} lpg_graph_strash_entry_t;
+
+
+static inline size_t __lpg_graph_strash_mix(size_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+
+/**
+ * __lpg_graph_strash_hsh - hash function of structural hash table entries
+ * @entry:      pointer to entry
+ *
+ * Node addresses are aligned and allocated from a contiguous slab, so they are mixed
+ * thoroughly for the low bits of the hash to be distributed uniformly.
+ *
+ * Return: Hash of @type and @parents of @entry
+*/
+static size_t __lpg_graph_strash_hsh(const lpg_graph_strash_entry_t *entry)
+{
+    size_t h = __lpg_graph_strash_mix((size_t)entry->parents[0] ^ (size_t)entry->type);
+    return __lpg_graph_strash_mix(h ^ (size_t)entry->parents[1]);
+}
+
+
+static bool __lpg_graph_strash_eq(const lpg_graph_strash_entry_t *a, const lpg_graph_strash_entry_t *b)
+{
+    return a->type == b->type && a->parents[0] == b->parents[0] && a->parents[1] == b->parents[1];
+}
+
+
+/**
+ * __lpg_graph_strash_key - fills key of structural hash table entry
+ * @entry:      entry to fill
+ * @type:       type of the node
+ * @a:          first operand
+ * @b:          second operand or NULL for unary nodes
+ *
+ * All binary operations are commutative, so operands are ordered by address and
+ * 'op(a,b)' shares the entry with 'op(b,a)'.
+ *
+ * Return: None
+*/
+static inline void __lpg_graph_strash_key(lpg_graph_strash_entry_t *entry, lpg_node_type_t type, lpg_node_t *a, lpg_node_t *b)
+{
+    entry->type = type;
+    if(b && b < a)
+    {
+        entry->parents[0] = b;
+        entry->parents[1] = a;
+    }
+    else
+    {
+        entry->parents[0] = a;
+        entry->parents[1] = b;
+    }
+    entry->node = NULL;
+}
+
+
+static inline bool __lpg_graph_strash_is_hashable(const lpg_node_t *node)
+{
+    return node->type != LPG_NODE_TYPE_CONST;
+}
+
+
+static inline void __lpg_graph_strash_node_key(lpg_graph_strash_entry_t *entry, lpg_node_t *node)
+{
+    lpg_node_t **parents = lpg_node_parents(node);
+    lpg_node_t *b = lpg_node_get_parents_num(node) > 1 ? parents[1] : NULL;
+    __lpg_graph_strash_key(entry,node->type,parents[0],b);
+    entry->node = node;
+}
+
+
+/**
+ * __lpg_graph_strash_table_create - creates empty structural hash table
+ * @nodes_num:  expected number of hashed nodes
+ *
+ * Return: Hash table of structural entries, which must be released with 'lp_htable_release'
+*/
+lp_htable_t *__lpg_graph_strash_table_create(size_t nodes_num)
+{
+    return lp_htable_create_el_num(
+            MAX(1,nodes_num),
+            sizeof(lpg_graph_strash_entry_t),
+            lp_htable_cast_hsh(__lpg_graph_strash_hsh),
+            lp_htable_cast_eq(__lpg_graph_strash_eq));
+}
+
+
+/**
+ * __lpg_graph_strash_table_insert - inserts node into structural hash table unless it has a twin
+ * @table:      table created with '__lpg_graph_strash_table_create'
+ * @node:       non-constant node to insert
+ *
+ * Return: Node of the same structure already present in @table or @node itself if there was none
+*/
+lpg_node_t *__lpg_graph_strash_table_insert(lp_htable_t *table, lpg_node_t *node)
+{
+    lpg_graph_strash_entry_t entry;
+    __lpg_graph_strash_node_key(&entry,node);
+
+    lpg_graph_strash_entry_t found;
+    if(lp_htable_find(table,&entry,&found))
+        return found.node;
+
+    lp_htable_insert(table,&entry);
+    return node;
+}
+
+
+static void __lpg_graph_strash_insert_callback(void *entry_ptr, void *args)
+{
+    lpg_node_t *node = (lpg_node_t*)entry_ptr;
+    if(!__lpg_graph_strash_is_hashable(node))
+        return;
+
+    lpg_graph_strash_entry_t entry;
+    __lpg_graph_strash_node_key(&entry,node);
+    lp_htable_insert((lp_htable_t*)args,&entry);
+}
+
+
+/**
+ * lpg_graph_enable_strash - enables structural hashing of nodes created in graph
+ * @graph:      super-graph object
+ *
+ * Once enabled, 'lpg_node_and', 'lpg_node_or', 'lpg_node_xor' and 'lpg_node_not' look up a node of
+ * the same type over the same operands before allocating a new one and return the existing node
+ * if there is any. Operands of binary nodes are unordered, so 'lpg_node_and(graph,a,b)' and
+ * 'lpg_node_and(graph,b,a)' yield the same node. Repeated subexpressions, e.g. shared partial
+ * products of Karatsuba multiplication, are thus built once, which shrinks the graph itself and
+ * everything derived from it: sorted and inference graphs, kernels and uploaded buffers.
+ *
+ * Nodes already allocated in @graph are hashed as well, so the table may be enabled at any moment.
+ * Constant nodes are never shared: input nodes are constants, values of which are updated in place.
+ *
+ * With structural hashing enabled, a node returned by a constructor may already have children
+ * and serve as an output, so the caller must not assume it is fresh, e.g. when releasing it
+ * with 'lpg_graph_release_node'. Enabling is idempotent. The table is released with @graph.
+ *
+ * Return: None
+*/
+void lpg_graph_enable_strash(lpg_graph_t *graph)
+{
+    affirm_nullptr(graph,"graph");
+    affirmf(lpg_graph_is_super(graph),"Structural hashing can be enabled only for super-graphs");
+
+    if(graph->__strash)
+        return;
+
+    lp_slab_t *slab = __lpg_graph_slab(graph);
+    graph->__strash = __lpg_graph_strash_table_create(slab->__total_entries-slab->__total_free);
+
+    lp_slab_exec(slab,__lpg_graph_strash_insert_callback,graph->__strash);
+}
+
+
+/**
+ * lpg_graph_is_strash_enabled - checks if structural hashing is enabled for graph
+ * @graph:      graph object
+ *
+ * Return: True if nodes of @graph are structurally hashed, see 'lpg_graph_enable_strash'
+*/
+bool lpg_graph_is_strash_enabled(const lpg_graph_t *graph)
+{
+    affirm_nullptr(graph,"graph");
+
+    return graph->__strash != NULL;
+}
+
+
+/**
+ * __lpg_graph_strash_find - finds structurally identical node
+ * @graph:      graph object with enabled structural hashing
+ * @type:       type of the node
+ * @a:          first operand
+ * @b:          second operand or NULL for unary nodes
+ *
+ * Return: Existing node computing @type over @a and @b or NULL if there is none
+*/
+lpg_node_t *__lpg_graph_strash_find(lpg_graph_t *graph, lpg_node_type_t type, lpg_node_t *a, lpg_node_t *b)
+{
+    lpg_graph_strash_entry_t entry;
+    __lpg_graph_strash_key(&entry,type,a,b);
+
+    if(!lp_htable_find(graph->__strash,&entry,&entry))
+        return NULL;
+
+    return entry.node;
+}
+
+
+void __lpg_graph_strash_insert(lpg_graph_t *graph, lpg_node_t *node)
+{
+    if(!__lpg_graph_strash_is_hashable(node))
+        return;
+
+    lpg_graph_strash_entry_t entry;
+    __lpg_graph_strash_node_key(&entry,node);
+    lp_htable_insert(graph->__strash,&entry);
+}
+
+
+/**
+ * __lpg_graph_strash_remove - removes node from structural hash table
+ * @graph:      graph object with enabled structural hashing
+ * @node:       node to remove, which must be still initialized
+ *
+ * Entry is removed only if it refers to @node itself rather than to another node of the same
+ * structure, which might have been allocated before hashing was enabled.
+ *
+ * Return: None
+*/
+void __lpg_graph_strash_remove(lpg_graph_t *graph, lpg_node_t *node)
+{
+    if(!__lpg_graph_strash_is_hashable(node))
+        return;
+
+    lpg_graph_strash_entry_t entry;
+    __lpg_graph_strash_node_key(&entry,node);
+
+    lpg_graph_strash_entry_t found;
+    if(lp_htable_find(graph->__strash,&entry,&found) && found.node == node)
+        lp_htable_remove(graph->__strash,&entry);
+}
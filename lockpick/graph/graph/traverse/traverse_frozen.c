@@ -0,0 +1,130 @@
+#include <lockpick/graph/traverse.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/bitset.h>
+#include <lockpick/define.h>
+#include <lockpick/vector.h>
+
+
+/**
+ * lpg_frozen_graph_traverse - DFS traversal of frozen graph from its output nodes
+ * @frozen:         frozen graph object
+ * @enter_cb:       callback on first reaching node
+ * @enter_cb_args:  optional enter callback arguments
+ * @leave_cb:       callback on leaving node after all its parents are left
+ * @leave_cb_args:  optional leave callback arguments
+ *
+ * Counterpart of 'lpg_graph_traverse' for frozen graphs: every node reachable from outputs is entered
+ * and left exactly once, traversal ends at constant and input nodes. Visited nodes are tracked with
+ * bitsets indexed by slot instead of hash tables, and parents are read from the contiguous
+ * adjacency arrays, so the traversal does not touch nodes of the underlying graph at all.
+ *
+ * Nodes are left in topological order. Callbacks pass frozen graph, slot, input flag and args.
+ *
+ * Return: None
+*/
+void lpg_frozen_graph_traverse(const lpg_frozen_graph_t *frozen, lpg_frozen_traverse_cb_t enter_cb, void *enter_cb_args, lpg_frozen_traverse_cb_t leave_cb, void *leave_cb_args)
+{
+    affirm_nullptr(frozen,"frozen graph");
+    affirmf(enter_cb || leave_cb,"Either leave or enter callback must be specified");
+
+    lp_bitset_t *entered = lp_bitset_create(MAX(1,frozen->slots_num));
+    lp_bitset_t *left = lp_bitset_create(MAX(1,frozen->slots_num));
+    lp_vector_t *stack = lp_vector_create(0,sizeof(lpg_frozen_index_t));
+
+    // Outputs are pushed in reverse, so nodes of the first one are entered first
+    for(size_t out_i = frozen->outputs_size; out_i-- > 0;)
+    {
+        lpg_frozen_index_t out_slot = frozen->outputs[out_i];
+        lp_vector_push_back(stack,&out_slot);
+    }
+
+    while(!lp_vector_empty(stack))
+    {
+        lpg_frozen_index_t slot = lp_vector_back_type(stack,lpg_frozen_index_t);
+        lp_vector_pop_back(stack);
+
+        bool is_input = lp_bitset_test(frozen->is_input,slot);
+        if(!lp_bitset_test(entered,slot))
+        {
+            lp_bitset_set(entered,slot);
+            // Node is left once it surfaces again, i.e. after all of its parents
+            lp_vector_push_back(stack,&slot);
+
+            if(enter_cb)
+                enter_cb(frozen,slot,is_input,enter_cb_args);
+
+            if(is_input)
+                continue;
+
+            for(lpg_frozen_index_t parent_i = frozen->parents_offsets[slot]; parent_i < frozen->parents_offsets[slot+1]; ++parent_i)
+            {
+                lpg_frozen_index_t parent = frozen->parents[parent_i];
+                if(!lp_bitset_test(entered,parent))
+                    lp_vector_push_back(stack,&parent);
+            }
+        }
+        else if(!lp_bitset_test(left,slot))
+        {
+            lp_bitset_set(left,slot);
+
+            if(leave_cb)
+                leave_cb(frozen,slot,is_input,leave_cb_args);
+        }
+    }
+
+    lp_bitset_release(entered);
+    lp_bitset_release(left);
+    lp_vector_release(stack);
+}
+
+
+/**
+ * lpg_frozen_graph_traverse_once - DFS traversal of frozen graph from its output nodes without revisiting nodes
+ * @frozen:         frozen graph object
+ * @cb:             node visit callback
+ * @cb_args:        optional node visit callback args
+ *
+ * Counterpart of 'lpg_graph_traverse_once' for frozen graphs, see 'lpg_frozen_graph_traverse'.
+ *
+ * Return: None
+*/
+void lpg_frozen_graph_traverse_once(const lpg_frozen_graph_t *frozen, lpg_frozen_traverse_cb_t cb, void *cb_args)
+{
+    affirm_nullptr(frozen,"frozen graph");
+    affirmf(cb,"Node visit callback must be specified");
+
+    lp_bitset_t *visited = lp_bitset_create(MAX(1,frozen->slots_num));
+    lp_vector_t *stack = lp_vector_create(0,sizeof(lpg_frozen_index_t));
+
+    for(size_t out_i = frozen->outputs_size; out_i-- > 0;)
+    {
+        lpg_frozen_index_t out_slot = frozen->outputs[out_i];
+        lp_vector_push_back(stack,&out_slot);
+    }
+
+    while(!lp_vector_empty(stack))
+    {
+        lpg_frozen_index_t slot = lp_vector_back_type(stack,lpg_frozen_index_t);
+        lp_vector_pop_back(stack);
+
+        if(lp_bitset_test(visited,slot))
+            continue;
+        lp_bitset_set(visited,slot);
+
+        bool is_input = lp_bitset_test(frozen->is_input,slot);
+        cb(frozen,slot,is_input,cb_args);
+
+        if(is_input)
+            continue;
+
+        for(lpg_frozen_index_t parent_i = frozen->parents_offsets[slot]; parent_i < frozen->parents_offsets[slot+1]; ++parent_i)
+        {
+            lpg_frozen_index_t parent = frozen->parents[parent_i];
+            if(!lp_bitset_test(visited,parent))
+                lp_vector_push_back(stack,&parent);
+        }
+    }
+
+    lp_bitset_release(visited);
+    lp_vector_release(stack);
+}
@@ -1,5 +1,6 @@
 #include <lockpick/graph/tsort.h>
 #include <lockpick/affirmf.h>
+#include <lockpick/define.h>
 #include <lockpick/math.h>
 
 
@@ -24,3 +25,115 @@ void __lpg_tsort_init_state_cb(lpg_graph_t *graph, lpg_node_t *node, bool is_inp
         ++init_state->const_nodes_count;
     }
 }
+
+
+typedef struct __lpg_graph_post_order_entry
+{
+    lpg_node_t *node;
+    bool expanded;
+} __lpg_graph_post_order_entry_t;
+
+
+/**
+ * __lpg_graph_collect_post_order - collects nodes reachable from outputs of the graph in DFS post-order
+ * @graph:          graph object
+ * @inputs:         bitset of slab slots occupied by input nodes of @graph
+ * @visited:        bitset of slab slots, where collected nodes are marked
+ * @nodes_num:      resulting number of collected nodes
+ *
+ * Performs a DFS from output nodes of @graph in their order, which, like 'lpg_graph_traverse_once', stops
+ * at constant and input nodes. Every node is collected right after all its parents are, first parent first,
+ * so the result is topologically sorted and every gate directly follows the last unvisited subtree of its
+ * operands. Nodes already marked inside @visited are neither collected nor expanded.
+ *
+ * Visited nodes are marked by their slab slots, so no hashing is involved.
+ *
+ * Return: Allocated array of collected nodes, which must be freed by the caller
+*/
+lpg_node_t **__lpg_graph_collect_post_order(lpg_graph_t *graph, const lp_bitset_t *inputs, lp_bitset_t *visited, size_t *nodes_num)
+{
+    affirm_nullptr(graph,"graph");
+    affirm_nullptr(inputs,"inputs bitset");
+    affirm_nullptr(visited,"visited bitset");
+    affirm_nullptr(nodes_num,"nodes number");
+
+    lp_slab_t *slab = __lpg_graph_slab(graph);
+
+    size_t stack_capacity = MAX(1,graph->outputs_size);
+    size_t stack_size = 0;
+    __lpg_graph_post_order_entry_t *stack = (__lpg_graph_post_order_entry_t*)malloc(stack_capacity*sizeof(__lpg_graph_post_order_entry_t));
+    affirm_bad_malloc(stack,"post-order stack",stack_capacity*sizeof(__lpg_graph_post_order_entry_t));
+
+    size_t collected_capacity = MAX(1,graph->inputs_size+graph->outputs_size);
+    size_t collected_size = 0;
+    lpg_node_t **collected = (lpg_node_t**)malloc(collected_capacity*sizeof(lpg_node_t*));
+    affirm_bad_malloc(collected,"collected nodes array",collected_capacity*sizeof(lpg_node_t*));
+
+    for(size_t out_node_i = 0; out_node_i < graph->outputs_size; ++out_node_i)
+    {
+        lpg_node_t *out_node = graph->outputs[out_node_i];
+        affirmf(out_node,"Attempt to process null graph output at index %zd. "
+                         "Was graph assembled properly?",out_node_i);
+
+        stack[stack_size].node = out_node;
+        stack[stack_size].expanded = false;
+        ++stack_size;
+
+        while(stack_size > 0)
+        {
+            __lpg_graph_post_order_entry_t *top = &stack[stack_size-1];
+            lpg_node_t *node = top->node;
+            size_t slot = lp_slab_index(slab,node);
+
+            // Node may have been pushed by several children before being collected
+            if(lp_bitset_test(visited,slot))
+            {
+                --stack_size;
+                continue;
+            }
+
+            size_t parents_num = lp_bitset_test(inputs,slot) ? 0 : lpg_node_get_parents_num(node);
+            if(top->expanded || parents_num == 0)
+            {
+                --stack_size;
+
+                if(collected_size == collected_capacity)
+                {
+                    collected_capacity *= 2;
+                    collected = (lpg_node_t**)realloc(collected,collected_capacity*sizeof(lpg_node_t*));
+                    affirm_bad_malloc(collected,"collected nodes array realloc",collected_capacity*sizeof(lpg_node_t*));
+                }
+
+                lp_bitset_set(visited,slot);
+                collected[collected_size++] = node;
+                continue;
+            }
+            top->expanded = true;
+
+            if(stack_size+parents_num > stack_capacity)
+            {
+                stack_capacity = 2*(stack_size+parents_num);
+                stack = (__lpg_graph_post_order_entry_t*)realloc(stack,stack_capacity*sizeof(__lpg_graph_post_order_entry_t));
+                affirm_bad_malloc(stack,"post-order stack realloc",stack_capacity*sizeof(__lpg_graph_post_order_entry_t));
+            }
+
+            // Parents are pushed in reverse, so the first parent is collected first
+            lpg_node_t **parents = lpg_node_parents(node);
+            for(size_t parent_i = parents_num; parent_i > 0; --parent_i)
+            {
+                lpg_node_t *parent = parents[parent_i-1];
+                if(lp_bitset_test(visited,lp_slab_index(slab,parent)))
+                    continue;
+
+                stack[stack_size].node = parent;
+                stack[stack_size].expanded = false;
+                ++stack_size;
+            }
+        }
+    }
+
+    free(stack);
+
+    *nodes_num = collected_size;
+    return collected;
+}
@@ -0,0 +1,171 @@
+#include <lockpick/graph/tsort.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/bitset.h>
+#include <lockpick/define.h>
+#include <malloc.h>
+#include <string.h>
+
+
+/**
+ * __lpg_graph_tsort_levels - sorts nodes reachable from outputs by levels
+ * @graph:              pointer to graph object
+ * @keep_post_order:    whether nodes beyond zero level should be kept in post-order as a single level
+ * @levels:             resulting sorted nodes and levels
+ *
+ * Nodes reachable from outputs are collected with a single DFS, see '__lpg_graph_collect_post_order'. Zero level
+ * consists of all input nodes in their order followed by reached constant nodes. Every other node belongs to
+ * the level right after the deepest level among its parents.
+ *
+ * Parents precede their children in post-order, so levels of all nodes are computed in a single linear pass
+ * over it, without counting parents of nodes or scanning their children. Nodes are then grouped by levels with
+ * a stable counting sort, so nodes within a level keep their post-order. If @keep_post_order is set, all nodes
+ * beyond zero level form a single level in post-order instead, see 'LPG_INFERENCE_ORDER_DFS'.
+ *
+ * Levels of nodes are kept in a flat array addressed by slab slots, since every node of the graph lives
+ * in its slab.
+ *
+ * Input nodes, which are not reachable from outputs, are still placed into zero level and are counted in
+ * @redundant_inputs_num of @levels.
+ *
+ * Return: None
+*/
+void __lpg_graph_tsort_levels(lpg_graph_t *graph, bool keep_post_order, __lpg_tsort_levels_t *levels)
+{
+    affirm_nullptr(graph,"graph");
+    affirm_nullptr(levels,"levels");
+
+    lp_slab_t *slab = __lpg_graph_slab(graph);
+    size_t slab_capacity = MAX(1,lp_slab_capacity(slab));
+    size_t inputs_size = graph->inputs_size;
+
+    lp_bitset_t *inputs = lp_bitset_create(slab_capacity);
+    for(size_t in_node_i = 0; in_node_i < inputs_size; ++in_node_i)
+        lp_bitset_set(inputs,lp_slab_index(slab,graph->inputs[in_node_i]));
+
+    lp_bitset_t *reached = lp_bitset_create(slab_capacity);
+
+    size_t post_order_num;
+    lpg_node_t **post_order = __lpg_graph_collect_post_order(graph,inputs,reached,&post_order_num);
+
+    size_t reached_inputs_num = 0;
+    for(size_t in_node_i = 0; in_node_i < inputs_size; ++in_node_i)
+        reached_inputs_num += lp_bitset_test(reached,lp_slab_index(slab,graph->inputs[in_node_i]));
+    levels->redundant_inputs_num = inputs_size-reached_inputs_num;
+    levels->nodes_num = post_order_num+levels->redundant_inputs_num;
+
+    uint32_t *node_levels = (uint32_t*)malloc(slab_capacity*sizeof(uint32_t));
+    affirm_bad_malloc(node_levels,"node levels array",slab_capacity*sizeof(uint32_t));
+
+    uint32_t max_level = 0;
+    for(size_t node_i = 0; node_i < post_order_num; ++node_i)
+    {
+        lpg_node_t *node = post_order[node_i];
+        size_t slot = lp_slab_index(slab,node);
+
+        uint32_t level = 0;
+        if(!lp_bitset_test(inputs,slot))
+        {
+            size_t parents_num = lpg_node_get_parents_num(node);
+            lpg_node_t **parents = lpg_node_parents(node);
+            for(size_t parent_i = 0; parent_i < parents_num; ++parent_i)
+                level = MAX(level,node_levels[lp_slab_index(slab,parents[parent_i])]+1);
+        }
+
+        if(keep_post_order)
+            level = MIN(level,1);
+
+        node_levels[slot] = level;
+        max_level = MAX(max_level,level);
+    }
+
+    // Every level is non-empty, since a node of each level has a parent in the previous one
+    levels->levels_num = levels->nodes_num > 0 ? max_level+1 : 0;
+    size_t level_offsets_size = (levels->levels_num+1)*sizeof(size_t);
+    levels->level_offsets = (size_t*)calloc(levels->levels_num+1,sizeof(size_t));
+    affirm_bad_malloc(levels->level_offsets,"level offsets array",level_offsets_size);
+
+    if(levels->levels_num > 0)
+        levels->level_offsets[1] = inputs_size;
+    for(size_t node_i = 0; node_i < post_order_num; ++node_i)
+    {
+        size_t slot = lp_slab_index(slab,post_order[node_i]);
+        if(!lp_bitset_test(inputs,slot))
+            ++levels->level_offsets[node_levels[slot]+1];
+    }
+    for(size_t level_i = 0; level_i < levels->levels_num; ++level_i)
+        levels->level_offsets[level_i+1] += levels->level_offsets[level_i];
+
+    affirmf_debug(levels->level_offsets[levels->levels_num] == levels->nodes_num,
+        "Number of sorted nodes %zd differs from number of nodes in graph %zd",
+        levels->level_offsets[levels->levels_num],levels->nodes_num);
+
+    size_t sorted_nodes_size = MAX(1,levels->nodes_num)*sizeof(lpg_node_t*);
+    lpg_node_t **sorted_nodes = (lpg_node_t**)malloc(sorted_nodes_size);
+    affirm_bad_malloc(sorted_nodes,"sorted nodes array",sorted_nodes_size);
+
+    // Inputs come first in their order, other nodes are placed with their levels' positions advancing
+    size_t *level_positions = (size_t*)malloc(MAX(1,levels->levels_num)*sizeof(size_t));
+    affirm_bad_malloc(level_positions,"level positions array",MAX(1,levels->levels_num)*sizeof(size_t));
+    memcpy(level_positions,levels->level_offsets,levels->levels_num*sizeof(size_t));
+
+    memcpy(sorted_nodes,graph->inputs,inputs_size*sizeof(lpg_node_t*));
+    if(levels->levels_num > 0)
+        level_positions[0] = inputs_size;
+    for(size_t node_i = 0; node_i < post_order_num; ++node_i)
+    {
+        lpg_node_t *node = post_order[node_i];
+        size_t slot = lp_slab_index(slab,node);
+        if(!lp_bitset_test(inputs,slot))
+            sorted_nodes[level_positions[node_levels[slot]]++] = node;
+    }
+
+    levels->sorted_nodes = sorted_nodes;
+
+    free(level_positions);
+    free(node_levels);
+    free(post_order);
+    lp_bitset_release(reached);
+    lp_bitset_release(inputs);
+}
+
+
+/**
+ * lpg_graph_tsort_levels - sorts graph's nodes in topological order grouped by levels
+ * @graph:          pointer to graph object
+ * @sorted_nodes:   pointer on array of sorted nodes
+ * @nodes_num:      resulting number of sorted nodes
+ * @node_levels:    optional pointer on array of levels of sorted nodes
+ *
+ * Nodes are sorted level by level: input and constant nodes form the zero level and every other node belongs
+ * to the level right after the deepest level among its parents, see '__lpg_graph_tsort_levels'. Unlike
+ * 'lpg_graph_tsort', only nodes reachable from outputs and input nodes are sorted.
+ *
+ * If @node_levels is not NULL, it is set to an allocated array with the level of every node within @sorted_nodes,
+ * which is non-decreasing. Both arrays must be freed by the caller.
+ *
+ * Return: None
+*/
+void lpg_graph_tsort_levels(lpg_graph_t *graph, lpg_node_t ***sorted_nodes, size_t *nodes_num, uint32_t **node_levels)
+{
+    affirm_nullptr(sorted_nodes,"sorted nodes array pointer");
+    affirm_nullptr(nodes_num,"nodes number");
+
+    __lpg_tsort_levels_t levels;
+    __lpg_graph_tsort_levels(graph,false,&levels);
+
+    if(node_levels)
+    {
+        size_t node_levels_size = MAX(1,levels.nodes_num)*sizeof(uint32_t);
+        *node_levels = (uint32_t*)malloc(node_levels_size);
+        affirm_bad_malloc(*node_levels,"node levels array",node_levels_size);
+
+        for(size_t level_i = 0; level_i < levels.levels_num; ++level_i)
+            for(size_t node_i = levels.level_offsets[level_i]; node_i < levels.level_offsets[level_i+1]; ++node_i)
+                (*node_levels)[node_i] = level_i;
+    }
+
+    *sorted_nodes = levels.sorted_nodes;
+    *nodes_num = levels.nodes_num;
+
+    free(levels.level_offsets);
+}
@@ -0,0 +1,102 @@
+#include <lockpick/graph/tsort.h>
+#include <lockpick/graph/traverse.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/bitset.h>
+#include <lockpick/define.h>
+#include <lockpick/vector.h>
+#include <stdlib.h>
+
+
+typedef struct __lpg_frozen_tsort_init_state
+{
+    lp_bitset_t *reachable;
+    lp_vector_t *const_slots;
+    size_t nodes_count;
+} __lpg_frozen_tsort_init_state_t;
+
+
+static void __lpg_frozen_tsort_init_state_cb(const lpg_frozen_graph_t *frozen, lpg_frozen_index_t slot, bool is_input, void *args)
+{
+    __lpg_frozen_tsort_init_state_t *state = (__lpg_frozen_tsort_init_state_t*)args;
+
+    lp_bitset_set(state->reachable,slot);
+    if(is_input)
+        return;
+
+    ++state->nodes_count;
+    if(frozen->types[slot] == LPG_NODE_TYPE_CONST)
+        lp_vector_push_back(state->const_slots,&slot);
+}
+
+
+/**
+ * lpg_frozen_graph_tsort - sorts slots of frozen graph in topological order
+ * @frozen:         pointer to frozen graph object
+ * @sorted_slots:   pointer on array of sorted slots
+ * @nodes_num:      pointer on number of sorted slots
+ *
+ * Counterpart of 'lpg_graph_tsort' for frozen graphs. @sorted_slots starts with all input nodes in their
+ * order, followed by other constant nodes reachable from outputs and the remaining reachable nodes, every
+ * node being placed after all its parents. Input nodes are terminal, even if they have parents.
+ *
+ * Reachable nodes are marked with 'lpg_frozen_graph_traverse_once', then Kahn's algorithm runs over the
+ * children arrays with counters of unprocessed parents indexed by slot, so no hash table is involved.
+ * Sorted array doubles as the queue of nodes, all parents of which are processed.
+ *
+ * Return: None
+*/
+void lpg_frozen_graph_tsort(const lpg_frozen_graph_t *frozen, lpg_frozen_index_t **sorted_slots, size_t *nodes_num)
+{
+    affirm_nullptr(frozen,"frozen graph");
+    affirm_nullptr(sorted_slots,"sorted slots array pointer");
+    affirm_nullptr(nodes_num,"nodes number pointer");
+
+    __lpg_frozen_tsort_init_state_t init_state;
+    init_state.reachable = lp_bitset_create(MAX(1,frozen->slots_num));
+    init_state.const_slots = lp_vector_create(0,sizeof(lpg_frozen_index_t));
+    init_state.nodes_count = 0;
+
+    lpg_frozen_graph_traverse_once(frozen,__lpg_frozen_tsort_init_state_cb,&init_state);
+
+    size_t result_num = frozen->inputs_size+init_state.nodes_count;
+    size_t result_size = MAX(1,result_num)*sizeof(lpg_frozen_index_t);
+    lpg_frozen_index_t *result = (lpg_frozen_index_t*)malloc(result_size);
+    affirm_bad_malloc(result,"result sorted slots array",result_size);
+
+    size_t pending_size = MAX(1,frozen->slots_num)*sizeof(uint8_t);
+    uint8_t *pending_parents = (uint8_t*)malloc(pending_size);
+    affirm_bad_malloc(pending_parents,"pending parents array",pending_size);
+    for(size_t slot = 0; slot < frozen->slots_num; ++slot)
+        pending_parents[slot] = frozen->parents_offsets[slot+1]-frozen->parents_offsets[slot];
+
+    size_t result_end = 0;
+    for(size_t in_i = 0; in_i < frozen->inputs_size; ++in_i)
+        result[result_end++] = frozen->inputs[in_i];
+
+    for(size_t const_i = 0; const_i < init_state.const_slots->size; ++const_i)
+        result[result_end++] = lp_vector_at_type(init_state.const_slots,const_i,lpg_frozen_index_t);
+
+    for(size_t result_i = 0; result_i < result_end; ++result_i)
+    {
+        lpg_frozen_index_t slot = result[result_i];
+        for(lpg_frozen_index_t child_i = frozen->children_offsets[slot]; child_i < frozen->children_offsets[slot+1]; ++child_i)
+        {
+            lpg_frozen_index_t child = frozen->children[child_i];
+            if(!lp_bitset_test(init_state.reachable,child) || lp_bitset_test(frozen->is_input,child))
+                continue;
+
+            // Child is recorded once per parent slot, so it is released after the last one
+            if(--pending_parents[child] == 0)
+                result[result_end++] = child;
+        }
+    }
+
+    affirmf(result_end == result_num,"Sorted %zd nodes out of %zd, graph must be acyclic",result_end,result_num);
+
+    *sorted_slots = result;
+    *nodes_num = result_num;
+
+    free(pending_parents);
+    lp_bitset_release(init_state.reachable);
+    lp_vector_release(init_state.const_slots);
+}
@@ -1,22 +1,29 @@
 #include <lockpick/graph/inference/host/infer.h>
 #include <lockpick/bitset.h>
+#include <lockpick/affirmf.h>
+#include <stdlib.h>
 
 
-lp_bitset_t *lpg_inference_graph_infer_host(lpg_inference_graph_t *inference_graph, const lp_bitset_t *input_values)
+/**
+ * __lpg_inference_graph_infer_host_values - evaluates inference graph using caller-provided buffers
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       values of input nodes
+ * @values:             buffer for values of all nodes
+ * @output:             buffer for values of output nodes
+ *
+ * Nodes are loaded from @narrow_nodes of graphs having them and widened in registers.
+ *
+ * Return: None
+*/
+static void __lpg_inference_graph_infer_host_values(const lpg_inference_graph_t *inference_graph, const lp_bitset_t *input_values, lp_bitset_t *values, lp_bitset_t *output)
 {
-    affirm_nullptr(inference_graph,"ocl graph");
-
-    lp_bitset_t *values = lp_bitset_create(inference_graph->nodes_num);
     lp_bitset_copy(values,input_values);
 
-    uint16_t outputs_size = inference_graph->graph->outputs_size;
-    lp_bitset_t *output = lp_bitset_create(outputs_size);
-
-    uint16_t inputs_size = inference_graph->graph->inputs_size;
-    lpg_inference_graph_index_t curr_out_i = 0;
-    for(uint16_t node_i = inputs_size; node_i < inference_graph->nodes_num; ++node_i)
+    size_t inputs_size = inference_graph->inputs_size;
+    for(size_t node_i = inputs_size; node_i < inference_graph->nodes_num; ++node_i)
     {
-        lpg_node_packed_t curr_node = inference_graph->sorted_nodes[node_i];
+        lpg_node_packed_t curr_node = inference_graph->narrow_nodes ?
+            __LPG_NODE_PACKED_WIDEN(inference_graph->narrow_nodes[node_i]) : inference_graph->sorted_nodes[node_i];
         cl_char type = lpg_node_packed_type(&curr_node);
         bool curr_node_value;
 
@@ -24,22 +31,22 @@ lp_bitset_t *lpg_inference_graph_infer_host(lpg_inference_graph_t *inference_gra
         {
             case LPG_NODE_PACKED_TYPE_AND:
                 curr_node_value =
-                    lp_bitset_test(values,curr_node.parents[0]) && lp_bitset_test(values,curr_node.parents[1]);
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[0]) && lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[1]);
                 break;
             
             case LPG_NODE_PACKED_TYPE_OR:
                 curr_node_value =
-                    lp_bitset_test(values,curr_node.parents[0]) || lp_bitset_test(values,curr_node.parents[1]);
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[0]) || lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[1]);
                 break;
             
             case LPG_NODE_PACKED_TYPE_NOT:
                 curr_node_value =
-                    !lp_bitset_test(values,curr_node.parents[0]);
+                    !lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[0]);
                 break;
             
             case LPG_NODE_PACKED_TYPE_XOR:
                 curr_node_value =
-                    lp_bitset_test(values,curr_node.parents[0]) ^ lp_bitset_test(values,curr_node.parents[1]);
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[0]) ^ lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[1]);
                 break;
             
             case LPG_NODE_PACKED_TYPE_TRUE:
@@ -50,20 +57,167 @@ lp_bitset_t *lpg_inference_graph_infer_host(lpg_inference_graph_t *inference_gra
                 curr_node_value = false;
                 break;
 
+            case LPG_NODE_PACKED_TYPE_NAND:
+                curr_node_value =
+                    !(lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[0]) && lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[1]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NOR:
+                curr_node_value =
+                    !(lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[0]) || lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[1]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XNOR:
+                curr_node_value =
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[0]) == lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[1]);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_ANDNOT:
+                curr_node_value =
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[0]) && !lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[1]);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_ORNOT:
+                curr_node_value =
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[0]) || !lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[1]);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XOR3:
+                curr_node_value = __LPG_INFERENCE_HOST_OP_XOR3(
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[0]),
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[1]),
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[2]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_MAJ:
+                curr_node_value = __LPG_INFERENCE_HOST_OP_MAJ(
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[0]),
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[1]),
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[2]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_MUX:
+                curr_node_value = __LPG_INFERENCE_HOST_OP_MUX(
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[0]),
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[1]),
+                    lp_bitset_test(values,(lpg_inference_graph_uindex_t)curr_node.parents[2]));
+                break;
+
             default:
                 errorf("Unknown type: %d",(uint32_t)type);
         }
 
         lp_bitset_update(values,node_i,curr_node_value);
-
-        if(lpg_node_packed_output(&curr_node) != LPG_NODE_PACKED_NOT_OUTPUT)
-        {
-            lp_bitset_update(output,curr_out_i,curr_node_value);
-            ++curr_out_i;
-        }
     }
 
+    // Values of all nodes are kept, so outputs are gathered in a single pass afterwards
+    const lpg_inference_graph_uindex_t *output_nodes = inference_graph->output_nodes;
+    for(size_t out_i = 0; out_i < inference_graph->outputs_size; ++out_i)
+        lp_bitset_update(output,out_i,lp_bitset_test(values,output_nodes[out_i]));
+}
+
+
+lp_bitset_t *lpg_inference_graph_infer_host(lpg_inference_graph_t *inference_graph, const lp_bitset_t *input_values)
+{
+    affirm_nullptr(inference_graph,"ocl graph");
+
+    lp_bitset_t *values = lp_bitset_create(inference_graph->nodes_num);
+
+    size_t outputs_size = inference_graph->outputs_size;
+    lp_bitset_t *output = lp_bitset_create(outputs_size);
+
+    __lpg_inference_graph_infer_host_values(inference_graph,input_values,values,output);
+
     lp_bitset_release(values);
 
     return output;
 }
+
+
+/**
+ * lpg_inference_host_context_create - creates reusable context for host inference
+ * @inference_graph:    pointer to inference graph object
+ *
+ * Context owns buffers for values of all nodes and of output nodes of @inference_graph, so
+ * that repeated evaluations do not allocate memory. Context must not be shared between threads
+ * evaluating simultaneously, create one context per thread instead.
+ *
+ * Return: Pointer to created context object
+*/
+lpg_inference_host_context_t *lpg_inference_host_context_create(lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    size_t context_size = sizeof(lpg_inference_host_context_t);
+    lpg_inference_host_context_t *context = (lpg_inference_host_context_t*)malloc(context_size);
+    affirm_bad_malloc(context,"inference context",context_size);
+
+    context->inference_graph = inference_graph;
+    context->values = lp_bitset_create(inference_graph->nodes_num);
+    context->output = lp_bitset_create(inference_graph->outputs_size);
+
+    return context;
+}
+
+
+/**
+ * lpg_inference_host_context_release - releases host inference context
+ * @context:    pointer to context object
+ *
+ * Inference graph used by @context is not released.
+ *
+ * Return: None
+*/
+void lpg_inference_host_context_release(lpg_inference_host_context_t *context)
+{
+    affirm_nullptr(context,"inference context");
+
+    lp_bitset_release(context->values);
+    lp_bitset_release(context->output);
+    free(context);
+}
+
+
+/**
+ * lpg_inference_graph_infer_host_ctx - evaluates inference graph using buffers of the context
+ * @context:        pointer to context object
+ * @input_values:   values of input nodes
+ *
+ * Same as 'lpg_inference_graph_infer_host', but does not allocate memory.
+ *
+ * Return: Values of output nodes owned by @context, valid until the next evaluation or release
+*/
+const lp_bitset_t *lpg_inference_graph_infer_host_ctx(lpg_inference_host_context_t *context, const lp_bitset_t *input_values)
+{
+    affirm_nullptr(context,"inference context");
+    affirm_nullptr(input_values,"input values");
+
+    __lpg_inference_graph_infer_host_values(context->inference_graph,input_values,context->values,context->output);
+
+    return context->output;
+}
+
+
+/**
+ * lpg_inference_graph_infer_host_into - evaluates inference graph into caller-provided buffer
+ * @context:        pointer to context object
+ * @input_values:   values of input nodes
+ * @output:         buffer for values of output nodes
+ *
+ * Same as 'lpg_inference_graph_infer_host_ctx', but writes values of output nodes directly into
+ * @output, which must hold at least as many bits as there are outputs in the underlying graph.
+ *
+ * Return: None
+*/
+void lpg_inference_graph_infer_host_into(lpg_inference_host_context_t *context, const lp_bitset_t *input_values, lp_bitset_t *output)
+{
+    affirm_nullptr(context,"inference context");
+    affirm_nullptr(input_values,"input values");
+    affirm_nullptr(output,"output values");
+
+    size_t outputs_size = context->inference_graph->outputs_size;
+    affirmf(output->size >= outputs_size,
+        "Output buffer of size %zd cannot hold %zd outputs",output->size,outputs_size);
+
+    __lpg_inference_graph_infer_host_values(context->inference_graph,input_values,context->values,output);
+}
@@ -0,0 +1,347 @@
+#include <lockpick/graph/inference/host/infer.h>
+#include <lockpick/graph/inference/cone.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/*
+    Evaluates binary gate word by word with the given operation of operands.
+*/
+#define __LPG_INFERENCE_HOST_BATCH_BINARY(node,node_slots,values,dest,words_num,op)                         \
+    {                                                                                                       \
+        const uint64_t *a = (values)+(node_slots)[(lpg_inference_graph_uindex_t)(node)->parents[0]]*(words_num);  \
+        const uint64_t *b = (values)+(node_slots)[(lpg_inference_graph_uindex_t)(node)->parents[1]]*(words_num);  \
+        for(size_t word_i = 0; word_i < (words_num); ++word_i)                                              \
+            (dest)[word_i] = op(a[word_i],b[word_i]);                                                       \
+    }
+
+
+/*
+    Evaluates ternary gate word by word with the given operation of operands.
+*/
+#define __LPG_INFERENCE_HOST_BATCH_TERNARY(node,node_slots,values,dest,words_num,op)                        \
+    {                                                                                                       \
+        const uint64_t *a = (values)+(node_slots)[(lpg_inference_graph_uindex_t)(node)->parents[0]]*(words_num);  \
+        const uint64_t *b = (values)+(node_slots)[(lpg_inference_graph_uindex_t)(node)->parents[1]]*(words_num);  \
+        const uint64_t *c = (values)+(node_slots)[(lpg_inference_graph_uindex_t)(node)->parents[2]]*(words_num);  \
+        for(size_t word_i = 0; word_i < (words_num); ++word_i)                                              \
+            (dest)[word_i] = op(a[word_i],b[word_i],c[word_i]);                                             \
+    }
+
+
+/**
+ * __lpg_inference_graph_infer_host_batch_node_scalar - evaluates single packed node over bit-sliced batch
+ * @node:           packed node to evaluate
+ * @node_slots:     value slots assigned to nodes
+ * @values:         bit-sliced values of all slots
+ * @dest:           bit-sliced value of @node
+ * @words_num:      number of bit-sliced words per node
+ *
+ * Every slot owns @words_num consecutive words inside @values, where bit 'j' of word 'w' holds
+ * the value of the node for the input vector with index 'w*LPG_INFERENCE_HOST_BATCH_WORD_WIDTH+j'.
+ * Thus, a single word-wide operation evaluates the node for LPG_INFERENCE_HOST_BATCH_WORD_WIDTH
+ * input vectors at once.
+ *
+ * @dest may share the slot with one of the operands, since every word of operands is read before
+ * the corresponding word of @dest is written.
+ *
+ * Return: None
+*/
+static inline void __lpg_inference_graph_infer_host_batch_node_scalar(const lpg_node_packed_t *node, const lpg_inference_graph_uindex_t *node_slots, const uint64_t *values, uint64_t *dest, size_t words_num)
+{
+    cl_char type = lpg_node_packed_type(node);
+    switch(type)
+    {
+        case LPG_NODE_PACKED_TYPE_AND:
+            __LPG_INFERENCE_HOST_BATCH_BINARY(node,node_slots,values,dest,words_num,__LPG_INFERENCE_HOST_OP_AND);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_OR:
+            __LPG_INFERENCE_HOST_BATCH_BINARY(node,node_slots,values,dest,words_num,__LPG_INFERENCE_HOST_OP_OR);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_NOT:
+        {
+            const uint64_t *a = values+node_slots[(lpg_inference_graph_uindex_t)node->parents[0]]*words_num;
+            for(size_t word_i = 0; word_i < words_num; ++word_i)
+                dest[word_i] = ~a[word_i];
+            break;
+        }
+
+        case LPG_NODE_PACKED_TYPE_XOR:
+            __LPG_INFERENCE_HOST_BATCH_BINARY(node,node_slots,values,dest,words_num,__LPG_INFERENCE_HOST_OP_XOR);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_TRUE:
+            memset(dest,0xff,words_num*sizeof(uint64_t));
+            break;
+
+        case LPG_NODE_PACKED_TYPE_FALSE:
+            memset(dest,0,words_num*sizeof(uint64_t));
+            break;
+
+        case LPG_NODE_PACKED_TYPE_NAND:
+            __LPG_INFERENCE_HOST_BATCH_BINARY(node,node_slots,values,dest,words_num,__LPG_INFERENCE_HOST_OP_NAND);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_NOR:
+            __LPG_INFERENCE_HOST_BATCH_BINARY(node,node_slots,values,dest,words_num,__LPG_INFERENCE_HOST_OP_NOR);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_XNOR:
+            __LPG_INFERENCE_HOST_BATCH_BINARY(node,node_slots,values,dest,words_num,__LPG_INFERENCE_HOST_OP_XNOR);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_ANDNOT:
+            __LPG_INFERENCE_HOST_BATCH_BINARY(node,node_slots,values,dest,words_num,__LPG_INFERENCE_HOST_OP_ANDNOT);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_ORNOT:
+            __LPG_INFERENCE_HOST_BATCH_BINARY(node,node_slots,values,dest,words_num,__LPG_INFERENCE_HOST_OP_ORNOT);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_XOR3:
+            __LPG_INFERENCE_HOST_BATCH_TERNARY(node,node_slots,values,dest,words_num,__LPG_INFERENCE_HOST_OP_XOR3);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_MAJ:
+            __LPG_INFERENCE_HOST_BATCH_TERNARY(node,node_slots,values,dest,words_num,__LPG_INFERENCE_HOST_OP_MAJ);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_MUX:
+            __LPG_INFERENCE_HOST_BATCH_TERNARY(node,node_slots,values,dest,words_num,__LPG_INFERENCE_HOST_OP_MUX);
+            break;
+
+        default:
+            errorf("Unknown type: %d",(uint32_t)type);
+    }
+}
+
+
+/*
+    Generates portable kernel evaluating range of packed nodes of the given layout.
+*/
+#define __LPG_INFERENCE_HOST_BATCH_NODES_SCALAR(name,packed_t,load)                                       \
+void name(const void *sorted_nodes, const lpg_inference_graph_uindex_t *node_slots,                        \
+            size_t nodes_begin, size_t nodes_end, uint64_t *values, size_t words_num)                     \
+{                                                                                                         \
+    const packed_t *packed_nodes = (const packed_t*)sorted_nodes;                                         \
+    for(size_t node_i = nodes_begin; node_i < nodes_end; ++node_i)                                        \
+    {                                                                                                     \
+        lpg_node_packed_t node = load(packed_nodes[node_i]);                                              \
+        uint64_t *dest = values+node_slots[node_i]*words_num;                                             \
+        __lpg_inference_graph_infer_host_batch_node_scalar(&node,node_slots,values,dest,words_num);       \
+    }                                                                                                     \
+}
+
+
+/*
+    Portable bit-sliced kernels evaluate nodes within [nodes_begin, nodes_end) using plain 64-bit word operations.
+    They are available on every CPU and serve as a fallback for the wide kernels. The narrow variant evaluates
+    'lpg_node_packed_narrow' arrays of small graphs.
+*/
+__LPG_INFERENCE_HOST_BATCH_NODES_SCALAR(__lpg_inference_graph_infer_host_batch_nodes_scalar,lpg_node_packed_t,__LPG_INFERENCE_HOST_LOAD_WIDE)
+
+__LPG_INFERENCE_HOST_BATCH_NODES_SCALAR(__lpg_inference_graph_infer_host_batch_nodes_scalar_narrow,lpg_node_packed_narrow_t,__LPG_INFERENCE_HOST_LOAD_NARROW)
+
+
+/**
+ * __lpg_inference_host_batch_values_alloc - allocates bit-sliced values buffer
+ * @nodes_num:      number of nodes to hold values for
+ * @words_num:      number of bit-sliced words per node
+ *
+ * The buffer is aligned on LPG_INFERENCE_HOST_BATCH_ALIGNMENT, so that wide kernels
+ * never split a register load across cache lines when @words_num is a multiple of
+ * the register width.
+ *
+ * Return: Allocated buffer, which must be freed by the caller
+*/
+uint64_t *__lpg_inference_host_batch_values_alloc(size_t nodes_num, size_t words_num)
+{
+    size_t values_size = nodes_num*words_num*sizeof(uint64_t);
+    size_t values_aligned_size = lp_ceil_div_u64(MAX(1,values_size),LPG_INFERENCE_HOST_BATCH_ALIGNMENT)*LPG_INFERENCE_HOST_BATCH_ALIGNMENT;
+    uint64_t *values = (uint64_t*)aligned_alloc(LPG_INFERENCE_HOST_BATCH_ALIGNMENT,values_aligned_size);
+    affirm_bad_malloc(values,"bit-sliced node values",values_aligned_size);
+
+    return values;
+}
+
+
+/**
+ * __lpg_inference_graph_infer_host_batch_gather_outputs - copies bit-sliced values of output nodes
+ * @inference_graph:    pointer to inference graph object
+ * @node_slots:         value slots assigned to nodes
+ * @output_nodes:       index of the node of each output within the evaluated array
+ * @outputs_mask:       outputs present inside the evaluated array, NULL if all of them are
+ * @values:             bit-sliced values of all slots
+ * @words_num:          number of bit-sliced words per node
+ * @output:             bit-sliced values of output nodes
+ *
+ * Places values of output nodes inside @output according to their indices inside the graph's outputs
+ * buffer. Slots of output nodes are never reused, see '__lpg_node_packed_alloc_slots', so all of them
+ * still hold their values once evaluation is finished. Several outputs served by the same node and
+ * outputs served by input nodes need no special handling.
+ *
+ * Return: None
+*/
+void __lpg_inference_graph_infer_host_batch_gather_outputs(
+    const lpg_inference_graph_t *inference_graph,
+    const lpg_inference_graph_uindex_t *node_slots,
+    const lpg_inference_graph_uindex_t *output_nodes,
+    const lp_bitset_t *outputs_mask,
+    const uint64_t *values,
+    size_t words_num,
+    uint64_t *output)
+{
+    for(size_t out_i = 0; out_i < inference_graph->outputs_size; ++out_i)
+    {
+        if(outputs_mask && !lp_bitset_test(outputs_mask,out_i))
+            continue;
+
+        memcpy(output+out_i*words_num,values+node_slots[output_nodes[out_i]]*words_num,words_num*sizeof(uint64_t));
+    }
+}
+
+
+/**
+ * __lpg_inference_graph_infer_host_batch_sorted - evaluates topologically sorted packed array over a batch
+ * @inference_graph:    pointer to inference graph object, the array is derived from
+ * @sorted_nodes:       topologically sorted array of packed nodes starting with all input nodes
+ * @narrow_nodes:       same as @sorted_nodes with 16-bit indices or NULL
+ * @node_slots:         value slots assigned to nodes
+ * @nodes_num:          number of nodes inside @sorted_nodes
+ * @slots_num:          number of value slots referenced by @node_slots
+ * @output_nodes:       index within @sorted_nodes of the node of each output
+ * @outputs_mask:       outputs present inside @sorted_nodes, NULL if all of them are
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ * @isa:                instruction set to evaluate nodes with
+ *
+ * Common part of sequential batch engines, which evaluate either the whole inference graph or
+ * some array derived from it, like fan-in cone of selected outputs. @narrow_nodes are evaluated
+ * instead of @sorted_nodes whenever present.
+ *
+ * Return: Allocated buffer of bit-sliced output values, which must be freed by the caller
+*/
+static uint64_t *__lpg_inference_graph_infer_host_batch_sorted(
+    const lpg_inference_graph_t *inference_graph,
+    const lpg_node_packed_t *sorted_nodes,
+    const lpg_node_packed_narrow_t *narrow_nodes,
+    const lpg_inference_graph_uindex_t *node_slots,
+    size_t nodes_num,
+    size_t slots_num,
+    const lpg_inference_graph_uindex_t *output_nodes,
+    const lp_bitset_t *outputs_mask,
+    const uint64_t *input_values,
+    size_t words_num,
+    lpg_inference_host_isa_t isa)
+{
+    __lpg_inference_host_batch_kernel_t kernel = __lpg_inference_host_batch_kernel(isa,narrow_nodes != NULL);
+
+    // Only live values are kept, see '__lpg_node_packed_alloc_slots'
+    uint64_t *values = __lpg_inference_host_batch_values_alloc(slots_num,words_num);
+
+    size_t inputs_size = inference_graph->inputs_size;
+    memcpy(values,input_values,inputs_size*words_num*sizeof(uint64_t));
+
+    size_t outputs_size = inference_graph->outputs_size;
+    uint64_t *output = (uint64_t*)calloc(outputs_size*words_num,sizeof(uint64_t));
+    affirm_bad_malloc(output,"bit-sliced output values",outputs_size*words_num*sizeof(uint64_t));
+
+    kernel(narrow_nodes ? (const void*)narrow_nodes : (const void*)sorted_nodes,node_slots,inputs_size,nodes_num,values,words_num);
+
+    __lpg_inference_graph_infer_host_batch_gather_outputs(inference_graph,node_slots,output_nodes,outputs_mask,values,words_num,output);
+
+    free(values);
+
+    return output;
+}
+
+
+/**
+ * lpg_inference_graph_infer_host_batch_isa - evaluates inference graph over a batch of bit-sliced input vectors
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ * @isa:                instruction set to evaluate nodes with
+ *
+ * Evaluates @inference_graph for @words_num*LPG_INFERENCE_HOST_BATCH_WORD_WIDTH independent input
+ * vectors at once.
+ *
+ * Values are laid out bit-sliced: @input_values holds @words_num consecutive words per input node,
+ * so the value of the input node 'i' for the input vector 'v' is the bit 'v%64' of the word
+ * '@input_values[i*@words_num+v/64]'. Every gate is then evaluated with a single word-wide
+ * AND/OR/XOR/NOT per word instead of a single bit operation per input vector.
+ *
+ * With @isa set to LPG_INFERENCE_HOST_ISA_AVX2 or LPG_INFERENCE_HOST_ISA_AVX512, every gate processes
+ * 256 or 512 input vectors per instruction, which is most effective when @words_num is a multiple of
+ * 4 or 8 respectively. The requested @isa must be supported by the running CPU.
+ *
+ * The returned buffer has the same layout and holds @words_num words per output node of the
+ * underlying graph. Outputs are placed according to their indices inside the graph's outputs buffer.
+ *
+ * Intermediate values are kept only while alive, so the working set is bounded by the graph's
+ * @slots_num rather than by the total number of nodes.
+ *
+ * Graphs having @narrow_nodes are evaluated from them, which halves the size of packed nodes loaded
+ * per gate, larger graphs are evaluated from @sorted_nodes with 32-bit indices.
+ *
+ * Return: Allocated buffer of bit-sliced output values, which must be freed by the caller
+*/
+uint64_t *lpg_inference_graph_infer_host_batch_isa(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, lpg_inference_host_isa_t isa)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+    affirm_nullptr(input_values,"input values");
+    affirmf(words_num > 0,"Number of words per node must be greater than zero");
+
+    return __lpg_inference_graph_infer_host_batch_sorted(inference_graph,inference_graph->sorted_nodes,inference_graph->narrow_nodes,
+        inference_graph->node_slots,inference_graph->nodes_num,inference_graph->slots_num,inference_graph->output_nodes,NULL,
+        input_values,words_num,isa);
+}
+
+
+/**
+ * lpg_inference_graph_infer_host_batch - evaluates inference graph over a batch of bit-sliced input vectors
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ *
+ * Same as 'lpg_inference_graph_infer_host_batch_isa' with the widest instruction set
+ * supported by the running CPU.
+ *
+ * Return: Allocated buffer of bit-sliced output values, which must be freed by the caller
+*/
+uint64_t *lpg_inference_graph_infer_host_batch(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num)
+{
+    return lpg_inference_graph_infer_host_batch_isa(inference_graph,input_values,words_num,LPG_INFERENCE_HOST_ISA_AUTO);
+}
+
+
+/**
+ * lpg_inference_graph_infer_host_batch_masked - evaluates selected outputs of inference graph over a batch
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ * @outputs_mask:       outputs of the underlying graph to evaluate
+ *
+ * Same as 'lpg_inference_graph_infer_host_batch', but evaluates only the fan-in cone of outputs
+ * selected by @outputs_mask. Cones are cached inside @inference_graph, see 'lpg_inference_graph_cone',
+ * so repeated queries with the same mask skip unrelated gates without any preprocessing.
+ *
+ * The returned buffer has the same layout as for the whole graph, words of not selected outputs are zero.
+ *
+ * Return: Allocated buffer of bit-sliced output values, which must be freed by the caller
+*/
+uint64_t *lpg_inference_graph_infer_host_batch_masked(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, const lp_bitset_t *outputs_mask)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+    affirm_nullptr(input_values,"input values");
+    affirmf(words_num > 0,"Number of words per node must be greater than zero");
+
+    lpg_inference_cone_t *cone = lpg_inference_graph_cone(inference_graph,outputs_mask);
+
+    return __lpg_inference_graph_infer_host_batch_sorted(inference_graph,cone->sorted_nodes,cone->narrow_nodes,cone->node_slots,
+        cone->nodes_num,cone->slots_num,cone->output_nodes,cone->outputs_mask,input_values,words_num,LPG_INFERENCE_HOST_ISA_AUTO);
+}
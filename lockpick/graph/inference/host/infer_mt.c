@@ -0,0 +1,208 @@
+#include <lockpick/graph/inference/host/infer.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/affinity.h>
+#include <lockpick/math.h>
+#include <pthread.h>
+#include <string.h>
+
+
+typedef struct __lpg_inference_graph_infer_mt_thr_args_common
+{
+    const lpg_inference_graph_t *inference_graph;
+    __lpg_inference_host_batch_kernel_t kernel;
+    const void *sorted_nodes;
+    const lpg_inference_graph_uindex_t *node_slots;
+    uint64_t *values;
+    size_t words_num;
+    uint32_t total_threads;
+    pthread_barrier_t *level_barrier;
+} __lpg_inference_graph_infer_mt_thr_args_common_t;
+
+typedef struct __lpg_inference_graph_infer_mt_thr_args
+{
+    __lpg_inference_graph_infer_mt_thr_args_common_t *common_args;
+    uint32_t current_thread_i;
+} __lpg_inference_graph_infer_mt_thr_args_t;
+
+
+/**
+ * __lpg_inference_graph_infer_host_batch_mt_thr - levelized inference pthread_create entry point
+ * @args:       unpacking below
+ * @current_thread_i:   index of calling thread
+ * @inference_graph:    pointer to inference graph object
+ * @kernel:             bit-sliced kernel to evaluate nodes with
+ * @sorted_nodes:       packed nodes of the layout @kernel expects
+ * @node_slots:         identity map of value slots, every node keeps its own slot
+ * @values:             bit-sliced values of all nodes shared between threads
+ * @words_num:          number of bit-sliced words per node
+ * @total_threads:      number of threads participating in inference
+ * @level_barrier:      barrier separating evaluation of consecutive levels
+ *
+ * Every level of the inference graph is split into @total_threads contiguous chunks of nearly
+ * equal size and each thread evaluates its own chunk. Since nodes of a single level depend only on
+ * nodes of previous levels, chunks are evaluated without any synchronization. Threads wait on
+ * @level_barrier after each level, so that the next level starts with all its operands computed.
+ *
+ * Return: None
+*/
+static void *__lpg_inference_graph_infer_host_batch_mt_thr(__lpg_inference_graph_infer_mt_thr_args_t *args)
+{
+    uint32_t current_thread_i = args->current_thread_i;
+    const lpg_inference_graph_t *inference_graph = args->common_args->inference_graph;
+    __lpg_inference_host_batch_kernel_t kernel = args->common_args->kernel;
+    const void *sorted_nodes = args->common_args->sorted_nodes;
+    const lpg_inference_graph_uindex_t *node_slots = args->common_args->node_slots;
+    uint64_t *values = args->common_args->values;
+    size_t words_num = args->common_args->words_num;
+    uint32_t total_threads = args->common_args->total_threads;
+    pthread_barrier_t *level_barrier = args->common_args->level_barrier;
+
+    // Zero level consists of input and constant nodes, inputs are already in place
+    size_t inputs_size = inference_graph->inputs_size;
+    for(size_t level_i = 0; level_i < inference_graph->levels_num; ++level_i)
+    {
+        size_t level_begin = MAX(inference_graph->level_offsets[level_i],inputs_size);
+        size_t level_end = inference_graph->level_offsets[level_i+1];
+        if(level_begin < level_end)
+        {
+            size_t chunk_size = lp_ceil_div_u64(level_end-level_begin,total_threads);
+            size_t chunk_begin = MIN(level_begin+current_thread_i*chunk_size,level_end);
+            size_t chunk_end = MIN(chunk_begin+chunk_size,level_end);
+
+            kernel(sorted_nodes,node_slots,chunk_begin,chunk_end,values,words_num);
+        }
+
+        pthread_barrier_wait(level_barrier);
+    }
+
+    return NULL;
+}
+
+
+/**
+ * __lpg_inference_graph_identity_slots - returns identity map of value slots of inference graph
+ * @inference_graph:    pointer to inference graph object
+ *
+ * The map is built on the first call and cached inside @inference_graph until its release, so
+ * engines which keep value of every node do not rebuild it on every inference. Building is not
+ * synchronized, so run such engine once before sharing @inference_graph between threads.
+ *
+ * Return: Identity map of @nodes_num value slots owned by @inference_graph
+*/
+static const lpg_inference_graph_uindex_t *__lpg_inference_graph_identity_slots(lpg_inference_graph_t *inference_graph)
+{
+    if(!inference_graph->identity_slots)
+    {
+        size_t identity_slots_size = MAX(1,inference_graph->nodes_num)*sizeof(lpg_inference_graph_uindex_t);
+        lpg_inference_graph_uindex_t *identity_slots = (lpg_inference_graph_uindex_t*)malloc(identity_slots_size);
+        affirm_bad_malloc(identity_slots,"identity slots array",identity_slots_size);
+        for(size_t node_i = 0; node_i < inference_graph->nodes_num; ++node_i)
+            identity_slots[node_i] = node_i;
+
+        inference_graph->identity_slots = identity_slots;
+    }
+
+    return inference_graph->identity_slots;
+}
+
+
+/**
+ * __lpg_inference_graph_infer_host_batch_mt - evaluates inference graph levels in parallel
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ * @threads_num:        number of threads to evaluate levels with
+ *
+ * Same as 'lpg_inference_graph_infer_host_batch_mt', but with explicitly specified number of threads.
+ * Threads are pinned to the available CPUs in round-robin manner.
+ *
+ * Reusable value slots of the graph cannot be used here, since nodes of a single level are evaluated
+ * in arbitrary order, so every node keeps its own slot, see '__lpg_inference_graph_identity_slots'.
+ *
+ * Return: Allocated buffer of bit-sliced output values, which must be freed by the caller
+*/
+uint64_t *__lpg_inference_graph_infer_host_batch_mt(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, uint32_t threads_num)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+    affirm_nullptr(input_values,"input values");
+    affirmf(words_num > 0,"Number of words per node must be greater than zero");
+    affirmf(threads_num > 0,"Number of threads must be greater than zero");
+
+    uint64_t *values = __lpg_inference_host_batch_values_alloc(inference_graph->nodes_num,words_num);
+
+    const lpg_inference_graph_uindex_t *node_slots = __lpg_inference_graph_identity_slots(inference_graph);
+
+    size_t inputs_size = inference_graph->inputs_size;
+    memcpy(values,input_values,inputs_size*words_num*sizeof(uint64_t));
+
+    size_t outputs_size = inference_graph->outputs_size;
+    uint64_t *output = (uint64_t*)calloc(outputs_size*words_num,sizeof(uint64_t));
+    affirm_bad_malloc(output,"bit-sliced output values",outputs_size*words_num*sizeof(uint64_t));
+
+    pthread_barrier_t level_barrier;
+    affirmf(!pthread_barrier_init(&level_barrier,NULL,threads_num),"Failed to initialize level barrier");
+
+    __lpg_inference_graph_infer_mt_thr_args_common_t common_args;
+    common_args.inference_graph = inference_graph;
+    common_args.kernel = __lpg_inference_host_batch_kernel(LPG_INFERENCE_HOST_ISA_AUTO,inference_graph->narrow_nodes != NULL);
+    common_args.sorted_nodes = inference_graph->narrow_nodes ? (const void*)inference_graph->narrow_nodes : (const void*)inference_graph->sorted_nodes;
+    common_args.node_slots = node_slots;
+    common_args.values = values;
+    common_args.words_num = words_num;
+    common_args.total_threads = threads_num;
+    common_args.level_barrier = &level_barrier;
+
+    __lpg_inference_graph_infer_mt_thr_args_t *args = (__lpg_inference_graph_infer_mt_thr_args_t*)malloc(threads_num*sizeof(__lpg_inference_graph_infer_mt_thr_args_t));
+    affirm_bad_malloc(args,"threads arguments",threads_num*sizeof(__lpg_inference_graph_infer_mt_thr_args_t));
+    pthread_t *threads = (pthread_t*)malloc(threads_num*sizeof(pthread_t));
+    affirm_bad_malloc(threads,"threads array",threads_num*sizeof(pthread_t));
+
+    // Affinity is set before start, since short-lived threads may exit before it could be set afterwards
+    pthread_attr_t thread_attr;
+    affirmf(!pthread_attr_init(&thread_attr),"Failed to initialize thread attributes");
+    for(uint32_t thr_i = 0; thr_i < threads_num; ++thr_i)
+    {
+        args[thr_i].common_args = &common_args;
+        args[thr_i].current_thread_i = thr_i;
+        affirmf(!pthread_attr_setaffinity_np(&thread_attr,sizeof(cpu_set_t),&lp_affinity_cpus[thr_i%lp_affinity_cpu_count]),
+            "Failed to set cpu affinity for thread %d",thr_i);
+        affirmf(!pthread_create(&threads[thr_i],&thread_attr,(void *(*)(void*))__lpg_inference_graph_infer_host_batch_mt_thr,&args[thr_i]),
+            "Failed to create thread %d",thr_i);
+    }
+    pthread_attr_destroy(&thread_attr);
+
+    for(uint32_t thr_i = 0; thr_i < threads_num; ++thr_i)
+        affirmf(!pthread_join(threads[thr_i],NULL),"Failed to join thread %d",thr_i);
+
+    __lpg_inference_graph_infer_host_batch_gather_outputs(inference_graph,node_slots,inference_graph->output_nodes,NULL,values,words_num,output);
+
+    pthread_barrier_destroy(&level_barrier);
+    free(threads);
+    free(args);
+    free(values);
+
+    return output;
+}
+
+
+/**
+ * lpg_inference_graph_infer_host_batch_mt - evaluates inference graph levels in parallel
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ *
+ * Multithreaded variant of 'lpg_inference_graph_infer_host_batch' with identical layout of
+ * @input_values and of the returned buffer.
+ *
+ * Creates one thread per available CPU. Nodes of every level of @inference_graph are evaluated
+ * concurrently, with all threads synchronizing on a barrier between consecutive levels.
+ *
+ * This variant pays off for wide graphs, where levels contain many independent gates. For narrow
+ * and deep graphs the barrier per level dominates, so prefer the sequential variant there.
+ *
+ * Return: Allocated buffer of bit-sliced output values, which must be freed by the caller
+*/
+uint64_t *lpg_inference_graph_infer_host_batch_mt(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num)
+{
+    return __lpg_inference_graph_infer_host_batch_mt(inference_graph,input_values,words_num,lp_affinity_cpu_count);
+}
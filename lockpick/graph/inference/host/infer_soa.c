@@ -0,0 +1,188 @@
+#include <lockpick/graph/inference/host/infer.h>
+#include <lockpick/graph/inference/soa.h>
+#include <lockpick/affirmf.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/*
+    Evaluates binary gates within [gates_begin, gates_end) with the same word-wide expression of operands 'a' and 'b'.
+*/
+#define __LPG_INFERENCE_HOST_SOA_GATES(soa,values,words_num,gates_begin,gates_end,expr)     \
+    for(size_t gate_i = (gates_begin); gate_i < (gates_end); ++gate_i)                      \
+    {                                                                                       \
+        const uint64_t *a = (values)+(soa)->parents_a[gate_i]*(words_num);                  \
+        const uint64_t *b = (values)+(soa)->parents_b[gate_i]*(words_num);                  \
+        uint64_t *dest = (values)+(soa)->dests[gate_i]*(words_num);                         \
+        for(size_t word_i = 0; word_i < (words_num); ++word_i)                              \
+            dest[word_i] = (expr);                                                          \
+    }
+
+
+/*
+    Evaluates ternary gates within [gates_begin, gates_end) with the same word-wide expression of operands 'a', 'b' and 'c'.
+*/
+#define __LPG_INFERENCE_HOST_SOA_TERNARY_GATES(soa,values,words_num,gates_begin,gates_end,expr) \
+    for(size_t gate_i = (gates_begin); gate_i < (gates_end); ++gate_i)                      \
+    {                                                                                       \
+        const uint64_t *a = (values)+(soa)->parents_a[gate_i]*(words_num);                  \
+        const uint64_t *b = (values)+(soa)->parents_b[gate_i]*(words_num);                  \
+        const uint64_t *c = (values)+(soa)->parents_c[gate_i]*(words_num);                  \
+        uint64_t *dest = (values)+(soa)->dests[gate_i]*(words_num);                         \
+        for(size_t word_i = 0; word_i < (words_num); ++word_i)                              \
+            dest[word_i] = (expr);                                                          \
+    }
+
+
+/**
+ * __lpg_inference_graph_infer_host_soa_groups_scalar - portable bit-sliced kernel for grouped gates
+ * @soa:            pointer to structure-of-arrays object
+ * @values:         bit-sliced values of all slots with values of input nodes already in place
+ * @words_num:      number of bit-sliced words per node
+ *
+ * Dispatches on the type once per group, so loops over gates of a group contain no branches
+ * depending on the graph.
+ *
+ * Return: None
+*/
+void __lpg_inference_graph_infer_host_soa_groups_scalar(const lpg_inference_soa_t *soa, uint64_t *values, size_t words_num)
+{
+    for(size_t group_i = 0; group_i < soa->groups_num; ++group_i)
+    {
+        size_t gates_begin = soa->group_offsets[group_i];
+        size_t gates_end = soa->group_offsets[group_i+1];
+
+        cl_char type = soa->group_types[group_i];
+        switch(type)
+        {
+            case LPG_NODE_PACKED_TYPE_AND:
+                __LPG_INFERENCE_HOST_SOA_GATES(soa,values,words_num,gates_begin,gates_end,__LPG_INFERENCE_HOST_OP_AND(a[word_i],b[word_i]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_OR:
+                __LPG_INFERENCE_HOST_SOA_GATES(soa,values,words_num,gates_begin,gates_end,__LPG_INFERENCE_HOST_OP_OR(a[word_i],b[word_i]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NOT:
+                for(size_t gate_i = gates_begin; gate_i < gates_end; ++gate_i)
+                {
+                    const uint64_t *a = values+soa->parents_a[gate_i]*words_num;
+                    uint64_t *dest = values+soa->dests[gate_i]*words_num;
+                    for(size_t word_i = 0; word_i < words_num; ++word_i)
+                        dest[word_i] = ~a[word_i];
+                }
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XOR:
+                __LPG_INFERENCE_HOST_SOA_GATES(soa,values,words_num,gates_begin,gates_end,__LPG_INFERENCE_HOST_OP_XOR(a[word_i],b[word_i]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_TRUE:
+                for(size_t gate_i = gates_begin; gate_i < gates_end; ++gate_i)
+                    memset(values+soa->dests[gate_i]*words_num,0xff,words_num*sizeof(uint64_t));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_FALSE:
+                for(size_t gate_i = gates_begin; gate_i < gates_end; ++gate_i)
+                    memset(values+soa->dests[gate_i]*words_num,0,words_num*sizeof(uint64_t));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NAND:
+                __LPG_INFERENCE_HOST_SOA_GATES(soa,values,words_num,gates_begin,gates_end,__LPG_INFERENCE_HOST_OP_NAND(a[word_i],b[word_i]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NOR:
+                __LPG_INFERENCE_HOST_SOA_GATES(soa,values,words_num,gates_begin,gates_end,__LPG_INFERENCE_HOST_OP_NOR(a[word_i],b[word_i]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XNOR:
+                __LPG_INFERENCE_HOST_SOA_GATES(soa,values,words_num,gates_begin,gates_end,__LPG_INFERENCE_HOST_OP_XNOR(a[word_i],b[word_i]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_ANDNOT:
+                __LPG_INFERENCE_HOST_SOA_GATES(soa,values,words_num,gates_begin,gates_end,__LPG_INFERENCE_HOST_OP_ANDNOT(a[word_i],b[word_i]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_ORNOT:
+                __LPG_INFERENCE_HOST_SOA_GATES(soa,values,words_num,gates_begin,gates_end,__LPG_INFERENCE_HOST_OP_ORNOT(a[word_i],b[word_i]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XOR3:
+                __LPG_INFERENCE_HOST_SOA_TERNARY_GATES(soa,values,words_num,gates_begin,gates_end,__LPG_INFERENCE_HOST_OP_XOR3(a[word_i],b[word_i],c[word_i]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_MAJ:
+                __LPG_INFERENCE_HOST_SOA_TERNARY_GATES(soa,values,words_num,gates_begin,gates_end,__LPG_INFERENCE_HOST_OP_MAJ(a[word_i],b[word_i],c[word_i]));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_MUX:
+                __LPG_INFERENCE_HOST_SOA_TERNARY_GATES(soa,values,words_num,gates_begin,gates_end,__LPG_INFERENCE_HOST_OP_MUX(a[word_i],b[word_i],c[word_i]));
+                break;
+
+            default:
+                errorf("Unknown type: %d",(uint32_t)type);
+        }
+    }
+}
+
+
+/**
+ * lpg_inference_graph_infer_host_soa_isa - evaluates structure-of-arrays version of inference graph over a batch
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ * @isa:                instruction set to evaluate gates with
+ *
+ * Drop-in replacement for 'lpg_inference_graph_infer_host_batch_isa' with identical layout of @input_values
+ * and of the returned buffer. Gates are evaluated group by group, see 'lpg_inference_soa', so the engine
+ * does not branch on the type of every node. The layout is built on the first call, see 'lpg_inference_graph_soa'.
+ *
+ * With LPG_INFERENCE_HOST_ISA_AVX512 and a single word per node, gates of a group are evaluated eight at a time
+ * with vector gathers of operands and scatters of results.
+ *
+ * Return: Allocated buffer of bit-sliced output values, which must be freed by the caller
+*/
+uint64_t *lpg_inference_graph_infer_host_soa_isa(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, lpg_inference_host_isa_t isa)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+    affirm_nullptr(input_values,"input values");
+    affirmf(words_num > 0,"Number of words per node must be greater than zero");
+
+    __lpg_inference_host_soa_kernel_t kernel = __lpg_inference_host_soa_kernel(isa);
+    lpg_inference_soa_t *soa = lpg_inference_graph_soa(inference_graph);
+
+    uint64_t *values = __lpg_inference_host_batch_values_alloc(soa->slots_num,words_num);
+
+    size_t inputs_size = inference_graph->inputs_size;
+    memcpy(values,input_values,inputs_size*words_num*sizeof(uint64_t));
+
+    size_t outputs_size = inference_graph->outputs_size;
+    uint64_t *output = (uint64_t*)calloc(outputs_size*words_num,sizeof(uint64_t));
+    affirm_bad_malloc(output,"bit-sliced output values",outputs_size*words_num*sizeof(uint64_t));
+
+    kernel(soa,values,words_num);
+
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+        memcpy(output+out_i*words_num,values+soa->output_slots[out_i]*words_num,words_num*sizeof(uint64_t));
+
+    free(values);
+
+    return output;
+}
+
+
+/**
+ * lpg_inference_graph_infer_host_soa - evaluates structure-of-arrays version of inference graph over a batch
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ *
+ * Same as 'lpg_inference_graph_infer_host_soa_isa' with the widest instruction set
+ * supported by the running CPU.
+ *
+ * Return: Allocated buffer of bit-sliced output values, which must be freed by the caller
+*/
+uint64_t *lpg_inference_graph_infer_host_soa(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num)
+{
+    return lpg_inference_graph_infer_host_soa_isa(inference_graph,input_values,words_num,LPG_INFERENCE_HOST_ISA_AUTO);
+}
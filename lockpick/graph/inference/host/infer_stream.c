@@ -0,0 +1,171 @@
+#include <lockpick/graph/inference/host/infer.h>
+#include <lockpick/graph/inference/stream.h>
+#include <lockpick/affirmf.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static inline size_t __lpg_inference_stream_read_varint(const uint8_t **pos)
+{
+    const uint8_t *curr = *pos;
+    size_t value = *curr & 0x7f;
+    for(uint32_t shift = 7; *curr++ & 0x80; shift += 7)
+        value |= (size_t)(*curr & 0x7f) << shift;
+
+    *pos = curr;
+    return value;
+}
+
+
+/*
+    Decodes slots of both parents of binary gate and evaluates it word by word with the given operation of operands.
+*/
+#define __LPG_INFERENCE_STREAM_BINARY(pos,values,dest,words_num,op)                             \
+    {                                                                                           \
+        const uint64_t *a = (values)+__lpg_inference_stream_read_varint(pos)*(words_num);       \
+        const uint64_t *b = (values)+__lpg_inference_stream_read_varint(pos)*(words_num);       \
+        for(size_t word_i = 0; word_i < (words_num); ++word_i)                                  \
+            (dest)[word_i] = op(a[word_i],b[word_i]);                                           \
+    }
+
+
+/*
+    Decodes slots of all three parents of ternary gate and evaluates it word by word with the given operation of operands.
+*/
+#define __LPG_INFERENCE_STREAM_TERNARY(pos,values,dest,words_num,op)                            \
+    {                                                                                           \
+        const uint64_t *a = (values)+__lpg_inference_stream_read_varint(pos)*(words_num);       \
+        const uint64_t *b = (values)+__lpg_inference_stream_read_varint(pos)*(words_num);       \
+        const uint64_t *c = (values)+__lpg_inference_stream_read_varint(pos)*(words_num);       \
+        for(size_t word_i = 0; word_i < (words_num); ++word_i)                                  \
+            (dest)[word_i] = op(a[word_i],b[word_i],c[word_i]);                                 \
+    }
+
+
+/**
+ * lpg_inference_graph_infer_host_stream - evaluates compressed stream of inference graph over a batch
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ *
+ * Drop-in replacement for 'lpg_inference_graph_infer_host_batch' with identical layout of @input_values
+ * and of the returned buffer. Nodes are decoded on the fly from 'lpg_inference_graph_stream' instead of
+ * being read from @sorted_nodes, which trades a few instructions per node for fewer bytes loaded from
+ * memory. This pays off for graphs, which do not fit into cache, especially when ordered with
+ * LPG_INFERENCE_ORDER_DFS, where most slots are encoded with a single byte.
+ *
+ * The stream holds value slots of nodes and indices of all their outputs, so evaluation touches only
+ * the stream, the values of live slots and the returned buffer.
+ *
+ * Return: Allocated buffer of bit-sliced output values, which must be freed by the caller
+*/
+uint64_t *lpg_inference_graph_infer_host_stream(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+    affirm_nullptr(input_values,"input values");
+    affirmf(words_num > 0,"Number of words per node must be greater than zero");
+
+    const lpg_inference_stream_t *stream = lpg_inference_graph_stream(inference_graph);
+
+    uint64_t *values = __lpg_inference_host_batch_values_alloc(inference_graph->slots_num,words_num);
+
+    size_t inputs_size = inference_graph->inputs_size;
+    memcpy(values,input_values,inputs_size*words_num*sizeof(uint64_t));
+
+    size_t outputs_size = inference_graph->outputs_size;
+    uint64_t *output = (uint64_t*)calloc(outputs_size*words_num,sizeof(uint64_t));
+    affirm_bad_malloc(output,"bit-sliced output values",outputs_size*words_num*sizeof(uint64_t));
+
+    const uint8_t *pos = stream->data;
+    for(size_t node_i = 0; node_i < stream->nodes_num; ++node_i)
+    {
+        uint8_t header = *pos++;
+        size_t slot = node_i < stream->inputs_size ? node_i : __lpg_inference_stream_read_varint(&pos);
+        uint64_t *dest = values+slot*words_num;
+
+        cl_char type = header & LPG_INFERENCE_STREAM_TYPE_MASK;
+        switch(type)
+        {
+            case LPG_NODE_PACKED_TYPE_AND:
+                __LPG_INFERENCE_STREAM_BINARY(&pos,values,dest,words_num,__LPG_INFERENCE_HOST_OP_AND);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_OR:
+                __LPG_INFERENCE_STREAM_BINARY(&pos,values,dest,words_num,__LPG_INFERENCE_HOST_OP_OR);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NOT:
+            {
+                const uint64_t *a = values+__lpg_inference_stream_read_varint(&pos)*words_num;
+                for(size_t word_i = 0; word_i < words_num; ++word_i)
+                    dest[word_i] = ~a[word_i];
+                break;
+            }
+
+            case LPG_NODE_PACKED_TYPE_XOR:
+                __LPG_INFERENCE_STREAM_BINARY(&pos,values,dest,words_num,__LPG_INFERENCE_HOST_OP_XOR);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_TRUE:
+                memset(dest,0xff,words_num*sizeof(uint64_t));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_FALSE:
+                memset(dest,0,words_num*sizeof(uint64_t));
+                break;
+
+            case LPG_NODE_PACKED_TYPE_INPUT:
+                // Input values are already in their slots
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NAND:
+                __LPG_INFERENCE_STREAM_BINARY(&pos,values,dest,words_num,__LPG_INFERENCE_HOST_OP_NAND);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NOR:
+                __LPG_INFERENCE_STREAM_BINARY(&pos,values,dest,words_num,__LPG_INFERENCE_HOST_OP_NOR);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XNOR:
+                __LPG_INFERENCE_STREAM_BINARY(&pos,values,dest,words_num,__LPG_INFERENCE_HOST_OP_XNOR);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_ANDNOT:
+                __LPG_INFERENCE_STREAM_BINARY(&pos,values,dest,words_num,__LPG_INFERENCE_HOST_OP_ANDNOT);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_ORNOT:
+                __LPG_INFERENCE_STREAM_BINARY(&pos,values,dest,words_num,__LPG_INFERENCE_HOST_OP_ORNOT);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XOR3:
+                __LPG_INFERENCE_STREAM_TERNARY(&pos,values,dest,words_num,__LPG_INFERENCE_HOST_OP_XOR3);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_MAJ:
+                __LPG_INFERENCE_STREAM_TERNARY(&pos,values,dest,words_num,__LPG_INFERENCE_HOST_OP_MAJ);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_MUX:
+                __LPG_INFERENCE_STREAM_TERNARY(&pos,values,dest,words_num,__LPG_INFERENCE_HOST_OP_MUX);
+                break;
+
+            default:
+                errorf("Unknown type: %d",(uint32_t)type);
+        }
+
+        if(header & LPG_INFERENCE_STREAM_OUTPUT_FLAG)
+        {
+            size_t node_outputs_num = __lpg_inference_stream_read_varint(&pos);
+            for(size_t node_out_i = 0; node_out_i < node_outputs_num; ++node_out_i)
+            {
+                size_t out_i = __lpg_inference_stream_read_varint(&pos);
+                memcpy(output+out_i*words_num,dest,words_num*sizeof(uint64_t));
+            }
+        }
+    }
+
+    free(values);
+
+    return output;
+}
@@ -0,0 +1,348 @@
+#include <lockpick/graph/inference/host/jit.h>
+#include <lockpick/graph/inference/host/infer.h>
+#include <lockpick/affirmf.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Compiler, its flags, output option, object and source paths and terminating NULL
+#define __LPG_INFERENCE_JIT_MAX_ARGS_NUM 64
+
+
+/**
+ * __lpg_inference_jit_emit_source - writes C source of straight-line evaluation function
+ * @inference_graph:    pointer to inference graph object
+ * @source:             file to write the source into
+ *
+ * Every node 'i' is represented by the local variable 'n<i>' holding its bit-sliced word. Values
+ * of outputs are stored after all nodes are evaluated according to @output_nodes, the compiler is
+ * free to schedule the stores anywhere after the corresponding nodes.
+ *
+ * Return: None
+*/
+static void __lpg_inference_jit_emit_source(const lpg_inference_graph_t *inference_graph, FILE *source)
+{
+    fprintf(source,
+        "#include <stdint.h>\n"
+        "#include <stddef.h>\n\n"
+        "void %s(const uint64_t *restrict input_values, uint64_t *restrict output, size_t words_num)\n"
+        "{\n"
+        "    for(size_t word_i = 0; word_i < words_num; ++word_i)\n"
+        "    {\n",LPG_INFERENCE_JIT_KERNEL_NAME);
+
+    for(size_t node_i = 0; node_i < inference_graph->nodes_num; ++node_i)
+    {
+        const lpg_node_packed_t *node = &inference_graph->sorted_nodes[node_i];
+        size_t a = (lpg_inference_graph_uindex_t)node->parents[0];
+        size_t b = (lpg_inference_graph_uindex_t)node->parents[1];
+        size_t c = (lpg_inference_graph_uindex_t)node->parents[2];
+
+        cl_char type = lpg_node_packed_type(node);
+        switch(type)
+        {
+            case LPG_NODE_PACKED_TYPE_INPUT:
+                fprintf(source,"        const uint64_t n%zd = input_values[%zdu*words_num+word_i];\n",node_i,node_i);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_AND:
+                fprintf(source,"        const uint64_t n%zd = n%zd & n%zd;\n",node_i,a,b);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_OR:
+                fprintf(source,"        const uint64_t n%zd = n%zd | n%zd;\n",node_i,a,b);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NOT:
+                fprintf(source,"        const uint64_t n%zd = ~n%zd;\n",node_i,a);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XOR:
+                fprintf(source,"        const uint64_t n%zd = n%zd ^ n%zd;\n",node_i,a,b);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_TRUE:
+                fprintf(source,"        const uint64_t n%zd = ~(uint64_t)0;\n",node_i);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_FALSE:
+                fprintf(source,"        const uint64_t n%zd = 0;\n",node_i);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NAND:
+                fprintf(source,"        const uint64_t n%zd = ~(n%zd & n%zd);\n",node_i,a,b);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_NOR:
+                fprintf(source,"        const uint64_t n%zd = ~(n%zd | n%zd);\n",node_i,a,b);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XNOR:
+                fprintf(source,"        const uint64_t n%zd = ~(n%zd ^ n%zd);\n",node_i,a,b);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_ANDNOT:
+                fprintf(source,"        const uint64_t n%zd = n%zd & ~n%zd;\n",node_i,a,b);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_ORNOT:
+                fprintf(source,"        const uint64_t n%zd = n%zd | ~n%zd;\n",node_i,a,b);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_XOR3:
+                fprintf(source,"        const uint64_t n%zd = n%zd ^ n%zd ^ n%zd;\n",node_i,a,b,c);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_MAJ:
+                fprintf(source,"        const uint64_t n%zd = (n%zd & n%zd) | (n%zd & (n%zd | n%zd));\n",node_i,a,b,c,a,b);
+                break;
+
+            case LPG_NODE_PACKED_TYPE_MUX:
+                fprintf(source,"        const uint64_t n%zd = n%zd ^ ((n%zd ^ n%zd) & n%zd);\n",node_i,a,a,b,c);
+                break;
+
+            default:
+                errorf("Unknown type: %d",(uint32_t)type);
+        }
+    }
+
+    for(size_t out_i = 0; out_i < inference_graph->outputs_size; ++out_i)
+        fprintf(source,"        output[%zdu*words_num+word_i] = n%zd;\n",out_i,(size_t)inference_graph->output_nodes[out_i]);
+
+    fprintf(source,
+        "    }\n"
+        "}\n");
+}
+
+
+/**
+ * __lpg_inference_jit_run_compiler - builds generated source into shared object
+ * @object_path:    path of resulting shared object
+ * @source_path:    path of generated source
+ *
+ * Runs LPG_INFERENCE_JIT_CC with LPG_INFERENCE_JIT_CFLAGS split by spaces directly with 'execvp',
+ * so no shell is involved in interpreting the paths.
+ *
+ * Return: True if the compiler has run and exited successfully
+*/
+static bool __lpg_inference_jit_run_compiler(const char *object_path, const char *source_path)
+{
+    char flags[] = LPG_INFERENCE_JIT_CFLAGS;
+    char *args[__LPG_INFERENCE_JIT_MAX_ARGS_NUM];
+    size_t args_num = 0;
+
+    args[args_num++] = LPG_INFERENCE_JIT_CC;
+    char *save_ptr;
+    for(char *flag = strtok_r(flags," ",&save_ptr); flag; flag = strtok_r(NULL," ",&save_ptr))
+    {
+        affirmf(args_num+5 <= __LPG_INFERENCE_JIT_MAX_ARGS_NUM,"Too many compiler flags in '%s'",LPG_INFERENCE_JIT_CFLAGS);
+        args[args_num++] = flag;
+    }
+    args[args_num++] = "-o";
+    args[args_num++] = (char*)object_path;
+    args[args_num++] = (char*)source_path;
+    args[args_num] = NULL;
+
+    pid_t pid = fork();
+    if(pid < 0)
+        return false;
+
+    if(pid == 0)
+    {
+        execvp(args[0],args);
+        _exit(127);
+    }
+
+    int status;
+    while(waitpid(pid,&status,0) < 0)
+        if(errno != EINTR)
+            return false;
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+
+/**
+ * __lpg_inference_jit_build - generates, compiles and loads evaluation function of inference graph
+ * @inference_graph:    pointer to inference graph object
+ * @jit:                compiled graph object to fill
+ *
+ * Sources are generated inside a private directory created with 'mkdtemp' under $TMPDIR or '/tmp',
+ * so paths are neither predictable nor shared with other users. Temporary files are removed right
+ * after loading or on failure.
+ *
+ * Return: True if the evaluation function has been loaded
+*/
+static bool __lpg_inference_jit_build(const lpg_inference_graph_t *inference_graph, lpg_inference_jit_t *jit)
+{
+    const char *tmp_dir = getenv("TMPDIR");
+    if(!tmp_dir || !*tmp_dir)
+        tmp_dir = "/tmp";
+
+    char dir_path[PATH_MAX],source_path[PATH_MAX],object_path[PATH_MAX];
+    int dir_path_len = snprintf(dir_path,PATH_MAX,"%s/lockpick_jit_XXXXXX",tmp_dir);
+    if(dir_path_len < 0 || dir_path_len >= PATH_MAX || !mkdtemp(dir_path))
+        return false;
+
+    bool loaded = false;
+    int source_path_len = snprintf(source_path,PATH_MAX,"%s/graph.c",dir_path);
+    int object_path_len = snprintf(object_path,PATH_MAX,"%s/graph.so",dir_path);
+    if(source_path_len < 0 || source_path_len >= PATH_MAX || object_path_len < 0 || object_path_len >= PATH_MAX)
+    {
+        rmdir(dir_path);
+        return false;
+    }
+
+    FILE *source = fopen(source_path,"w");
+    if(source)
+    {
+        __lpg_inference_jit_emit_source(inference_graph,source);
+        bool written = !fclose(source);
+
+        if(written && __lpg_inference_jit_run_compiler(object_path,source_path))
+        {
+            jit->handle = dlopen(object_path,RTLD_NOW | RTLD_LOCAL);
+            if(jit->handle)
+            {
+                jit->kernel = (lpg_inference_jit_kernel_t)dlsym(jit->handle,LPG_INFERENCE_JIT_KERNEL_NAME);
+                affirmf(jit->kernel,"Failed to find evaluation function in compiled graph: %s",dlerror());
+                loaded = true;
+            }
+        }
+    }
+
+    unlink(source_path);
+    unlink(object_path);
+    rmdir(dir_path);
+
+    return loaded;
+}
+
+
+/**
+ * __lpg_inference_jit_compile - compiles inference graph into native code
+ * @inference_graph:    pointer to inference graph object
+ *
+ * Generates C source of the evaluation function, builds it into shared object with LPG_INFERENCE_JIT_CC
+ * and loads the result, see '__lpg_inference_jit_build'. If any step fails, e.g. there is no compiler
+ * on the host, the returned object has no @kernel and engines fall back to the interpreter.
+ *
+ * Compilation takes time proportional to the number of nodes, so it pays off only when the
+ * compiled graph is evaluated many times.
+ *
+ * Return: Pointer to compiled graph object
+*/
+lpg_inference_jit_t *__lpg_inference_jit_compile(const lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    size_t jit_size = sizeof(lpg_inference_jit_t);
+    lpg_inference_jit_t *jit = (lpg_inference_jit_t*)malloc(jit_size);
+    affirm_bad_malloc(jit,"compiled inference graph",jit_size);
+
+    jit->handle = NULL;
+    jit->kernel = NULL;
+    __lpg_inference_jit_build(inference_graph,jit);
+
+    return jit;
+}
+
+
+/**
+ * __lpg_inference_jit_release - unloads compiled inference graph
+ * @jit:    pointer to compiled graph object
+ *
+ * Return: None
+*/
+void __lpg_inference_jit_release(lpg_inference_jit_t *jit)
+{
+    affirm_nullptr(jit,"compiled inference graph");
+
+    if(jit->handle)
+        dlclose(jit->handle);
+    free(jit);
+}
+
+
+/**
+ * lpg_inference_graph_jit - returns natively compiled version of inference graph
+ * @inference_graph:    pointer to inference graph object
+ *
+ * The graph is compiled on the first call and cached inside @inference_graph until its release.
+ * Compilation is not synchronized, so call this function once before sharing @inference_graph
+ * between threads. Failed compilation is cached as well: @kernel of the returned object is NULL
+ * then and the graph is not recompiled on subsequent calls.
+ *
+ * Return: Pointer to compiled graph object owned by @inference_graph
+*/
+lpg_inference_jit_t *lpg_inference_graph_jit(lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    if(!inference_graph->jit)
+        inference_graph->jit = __lpg_inference_jit_compile(inference_graph);
+
+    return inference_graph->jit;
+}
+
+
+/**
+ * lpg_inference_graph_infer_host_jit_into - evaluates natively compiled inference graph into caller-provided buffer
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ * @output:             buffer for bit-sliced values of output nodes
+ *
+ * Same as 'lpg_inference_graph_infer_host_jit', but writes into @output, which must hold @words_num
+ * words per output node of the underlying graph. If the graph could not be compiled, it is evaluated
+ * by 'lpg_inference_graph_infer_host_batch' instead.
+ *
+ * Return: None
+*/
+void lpg_inference_graph_infer_host_jit_into(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, uint64_t *output)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+    affirm_nullptr(input_values,"input values");
+    affirm_nullptr(output,"output values");
+    affirmf(words_num > 0,"Number of words per node must be greater than zero");
+
+    lpg_inference_jit_t *jit = lpg_inference_graph_jit(inference_graph);
+    if(jit->kernel)
+    {
+        jit->kernel(input_values,output,words_num);
+        return;
+    }
+
+    uint64_t *interpreted_output = lpg_inference_graph_infer_host_batch(inference_graph,input_values,words_num);
+    memcpy(output,interpreted_output,inference_graph->outputs_size*words_num*sizeof(uint64_t));
+    free(interpreted_output);
+}
+
+
+/**
+ * lpg_inference_graph_infer_host_jit - evaluates natively compiled inference graph over a batch of bit-sliced input vectors
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ *
+ * Drop-in replacement for 'lpg_inference_graph_infer_host_batch' with identical layout of @input_values
+ * and of the returned buffer. The graph is compiled on the first call, see 'lpg_inference_graph_jit'.
+ *
+ * Return: Allocated buffer of bit-sliced output values, which must be freed by the caller
+*/
+uint64_t *lpg_inference_graph_infer_host_jit(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    size_t outputs_size = inference_graph->outputs_size;
+    uint64_t *output = (uint64_t*)calloc(outputs_size*words_num,sizeof(uint64_t));
+    affirm_bad_malloc(output,"bit-sliced output values",outputs_size*words_num*sizeof(uint64_t));
+
+    lpg_inference_graph_infer_host_jit_into(inference_graph,input_values,words_num,output);
+
+    return output;
+}
@@ -0,0 +1,296 @@
+#include <lockpick/graph/inference/host/session.h>
+#include <lockpick/graph/inference/host/infer.h>
+#include <lockpick/affirmf.h>
+#include <stdlib.h>
+
+
+/**
+ * __lpg_inference_host_session_node_value - evaluates single packed node from current values of its parents
+ * @node:       packed node to evaluate
+ * @values:     values of all nodes
+ *
+ * Return: Value of @node
+*/
+static inline bool __lpg_inference_host_session_node_value(const lpg_node_packed_t *node, const lp_bitset_t *values)
+{
+    cl_char type = lpg_node_packed_type(node);
+    switch(type)
+    {
+        case LPG_NODE_PACKED_TYPE_AND:
+            return lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[0]) && lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[1]);
+
+        case LPG_NODE_PACKED_TYPE_OR:
+            return lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[0]) || lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[1]);
+
+        case LPG_NODE_PACKED_TYPE_NOT:
+            return !lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[0]);
+
+        case LPG_NODE_PACKED_TYPE_XOR:
+            return lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[0]) ^ lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[1]);
+
+        case LPG_NODE_PACKED_TYPE_TRUE:
+            return true;
+
+        case LPG_NODE_PACKED_TYPE_FALSE:
+            return false;
+
+        case LPG_NODE_PACKED_TYPE_NAND:
+            return !(lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[0]) && lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[1]));
+
+        case LPG_NODE_PACKED_TYPE_NOR:
+            return !(lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[0]) || lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[1]));
+
+        case LPG_NODE_PACKED_TYPE_XNOR:
+            return lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[0]) == lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[1]);
+
+        case LPG_NODE_PACKED_TYPE_ANDNOT:
+            return lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[0]) && !lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[1]);
+
+        case LPG_NODE_PACKED_TYPE_ORNOT:
+            return lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[0]) || !lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[1]);
+
+        case LPG_NODE_PACKED_TYPE_XOR3:
+            return __LPG_INFERENCE_HOST_OP_XOR3(
+                lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[0]),
+                lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[1]),
+                lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[2]));
+
+        case LPG_NODE_PACKED_TYPE_MAJ:
+            return __LPG_INFERENCE_HOST_OP_MAJ(
+                lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[0]),
+                lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[1]),
+                lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[2]));
+
+        case LPG_NODE_PACKED_TYPE_MUX:
+            return __LPG_INFERENCE_HOST_OP_MUX(
+                lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[0]),
+                lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[1]),
+                lp_bitset_test(values,(lpg_inference_graph_uindex_t)node->parents[2]));
+
+        default:
+            errorf("Unknown type: %d",(uint32_t)type);
+    }
+}
+
+
+/**
+ * __lpg_inference_host_session_set_value - updates value of the node and of outputs it serves
+ * @session:    pointer to session object
+ * @node_i:     index of the node within topologically sorted array
+ * @value:      new value of the node
+ *
+ * Return: None
+*/
+static inline void __lpg_inference_host_session_set_value(lpg_inference_host_session_t *session, size_t node_i, bool value)
+{
+    lp_bitset_update(session->values,node_i,value);
+
+    for(size_t node_out_i = session->node_outputs_offsets[node_i]; node_out_i < session->node_outputs_offsets[node_i+1]; ++node_out_i)
+        lp_bitset_update(session->output,session->node_outputs[node_out_i],value);
+}
+
+
+/**
+ * __lpg_inference_host_session_queue_push - pushes node index into min-heap of scheduled nodes
+ * @session:    pointer to session object
+ * @node_i:     index of the scheduled node
+ *
+ * Return: None
+*/
+static inline void __lpg_inference_host_session_queue_push(lpg_inference_host_session_t *session, lpg_inference_graph_uindex_t node_i)
+{
+    lpg_inference_graph_uindex_t *queue = session->queue;
+    size_t curr_i = session->queue_size++;
+    while(curr_i > 0)
+    {
+        size_t parent_i = (curr_i-1)/2;
+        if(queue[parent_i] <= node_i)
+            break;
+        queue[curr_i] = queue[parent_i];
+        curr_i = parent_i;
+    }
+    queue[curr_i] = node_i;
+}
+
+
+/**
+ * __lpg_inference_host_session_queue_pop - pops the smallest node index from min-heap of scheduled nodes
+ * @session:    pointer to session object
+ *
+ * Return: Index of the scheduled node preceding all other scheduled nodes in topological order
+*/
+static inline lpg_inference_graph_uindex_t __lpg_inference_host_session_queue_pop(lpg_inference_host_session_t *session)
+{
+    lpg_inference_graph_uindex_t *queue = session->queue;
+    lpg_inference_graph_uindex_t top = queue[0];
+    lpg_inference_graph_uindex_t last = queue[--session->queue_size];
+    size_t queue_size = session->queue_size;
+
+    size_t curr_i = 0;
+    while(2*curr_i+1 < queue_size)
+    {
+        size_t child_i = 2*curr_i+1;
+        if(child_i+1 < queue_size && queue[child_i+1] < queue[child_i])
+            ++child_i;
+        if(last <= queue[child_i])
+            break;
+        queue[curr_i] = queue[child_i];
+        curr_i = child_i;
+    }
+    if(queue_size > 0)
+        queue[curr_i] = last;
+
+    return top;
+}
+
+
+/**
+ * __lpg_inference_host_session_schedule_children - schedules children of the node for re-evaluation
+ * @session:    pointer to session object
+ * @node_i:     index of the node, value of which has changed
+ *
+ * Return: None
+*/
+static inline void __lpg_inference_host_session_schedule_children(lpg_inference_host_session_t *session, size_t node_i)
+{
+    const lpg_inference_graph_t *inference_graph = session->inference_graph;
+    size_t children_end = inference_graph->children_offsets[node_i+1];
+    for(size_t child_i = inference_graph->children_offsets[node_i]; child_i < children_end; ++child_i)
+    {
+        lpg_inference_graph_uindex_t child_node_i = (lpg_inference_graph_uindex_t)inference_graph->children[child_i];
+        if(!lp_bitset_set(session->scheduled,child_node_i))
+            __lpg_inference_host_session_queue_push(session,child_node_i);
+    }
+}
+
+
+/**
+ * lpg_inference_host_session_create - creates incremental inference session
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       initial values of input nodes
+ *
+ * Evaluates all nodes of @inference_graph for @input_values and keeps their values for
+ * subsequent incremental updates.
+ *
+ * Return: Pointer to created session object
+*/
+lpg_inference_host_session_t *lpg_inference_host_session_create(lpg_inference_graph_t *inference_graph, const lp_bitset_t *input_values)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+    affirm_nullptr(input_values,"input values");
+
+    size_t inputs_size = inference_graph->inputs_size;
+    affirmf(input_values->size == inputs_size,
+        "Size of input values %zd differs from number of inputs %zd",input_values->size,inputs_size);
+
+    size_t session_size = sizeof(lpg_inference_host_session_t);
+    lpg_inference_host_session_t *session = (lpg_inference_host_session_t*)malloc(session_size);
+    affirm_bad_malloc(session,"inference session",session_size);
+
+    size_t nodes_num = inference_graph->nodes_num;
+    session->inference_graph = inference_graph;
+    session->values = lp_bitset_create(nodes_num);
+    session->output = lp_bitset_create(MAX(1,inference_graph->outputs_size));
+    session->scheduled = lp_bitset_create(nodes_num);
+
+    size_t queue_size = nodes_num*sizeof(lpg_inference_graph_uindex_t);
+    session->queue = (lpg_inference_graph_uindex_t*)malloc(queue_size);
+    affirm_bad_malloc(session->queue,"inference session queue",queue_size);
+    session->queue_size = 0;
+
+    __lpg_inference_graph_build_node_outputs(inference_graph,&session->node_outputs_offsets,&session->node_outputs);
+
+    for(size_t in_node_i = 0; in_node_i < inputs_size; ++in_node_i)
+        __lpg_inference_host_session_set_value(session,in_node_i,lp_bitset_test(input_values,in_node_i));
+
+    for(size_t node_i = inputs_size; node_i < nodes_num; ++node_i)
+    {
+        bool value = __lpg_inference_host_session_node_value(&inference_graph->sorted_nodes[node_i],session->values);
+        __lpg_inference_host_session_set_value(session,node_i,value);
+    }
+
+    return session;
+}
+
+
+/**
+ * lpg_inference_host_session_release - releases incremental inference session
+ * @session:    pointer to session object
+ *
+ * Inference graph used by @session is not released.
+ *
+ * Return: None
+*/
+void lpg_inference_host_session_release(lpg_inference_host_session_t *session)
+{
+    affirm_nullptr(session,"inference session");
+
+    lp_bitset_release(session->values);
+    lp_bitset_release(session->output);
+    lp_bitset_release(session->scheduled);
+    free(session->queue);
+    free(session->node_outputs_offsets);
+    free(session->node_outputs);
+    free(session);
+}
+
+
+/**
+ * lpg_inference_host_session_update - flips values of given inputs and propagates changes
+ * @session:                pointer to session object
+ * @changed_inputs:         indices of input nodes, values of which are flipped
+ * @changed_inputs_num:     number of indices inside @changed_inputs
+ *
+ * Only the nodes of the fan-out cone of @changed_inputs are re-evaluated. Propagation stops at
+ * nodes, values of which remain the same, so the cost is proportional to the number of nodes
+ * that actually change rather than to the size of the graph.
+ *
+ * An input listed twice inside @changed_inputs is flipped twice.
+ *
+ * Return: Values of output nodes owned by @session, valid until the next update or release
+*/
+const lp_bitset_t *lpg_inference_host_session_update(lpg_inference_host_session_t *session, const size_t *changed_inputs, size_t changed_inputs_num)
+{
+    affirm_nullptr(session,"inference session");
+    affirmf(changed_inputs || changed_inputs_num == 0,"Changed inputs must be specified");
+
+    const lpg_inference_graph_t *inference_graph = session->inference_graph;
+    size_t inputs_size = inference_graph->inputs_size;
+    for(size_t changed_i = 0; changed_i < changed_inputs_num; ++changed_i)
+    {
+        size_t in_node_i = changed_inputs[changed_i];
+        affirmf(in_node_i < inputs_size,"Input index %zd is out of range for %zd inputs",in_node_i,inputs_size);
+
+        __lpg_inference_host_session_set_value(session,in_node_i,!lp_bitset_test(session->values,in_node_i));
+        __lpg_inference_host_session_schedule_children(session,in_node_i);
+    }
+
+    while(session->queue_size > 0)
+    {
+        lpg_inference_graph_uindex_t node_i = __lpg_inference_host_session_queue_pop(session);
+        lp_bitset_reset(session->scheduled,node_i);
+
+        bool value = __lpg_inference_host_session_node_value(&inference_graph->sorted_nodes[node_i],session->values);
+        if(value == lp_bitset_test(session->values,node_i))
+            continue;
+
+        __lpg_inference_host_session_set_value(session,node_i,value);
+        __lpg_inference_host_session_schedule_children(session,node_i);
+    }
+
+    return session->output;
+}
+
+
+/**
+ * lpg_inference_host_session_output - values of output nodes for the current inputs
+ * @session:    pointer to session object
+ *
+ * Return: Values of output nodes owned by @session, valid until the next update or release
+*/
+const lp_bitset_t *lpg_inference_host_session_output(const lpg_inference_host_session_t *session)
+{
+    affirm_nullptr(session,"inference session");
+
+    return session->output;
+}
@@ -0,0 +1,160 @@
+#include <lockpick/graph/inference/cone.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/define.h>
+#include <lockpick/vector.h>
+#include <stdlib.h>
+
+
+/**
+ * __lpg_inference_cone_create - extracts fan-in cone of selected outputs of inference graph
+ * @inference_graph:    pointer to inference graph object
+ * @outputs_mask:       outputs of the underlying graph to build the cone for
+ *
+ * Marks nodes of requested outputs and then walks @sorted_nodes backwards, marking parents of every marked
+ * node. Since parents always precede their children, a single backward pass marks the whole cone.
+ * Marked nodes are then copied in their original order with parents reindexed.
+ *
+ * Return: Pointer to created cone object
+*/
+lpg_inference_cone_t *__lpg_inference_cone_create(const lpg_inference_graph_t *inference_graph, const lp_bitset_t *outputs_mask)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+    affirm_nullptr(outputs_mask,"outputs mask");
+
+    size_t outputs_size = inference_graph->outputs_size;
+    affirmf(outputs_mask->size == outputs_size,
+        "Size of outputs mask %zd differs from number of outputs %zd",outputs_mask->size,outputs_size);
+
+    size_t nodes_num = inference_graph->nodes_num;
+    size_t inputs_size = inference_graph->inputs_size;
+    const lpg_node_packed_t *sorted_nodes = inference_graph->sorted_nodes;
+
+    lp_bitset_t *in_cone = lp_bitset_create(nodes_num);
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+    {
+        if(lp_bitset_test(outputs_mask,out_i))
+            lp_bitset_set(in_cone,inference_graph->output_nodes[out_i]);
+    }
+
+    for(size_t node_i = nodes_num; node_i > 0; --node_i)
+    {
+        const lpg_node_packed_t *node = &sorted_nodes[node_i-1];
+        if(!lp_bitset_test(in_cone,node_i-1))
+            continue;
+
+        uint16_t parents_num = lpg_node_packed_get_parents_num(node);
+        for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+            lp_bitset_set(in_cone,(lpg_inference_graph_uindex_t)node->parents[parent_i]);
+    }
+
+    size_t cone_size = sizeof(lpg_inference_cone_t);
+    lpg_inference_cone_t *cone = (lpg_inference_cone_t*)malloc(cone_size);
+    affirm_bad_malloc(cone,"inference cone",cone_size);
+
+    cone->outputs_mask = lp_bitset_create(outputs_size);
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+        lp_bitset_update(cone->outputs_mask,out_i,lp_bitset_test(outputs_mask,out_i));
+
+    // Index of each node of the cone within the compacted array
+    size_t cone_indices_size = nodes_num*sizeof(lpg_inference_graph_uindex_t);
+    lpg_inference_graph_uindex_t *cone_indices = (lpg_inference_graph_uindex_t*)malloc(cone_indices_size);
+    affirm_bad_malloc(cone_indices,"cone indices array",cone_indices_size);
+
+    size_t cone_sorted_nodes_size = nodes_num*sizeof(lpg_node_packed_t);
+    cone->sorted_nodes = (lpg_node_packed_t*)malloc(cone_sorted_nodes_size);
+    affirm_bad_malloc(cone->sorted_nodes,"cone sorted nodes array",cone_sorted_nodes_size);
+
+    size_t cone_nodes_num = 0;
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+    {
+        if(node_i >= inputs_size && !lp_bitset_test(in_cone,node_i))
+            continue;
+
+        lpg_node_packed_t cone_node = sorted_nodes[node_i];
+        uint16_t parents_num = lpg_node_packed_get_parents_num(&cone_node);
+        for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+            cone_node.parents[parent_i] = cone_indices[(lpg_inference_graph_uindex_t)cone_node.parents[parent_i]];
+
+        cone->sorted_nodes[cone_nodes_num] = cone_node;
+        cone_indices[node_i] = cone_nodes_num++;
+    }
+
+    size_t cone_output_nodes_size = MAX(1,outputs_size)*sizeof(lpg_inference_graph_uindex_t);
+    cone->output_nodes = (lpg_inference_graph_uindex_t*)malloc(cone_output_nodes_size);
+    affirm_bad_malloc(cone->output_nodes,"cone output nodes array",cone_output_nodes_size);
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+        cone->output_nodes[out_i] = lp_bitset_test(outputs_mask,out_i) ? cone_indices[inference_graph->output_nodes[out_i]] : 0;
+
+    cone->nodes_num = cone_nodes_num;
+    cone->narrow_nodes = __lpg_node_packed_narrow(cone->sorted_nodes,cone_nodes_num);
+    cone->node_slots = __lpg_node_packed_alloc_slots(cone->sorted_nodes,cone_nodes_num,inputs_size,
+        cone->output_nodes,outputs_size,cone->outputs_mask,&cone->slots_num);
+
+    free(cone_indices);
+    lp_bitset_release(in_cone);
+
+    return cone;
+}
+
+
+/**
+ * __lpg_inference_cone_release - releases fan-in cone
+ * @cone:   pointer to cone object
+ *
+ * Return: None
+*/
+void __lpg_inference_cone_release(lpg_inference_cone_t *cone)
+{
+    affirm_nullptr(cone,"inference cone");
+
+    lp_bitset_release(cone->outputs_mask);
+    free(cone->sorted_nodes);
+    free(cone->narrow_nodes);
+    free(cone->output_nodes);
+    free(cone->node_slots);
+    free(cone);
+}
+
+
+static bool __lpg_inference_cone_mask_eq(const lp_bitset_t *a, const lp_bitset_t *b)
+{
+    for(size_t out_i = 0; out_i < a->size; ++out_i)
+        if(lp_bitset_test(a,out_i) != lp_bitset_test(b,out_i))
+            return false;
+
+    return true;
+}
+
+
+/**
+ * lpg_inference_graph_cone - returns fan-in cone of selected outputs of inference graph
+ * @inference_graph:    pointer to inference graph object
+ * @outputs_mask:       outputs of the underlying graph to get the cone for
+ *
+ * Cones are built on the first request for every distinct @outputs_mask and cached inside
+ * @inference_graph until its release. The number of distinct masks is expected to be small,
+ * so cached cones are looked up linearly. Lookup is not synchronized, so request all needed
+ * cones before sharing @inference_graph between threads.
+ *
+ * Return: Pointer to cone object owned by @inference_graph
+*/
+lpg_inference_cone_t *lpg_inference_graph_cone(lpg_inference_graph_t *inference_graph, const lp_bitset_t *outputs_mask)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+    affirm_nullptr(outputs_mask,"outputs mask");
+
+    if(!inference_graph->cones)
+        inference_graph->cones = lp_vector_create(1,sizeof(lpg_inference_cone_t*));
+
+    for(size_t cone_i = 0; cone_i < inference_graph->cones->size; ++cone_i)
+    {
+        lpg_inference_cone_t *cone = lp_vector_at_type(inference_graph->cones,cone_i,lpg_inference_cone_t*);
+        if(cone->outputs_mask->size == outputs_mask->size && __lpg_inference_cone_mask_eq(cone->outputs_mask,outputs_mask))
+            return cone;
+    }
+
+    lpg_inference_cone_t *cone = __lpg_inference_cone_create(inference_graph,outputs_mask);
+    lp_vector_push_back(inference_graph->cones,&cone);
+
+    return cone;
+}
@@ -0,0 +1,554 @@
+#include <lockpick/graph/inference/inference_graph.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/define.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/*
+    State of fusion shared by all visited nodes. Current parents of node 'i' occupy
+    LPG_NODE_PACKED_MAX_PARENTS_NUM entries of @parents starting from 'i*LPG_NODE_PACKED_MAX_PARENTS_NUM'
+    and @uses counts references to each node from current parents of other nodes.
+*/
+typedef struct __lpg_inference_fuse
+{
+    size_t inputs_size;
+    const lp_bitset_t *is_output;
+    cl_char *types;
+    size_t *parents;
+    size_t *uses;
+    lp_bitset_t *removed;
+} __lpg_inference_fuse_t;
+
+
+static inline size_t *__lpg_inference_fuse_parents(const __lpg_inference_fuse_t *fuse, size_t node_i)
+{
+    return fuse->parents+LPG_NODE_PACKED_MAX_PARENTS_NUM*node_i;
+}
+
+
+static inline uint16_t __lpg_inference_fuse_parents_num(const __lpg_inference_fuse_t *fuse, size_t node_i)
+{
+    lpg_node_packed_t node = {0};
+    __lpg_node_packed_set_type(&node,fuse->types[node_i]);
+    return lpg_node_packed_get_parents_num(&node);
+}
+
+
+/**
+ * __lpg_inference_fuse_is_gate - checks if node is a gate of the given plain type
+ * @fuse:       pointer to fusion state
+ * @node_i:     index of the node within @sorted_nodes
+ * @type:       expected type of the node
+ *
+ * Return: True if @node_i is not an input node and its current type is @type
+*/
+static inline bool __lpg_inference_fuse_is_gate(const __lpg_inference_fuse_t *fuse, size_t node_i, cl_char type)
+{
+    return node_i >= fuse->inputs_size && fuse->types[node_i] == type;
+}
+
+
+/**
+ * __lpg_inference_fuse_absorbable - checks if node can be absorbed by its only child
+ * @fuse:       pointer to fusion state
+ * @node_i:     index of the node within @sorted_nodes
+ *
+ * Value of absorbed node is not stored anywhere, so the node must be a gate, which is neither an output
+ * nor an operand of any node but the one absorbing it. Only nodes of plain types are absorbed, so fused
+ * nodes are never absorbed again.
+ *
+ * Return: True if @node_i can be absorbed
+*/
+static bool __lpg_inference_fuse_absorbable(const __lpg_inference_fuse_t *fuse, size_t node_i)
+{
+    if(node_i < fuse->inputs_size || lp_bitset_test(fuse->is_output,node_i) || fuse->uses[node_i] != 1)
+        return false;
+
+    cl_char type = fuse->types[node_i];
+    return type == LPG_NODE_PACKED_TYPE_AND || type == LPG_NODE_PACKED_TYPE_OR ||
+           type == LPG_NODE_PACKED_TYPE_XOR || type == LPG_NODE_PACKED_TYPE_NOT;
+}
+
+
+/**
+ * __lpg_inference_fuse_release - drops single reference to node
+ * @fuse:       pointer to fusion state
+ * @node_i:     index of the node within @sorted_nodes
+ *
+ * Gates, which are neither outputs nor operands of any node anymore, are removed, dropping references
+ * to their own parents in turn.
+ *
+ * Return: None
+*/
+static void __lpg_inference_fuse_release(__lpg_inference_fuse_t *fuse, size_t node_i)
+{
+    affirmf_debug(fuse->uses[node_i] > 0,"Node %zd is not used",node_i);
+
+    if(--fuse->uses[node_i] > 0 || node_i < fuse->inputs_size || lp_bitset_test(fuse->is_output,node_i))
+        return;
+
+    lp_bitset_set(fuse->removed,node_i);
+
+    uint16_t parents_num = __lpg_inference_fuse_parents_num(fuse,node_i);
+    size_t *node_parents = __lpg_inference_fuse_parents(fuse,node_i);
+    for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+        __lpg_inference_fuse_release(fuse,node_parents[parent_i]);
+}
+
+
+/**
+ * __lpg_inference_fuse_replace - turns node into fused gate over new parents
+ * @fuse:           pointer to fusion state
+ * @node_i:         index of the node within @sorted_nodes
+ * @type:           fused type of the node
+ * @new_parents:    parents of the fused node, as many as @type reads
+ *
+ * New parents are referenced before old ones are released, so nodes, which are operands of both,
+ * are never removed.
+ *
+ * Return: None
+*/
+static void __lpg_inference_fuse_replace(__lpg_inference_fuse_t *fuse, size_t node_i, cl_char type, const size_t *new_parents)
+{
+    size_t *node_parents = __lpg_inference_fuse_parents(fuse,node_i);
+    size_t old_parents[LPG_NODE_PACKED_MAX_PARENTS_NUM];
+    uint16_t old_parents_num = __lpg_inference_fuse_parents_num(fuse,node_i);
+    for(uint16_t parent_i = 0; parent_i < old_parents_num; ++parent_i)
+        old_parents[parent_i] = node_parents[parent_i];
+
+    fuse->types[node_i] = type;
+    uint16_t parents_num = __lpg_inference_fuse_parents_num(fuse,node_i);
+    for(uint16_t parent_i = 0; parent_i < LPG_NODE_PACKED_MAX_PARENTS_NUM; ++parent_i)
+    {
+        node_parents[parent_i] = parent_i < parents_num ? new_parents[parent_i] : 0;
+        if(parent_i < parents_num)
+            ++fuse->uses[node_parents[parent_i]];
+    }
+
+    for(uint16_t parent_i = 0; parent_i < old_parents_num; ++parent_i)
+        __lpg_inference_fuse_release(fuse,old_parents[parent_i]);
+}
+
+
+/**
+ * __lpg_inference_fuse_xor3 - fuses XOR of XOR into single parity gate
+ * @fuse:       pointer to fusion state
+ * @node_i:     index of XOR node within @sorted_nodes
+ *
+ * An operand of the node, which is a plain XOR itself, is bypassed even if it has other children: the value
+ * of the node costs a single gate either way, and the operand is removed once its last child bypasses it.
+ * E.g. 'a^b' of a full adder feeds both the sum and the carry and disappears when both are fused.
+ * Absorbable operands are preferred, since bypassing them removes a gate right away.
+ *
+ * Return: True if the node was fused
+*/
+static bool __lpg_inference_fuse_xor3(__lpg_inference_fuse_t *fuse, size_t node_i)
+{
+    const size_t *node_parents = __lpg_inference_fuse_parents(fuse,node_i);
+    if(node_parents[0] == node_parents[1])
+        return false;
+
+    size_t fused_parent_i = SIZE_MAX;
+    for(uint16_t parent_i = 0; parent_i < 2; ++parent_i)
+    {
+        size_t parent = node_parents[parent_i];
+        if(!__lpg_inference_fuse_is_gate(fuse,parent,LPG_NODE_PACKED_TYPE_XOR))
+            continue;
+
+        if(fused_parent_i == SIZE_MAX || __lpg_inference_fuse_absorbable(fuse,parent))
+            fused_parent_i = parent_i;
+    }
+
+    if(fused_parent_i == SIZE_MAX)
+        return false;
+
+    const size_t *xor_parents = __lpg_inference_fuse_parents(fuse,node_parents[fused_parent_i]);
+    size_t new_parents[] = {xor_parents[0],xor_parents[1],node_parents[1-fused_parent_i]};
+    __lpg_inference_fuse_replace(fuse,node_i,LPG_NODE_PACKED_TYPE_XOR3,new_parents);
+    return true;
+}
+
+
+/**
+ * __lpg_inference_fuse_maj - fuses carry of full adder into single majority gate
+ * @fuse:       pointer to fusion state
+ * @node_i:     index of OR node within @sorted_nodes
+ *
+ * Matches '(a&b)|(c&t)' with 't' being either 'a^b' or 'a|b' in any order of operands, which equals
+ * the majority of 'a', 'b' and 'c'. Both AND gates must be absorbable, 't' may have other children.
+ *
+ * Return: True if the node was fused
+*/
+static bool __lpg_inference_fuse_maj(__lpg_inference_fuse_t *fuse, size_t node_i)
+{
+    const size_t *node_parents = __lpg_inference_fuse_parents(fuse,node_i);
+    if(node_parents[0] == node_parents[1])
+        return false;
+
+    for(uint16_t parent_i = 0; parent_i < 2; ++parent_i)
+    {
+        if(!__lpg_inference_fuse_absorbable(fuse,node_parents[parent_i]) ||
+           fuse->types[node_parents[parent_i]] != LPG_NODE_PACKED_TYPE_AND)
+            return false;
+    }
+
+    for(uint16_t parent_i = 0; parent_i < 2; ++parent_i)
+    {
+        const size_t *ab = __lpg_inference_fuse_parents(fuse,node_parents[parent_i]);
+        const size_t *ct = __lpg_inference_fuse_parents(fuse,node_parents[1-parent_i]);
+        for(uint16_t t_i = 0; t_i < 2; ++t_i)
+        {
+            size_t t = ct[t_i];
+            if(!__lpg_inference_fuse_is_gate(fuse,t,LPG_NODE_PACKED_TYPE_XOR) && !__lpg_inference_fuse_is_gate(fuse,t,LPG_NODE_PACKED_TYPE_OR))
+                continue;
+
+            const size_t *t_parents = __lpg_inference_fuse_parents(fuse,t);
+            if((t_parents[0] != ab[0] || t_parents[1] != ab[1]) && (t_parents[0] != ab[1] || t_parents[1] != ab[0]))
+                continue;
+
+            size_t new_parents[] = {ab[0],ab[1],ct[1-t_i]};
+            __lpg_inference_fuse_replace(fuse,node_i,LPG_NODE_PACKED_TYPE_MAJ,new_parents);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * __lpg_inference_fuse_mux - fuses selection between two operands into single multiplexer gate
+ * @fuse:       pointer to fusion state
+ * @node_i:     index of OR node within @sorted_nodes
+ *
+ * Matches '(a&~s)|(b&s)' in any order of operands, where 'a&~s' is either an ANDNOT gate fused before
+ * or an AND with a NOT operand. Both gates of the disjunction must be absorbable, the negation of 's'
+ * is removed as well if nothing else uses it.
+ *
+ * Return: True if the node was fused
+*/
+static bool __lpg_inference_fuse_mux(__lpg_inference_fuse_t *fuse, size_t node_i)
+{
+    const size_t *node_parents = __lpg_inference_fuse_parents(fuse,node_i);
+    if(node_parents[0] == node_parents[1])
+        return false;
+
+    for(uint16_t parent_i = 0; parent_i < 2; ++parent_i)
+    {
+        size_t parent = node_parents[parent_i];
+        // Fused gates are not absorbable, so ANDNOT is checked separately
+        bool absorbable = __lpg_inference_fuse_absorbable(fuse,parent) ||
+            (__lpg_inference_fuse_is_gate(fuse,parent,LPG_NODE_PACKED_TYPE_ANDNOT) && fuse->uses[parent] == 1 &&
+             !lp_bitset_test(fuse->is_output,parent));
+        if(!absorbable)
+            return false;
+    }
+
+    for(uint16_t parent_i = 0; parent_i < 2; ++parent_i)
+    {
+        size_t low = node_parents[parent_i];
+        size_t high = node_parents[1-parent_i];
+        if(fuse->types[high] != LPG_NODE_PACKED_TYPE_AND)
+            continue;
+
+        // Find 'a' and 's' of 'a&~s'
+        const size_t *low_parents = __lpg_inference_fuse_parents(fuse,low);
+        size_t a, s;
+        if(fuse->types[low] == LPG_NODE_PACKED_TYPE_ANDNOT)
+        {
+            a = low_parents[0];
+            s = low_parents[1];
+        }
+        else if(fuse->types[low] == LPG_NODE_PACKED_TYPE_AND && __lpg_inference_fuse_is_gate(fuse,low_parents[1],LPG_NODE_PACKED_TYPE_NOT))
+        {
+            a = low_parents[0];
+            s = __lpg_inference_fuse_parents(fuse,low_parents[1])[0];
+        }
+        else if(fuse->types[low] == LPG_NODE_PACKED_TYPE_AND && __lpg_inference_fuse_is_gate(fuse,low_parents[0],LPG_NODE_PACKED_TYPE_NOT))
+        {
+            a = low_parents[1];
+            s = __lpg_inference_fuse_parents(fuse,low_parents[0])[0];
+        }
+        else
+            continue;
+
+        const size_t *high_parents = __lpg_inference_fuse_parents(fuse,high);
+        for(uint16_t s_i = 0; s_i < 2; ++s_i)
+        {
+            if(high_parents[s_i] != s)
+                continue;
+
+            size_t new_parents[] = {a,high_parents[1-s_i],s};
+            __lpg_inference_fuse_replace(fuse,node_i,LPG_NODE_PACKED_TYPE_MUX,new_parents);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * __lpg_inference_fuse_negation - absorbs negations into gate
+ * @fuse:       pointer to fusion state
+ * @node_i:     index of the node within @sorted_nodes
+ *
+ * Negation of AND, OR and XOR becomes NAND, NOR and XNOR respectively. Binary gates absorb negated operands:
+ * a single negated operand turns AND into ANDNOT, OR into ORNOT and XOR into XNOR with the negated operand
+ * moved to the second position, while two negated operands turn AND into NOR, OR into NAND and leave XOR as is.
+ *
+ * Return: None
+*/
+static void __lpg_inference_fuse_negation(__lpg_inference_fuse_t *fuse, size_t node_i)
+{
+    cl_char type = fuse->types[node_i];
+    const size_t *node_parents = __lpg_inference_fuse_parents(fuse,node_i);
+
+    if(type == LPG_NODE_PACKED_TYPE_NOT)
+    {
+        size_t parent = node_parents[0];
+        if(!__lpg_inference_fuse_absorbable(fuse,parent) || fuse->types[parent] == LPG_NODE_PACKED_TYPE_NOT)
+            return;
+
+        cl_char fused_type = LPG_NODE_PACKED_TYPE_NAND;
+        switch(fuse->types[parent])
+        {
+            case LPG_NODE_PACKED_TYPE_AND: fused_type = LPG_NODE_PACKED_TYPE_NAND; break;
+            case LPG_NODE_PACKED_TYPE_OR:  fused_type = LPG_NODE_PACKED_TYPE_NOR;  break;
+            case LPG_NODE_PACKED_TYPE_XOR: fused_type = LPG_NODE_PACKED_TYPE_XNOR; break;
+        }
+
+        __lpg_inference_fuse_replace(fuse,node_i,fused_type,__lpg_inference_fuse_parents(fuse,parent));
+        return;
+    }
+
+    if(type != LPG_NODE_PACKED_TYPE_AND && type != LPG_NODE_PACKED_TYPE_OR && type != LPG_NODE_PACKED_TYPE_XOR)
+        return;
+
+    bool negated[2];
+    size_t new_parents[2];
+    for(uint16_t parent_i = 0; parent_i < 2; ++parent_i)
+    {
+        size_t parent = node_parents[parent_i];
+        negated[parent_i] = __lpg_inference_fuse_absorbable(fuse,parent) && fuse->types[parent] == LPG_NODE_PACKED_TYPE_NOT;
+        new_parents[parent_i] = negated[parent_i] ? __lpg_inference_fuse_parents(fuse,parent)[0] : parent;
+    }
+
+    if(!negated[0] && !negated[1])
+        return;
+
+    if(negated[0] && negated[1])
+    {
+        // De Morgan's laws, negations of both operands of XOR cancel out
+        cl_char fused_type = type;
+        if(type == LPG_NODE_PACKED_TYPE_AND)
+            fused_type = LPG_NODE_PACKED_TYPE_NOR;
+        else if(type == LPG_NODE_PACKED_TYPE_OR)
+            fused_type = LPG_NODE_PACKED_TYPE_NAND;
+
+        __lpg_inference_fuse_replace(fuse,node_i,fused_type,new_parents);
+        return;
+    }
+
+    // Fused types negate the second operand
+    if(negated[0])
+    {
+        size_t tmp = new_parents[0];
+        new_parents[0] = new_parents[1];
+        new_parents[1] = tmp;
+    }
+
+    cl_char fused_type = LPG_NODE_PACKED_TYPE_ANDNOT;
+    switch(type)
+    {
+        case LPG_NODE_PACKED_TYPE_AND: fused_type = LPG_NODE_PACKED_TYPE_ANDNOT; break;
+        case LPG_NODE_PACKED_TYPE_OR:  fused_type = LPG_NODE_PACKED_TYPE_ORNOT;  break;
+        case LPG_NODE_PACKED_TYPE_XOR: fused_type = LPG_NODE_PACKED_TYPE_XNOR;  break;
+    }
+
+    __lpg_inference_fuse_replace(fuse,node_i,fused_type,new_parents);
+}
+
+
+/**
+ * __lpg_inference_fuse_node - replaces node and its parents with a single fused node where possible
+ * @fuse:       pointer to fusion state
+ * @node_i:     index of the node within @sorted_nodes
+ *
+ * Ternary patterns are tried first, since they replace more gates, see '__lpg_inference_fuse_xor3',
+ * '__lpg_inference_fuse_maj' and '__lpg_inference_fuse_mux'. Otherwise negations are absorbed,
+ * see '__lpg_inference_fuse_negation'.
+ *
+ * Return: None
+*/
+static void __lpg_inference_fuse_node(__lpg_inference_fuse_t *fuse, size_t node_i)
+{
+    if(node_i < fuse->inputs_size)
+        return;
+
+    cl_char type = fuse->types[node_i];
+    if(type == LPG_NODE_PACKED_TYPE_XOR && __lpg_inference_fuse_xor3(fuse,node_i))
+        return;
+
+    if(type == LPG_NODE_PACKED_TYPE_OR && (__lpg_inference_fuse_maj(fuse,node_i) || __lpg_inference_fuse_mux(fuse,node_i)))
+        return;
+
+    __lpg_inference_fuse_negation(fuse,node_i);
+}
+
+
+/**
+ * lpg_inference_graph_fuse - creates inference graph with groups of gates fused into single packed nodes
+ * @inference_graph:    pointer to inference graph object
+ *
+ * Gates are merged into their children whenever the group is expressible with one of fused packed types,
+ * see '__lpg_inference_fuse_node': parity of three operands, majority of three operands as in the carry
+ * of a full adder, selection of one of two operands, NOT following AND, OR or XOR and NOT preceding an
+ * operand of AND, OR or XOR. Nodes are visited in topological order, so a node absorbs its parents before
+ * it may itself be absorbed, and fused nodes are never absorbed again.
+ *
+ * Every node keeps the number of references to it from current parents of other nodes. A gate, which is
+ * neither an output nor referenced anymore, is dropped, so a fused node may replace several gates and
+ * gates shared by several fused children are dropped once all of them bypass it. A full adder takes two
+ * ternary gates instead of five plain ones.
+ *
+ * Every dropped gate saves a packed node, a value slot and a dispatch of engines, which evaluate fused types with a single
+ * operation where the instruction set allows, e.g. with ternary logic of AVX-512.
+ *
+ * Surviving nodes keep their relative order, outputs they serve and levels: new parents of a fused node are parents of its
+ * bypassed parents, which reside in even earlier levels. Levels left empty are dropped. The result does not refer to
+ * the underlying general-purpose graph, so only engines and functions, which do not need @graph, @index_map or
+ * @inv_index_map, can be used with it. @inference_graph is not modified and may be released independently.
+ *
+ * Return: Pointer to created inference graph object
+*/
+lpg_inference_graph_t *lpg_inference_graph_fuse(const lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    size_t nodes_num = inference_graph->nodes_num;
+    size_t outputs_size = inference_graph->outputs_size;
+    const lpg_node_packed_t *sorted_nodes = inference_graph->sorted_nodes;
+
+    lp_bitset_t *is_output = lp_bitset_create(MAX(1,nodes_num));
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+        lp_bitset_set(is_output,inference_graph->output_nodes[out_i]);
+
+    __lpg_inference_fuse_t fuse;
+    fuse.inputs_size = inference_graph->inputs_size;
+    fuse.is_output = is_output;
+
+    size_t types_size = MAX(1,nodes_num)*sizeof(cl_char);
+    fuse.types = (cl_char*)malloc(types_size);
+    affirm_bad_malloc(fuse.types,"fused types array",types_size);
+
+    size_t parents_size = MAX(1,nodes_num)*LPG_NODE_PACKED_MAX_PARENTS_NUM*sizeof(size_t);
+    fuse.parents = (size_t*)malloc(parents_size);
+    affirm_bad_malloc(fuse.parents,"fused parents array",parents_size);
+
+    fuse.uses = (size_t*)calloc(MAX(1,nodes_num),sizeof(size_t));
+    affirm_bad_malloc(fuse.uses,"uses array",MAX(1,nodes_num)*sizeof(size_t));
+
+    fuse.removed = lp_bitset_create(MAX(1,nodes_num));
+
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+    {
+        const lpg_node_packed_t *node = &sorted_nodes[node_i];
+        fuse.types[node_i] = lpg_node_packed_type(node);
+        uint16_t parents_num = lpg_node_packed_get_parents_num(node);
+        size_t *node_parents = __lpg_inference_fuse_parents(&fuse,node_i);
+        for(uint16_t parent_i = 0; parent_i < LPG_NODE_PACKED_MAX_PARENTS_NUM; ++parent_i)
+        {
+            node_parents[parent_i] = parent_i < parents_num ? (lpg_inference_graph_uindex_t)node->parents[parent_i] : 0;
+            if(parent_i < parents_num)
+                ++fuse.uses[node_parents[parent_i]];
+        }
+    }
+
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+    {
+        if(!lp_bitset_test(fuse.removed,node_i))
+            __lpg_inference_fuse_node(&fuse,node_i);
+    }
+
+    size_t fused_size = sizeof(lpg_inference_graph_t);
+    lpg_inference_graph_t *fused = (lpg_inference_graph_t*)malloc(fused_size);
+    affirm_bad_malloc(fused,"fused inference graph",fused_size);
+
+    fused->graph = NULL;
+    fused->id = __lpg_inference_graph_next_id();
+    fused->inputs_size = inference_graph->inputs_size;
+    fused->outputs_size = outputs_size;
+    fused->index_map = NULL;
+    fused->inv_index_map = NULL;
+    fused->identity_slots = NULL;
+    fused->jit = NULL;
+    fused->cones = NULL;
+    fused->soa = NULL;
+    fused->stream = NULL;
+    fused->mapping = NULL;
+    fused->mapping_size = 0;
+
+    // Index of each surviving node within the fused array
+    size_t fused_indices_size = MAX(1,nodes_num)*sizeof(lpg_inference_graph_uindex_t);
+    lpg_inference_graph_uindex_t *fused_indices = (lpg_inference_graph_uindex_t*)malloc(fused_indices_size);
+    affirm_bad_malloc(fused_indices,"fused indices array",fused_indices_size);
+
+    size_t sorted_nodes_size = MAX(1,nodes_num)*sizeof(lpg_node_packed_t);
+    fused->sorted_nodes = (lpg_node_packed_t*)malloc(sorted_nodes_size);
+    affirm_bad_malloc(fused->sorted_nodes,"fused sorted nodes array",sorted_nodes_size);
+
+    size_t level_offsets_size = (inference_graph->levels_num+1)*sizeof(size_t);
+    fused->level_offsets = (size_t*)malloc(level_offsets_size);
+    affirm_bad_malloc(fused->level_offsets,"fused level offsets array",level_offsets_size);
+
+    size_t fused_nodes_num = 0;
+    size_t fused_levels_num = 0;
+    for(size_t level_i = 0; level_i < inference_graph->levels_num; ++level_i)
+    {
+        size_t level_begin = fused_nodes_num;
+        for(size_t node_i = inference_graph->level_offsets[level_i]; node_i < inference_graph->level_offsets[level_i+1]; ++node_i)
+        {
+            if(lp_bitset_test(fuse.removed,node_i))
+                continue;
+
+            lpg_node_packed_t fused_node = sorted_nodes[node_i];
+            __lpg_node_packed_set_type(&fused_node,fuse.types[node_i]);
+            uint16_t parents_num = lpg_node_packed_get_parents_num(&fused_node);
+            const size_t *node_parents = __lpg_inference_fuse_parents(&fuse,node_i);
+            // Unused parents are zeroed, so saved graphs do not depend on indices of dropped nodes
+            for(uint16_t parent_i = 0; parent_i < LPG_NODE_PACKED_MAX_PARENTS_NUM; ++parent_i)
+                fused_node.parents[parent_i] = parent_i < parents_num ? fused_indices[node_parents[parent_i]] : 0;
+
+            fused->sorted_nodes[fused_nodes_num] = fused_node;
+            fused_indices[node_i] = fused_nodes_num++;
+        }
+
+        if(fused_nodes_num > level_begin)
+            fused->level_offsets[fused_levels_num++] = level_begin;
+    }
+    fused->level_offsets[fused_levels_num] = fused_nodes_num;
+    fused->levels_num = fused_levels_num;
+    fused->nodes_num = fused_nodes_num;
+
+    size_t output_nodes_size = MAX(1,outputs_size)*sizeof(lpg_inference_graph_uindex_t);
+    fused->output_nodes = (lpg_inference_graph_uindex_t*)malloc(output_nodes_size);
+    affirm_bad_malloc(fused->output_nodes,"fused output nodes array",output_nodes_size);
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+        fused->output_nodes[out_i] = fused_indices[inference_graph->output_nodes[out_i]];
+
+    free(fused_indices);
+    free(fuse.parents);
+    free(fuse.types);
+    free(fuse.uses);
+    lp_bitset_release(fuse.removed);
+    lp_bitset_release(is_output);
+
+    __lpg_inference_graph_build_children(fused);
+    __lpg_inference_graph_alloc_slots(fused);
+    // Fusion may bring a wide graph within the narrow limit
+    __lpg_inference_graph_select_index(fused);
+
+    return fused;
+}
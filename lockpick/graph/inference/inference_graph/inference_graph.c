@@ -1,102 +1,341 @@
 #include <lockpick/graph/inference/inference_graph.h>
-#include <lockpick/graph/count.h>
+#include <lockpick/graph/inference/host/jit.h>
+#include <lockpick/graph/inference/cone.h>
+#include <lockpick/graph/inference/soa.h>
+#include <lockpick/graph/inference/stream.h>
 #include <lockpick/affirmf.h>
+#include <lockpick/affinity.h>
 #include <lockpick/utility.h>
-#include <lockpick/htable.h>
+#include <lockpick/math.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
 
 
-lpg_inference_graph_t *lpg_inference_graph_create(lpg_graph_t *graph, bool gen_inverse_index)
+/**
+ * __lpg_inference_graph_next_id - generates identifier of a new inference graph
+ *
+ * Identifiers are never reused within the process, unlike addresses of released graphs, so caches
+ * of derived data outside of the graph, like device copies, can be keyed on them.
+ *
+ * Return: Unique identifier
+*/
+uint64_t __lpg_inference_graph_next_id()
 {
-    affirm_nullptr(graph,"graph");
+    static _Atomic uint64_t next_id = 1;
+
+    return atomic_fetch_add(&next_id,1);
+}
 
-    size_t redundant_inputs_num = lpg_graph_count_redundant_inputs(graph);
-    affirmf(redundant_inputs_num == 0,
-        "Given graph contains %zd redundant input nodes and cannot be converted to ocl graph",redundant_inputs_num);
+
+/**
+ * __lpg_inference_graph_alloc - allocates inference graph object for general-purpose graph
+ * @graph:      graph to encode
+ *
+ * Sets fields, which do not depend on sorting, and checks limits known before sorting.
+ *
+ * Return: Pointer to allocated inference graph object
+*/
+static lpg_inference_graph_t *__lpg_inference_graph_alloc(lpg_graph_t *graph)
+{
+    affirm_nullptr(graph,"graph");
 
     size_t inference_graph_size = sizeof(lpg_inference_graph_t);
     lpg_inference_graph_t *inference_graph = (lpg_inference_graph_t*)malloc(inference_graph_size);
     affirm_bad_malloc(inference_graph,"ocl graph",inference_graph_size);
 
     inference_graph->graph = graph;
+    inference_graph->id = __lpg_inference_graph_next_id();
+    inference_graph->inputs_size = graph->inputs_size;
+    inference_graph->outputs_size = graph->outputs_size;
+    inference_graph->mapping = NULL;
+    inference_graph->mapping_size = 0;
+    inference_graph->narrow_nodes = NULL;
+    inference_graph->identity_slots = NULL;
+    inference_graph->jit = NULL;
+    inference_graph->cones = NULL;
+    inference_graph->soa = NULL;
+    inference_graph->stream = NULL;
 
-    __lpg_inference_graph_tsort_packed(inference_graph,gen_inverse_index);
+    return inference_graph;
+}
 
-    affirmf(inference_graph->nodes_num <= LPG_INFERENCE_GRAPH_MAX_NODES_NUM,
-        "Number of nodes in the given graph exceeds max number of nodes supported (%zd > %d)",
-        inference_graph->nodes_num,LPG_INFERENCE_GRAPH_MAX_NODES_NUM);
 
-    return inference_graph;
+/**
+ * __lpg_inference_graph_select_index - selects width of indices inside packed nodes of inference graph
+ * @inference_graph:    pointer to inference graph object with populated @sorted_nodes
+ *
+ * Graphs, which fit into LPG_INFERENCE_GRAPH_NARROW_MAX_NODES_NUM nodes, get @narrow_nodes with 16-bit
+ * indices, so engines load 8 bytes per node instead of 16. Larger graphs are evaluated from @sorted_nodes.
+ * Must be called once @sorted_nodes are final, since @narrow_nodes are not updated afterwards.
+ *
+ * Return: None
+*/
+void __lpg_inference_graph_select_index(lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    inference_graph->narrow_nodes = __lpg_node_packed_narrow(inference_graph->sorted_nodes,inference_graph->nodes_num);
 }
 
 
-void lpg_inference_graph_release(lpg_inference_graph_t *inference_graph)
+/**
+ * __lpg_inference_graph_create_mt - creates inference graph using several threads
+ * @graph:              graph to encode
+ * @gen_inverse_index:  whether map from indices to nodes should be built
+ * @order:              ordering strategy of sorted nodes
+ * @threads_num:        number of threads to pack nodes with
+ *
+ * Same as 'lpg_inference_graph_create_mt', but with explicitly specified ordering strategy
+ * and number of threads.
+ *
+ * Return: Pointer to created inference graph object
+*/
+lpg_inference_graph_t *__lpg_inference_graph_create_mt(lpg_graph_t *graph, bool gen_inverse_index, lpg_inference_order_t order, uint32_t threads_num)
 {
-    affirm_nullptr(inference_graph,"ocl graph");
+    lpg_inference_graph_t *inference_graph = __lpg_inference_graph_alloc(graph);
 
-    lp_htable_release(inference_graph->index_map);
-    if(inference_graph->inv_index_map)
-        lp_htable_release(inference_graph->inv_index_map);
-    
-    free(inference_graph->sorted_nodes);
-    free(inference_graph);
+    __lpg_inference_graph_tsort_packed(inference_graph,gen_inverse_index,order,threads_num);
+
+    __lpg_inference_graph_build_children(inference_graph);
+    __lpg_inference_graph_alloc_slots(inference_graph);
+    __lpg_inference_graph_select_index(inference_graph);
+
+    return inference_graph;
 }
 
 
-size_t __lpg_inference_graph_index_map_hsh(const __lpg_inference_graph_index_map_entry_t *entry)
+/**
+ * lpg_inference_graph_create - creates inference graph from general-purpose graph
+ * @graph:              graph to encode
+ * @gen_inverse_index:  whether map from indices to nodes should be built
+ *
+ * See 'lpg_inference_graph'. Nodes are packed by a single thread.
+ *
+ * Return: Pointer to created inference graph object
+*/
+lpg_inference_graph_t *lpg_inference_graph_create(lpg_graph_t *graph, bool gen_inverse_index)
 {
-    return lp_uni_hash((size_t)entry->node);
+    return __lpg_inference_graph_create_mt(graph,gen_inverse_index,LPG_INFERENCE_ORDER_LEVELS,1);
 }
 
-bool __lpg_inference_graph_index_map_eq(const __lpg_inference_graph_index_map_entry_t *a, const __lpg_inference_graph_index_map_entry_t *b)
+
+/**
+ * lpg_inference_graph_create_mt - creates inference graph from general-purpose graph in parallel
+ * @graph:              graph to encode
+ * @gen_inverse_index:  whether map from indices to nodes should be built
+ * @order:              ordering strategy of sorted nodes
+ *
+ * Multithreaded variant of 'lpg_inference_graph_create_ordered', which creates one thread per available CPU
+ * to pack sorted nodes. Nodes are sorted by a single linear pass, see '__lpg_graph_tsort_levels', so the
+ * resulting graph is the same.
+ *
+ * Return: Pointer to created inference graph object
+*/
+lpg_inference_graph_t *lpg_inference_graph_create_mt(lpg_graph_t *graph, bool gen_inverse_index, lpg_inference_order_t order)
 {
-    return a->node == b->node;
+    return __lpg_inference_graph_create_mt(graph,gen_inverse_index,order,lp_affinity_cpu_count);
 }
 
 
-inline void __lpg_inference_graph_index_map_insert(lpg_inference_graph_t *inference_graph, lpg_node_t *node, lpg_inference_graph_index_t index)
+/**
+ * lpg_inference_graph_create_ordered - creates inference graph with specified order of nodes
+ * @graph:              graph to encode
+ * @gen_inverse_index:  whether map from indices to nodes should be built
+ * @order:              ordering strategy of sorted nodes
+ *
+ * Same as 'lpg_inference_graph_create', but nodes are arranged according to @order. Orders placing nodes
+ * closer to their parents improve cache hit rate of sequential engines, see 'lpg_inference_graph_avg_parent_distance'
+ * to compare them on a particular graph.
+ *
+ * Return: Pointer to created inference graph object
+*/
+lpg_inference_graph_t *lpg_inference_graph_create_ordered(lpg_graph_t *graph, bool gen_inverse_index, lpg_inference_order_t order)
 {
-    __lpg_inference_graph_index_map_entry_t entry;
-    entry.node = node;
-    entry.index = index;
-    lp_htable_insert(inference_graph->index_map,&entry);
+    return __lpg_inference_graph_create_mt(graph,gen_inverse_index,order,1);
 }
 
 
-inline void lpg_inference_graph_index_map_find(lpg_inference_graph_t *inference_graph, lpg_node_t *node, lpg_inference_graph_index_t *result)
+/**
+ * lpg_inference_graph_create_cone - creates inference graph from fan-in cone of graph outputs
+ * @graph:              graph to encode
+ * @gen_inverse_index:  whether map from indices to nodes should be built
+ * @order:              ordering strategy of sorted nodes
+ *
+ * Same as 'lpg_inference_graph_create_ordered'. Every builder collects nodes with a single DFS from outputs,
+ * see '__lpg_inference_graph_tsort_packed', so only the fan-in cone of outputs is touched, which suits graphs,
+ * outputs of which reach only a small part of the slab, e.g. sub-graphs of a large super-graph.
+ *
+ * Return: Pointer to created inference graph object
+*/
+lpg_inference_graph_t *lpg_inference_graph_create_cone(lpg_graph_t *graph, bool gen_inverse_index, lpg_inference_order_t order)
 {
-    __lpg_inference_graph_index_map_entry_t entry;
-    entry.node = node;
-    __lpg_inference_graph_index_map_entry_t found;
-    lp_htable_find(inference_graph->index_map,&entry,&found);
-    *result = found.index;
+    return __lpg_inference_graph_create_mt(graph,gen_inverse_index,order,1);
 }
 
 
-size_t __lpg_inference_graph_inv_index_map_hsh(const __lpg_inference_graph_index_map_entry_t *entry)
+void lpg_inference_graph_release(lpg_inference_graph_t *inference_graph)
 {
-    return lp_uni_hash(entry->index);
+    affirm_nullptr(inference_graph,"ocl graph");
+
+    free(inference_graph->index_map);
+    free(inference_graph->inv_index_map);
+    free(inference_graph->narrow_nodes);
+    // Sorted nodes, level offsets and output nodes of loaded graphs reside inside the mapping
+    if(inference_graph->mapping)
+        affirmf(!munmap(inference_graph->mapping,inference_graph->mapping_size),"Failed to unmap inference graph file");
+    else
+    {
+        free(inference_graph->sorted_nodes);
+        free(inference_graph->level_offsets);
+        free(inference_graph->output_nodes);
+    }
+    free(inference_graph->children_offsets);
+    free(inference_graph->children);
+    free(inference_graph->node_slots);
+    free(inference_graph->identity_slots);
+    if(inference_graph->jit)
+        __lpg_inference_jit_release(inference_graph->jit);
+    if(inference_graph->cones)
+    {
+        for(size_t cone_i = 0; cone_i < inference_graph->cones->size; ++cone_i)
+            __lpg_inference_cone_release(lp_vector_at_type(inference_graph->cones,cone_i,lpg_inference_cone_t*));
+        lp_vector_release(inference_graph->cones);
+    }
+    if(inference_graph->soa)
+        __lpg_inference_soa_release(inference_graph->soa);
+    if(inference_graph->stream)
+        __lpg_inference_stream_release(inference_graph->stream);
+    free(inference_graph);
 }
 
-bool __lpg_inference_graph_inv_index_map_eq(const __lpg_inference_graph_index_map_entry_t *a, const __lpg_inference_graph_index_map_entry_t *b)
+
+/**
+ * __lpg_inference_graph_build_children - builds compressed adjacency of children for packed nodes
+ * @inference_graph:    pointer to inference graph object with populated @sorted_nodes
+ *
+ * Counts children of every node from parents of packed nodes, turns counts into offsets and
+ * then scatters indices of children. Since @sorted_nodes is topologically sorted and scanned in
+ * ascending order, children of every node end up sorted by their indices.
+ *
+ * Return: None
+*/
+void __lpg_inference_graph_build_children(lpg_inference_graph_t *inference_graph)
 {
-    return a->index == b->index;
+    affirm_nullptr(inference_graph,"inference graph");
+
+    size_t nodes_num = inference_graph->nodes_num;
+    const lpg_node_packed_t *sorted_nodes = inference_graph->sorted_nodes;
+
+    size_t offsets_size = (nodes_num+1)*sizeof(size_t);
+    size_t *children_offsets = (size_t*)calloc(nodes_num+1,sizeof(size_t));
+    affirm_bad_malloc(children_offsets,"children offsets array",offsets_size);
+
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+    {
+        const lpg_node_packed_t *node = &sorted_nodes[node_i];
+        uint16_t parents_num = lpg_node_packed_get_parents_num(node);
+        for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+            ++children_offsets[(lpg_inference_graph_uindex_t)node->parents[parent_i]+1];
+    }
+
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+        children_offsets[node_i+1] += children_offsets[node_i];
+
+    size_t edges_num = children_offsets[nodes_num];
+    size_t children_size = MAX(1,edges_num)*sizeof(lpg_inference_graph_index_t);
+    lpg_inference_graph_index_t *children = (lpg_inference_graph_index_t*)malloc(children_size);
+    affirm_bad_malloc(children,"children array",children_size);
+
+    // Offsets are advanced while scattering and restored afterwards
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+    {
+        const lpg_node_packed_t *node = &sorted_nodes[node_i];
+        uint16_t parents_num = lpg_node_packed_get_parents_num(node);
+        for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+            children[children_offsets[(lpg_inference_graph_uindex_t)node->parents[parent_i]]++] = node_i;
+    }
+
+    for(size_t node_i = nodes_num; node_i > 0; --node_i)
+        children_offsets[node_i] = children_offsets[node_i-1];
+    children_offsets[0] = 0;
+
+    inference_graph->children_offsets = children_offsets;
+    inference_graph->children = children;
+}
+
+
+/**
+ * __lpg_inference_graph_build_node_outputs - groups outputs of inference graph by nodes serving them
+ * @inference_graph:        pointer to inference graph object with populated @output_nodes
+ * @node_outputs_offsets:   resulting indices within @node_outputs where outputs of each node begin, followed by @outputs_size
+ * @node_outputs:           resulting indices of outputs grouped by nodes
+ *
+ * Inverts @output_nodes of @inference_graph the same way children are built from parents, see
+ * '__lpg_inference_graph_build_children': outputs of the node 'i' occupy the range
+ * [@node_outputs_offsets[i], @node_outputs_offsets[i+1]) of @node_outputs in ascending order.
+ * Both arrays must be freed by the caller.
+ *
+ * Return: None
+*/
+void __lpg_inference_graph_build_node_outputs(const lpg_inference_graph_t *inference_graph, size_t **node_outputs_offsets, size_t **node_outputs)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+    affirm_nullptr(node_outputs_offsets,"node outputs offsets");
+    affirm_nullptr(node_outputs,"node outputs");
+
+    size_t nodes_num = inference_graph->nodes_num;
+    size_t outputs_size = inference_graph->outputs_size;
+    const lpg_inference_graph_uindex_t *output_nodes = inference_graph->output_nodes;
+
+    size_t offsets_size = (nodes_num+1)*sizeof(size_t);
+    size_t *offsets = (size_t*)calloc(nodes_num+1,sizeof(size_t));
+    affirm_bad_malloc(offsets,"node outputs offsets array",offsets_size);
+
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+        ++offsets[output_nodes[out_i]+1];
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+        offsets[node_i+1] += offsets[node_i];
+
+    size_t outputs_array_size = MAX(1,outputs_size)*sizeof(size_t);
+    size_t *outputs = (size_t*)malloc(outputs_array_size);
+    affirm_bad_malloc(outputs,"node outputs array",outputs_array_size);
+
+    // Offsets are advanced while scattering and restored afterwards
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+        outputs[offsets[output_nodes[out_i]]++] = out_i;
+    for(size_t node_i = nodes_num; node_i > 0; --node_i)
+        offsets[node_i] = offsets[node_i-1];
+    offsets[0] = 0;
+
+    *node_outputs_offsets = offsets;
+    *node_outputs = outputs;
 }
 
 
-inline void __lpg_inference_graph_inv_index_map_insert(lpg_inference_graph_t *inference_graph, lpg_node_t *node, lpg_inference_graph_index_t index)
+/**
+ * lpg_inference_graph_index_map_find - finds index of node within sorted nodes of inference graph
+ * @inference_graph:    pointer to inference graph object
+ * @node:               node of the underlying graph, which is a part of the inference graph
+ * @result:             resulting index within @sorted_nodes
+ *
+ * Return: None
+*/
+inline void lpg_inference_graph_index_map_find(const lpg_inference_graph_t *inference_graph, const lpg_node_t *node, lpg_inference_graph_index_t *result)
 {
-    __lpg_inference_graph_index_map_entry_t entry;
-    entry.node = node;
-    entry.index = index;
-    lp_htable_insert(inference_graph->inv_index_map,&entry);
+    *result = inference_graph->index_map[lp_slab_index(__lpg_graph_slab(inference_graph->graph),node)];
 }
 
 
-inline void lpg_inference_graph_inv_index_map_find(lpg_inference_graph_t *inference_graph, lpg_inference_graph_index_t index, lpg_node_t **result)
+/**
+ * lpg_inference_graph_inv_index_map_find - finds node corresponding to index within sorted nodes of inference graph
+ * @inference_graph:    pointer to inference graph object created with inverse index
+ * @index:              index within @sorted_nodes
+ * @result:             resulting node of the underlying graph
+ *
+ * Return: None
+*/
+inline void lpg_inference_graph_inv_index_map_find(const lpg_inference_graph_t *inference_graph, lpg_inference_graph_index_t index, lpg_node_t **result)
 {
-    __lpg_inference_graph_index_map_entry_t entry;
-    entry.index = index;
-    __lpg_inference_graph_index_map_entry_t found;
-    lp_htable_find(inference_graph->inv_index_map,&entry,&found);
-    *result = found.node;
+    affirmf_debug(inference_graph->inv_index_map,"Inference graph was created without inverse index");
+    *result = inference_graph->inv_index_map[(lpg_inference_graph_uindex_t)index];
 }
@@ -1,38 +1,25 @@
 #include <lockpick/graph/inference/inference_graph.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/define.h>
+#include <malloc.h>
 
-#define __LPG_NODE_PACKED_OUTPUT_MASK_OFFSET (__builtin_ffs(__LPG_NODE_PACKED_OUTPUT_MASK)-1)
 #define __LPG_NODE_PACKED_TYPE_MASK_OFFSET (__builtin_ffs(__LPG_NODE_PACKED_TYPE_MASK)-1)
 
 
 cl_char lpg_node_packed_type(const lpg_node_packed_t *node)
 {
-    return (node->__output_type & __LPG_NODE_PACKED_TYPE_MASK) >> __LPG_NODE_PACKED_TYPE_MASK_OFFSET;
+    return (node->__type & __LPG_NODE_PACKED_TYPE_MASK) >> __LPG_NODE_PACKED_TYPE_MASK_OFFSET;
 }
 
 void __lpg_node_packed_set_type(lpg_node_packed_t *node, cl_char type)
 {
-    lpg_inference_graph_index_t reset = node->__output_type & (~__LPG_NODE_PACKED_TYPE_MASK);
-    lpg_inference_graph_index_t assign = (((lpg_inference_graph_index_t)type) << __LPG_NODE_PACKED_TYPE_MASK_OFFSET) & __LPG_NODE_PACKED_TYPE_MASK;
-    node->__output_type = reset | assign;
-}
-
-
-lpg_inference_graph_index_t lpg_node_packed_output(const lpg_node_packed_t *node)
-{
-    return (node->__output_type & __LPG_NODE_PACKED_OUTPUT_MASK) >> __LPG_NODE_PACKED_OUTPUT_MASK_OFFSET; 
-}
-
-void __lpg_node_packed_set_output(lpg_node_packed_t *node, lpg_inference_graph_index_t output)
-{
-    lpg_inference_graph_index_t reset = node->__output_type & (~__LPG_NODE_PACKED_OUTPUT_MASK);
-    lpg_inference_graph_index_t assign = (output << __LPG_NODE_PACKED_OUTPUT_MASK_OFFSET) & __LPG_NODE_PACKED_OUTPUT_MASK;
-    node->__output_type = reset | assign;
+    node->__type = (((lpg_inference_graph_index_t)type) << __LPG_NODE_PACKED_TYPE_MASK_OFFSET) & __LPG_NODE_PACKED_TYPE_MASK;
 }
 
 
 uint16_t lpg_node_packed_get_parents_num(const lpg_node_packed_t *node)
 {
-    static const uint16_t node_type_parents_num[] = {2, 2, 1, 2, 0, 0, 0};
+    static const uint16_t node_type_parents_num[] = {2, 2, 1, 2, 0, 0, 0, 2, 2, 2, 2, 2, 3, 3, 3};
 
     cl_char type = lpg_node_packed_type(node);
     return node_type_parents_num[type];
@@ -63,9 +50,9 @@ cl_char __lpg_node_packed_type_from_node(const lpg_node_t *node)
 }
 
 
-inline lpg_node_packed_t __lpg_node_packed_from_node(lpg_inference_graph_t *inference_graph, lpg_node_t *node, lpg_inference_graph_index_t output_index)
+inline lpg_node_packed_t __lpg_node_packed_from_node(lpg_inference_graph_t *inference_graph, lpg_node_t *node)
 {
-    lpg_node_packed_t packed_node;
+    lpg_node_packed_t packed_node = {0};
 
     size_t parents_num = lpg_node_get_parents_num(node);
     lpg_node_t **parents = lpg_node_parents(node);
@@ -78,15 +65,13 @@ inline lpg_node_packed_t __lpg_node_packed_from_node(lpg_inference_graph_t *infe
     cl_char type = __lpg_node_packed_type_from_node(node);
     __lpg_node_packed_set_type(&packed_node,type);
 
-    __lpg_node_packed_set_output(&packed_node,output_index);
-
     return packed_node;
 }
 
 
-inline lpg_node_packed_t __lpg_node_packed_from_const_node(const lpg_node_t *node, lpg_inference_graph_index_t output_index)
+inline lpg_node_packed_t __lpg_node_packed_from_const_node(const lpg_node_t *node)
 {
-    lpg_node_packed_t packed_node;
+    lpg_node_packed_t packed_node = {0};
 
     cl_char type = __lpg_node_packed_type_from_node(node);
 
@@ -94,17 +79,45 @@ inline lpg_node_packed_t __lpg_node_packed_from_const_node(const lpg_node_t *nod
             "Expected node of terminal type but type %d was given",(uint32_t)type);
     
     __lpg_node_packed_set_type(&packed_node,type);
-    __lpg_node_packed_set_output(&packed_node,output_index);
 
     return packed_node;
 }
 
 
-inline lpg_node_packed_t __lpg_node_packed_from_input_node(const lpg_node_t *node, lpg_inference_graph_index_t output_index)
+inline lpg_node_packed_t __lpg_node_packed_from_input_node(const lpg_node_t *node)
 {
-    lpg_node_packed_t packed_node;
+    lpg_node_packed_t packed_node = {0};
     __lpg_node_packed_set_type(&packed_node,LPG_NODE_PACKED_TYPE_INPUT);
-    __lpg_node_packed_set_output(&packed_node,output_index);
 
     return packed_node;
 }
+
+
+/**
+ * __lpg_node_packed_narrow - converts array of packed nodes to 16-bit indices
+ * @sorted_nodes:   topologically sorted array of packed nodes
+ * @nodes_num:      number of nodes inside @sorted_nodes
+ *
+ * Arrays with more than LPG_INFERENCE_GRAPH_NARROW_MAX_NODES_NUM nodes cannot be indexed with 16 bits,
+ * so they are left wide and NULL is returned.
+ *
+ * Return: Allocated array of narrow packed nodes, which must be freed by the caller, or NULL
+*/
+lpg_node_packed_narrow_t *__lpg_node_packed_narrow(const lpg_node_packed_t *sorted_nodes, size_t nodes_num)
+{
+    if(nodes_num > LPG_INFERENCE_GRAPH_NARROW_MAX_NODES_NUM)
+        return NULL;
+
+    size_t narrow_nodes_size = MAX(1,nodes_num)*sizeof(lpg_node_packed_narrow_t);
+    lpg_node_packed_narrow_t *narrow_nodes = (lpg_node_packed_narrow_t*)malloc(narrow_nodes_size);
+    affirm_bad_malloc(narrow_nodes,"narrow sorted nodes array",narrow_nodes_size);
+
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+    {
+        for(size_t parent_i = 0; parent_i < LPG_NODE_PACKED_MAX_PARENTS_NUM; ++parent_i)
+            narrow_nodes[node_i].parents[parent_i] = (lpg_inference_graph_narrow_index_t)sorted_nodes[node_i].parents[parent_i];
+        narrow_nodes[node_i].__type = (lpg_inference_graph_narrow_index_t)sorted_nodes[node_i].__type;
+    }
+
+    return narrow_nodes;
+}
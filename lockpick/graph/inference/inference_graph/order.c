@@ -0,0 +1,212 @@
+#include <lockpick/graph/tsort.h>
+#include <lockpick/graph/inference/inference_graph.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/bitset.h>
+#include <lockpick/define.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+typedef struct __lpg_inference_order_entry
+{
+    size_t key;
+    size_t index;
+    lpg_node_t *node;
+} __lpg_inference_order_entry_t;
+
+
+static int __lpg_inference_order_entry_cmp(const void *a, const void *b)
+{
+    const __lpg_inference_order_entry_t *entry_a = a;
+    const __lpg_inference_order_entry_t *entry_b = b;
+
+    if(entry_a->key != entry_b->key)
+        return entry_a->key < entry_b->key ? -1 : 1;
+
+    // Ties keep the original order, since qsort is not stable
+    return entry_a->index < entry_b->index ? -1 : entry_a->index > entry_b->index;
+}
+
+
+static size_t __lpg_inference_order_latest_parent(lp_slab_t *slab, const size_t *positions, lpg_node_t *node)
+{
+    size_t latest_parent = 0;
+    size_t parents_num = lpg_node_get_parents_num(node);
+    lpg_node_t **parents = lpg_node_parents(node);
+    for(size_t parent_i = 0; parent_i < parents_num; ++parent_i)
+        latest_parent = MAX(latest_parent,positions[lp_slab_index(slab,parents[parent_i])]);
+
+    return latest_parent;
+}
+
+
+/**
+ * __lpg_inference_order_levels_locality - sorts nodes of every level by position of their latest parent
+ * @graph:          graph, nodes of which are sorted
+ * @levels:         nodes sorted by levels
+ *
+ * Levels are processed in order, so positions of parents are final by the time a level is sorted.
+ * Nodes consuming recently computed values are moved towards the end of their level, which brings
+ * them closer to their parents, while children of early nodes are evaluated early.
+ *
+ * Return: None
+*/
+static void __lpg_inference_order_levels_locality(lpg_graph_t *graph, __lpg_tsort_levels_t *levels)
+{
+    lp_slab_t *slab = __lpg_graph_slab(graph);
+    lpg_node_t **sorted_nodes = levels->sorted_nodes;
+
+    // Positions of nodes within sorted nodes array, addressed by slab slots
+    size_t positions_size = MAX(1,lp_slab_capacity(slab))*sizeof(size_t);
+    size_t *positions = (size_t*)malloc(positions_size);
+    affirm_bad_malloc(positions,"node positions array",positions_size);
+
+    size_t max_level_size = 0;
+    for(size_t level_i = 0; level_i < levels->levels_num; ++level_i)
+        max_level_size = MAX(max_level_size,levels->level_offsets[level_i+1]-levels->level_offsets[level_i]);
+
+    size_t entries_size = MAX(1,max_level_size)*sizeof(__lpg_inference_order_entry_t);
+    __lpg_inference_order_entry_t *entries = (__lpg_inference_order_entry_t*)malloc(entries_size);
+    affirm_bad_malloc(entries,"order entries array",entries_size);
+
+    // Zero level consists of input and constant nodes, order of inputs is fixed
+    size_t zero_level_end = levels->levels_num > 0 ? levels->level_offsets[1] : 0;
+    for(size_t node_i = 0; node_i < zero_level_end; ++node_i)
+        positions[lp_slab_index(slab,sorted_nodes[node_i])] = node_i;
+
+    for(size_t level_i = 1; level_i < levels->levels_num; ++level_i)
+    {
+        size_t level_begin = levels->level_offsets[level_i];
+        size_t level_size = levels->level_offsets[level_i+1]-level_begin;
+        for(size_t entry_i = 0; entry_i < level_size; ++entry_i)
+        {
+            lpg_node_t *node = sorted_nodes[level_begin+entry_i];
+            entries[entry_i].key = __lpg_inference_order_latest_parent(slab,positions,node);
+            entries[entry_i].index = entry_i;
+            entries[entry_i].node = node;
+        }
+
+        qsort(entries,level_size,sizeof(__lpg_inference_order_entry_t),__lpg_inference_order_entry_cmp);
+
+        for(size_t entry_i = 0; entry_i < level_size; ++entry_i)
+        {
+            sorted_nodes[level_begin+entry_i] = entries[entry_i].node;
+            positions[lp_slab_index(slab,entries[entry_i].node)] = level_begin+entry_i;
+        }
+    }
+
+    free(entries);
+    free(positions);
+}
+
+
+/**
+ * __lpg_inference_graph_split_runs - splits nodes of inference graph in DFS post-order into runs
+ * @inference_graph:    pointer to inference graph object with packed @sorted_nodes
+ *
+ * Nodes beyond zero level are expected to form a single level in post-order, see '__lpg_graph_tsort_levels'.
+ * @level_offsets are rebuilt as maximal runs of consecutive nodes, which do not depend on each other,
+ * so they can still be evaluated in parallel: a new run begins at every node with a parent inside
+ * the current run.
+ *
+ * Return: None
+*/
+void __lpg_inference_graph_split_runs(lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    if(inference_graph->levels_num == 0)
+        return;
+
+    const lpg_node_packed_t *sorted_nodes = inference_graph->sorted_nodes;
+    size_t nodes_num = inference_graph->nodes_num;
+    size_t zero_level_end = inference_graph->level_offsets[1];
+
+    size_t level_offsets_size = (nodes_num+2)*sizeof(size_t);
+    size_t *level_offsets = (size_t*)realloc(inference_graph->level_offsets,level_offsets_size);
+    affirm_bad_malloc(level_offsets,"level offsets array realloc",level_offsets_size);
+
+    size_t levels_num = 0;
+    size_t level_begin = 0;
+    level_offsets[0] = 0;
+    for(size_t node_i = zero_level_end; node_i < nodes_num; ++node_i)
+    {
+        size_t latest_parent = 0;
+        uint16_t parents_num = lpg_node_packed_get_parents_num(&sorted_nodes[node_i]);
+        for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+            latest_parent = MAX(latest_parent,(lpg_inference_graph_uindex_t)sorted_nodes[node_i].parents[parent_i]);
+
+        if(node_i == zero_level_end || latest_parent >= level_begin)
+        {
+            level_begin = node_i;
+            level_offsets[++levels_num] = level_begin;
+        }
+    }
+    level_offsets[++levels_num] = nodes_num;
+
+    inference_graph->levels_num = levels_num;
+    inference_graph->level_offsets = (size_t*)realloc(level_offsets,(levels_num+1)*sizeof(size_t));
+    affirm_bad_malloc(inference_graph->level_offsets,"level offsets array realloc",(levels_num+1)*sizeof(size_t));
+}
+
+
+/**
+ * __lpg_inference_graph_reorder - rearranges nodes sorted by levels according to ordering strategy
+ * @graph:      graph, nodes of which are sorted
+ * @order:      ordering strategy, see 'lpg_inference_order_t'
+ * @levels:     nodes sorted by levels, which are reordered in place
+ *
+ * Input nodes always stay at the beginning of sorted nodes in their order. LPG_INFERENCE_ORDER_LEVELS and
+ * LPG_INFERENCE_ORDER_DFS are produced by '__lpg_graph_tsort_levels' directly, so nodes are left as is.
+ *
+ * Return: None
+*/
+void __lpg_inference_graph_reorder(lpg_graph_t *graph, lpg_inference_order_t order, struct __lpg_tsort_levels *levels)
+{
+    affirm_nullptr(graph,"graph");
+    affirm_nullptr(levels,"levels");
+
+    switch(order)
+    {
+        case LPG_INFERENCE_ORDER_LEVELS:
+        case LPG_INFERENCE_ORDER_DFS:
+            break;
+
+        case LPG_INFERENCE_ORDER_LEVELS_LOCALITY:
+            __lpg_inference_order_levels_locality(graph,levels);
+            break;
+
+        default:
+            errorf("Unknown inference graph order %d",(int)order);
+    }
+}
+
+
+/**
+ * lpg_inference_graph_avg_parent_distance - computes average distance between nodes and their parents
+ * @inference_graph:    pointer to inference graph object
+ *
+ * Distance is the difference of indices of a node and of its parent within @sorted_nodes, averaged over
+ * all edges. The smaller the distance, the more likely values of parents still reside in cache when the
+ * node is evaluated, so the metric allows to compare ordering strategies on particular circuits.
+ *
+ * Return: Average parent distance or 0 if the graph has no edges
+*/
+double lpg_inference_graph_avg_parent_distance(const lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    size_t edges_num = 0;
+    double distances_sum = 0;
+    for(size_t node_i = 0; node_i < inference_graph->nodes_num; ++node_i)
+    {
+        const lpg_node_packed_t *node = &inference_graph->sorted_nodes[node_i];
+        uint16_t parents_num = lpg_node_packed_get_parents_num(node);
+        for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+            distances_sum += node_i-(lpg_inference_graph_uindex_t)node->parents[parent_i];
+        edges_num += parents_num;
+    }
+
+    return edges_num > 0 ? distances_sum/edges_num : 0;
+}
@@ -0,0 +1,201 @@
+#include <lockpick/graph/inference/serialize.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/define.h>
+#include <lockpick/math.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Level offsets are used in place, so they must have the same representation as in memory
+static_assert(sizeof(size_t) == sizeof(uint64_t),"Level offsets are stored as 64-bit words");
+
+
+/**
+ * lpg_inference_graph_save - writes inference graph into file
+ * @inference_graph:    pointer to inference graph object
+ * @path:               path of the file to create or overwrite
+ *
+ * See 'lpg_inference_file_header' for the layout. Only the data engines need is stored: neither
+ * the underlying general-purpose graph nor maps between its nodes and indices are saved. Structures
+ * derived from the sorted nodes, like adjacency of children and value slots, are rebuilt on load.
+ *
+ * Return: None
+*/
+void lpg_inference_graph_save(const lpg_inference_graph_t *inference_graph, const char *path)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+    affirm_nullptr(path,"path");
+
+    size_t level_offsets_size = (inference_graph->levels_num+1)*sizeof(uint64_t);
+    size_t output_nodes_size = inference_graph->outputs_size*sizeof(lpg_inference_graph_uindex_t);
+    // Keeps packed nodes aligned regardless of the number of outputs
+    size_t output_nodes_padded_size = lp_ceil_div_u64(output_nodes_size,sizeof(uint64_t))*sizeof(uint64_t);
+    size_t sorted_nodes_size = inference_graph->nodes_num*sizeof(lpg_node_packed_t);
+
+    lpg_inference_file_header_t header;
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,LPG_INFERENCE_FILE_MAGIC,LPG_INFERENCE_FILE_MAGIC_SIZE);
+    header.version = LPG_INFERENCE_FILE_VERSION;
+    header.index_size = sizeof(lpg_inference_graph_index_t);
+    header.nodes_num = inference_graph->nodes_num;
+    header.inputs_size = inference_graph->inputs_size;
+    header.outputs_size = inference_graph->outputs_size;
+    header.levels_num = inference_graph->levels_num;
+    header.level_offsets_offset = sizeof(lpg_inference_file_header_t);
+    header.output_nodes_offset = header.level_offsets_offset+level_offsets_size;
+    header.sorted_nodes_offset = header.output_nodes_offset+output_nodes_padded_size;
+    header.file_size = header.sorted_nodes_offset+sorted_nodes_size;
+
+    FILE *file = fopen(path,"wb");
+    affirmf(file,"Failed to open file '%s' for inference graph",path);
+
+    static const uint8_t padding[sizeof(uint64_t)] = {0};
+    affirmf(fwrite(&header,sizeof(header),1,file) == 1 &&
+            fwrite(inference_graph->level_offsets,level_offsets_size,1,file) == 1 &&
+            (output_nodes_size == 0 || fwrite(inference_graph->output_nodes,output_nodes_size,1,file) == 1) &&
+            (output_nodes_padded_size == output_nodes_size || fwrite(padding,output_nodes_padded_size-output_nodes_size,1,file) == 1) &&
+            (sorted_nodes_size == 0 || fwrite(inference_graph->sorted_nodes,sorted_nodes_size,1,file) == 1),
+        "Failed to write inference graph into '%s'",path);
+
+    affirmf(!fclose(file),"Failed to write inference graph into '%s'",path);
+}
+
+
+/**
+ * __lpg_inference_graph_validate_loaded - checks that packed nodes of loaded inference graph are well-formed
+ * @inference_graph:    pointer to loaded inference graph object
+ * @path:               path of the file the graph was loaded from
+ *
+ * Engines index values by parents of packed nodes and by output nodes without any checks, so a damaged file
+ * must be rejected before it is used. Level offsets must be non-decreasing and cover all nodes, parents
+ * must belong to earlier levels than their children, since multithreaded engines evaluate each level in
+ * parallel, input nodes must form the prefix of @sorted_nodes and every output must refer to an existing node.
+ *
+ * Return: None
+*/
+static void __lpg_inference_graph_validate_loaded(const lpg_inference_graph_t *inference_graph, const char *path)
+{
+    size_t nodes_num = inference_graph->nodes_num;
+    size_t inputs_size = inference_graph->inputs_size;
+    size_t outputs_size = inference_graph->outputs_size;
+
+    const size_t *level_offsets = inference_graph->level_offsets;
+    size_t levels_num = inference_graph->levels_num;
+    affirmf(level_offsets[0] == 0 && level_offsets[levels_num] == nodes_num,
+        "Levels of inference graph file '%s' do not cover all nodes",path);
+    for(size_t level_i = 0; level_i < levels_num; ++level_i)
+        affirmf(level_offsets[level_i] <= level_offsets[level_i+1],
+            "Level %zd of inference graph file '%s' has invalid bounds",level_i,path);
+
+    for(size_t level_i = 0; level_i < levels_num; ++level_i)
+    {
+        for(size_t node_i = level_offsets[level_i]; node_i < level_offsets[level_i+1]; ++node_i)
+        {
+            const lpg_node_packed_t *node = &inference_graph->sorted_nodes[node_i];
+            cl_char type = lpg_node_packed_type(node);
+            affirmf(type < LPG_NODE_PACKED_TYPES_NUM && (type == LPG_NODE_PACKED_TYPE_INPUT) == (node_i < inputs_size),
+                "Node %zd of inference graph file '%s' has invalid type %d",node_i,path,(int)type);
+
+            uint16_t parents_num = lpg_node_packed_get_parents_num(node);
+            for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+                affirmf((lpg_inference_graph_uindex_t)node->parents[parent_i] < level_offsets[level_i],
+                    "Node %zd of inference graph file '%s' does not follow its parent's level",node_i,path);
+        }
+    }
+
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+        affirmf(inference_graph->output_nodes[out_i] < nodes_num,
+            "Output %zd of inference graph file '%s' refers to invalid node",out_i,path);
+}
+
+
+/**
+ * lpg_inference_graph_load - maps inference graph file into memory
+ * @path:   path of the file written by 'lpg_inference_graph_save'
+ *
+ * The file is mapped read-only and shared, so @sorted_nodes, @level_offsets and @output_nodes of the
+ * returned graph point directly into the page cache: processes loading the same file share its pages and loading
+ * does not copy or parse the nodes. Adjacency of children and value slots are rebuilt in private
+ * memory with linear passes over the nodes.
+ *
+ * Packed nodes are always stored with 32-bit indices. Loaded graphs, which fit into the narrow limit,
+ * get a private copy with 16-bit indices, see '__lpg_inference_graph_select_index'. Loaded graph has no
+ * underlying general-purpose graph, so only engines and functions, which do not need @graph,
+ * @index_map or @inv_index_map, can be used. The mapping is released along with the graph.
+ *
+ * Return: Pointer to loaded inference graph object
+*/
+lpg_inference_graph_t *lpg_inference_graph_load(const char *path)
+{
+    affirm_nullptr(path,"path");
+
+    int fd = open(path,O_RDONLY);
+    affirmf(fd >= 0,"Failed to open inference graph file '%s'",path);
+
+    struct stat file_stat;
+    affirmf(!fstat(fd,&file_stat),"Failed to get size of inference graph file '%s'",path);
+    size_t file_size = file_stat.st_size;
+    affirmf(file_size >= sizeof(lpg_inference_file_header_t),"File '%s' is too small to be inference graph file",path);
+
+    void *mapping = mmap(NULL,file_size,PROT_READ,MAP_SHARED,fd,0);
+    affirmf(mapping != MAP_FAILED,"Failed to map inference graph file '%s'",path);
+    // Mapping stays valid after the descriptor is closed
+    close(fd);
+
+    const lpg_inference_file_header_t *header = (const lpg_inference_file_header_t*)mapping;
+    affirmf(!memcmp(header->magic,LPG_INFERENCE_FILE_MAGIC,LPG_INFERENCE_FILE_MAGIC_SIZE),
+        "File '%s' is not an inference graph file",path);
+    affirmf(header->version == LPG_INFERENCE_FILE_VERSION,
+        "Inference graph file '%s' has version %u, expected %u",path,header->version,LPG_INFERENCE_FILE_VERSION);
+    affirmf(header->index_size == sizeof(lpg_inference_graph_index_t),
+        "Inference graph file '%s' uses %u-byte indices, expected %zd-byte ones",
+        path,header->index_size,sizeof(lpg_inference_graph_index_t));
+    affirmf(header->nodes_num <= LPG_INFERENCE_GRAPH_MAX_NODES_NUM &&
+            header->inputs_size <= header->nodes_num && header->levels_num <= header->nodes_num,
+        "Inference graph file '%s' exceeds limits of inference graphs",path);
+    affirmf(header->file_size == file_size &&
+            header->level_offsets_offset % sizeof(uint64_t) == 0 &&
+            header->level_offsets_offset+(header->levels_num+1)*sizeof(uint64_t) <= header->output_nodes_offset &&
+            header->output_nodes_offset % sizeof(lpg_inference_graph_uindex_t) == 0 &&
+            header->output_nodes_offset+header->outputs_size*sizeof(lpg_inference_graph_uindex_t) <= header->sorted_nodes_offset &&
+            header->sorted_nodes_offset % sizeof(lpg_inference_graph_uindex_t) == 0 &&
+            header->sorted_nodes_offset+header->nodes_num*sizeof(lpg_node_packed_t) <= file_size,
+        "Inference graph file '%s' is truncated or damaged",path);
+
+    size_t inference_graph_size = sizeof(lpg_inference_graph_t);
+    lpg_inference_graph_t *inference_graph = (lpg_inference_graph_t*)malloc(inference_graph_size);
+    affirm_bad_malloc(inference_graph,"inference graph",inference_graph_size);
+
+    inference_graph->graph = NULL;
+    inference_graph->id = __lpg_inference_graph_next_id();
+    inference_graph->inputs_size = header->inputs_size;
+    inference_graph->outputs_size = header->outputs_size;
+    inference_graph->index_map = NULL;
+    inference_graph->inv_index_map = NULL;
+    inference_graph->nodes_num = header->nodes_num;
+    inference_graph->sorted_nodes = (lpg_node_packed_t*)((char*)mapping+header->sorted_nodes_offset);
+    inference_graph->narrow_nodes = NULL;
+    inference_graph->levels_num = header->levels_num;
+    inference_graph->level_offsets = (size_t*)((char*)mapping+header->level_offsets_offset);
+    inference_graph->output_nodes = (lpg_inference_graph_uindex_t*)((char*)mapping+header->output_nodes_offset);
+    inference_graph->identity_slots = NULL;
+    inference_graph->jit = NULL;
+    inference_graph->cones = NULL;
+    inference_graph->soa = NULL;
+    inference_graph->stream = NULL;
+    inference_graph->mapping = mapping;
+    inference_graph->mapping_size = file_size;
+
+    __lpg_inference_graph_validate_loaded(inference_graph,path);
+
+    __lpg_inference_graph_build_children(inference_graph);
+    __lpg_inference_graph_alloc_slots(inference_graph);
+    __lpg_inference_graph_select_index(inference_graph);
+
+    return inference_graph;
+}
@@ -0,0 +1,176 @@
+#include <lockpick/graph/inference/inference_graph.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/define.h>
+#include <stdlib.h>
+
+
+/**
+ * __lpg_node_packed_alloc_slots_grouped - assigns reusable value slots to groups of topologically sorted packed nodes
+ * @sorted_nodes:   topologically sorted array of packed nodes
+ * @nodes_num:      number of nodes inside @sorted_nodes
+ * @inputs_size:    number of input nodes at the beginning of @sorted_nodes
+ * @output_nodes:   index within @sorted_nodes of the node of each output
+ * @outputs_size:   number of entries inside @output_nodes
+ * @outputs_mask:   outputs present inside @sorted_nodes, NULL if all of them are
+ * @group_offsets:  indices within @sorted_nodes where each group begins, followed by @nodes_num, or NULL
+ * @groups_num:     number of groups described by @group_offsets
+ * @slots_num:      resulting number of required value slots
+ *
+ * Performs register allocation style pass over @sorted_nodes. The last use of every node is the
+ * index of its last child, which is found with a single forward scan over parents of all nodes.
+ * Once the node with such index is reached, the slot of the parent is returned to the pool and can
+ * be immediately reused by the node itself, since engines read operands word by word before writing.
+ *
+ * Input nodes occupy slots [0, @inputs_size), so input values can be copied into the slots as a whole.
+ * Slots of output nodes are never released, so engines gather output values through @output_nodes once
+ * all nodes are evaluated. Other nodes without children hold their slots until the end of their group,
+ * which lets engines write all gates of a group at once. Without @group_offsets every node forms its own group.
+ *
+ * The number of required slots equals the maximal number of simultaneously live values, which for
+ * typical circuits is much smaller than the total number of nodes.
+ *
+ * Return: Allocated array of slots assigned to nodes, which must be freed by the caller
+*/
+lpg_inference_graph_uindex_t *__lpg_node_packed_alloc_slots_grouped(
+    const lpg_node_packed_t *sorted_nodes,
+    size_t nodes_num,
+    size_t inputs_size,
+    const lpg_inference_graph_uindex_t *output_nodes,
+    size_t outputs_size,
+    const lp_bitset_t *outputs_mask,
+    const size_t *group_offsets,
+    size_t groups_num,
+    size_t *slots_num)
+{
+    affirm_nullptr(sorted_nodes,"sorted nodes");
+    affirm_nullptr(output_nodes,"output nodes");
+    affirm_nullptr(slots_num,"slots number");
+
+    size_t node_slots_size = MAX(1,nodes_num)*sizeof(lpg_inference_graph_uindex_t);
+    lpg_inference_graph_uindex_t *node_slots = (lpg_inference_graph_uindex_t*)malloc(node_slots_size);
+    affirm_bad_malloc(node_slots,"node slots array",node_slots_size);
+
+    // Stack of slots, values of which are not used anymore
+    lpg_inference_graph_uindex_t *free_slots = (lpg_inference_graph_uindex_t*)malloc(node_slots_size);
+    affirm_bad_malloc(free_slots,"free slots stack",node_slots_size);
+    size_t free_slots_num = 0;
+
+    // Slots of nodes without children, which are released at the end of the current group
+    lpg_inference_graph_uindex_t *pending_slots = (lpg_inference_graph_uindex_t*)malloc(node_slots_size);
+    affirm_bad_malloc(pending_slots,"pending slots array",node_slots_size);
+    size_t pending_slots_num = 0;
+
+    // Index of the last child of each node or the node itself if it has no children, SIZE_MAX for output nodes
+    size_t last_uses_size = MAX(1,nodes_num)*sizeof(size_t);
+    size_t *last_uses = (size_t*)malloc(last_uses_size);
+    affirm_bad_malloc(last_uses,"last uses array",last_uses_size);
+
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+    {
+        last_uses[node_i] = node_i;
+        const lpg_node_packed_t *node = &sorted_nodes[node_i];
+        uint16_t parents_num = lpg_node_packed_get_parents_num(node);
+        for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+            last_uses[(lpg_inference_graph_uindex_t)node->parents[parent_i]] = node_i;
+    }
+
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+    {
+        if(!outputs_mask || lp_bitset_test(outputs_mask,out_i))
+            last_uses[output_nodes[out_i]] = SIZE_MAX;
+    }
+
+    *slots_num = 0;
+    size_t group_i = 0;
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+    {
+        const lpg_node_packed_t *node = &sorted_nodes[node_i];
+        uint16_t parents_num = lpg_node_packed_get_parents_num(node);
+        for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+        {
+            lpg_inference_graph_uindex_t parent_node_i = (lpg_inference_graph_uindex_t)node->parents[parent_i];
+            // Same parent may be used several times by a single node
+            bool repeated = false;
+            for(uint16_t prev_parent_i = 0; prev_parent_i < parent_i; ++prev_parent_i)
+                repeated |= parent_node_i == (lpg_inference_graph_uindex_t)node->parents[prev_parent_i];
+
+            if(!repeated && last_uses[parent_node_i] == node_i)
+                free_slots[free_slots_num++] = node_slots[parent_node_i];
+        }
+
+        if(free_slots_num > 0)
+            node_slots[node_i] = free_slots[--free_slots_num];
+        else
+            node_slots[node_i] = (*slots_num)++;
+
+        if(last_uses[node_i] == node_i && node_i >= inputs_size)
+            pending_slots[pending_slots_num++] = node_slots[node_i];
+
+        while(group_offsets && group_i < groups_num && group_offsets[group_i+1] <= node_i+1)
+            ++group_i;
+
+        bool group_end = !group_offsets || group_i == groups_num || group_offsets[group_i] == node_i+1;
+        if(group_end)
+        {
+            while(pending_slots_num > 0)
+                free_slots[free_slots_num++] = pending_slots[--pending_slots_num];
+        }
+    }
+
+    free(free_slots);
+    free(pending_slots);
+    free(last_uses);
+
+    return node_slots;
+}
+
+
+/**
+ * __lpg_node_packed_alloc_slots - assigns reusable value slots to topologically sorted packed nodes
+ * @sorted_nodes:   topologically sorted array of packed nodes
+ * @nodes_num:      number of nodes inside @sorted_nodes
+ * @inputs_size:    number of input nodes at the beginning of @sorted_nodes
+ * @output_nodes:   index within @sorted_nodes of the node of each output
+ * @outputs_size:   number of entries inside @output_nodes
+ * @outputs_mask:   outputs present inside @sorted_nodes, NULL if all of them are
+ * @slots_num:      resulting number of required value slots
+ *
+ * See '__lpg_node_packed_alloc_slots_grouped'. Nodes without children, which are not outputs, hold
+ * their slots only while being evaluated.
+ *
+ * Return: Allocated array of slots assigned to nodes, which must be freed by the caller
+*/
+lpg_inference_graph_uindex_t *__lpg_node_packed_alloc_slots(
+    const lpg_node_packed_t *sorted_nodes,
+    size_t nodes_num,
+    size_t inputs_size,
+    const lpg_inference_graph_uindex_t *output_nodes,
+    size_t outputs_size,
+    const lp_bitset_t *outputs_mask,
+    size_t *slots_num)
+{
+    return __lpg_node_packed_alloc_slots_grouped(sorted_nodes,nodes_num,inputs_size,output_nodes,outputs_size,outputs_mask,NULL,0,slots_num);
+}
+
+
+/**
+ * __lpg_inference_graph_alloc_slots - assigns reusable value slots to nodes of inference graph
+ * @inference_graph:    pointer to inference graph object with populated @sorted_nodes and @output_nodes
+ *
+ * See '__lpg_node_packed_alloc_slots'.
+ *
+ * Return: None
+*/
+void __lpg_inference_graph_alloc_slots(lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    inference_graph->node_slots = __lpg_node_packed_alloc_slots(
+        inference_graph->sorted_nodes,
+        inference_graph->nodes_num,
+        inference_graph->inputs_size,
+        inference_graph->output_nodes,
+        inference_graph->outputs_size,
+        NULL,
+        &inference_graph->slots_num);
+}
@@ -0,0 +1,218 @@
+#include <lockpick/graph/inference/soa.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/define.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * __lpg_inference_soa_group_nodes - orders nodes of every level by their packed types
+ * @inference_graph:    pointer to inference graph object
+ * @grouped_nodes:      resulting indices within @sorted_nodes of nodes in grouped order
+ * @group_types:        resulting packed types of groups
+ * @group_offsets:      resulting indices within gate arrays where each group begins, followed by number of gates
+ *
+ * Input nodes stay at the beginning in their order. Gates of every level are placed with a counting sort
+ * by type, which keeps the relative order of gates of the same type.
+ *
+ * Return: Number of groups
+*/
+static size_t __lpg_inference_soa_group_nodes(const lpg_inference_graph_t *inference_graph, size_t *grouped_nodes, cl_char *group_types, size_t *group_offsets)
+{
+    size_t nodes_num = inference_graph->nodes_num;
+    size_t inputs_size = inference_graph->inputs_size;
+
+    for(size_t node_i = 0; node_i < inputs_size; ++node_i)
+        grouped_nodes[node_i] = node_i;
+
+    size_t groups_num = 0;
+    size_t placed_num = inputs_size;
+    for(size_t level_i = 0; level_i < inference_graph->levels_num; ++level_i)
+    {
+        // Zero level starts with input nodes, which are not evaluated
+        size_t level_begin = MAX(inference_graph->level_offsets[level_i],inputs_size);
+        size_t level_end = inference_graph->level_offsets[level_i+1];
+
+        size_t type_offsets[LPG_INFERENCE_SOA_GATE_TYPES_NUM] = {0};
+        for(size_t node_i = level_begin; node_i < level_end; ++node_i)
+            ++type_offsets[lpg_node_packed_type(&inference_graph->sorted_nodes[node_i])];
+
+        for(cl_char type = 0; type < LPG_INFERENCE_SOA_GATE_TYPES_NUM; ++type)
+        {
+            size_t type_count = type_offsets[type];
+            type_offsets[type] = placed_num;
+            if(type_count == 0)
+                continue;
+
+            group_types[groups_num] = type;
+            group_offsets[groups_num] = placed_num-inputs_size;
+            ++groups_num;
+            placed_num += type_count;
+        }
+
+        for(size_t node_i = level_begin; node_i < level_end; ++node_i)
+            grouped_nodes[type_offsets[lpg_node_packed_type(&inference_graph->sorted_nodes[node_i])]++] = node_i;
+    }
+
+    affirmf_debug(placed_num == nodes_num,"Number of grouped nodes %zd differs from number of nodes %zd",placed_num,nodes_num);
+    group_offsets[groups_num] = nodes_num-inputs_size;
+
+    return groups_num;
+}
+
+
+/**
+ * __lpg_inference_soa_create - builds structure-of-arrays layout of inference graph
+ * @inference_graph:    pointer to inference graph object
+ *
+ * Gates are grouped by type within levels, see 'lpg_inference_soa'. The grouped order is materialized as
+ * a reindexed packed array first, so that value slots are allocated for the order of evaluation, and then
+ * split into separate arrays of operand and result slots.
+ *
+ * Return: Pointer to created structure-of-arrays object
+*/
+lpg_inference_soa_t *__lpg_inference_soa_create(const lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    size_t nodes_num = inference_graph->nodes_num;
+    size_t inputs_size = inference_graph->inputs_size;
+    size_t outputs_size = inference_graph->outputs_size;
+    const lpg_node_packed_t *sorted_nodes = inference_graph->sorted_nodes;
+
+    size_t soa_size = sizeof(lpg_inference_soa_t);
+    lpg_inference_soa_t *soa = (lpg_inference_soa_t*)malloc(soa_size);
+    affirm_bad_malloc(soa,"inference soa",soa_size);
+
+    soa->gates_num = nodes_num-inputs_size;
+
+    // Every level holds at most one group per type
+    size_t max_groups_num = inference_graph->levels_num*LPG_INFERENCE_SOA_GATE_TYPES_NUM;
+    soa->group_types = (cl_char*)malloc(MAX(1,max_groups_num)*sizeof(cl_char));
+    affirm_bad_malloc(soa->group_types,"group types array",MAX(1,max_groups_num)*sizeof(cl_char));
+    soa->group_offsets = (size_t*)malloc((max_groups_num+1)*sizeof(size_t));
+    affirm_bad_malloc(soa->group_offsets,"group offsets array",(max_groups_num+1)*sizeof(size_t));
+
+    size_t grouped_nodes_size = MAX(1,nodes_num)*sizeof(size_t);
+    size_t *grouped_nodes = (size_t*)malloc(grouped_nodes_size);
+    affirm_bad_malloc(grouped_nodes,"grouped nodes array",grouped_nodes_size);
+
+    soa->groups_num = __lpg_inference_soa_group_nodes(inference_graph,grouped_nodes,soa->group_types,soa->group_offsets);
+
+    // Position of each node of @sorted_nodes within the grouped order
+    size_t grouped_indices_size = MAX(1,nodes_num)*sizeof(lpg_inference_graph_uindex_t);
+    lpg_inference_graph_uindex_t *grouped_indices = (lpg_inference_graph_uindex_t*)malloc(grouped_indices_size);
+    affirm_bad_malloc(grouped_indices,"grouped indices array",grouped_indices_size);
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+        grouped_indices[grouped_nodes[node_i]] = node_i;
+
+    size_t grouped_sorted_nodes_size = MAX(1,nodes_num)*sizeof(lpg_node_packed_t);
+    lpg_node_packed_t *grouped_sorted_nodes = (lpg_node_packed_t*)malloc(grouped_sorted_nodes_size);
+    affirm_bad_malloc(grouped_sorted_nodes,"grouped sorted nodes array",grouped_sorted_nodes_size);
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+    {
+        lpg_node_packed_t node = sorted_nodes[grouped_nodes[node_i]];
+        uint16_t parents_num = lpg_node_packed_get_parents_num(&node);
+        for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+            node.parents[parent_i] = grouped_indices[(lpg_inference_graph_uindex_t)node.parents[parent_i]];
+        grouped_sorted_nodes[node_i] = node;
+    }
+
+    size_t node_group_offsets_size = (soa->groups_num+1)*sizeof(size_t);
+    size_t *node_group_offsets = (size_t*)malloc(node_group_offsets_size);
+    affirm_bad_malloc(node_group_offsets,"node group offsets array",node_group_offsets_size);
+    for(size_t group_i = 0; group_i <= soa->groups_num; ++group_i)
+        node_group_offsets[group_i] = soa->group_offsets[group_i]+inputs_size;
+
+    size_t grouped_output_nodes_size = MAX(1,outputs_size)*sizeof(lpg_inference_graph_uindex_t);
+    lpg_inference_graph_uindex_t *grouped_output_nodes = (lpg_inference_graph_uindex_t*)malloc(grouped_output_nodes_size);
+    affirm_bad_malloc(grouped_output_nodes,"grouped output nodes array",grouped_output_nodes_size);
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+        grouped_output_nodes[out_i] = grouped_indices[inference_graph->output_nodes[out_i]];
+
+    lpg_inference_graph_uindex_t *node_slots = __lpg_node_packed_alloc_slots_grouped(grouped_sorted_nodes,nodes_num,inputs_size,
+        grouped_output_nodes,outputs_size,NULL,node_group_offsets,soa->groups_num,&soa->slots_num);
+
+    size_t gates_size = MAX(1,soa->gates_num)*sizeof(lpg_inference_graph_uindex_t);
+    soa->parents_a = (lpg_inference_graph_uindex_t*)malloc(gates_size);
+    affirm_bad_malloc(soa->parents_a,"first operands array",gates_size);
+    soa->parents_b = (lpg_inference_graph_uindex_t*)malloc(gates_size);
+    affirm_bad_malloc(soa->parents_b,"second operands array",gates_size);
+    soa->parents_c = (lpg_inference_graph_uindex_t*)malloc(gates_size);
+    affirm_bad_malloc(soa->parents_c,"third operands array",gates_size);
+    soa->dests = (lpg_inference_graph_uindex_t*)malloc(gates_size);
+    affirm_bad_malloc(soa->dests,"destinations array",gates_size);
+
+    for(size_t gate_i = 0; gate_i < soa->gates_num; ++gate_i)
+    {
+        size_t node_i = inputs_size+gate_i;
+        const lpg_node_packed_t *node = &grouped_sorted_nodes[node_i];
+        uint16_t parents_num = lpg_node_packed_get_parents_num(node);
+
+        // Constant gates do not read operands, so any valid slot fits
+        lpg_inference_graph_uindex_t a = parents_num > 0 ? node_slots[(lpg_inference_graph_uindex_t)node->parents[0]] : 0;
+        lpg_inference_graph_uindex_t b = parents_num > 1 ? node_slots[(lpg_inference_graph_uindex_t)node->parents[1]] : a;
+        lpg_inference_graph_uindex_t c = parents_num > 2 ? node_slots[(lpg_inference_graph_uindex_t)node->parents[2]] : b;
+        soa->parents_a[gate_i] = a;
+        soa->parents_b[gate_i] = b;
+        soa->parents_c[gate_i] = c;
+        soa->dests[gate_i] = node_slots[node_i];
+    }
+
+    size_t output_slots_size = MAX(1,outputs_size)*sizeof(lpg_inference_graph_uindex_t);
+    soa->output_slots = (lpg_inference_graph_uindex_t*)malloc(output_slots_size);
+    affirm_bad_malloc(soa->output_slots,"output slots array",output_slots_size);
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+        soa->output_slots[out_i] = node_slots[grouped_output_nodes[out_i]];
+
+    free(grouped_nodes);
+    free(grouped_indices);
+    free(grouped_sorted_nodes);
+    free(grouped_output_nodes);
+    free(node_group_offsets);
+    free(node_slots);
+
+    return soa;
+}
+
+
+/**
+ * __lpg_inference_soa_release - releases structure-of-arrays layout
+ * @soa:    pointer to structure-of-arrays object
+ *
+ * Return: None
+*/
+void __lpg_inference_soa_release(lpg_inference_soa_t *soa)
+{
+    affirm_nullptr(soa,"inference soa");
+
+    free(soa->group_types);
+    free(soa->group_offsets);
+    free(soa->parents_a);
+    free(soa->parents_b);
+    free(soa->parents_c);
+    free(soa->dests);
+    free(soa->output_slots);
+    free(soa);
+}
+
+
+/**
+ * lpg_inference_graph_soa - returns structure-of-arrays version of inference graph
+ * @inference_graph:    pointer to inference graph object
+ *
+ * The layout is built on the first call and cached inside @inference_graph until its release.
+ * Building is not synchronized, so call this function once before sharing @inference_graph
+ * between threads.
+ *
+ * Return: Pointer to structure-of-arrays object owned by @inference_graph
+*/
+lpg_inference_soa_t *lpg_inference_graph_soa(lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    if(!inference_graph->soa)
+        inference_graph->soa = __lpg_inference_soa_create(inference_graph);
+
+    return inference_graph->soa;
+}
@@ -0,0 +1,126 @@
+#include <lockpick/graph/inference/stream.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/define.h>
+#include <stdlib.h>
+
+
+static uint8_t *__lpg_inference_stream_write_varint(uint8_t *pos, size_t value)
+{
+    while(value >= 0x80)
+    {
+        *pos++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *pos++ = (uint8_t)value;
+
+    return pos;
+}
+
+
+/**
+ * __lpg_inference_stream_create - encodes sorted nodes of inference graph into compressed stream
+ * @inference_graph:    pointer to inference graph object
+ *
+ * See 'lpg_inference_stream' for the encoding. Outputs served by each node are gathered from @output_nodes
+ * beforehand. The buffer is allocated for the worst case of every field taking LPG_INFERENCE_STREAM_VARINT_MAX_SIZE
+ * bytes and shrunk to the actual size afterwards.
+ *
+ * Return: Pointer to created stream object
+*/
+lpg_inference_stream_t *__lpg_inference_stream_create(const lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    size_t nodes_num = inference_graph->nodes_num;
+    size_t inputs_size = inference_graph->inputs_size;
+    size_t outputs_size = inference_graph->outputs_size;
+    const lpg_inference_graph_uindex_t *node_slots = inference_graph->node_slots;
+
+    size_t stream_size = sizeof(lpg_inference_stream_t);
+    lpg_inference_stream_t *stream = (lpg_inference_stream_t*)malloc(stream_size);
+    affirm_bad_malloc(stream,"inference stream",stream_size);
+
+    // Outputs of node 'i' occupy [node_outputs_offsets[i], node_outputs_offsets[i+1]) of 'node_outputs'
+    size_t *node_outputs_offsets;
+    size_t *node_outputs;
+    __lpg_inference_graph_build_node_outputs(inference_graph,&node_outputs_offsets,&node_outputs);
+
+    size_t max_data_size = MAX(1,nodes_num*(1+(1+LPG_NODE_PACKED_MAX_PARENTS_NUM)*LPG_INFERENCE_STREAM_VARINT_MAX_SIZE)+outputs_size*2*LPG_INFERENCE_STREAM_VARINT_MAX_SIZE);
+    uint8_t *data = (uint8_t*)malloc(max_data_size);
+    affirm_bad_malloc(data,"inference stream data",max_data_size);
+
+    uint8_t *pos = data;
+    for(size_t node_i = 0; node_i < nodes_num; ++node_i)
+    {
+        const lpg_node_packed_t *node = &inference_graph->sorted_nodes[node_i];
+        uint16_t parents_num = lpg_node_packed_get_parents_num(node);
+        size_t node_outputs_begin = node_outputs_offsets[node_i];
+        size_t node_outputs_num = node_outputs_offsets[node_i+1]-node_outputs_begin;
+
+        uint8_t *header = pos++;
+        *header = lpg_node_packed_type(node);
+        if(node_outputs_num > 0)
+            *header |= LPG_INFERENCE_STREAM_OUTPUT_FLAG;
+
+        // Input nodes occupy the first slots in order
+        if(node_i >= inputs_size)
+            pos = __lpg_inference_stream_write_varint(pos,node_slots[node_i]);
+
+        for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+            pos = __lpg_inference_stream_write_varint(pos,node_slots[(lpg_inference_graph_uindex_t)node->parents[parent_i]]);
+
+        if(node_outputs_num > 0)
+        {
+            pos = __lpg_inference_stream_write_varint(pos,node_outputs_num);
+            for(size_t node_out_i = 0; node_out_i < node_outputs_num; ++node_out_i)
+                pos = __lpg_inference_stream_write_varint(pos,node_outputs[node_outputs_begin+node_out_i]);
+        }
+    }
+
+    free(node_outputs_offsets);
+    free(node_outputs);
+
+    stream->nodes_num = nodes_num;
+    stream->inputs_size = inputs_size;
+    stream->size = pos-data;
+    stream->data = (uint8_t*)realloc(data,MAX(1,stream->size));
+    affirm_bad_malloc(stream->data,"inference stream data realloc",MAX(1,stream->size));
+
+    return stream;
+}
+
+
+/**
+ * __lpg_inference_stream_release - releases compressed stream
+ * @stream:     pointer to stream object
+ *
+ * Return: None
+*/
+void __lpg_inference_stream_release(lpg_inference_stream_t *stream)
+{
+    affirm_nullptr(stream,"inference stream");
+
+    free(stream->data);
+    free(stream);
+}
+
+
+/**
+ * lpg_inference_graph_stream - returns compressed stream of nodes of inference graph
+ * @inference_graph:    pointer to inference graph object
+ *
+ * The stream is encoded on the first call and cached inside @inference_graph until its release.
+ * Encoding is not synchronized, so call this function once before sharing @inference_graph
+ * between threads.
+ *
+ * Return: Pointer to stream object owned by @inference_graph
+*/
+lpg_inference_stream_t *lpg_inference_graph_stream(lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    if(!inference_graph->stream)
+        inference_graph->stream = __lpg_inference_stream_create(inference_graph);
+
+    return inference_graph->stream;
+}
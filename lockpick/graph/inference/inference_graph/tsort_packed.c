@@ -1,118 +1,236 @@
 #include <lockpick/graph/tsort.h>
-#include <lockpick/graph/traverse.h>
 #include <lockpick/graph/inference/inference_graph.h>
 #include <lockpick/affirmf.h>
-#include <lockpick/htable.h>
+#include <lockpick/affinity.h>
+#include <lockpick/define.h>
 #include <lockpick/math.h>
-#include <lockpick/vector.h>
+#include <pthread.h>
 #include <malloc.h>
 #include <string.h>
 
 
-void __lpg_inference_graph_tsort_packed(lpg_inference_graph_t *inference_graph, bool gen_inverse_index)
+typedef struct __lpg_inference_graph_pack_thr_args_common
 {
-    affirm_nullptr(inference_graph,"graph");
-    affirmf_debug(inference_graph->graph,"Graph field of ocl graph instance must be set to this point");
+    lpg_inference_graph_t *inference_graph;
+    lpg_node_t **sorted_nodes;
+    lpg_node_packed_t *result;
+    uint32_t total_threads;
+    pthread_barrier_t *pack_barrier;
+} __lpg_inference_graph_pack_thr_args_common_t;
+
+typedef struct __lpg_inference_graph_pack_thr_args
+{
+    __lpg_inference_graph_pack_thr_args_common_t *common_args;
+    uint32_t current_thread_i;
+} __lpg_inference_graph_pack_thr_args_t;
 
-    lpg_graph_t *graph = inference_graph->graph;
 
-    __tsort_init_state_t init_state;
+static void __lpg_inference_graph_map_chunk(lpg_inference_graph_t *inference_graph, lpg_node_t **sorted_nodes, size_t chunk_begin, size_t chunk_end)
+{
+    lp_slab_t *slab = __lpg_graph_slab(inference_graph->graph);
+    for(size_t node_i = chunk_begin; node_i < chunk_end; ++node_i)
+        inference_graph->index_map[lp_slab_index(slab,sorted_nodes[node_i])] = node_i;
+}
 
-    size_t const_nodes_init_size = (1 << INIT_ZERO_LAYER_NODES_LOG_ARR_SIZE)*sizeof(lpg_node_t*);
-    init_state.const_nodes = (lpg_node_t**)malloc(const_nodes_init_size);
-    affirm_bad_malloc(init_state.const_nodes,"zero layer nodes array",const_nodes_init_size);
 
-    init_state.nodes_count = init_state.const_nodes_count = 0;
+static void __lpg_inference_graph_pack_chunk(lpg_inference_graph_t *inference_graph, lpg_node_t **sorted_nodes, lpg_node_packed_t *result, size_t chunk_begin, size_t chunk_end)
+{
+    size_t inputs_size = inference_graph->graph->inputs_size;
+    for(size_t node_i = chunk_begin; node_i < chunk_end; ++node_i)
+    {
+        lpg_node_t *node = sorted_nodes[node_i];
+        if(node_i < inputs_size)
+            result[node_i] = __lpg_node_packed_from_input_node(node);
+        else if(lpg_node_get_parents_num(node) == 0)
+            result[node_i] = __lpg_node_packed_from_const_node(node);
+        else
+            result[node_i] = __lpg_node_packed_from_node(inference_graph,node);
+    }
+}
 
-    lpg_graph_traverse_once(graph,__lpg_tsort_init_state_cb,&init_state);
 
-    inference_graph->nodes_num = init_state.nodes_count;
+/**
+ * __lpg_inference_graph_pack_thr - parallel packing of sorted nodes pthread_create entry point
+ * @args:       unpacking below
+ * @current_thread_i:   index of calling thread
+ * @inference_graph:    pointer to inference graph object with allocated @index_map
+ * @sorted_nodes:       topologically sorted nodes of the graph
+ * @result:             resulting array of packed nodes
+ * @total_threads:      number of threads participating in packing
+ * @pack_barrier:       barrier separating population of @index_map and packing
+ *
+ * Every thread handles its own contiguous chunk of @sorted_nodes: first it records indices of its nodes
+ * inside @index_map, then, once all indices are known, packs its nodes with parents translated into indices.
+ *
+ * Return: None
+*/
+static void *__lpg_inference_graph_pack_thr(__lpg_inference_graph_pack_thr_args_t *args)
+{
+    uint32_t current_thread_i = args->current_thread_i;
+    lpg_inference_graph_t *inference_graph = args->common_args->inference_graph;
+    lpg_node_t **sorted_nodes = args->common_args->sorted_nodes;
+    lpg_node_packed_t *result = args->common_args->result;
+    uint32_t total_threads = args->common_args->total_threads;
+    pthread_barrier_t *pack_barrier = args->common_args->pack_barrier;
 
-    size_t result_size = init_state.nodes_count*sizeof(lpg_node_packed_t);
-    lpg_node_packed_t *result = (lpg_node_packed_t*)malloc(result_size);
-    affirm_bad_malloc(result,"result sorted nodes array",result_size);
+    size_t nodes_num = inference_graph->nodes_num;
+    size_t chunk_size = lp_ceil_div_u64(nodes_num,total_threads);
+    size_t chunk_begin = MIN(current_thread_i*chunk_size,nodes_num);
+    size_t chunk_end = MIN(chunk_begin+chunk_size,nodes_num);
 
-    inference_graph->index_map = lp_htable_create_el_num(
-            init_state.nodes_count,
-            sizeof(__lpg_inference_graph_index_map_entry_t),
-            lp_htable_cast_hsh(__lpg_inference_graph_index_map_hsh),
-            lp_htable_cast_eq(__lpg_inference_graph_index_map_eq));
-    
-    if(gen_inverse_index)
-        inference_graph->inv_index_map = lp_htable_create_el_num(
-            init_state.nodes_count,
-            sizeof(__lpg_inference_graph_index_map_entry_t),
-            lp_htable_cast_hsh(__lpg_inference_graph_inv_index_map_hsh),
-            lp_htable_cast_eq(__lpg_inference_graph_index_map_eq));
-    else
-        inference_graph->inv_index_map = NULL;
-    
-    size_t zero_layer_size = init_state.const_nodes_count+graph->inputs_size;
-    size_t init_orphaned_capacity = zero_layer_size*2;
-    // Nodes that do not have unprocessed parents anymore
-    lp_vector_t *orphaned = lp_vector_create(init_orphaned_capacity,sizeof(lpg_node_t*));
+    __lpg_inference_graph_map_chunk(inference_graph,sorted_nodes,chunk_begin,chunk_end);
 
-    for(size_t in_node_i = 0; in_node_i < graph->inputs_size; ++in_node_i)
-    {
-        result[in_node_i] = __lpg_node_packed_from_input_node(graph->inputs[in_node_i],LPG_NODE_PACKED_NOT_OUTPUT);
-        lp_vector_push_back(orphaned,&graph->inputs[in_node_i]);
-        __lpg_inference_graph_index_map_insert(inference_graph,graph->inputs[in_node_i],in_node_i);
-        if(gen_inverse_index)
-            __lpg_inference_graph_inv_index_map_insert(inference_graph,graph->inputs[in_node_i],in_node_i);
-    }
-    
-    for(size_t const_node_i = 0; const_node_i < init_state.const_nodes_count; ++const_node_i)
+    pthread_barrier_wait(pack_barrier);
+
+    __lpg_inference_graph_pack_chunk(inference_graph,sorted_nodes,result,chunk_begin,chunk_end);
+
+    return NULL;
+}
+
+
+/**
+ * __lpg_inference_graph_pack_mt - packs sorted nodes of inference graph in parallel
+ * @inference_graph:    pointer to inference graph object with allocated @index_map
+ * @sorted_nodes:       topologically sorted nodes of the graph
+ * @result:             resulting array of packed nodes
+ * @threads_num:        number of threads to pack nodes with, greater than one
+ *
+ * Return: None
+*/
+static void __lpg_inference_graph_pack_mt(lpg_inference_graph_t *inference_graph, lpg_node_t **sorted_nodes, lpg_node_packed_t *result, uint32_t threads_num)
+{
+    pthread_barrier_t pack_barrier;
+    affirmf(!pthread_barrier_init(&pack_barrier,NULL,threads_num),"Failed to initialize pack barrier");
+
+    __lpg_inference_graph_pack_thr_args_common_t common_args;
+    common_args.inference_graph = inference_graph;
+    common_args.sorted_nodes = sorted_nodes;
+    common_args.result = result;
+    common_args.total_threads = threads_num;
+    common_args.pack_barrier = &pack_barrier;
+
+    __lpg_inference_graph_pack_thr_args_t *args = (__lpg_inference_graph_pack_thr_args_t*)malloc(threads_num*sizeof(__lpg_inference_graph_pack_thr_args_t));
+    affirm_bad_malloc(args,"threads arguments",threads_num*sizeof(__lpg_inference_graph_pack_thr_args_t));
+    pthread_t *threads = (pthread_t*)malloc(threads_num*sizeof(pthread_t));
+    affirm_bad_malloc(threads,"threads array",threads_num*sizeof(pthread_t));
+
+    // Affinity is set before start, since short-lived threads may exit before it could be set afterwards
+    pthread_attr_t thread_attr;
+    affirmf(!pthread_attr_init(&thread_attr),"Failed to initialize thread attributes");
+    for(uint32_t thr_i = 0; thr_i < threads_num; ++thr_i)
     {
-        result[graph->inputs_size+const_node_i] = __lpg_node_packed_from_const_node(init_state.const_nodes[const_node_i],LPG_NODE_PACKED_NOT_OUTPUT);
-        lp_vector_push_back(orphaned,&init_state.const_nodes[const_node_i]);
-        __lpg_inference_graph_index_map_insert(inference_graph,init_state.const_nodes[const_node_i],graph->inputs_size+const_node_i);
-        if(gen_inverse_index)
-            __lpg_inference_graph_inv_index_map_insert(inference_graph,init_state.const_nodes[const_node_i],graph->inputs_size+const_node_i);
+        args[thr_i].common_args = &common_args;
+        args[thr_i].current_thread_i = thr_i;
+        affirmf(!pthread_attr_setaffinity_np(&thread_attr,sizeof(cpu_set_t),&lp_affinity_cpus[thr_i%lp_affinity_cpu_count]),
+            "Failed to set cpu affinity for thread %d",thr_i);
+        affirmf(!pthread_create(&threads[thr_i],&thread_attr,(void *(*)(void*))__lpg_inference_graph_pack_thr,&args[thr_i]),
+            "Failed to create thread %d",thr_i);
     }
-    free(init_state.const_nodes);
+    pthread_attr_destroy(&thread_attr);
+
+    for(uint32_t thr_i = 0; thr_i < threads_num; ++thr_i)
+        affirmf(!pthread_join(threads[thr_i],NULL),"Failed to join thread %d",thr_i);
+
+    pthread_barrier_destroy(&pack_barrier);
+    free(threads);
+    free(args);
+}
+
 
-    lp_htable_t *visited = lp_htable_create_el_num(
-            init_state.nodes_count,
-            sizeof(lpg_node_t*),
-            lp_htable_cast_hsh(__lpg_graph_nodes_hsh),
-            lp_htable_cast_eq(__lpg_graph_nodes_eq));
+/**
+ * __lpg_inference_graph_record_outputs - records indices of output nodes of inference graph
+ * @inference_graph:    pointer to inference graph object with populated @index_map
+ *
+ * Allocates and populates @output_nodes of @inference_graph.
+ *
+ * Return: None
+*/
+static void __lpg_inference_graph_record_outputs(lpg_inference_graph_t *inference_graph)
+{
+    lpg_graph_t *graph = inference_graph->graph;
+    size_t outputs_size = graph->outputs_size;
+    size_t output_nodes_size = MAX(1,outputs_size)*sizeof(lpg_inference_graph_uindex_t);
+    inference_graph->output_nodes = (lpg_inference_graph_uindex_t*)malloc(output_nodes_size);
+    affirm_bad_malloc(inference_graph->output_nodes,"output nodes array",output_nodes_size);
 
-    size_t curr_node_i = zero_layer_size;
-    while(!lp_vector_empty(orphaned))
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
     {
-        lpg_node_t *curr_node = *(lpg_node_t**)lp_vector_back(orphaned);
-        size_t children_num = lpg_node_get_children_num(curr_node);
-        lp_vector_pop_back(orphaned);
-        for(size_t child_i = 0; child_i < children_num; ++child_i)
-        {
-            lpg_node_t *child_node = lp_vector_at_type(curr_node->children,child_i,lpg_node_t*);
-            size_t child_parents_num = lpg_node_get_parents_num(child_node);
-            affirmf_debug(child_parents_num > 0,"Parents num of a child node must always be greater than zero");
-            
-            if(child_parents_num == 1 || !lp_htable_insert(visited,&child_node))
-            {
-                result[curr_node_i] = __lpg_node_packed_from_node(inference_graph,child_node,LPG_NODE_PACKED_NOT_OUTPUT);
-                lp_vector_push_back(orphaned,&child_node);
-                __lpg_inference_graph_index_map_insert(inference_graph,child_node,curr_node_i);
-                if(gen_inverse_index)
-                    __lpg_inference_graph_inv_index_map_insert(inference_graph,child_node,curr_node_i);
-
-                ++curr_node_i;
-            }
-        }
+        lpg_inference_graph_index_t out_index;
+        lpg_inference_graph_index_map_find(inference_graph,graph->outputs[out_i],&out_index);
+        inference_graph->output_nodes[out_i] = (lpg_inference_graph_uindex_t)out_index;
     }
+}
+
+
+/**
+ * __lpg_inference_graph_tsort_packed - topologically sorts nodes of the graph into packed nodes array
+ * @inference_graph:    pointer to inference graph object with @graph set
+ * @gen_inverse_index:  whether @inv_index_map should be built
+ * @order:              ordering strategy of sorted nodes
+ * @threads_num:        number of threads to pack nodes with
+ *
+ * Nodes are sorted by levels with '__lpg_graph_tsort_levels', see 'lpg_inference_graph' for the layout,
+ * and rearranged according to @order. Sorting touches only the fan-in cone of outputs, so children outside
+ * of it are never scanned, which matters for graphs sharing the slab of a much larger super-graph.
+ *
+ * Sorted nodes are then packed, in parallel if @threads_num is greater than one. Since the array of sorted
+ * nodes maps indices to nodes, it is kept as @inv_index_map if requested. Indices of output nodes are
+ * recorded in @output_nodes.
+ *
+ * Return: None
+*/
+void __lpg_inference_graph_tsort_packed(lpg_inference_graph_t *inference_graph, bool gen_inverse_index, lpg_inference_order_t order, uint32_t threads_num)
+{
+    affirm_nullptr(inference_graph,"graph");
+    affirmf_debug(inference_graph->graph,"Graph field of ocl graph instance must be set to this point");
+    affirmf(threads_num > 0,"Number of threads must be greater than zero");
+
+    lpg_graph_t *graph = inference_graph->graph;
+
+    __lpg_tsort_levels_t levels;
+    __lpg_graph_tsort_levels(graph,order == LPG_INFERENCE_ORDER_DFS,&levels);
+
+    affirmf(levels.redundant_inputs_num == 0,
+        "Given graph contains %zd redundant input nodes and cannot be converted to ocl graph",levels.redundant_inputs_num);
+
+    // Must be checked before packing, since indices of exceeding nodes do not fit into packed nodes
+    affirmf(levels.nodes_num <= LPG_INFERENCE_GRAPH_MAX_NODES_NUM,
+        "Number of nodes in the given graph exceeds max number of nodes supported (%zd > %zd)",
+        levels.nodes_num,(size_t)LPG_INFERENCE_GRAPH_MAX_NODES_NUM);
 
-    lpg_inference_graph_index_t outputs_size = inference_graph->graph->outputs_size;
-    lpg_node_t **outputs = inference_graph->graph->outputs;
-    for(lpg_inference_graph_index_t out_node_i = 0; out_node_i < outputs_size; ++out_node_i)
+    __lpg_inference_graph_reorder(graph,order,&levels);
+
+    inference_graph->nodes_num = levels.nodes_num;
+    inference_graph->levels_num = levels.levels_num;
+    inference_graph->level_offsets = levels.level_offsets;
+
+    size_t result_size = MAX(1,levels.nodes_num)*sizeof(lpg_node_packed_t);
+    lpg_node_packed_t *result = (lpg_node_packed_t*)malloc(result_size);
+    affirm_bad_malloc(result,"result sorted nodes array",result_size);
+
+    size_t index_map_size = MAX(1,lp_slab_capacity(__lpg_graph_slab(graph)))*sizeof(lpg_inference_graph_index_t);
+    inference_graph->index_map = (lpg_inference_graph_index_t*)malloc(index_map_size);
+    affirm_bad_malloc(inference_graph->index_map,"index map array",index_map_size);
+
+    if(threads_num > 1)
+        __lpg_inference_graph_pack_mt(inference_graph,levels.sorted_nodes,result,threads_num);
+    else
     {
-        lpg_inference_graph_index_t out_index;
-        lpg_inference_graph_index_map_find(inference_graph,outputs[out_node_i],&out_index);
-        __lpg_node_packed_set_output(&result[out_index],out_node_i);
+        __lpg_inference_graph_map_chunk(inference_graph,levels.sorted_nodes,0,levels.nodes_num);
+        __lpg_inference_graph_pack_chunk(inference_graph,levels.sorted_nodes,result,0,levels.nodes_num);
     }
 
+    __lpg_inference_graph_record_outputs(inference_graph);
+
     inference_graph->sorted_nodes = result;
+    if(order == LPG_INFERENCE_ORDER_DFS)
+        __lpg_inference_graph_split_runs(inference_graph);
 
-    lp_htable_release(visited);
-    lp_vector_release(orphaned);
+    if(gen_inverse_index)
+        inference_graph->inv_index_map = levels.sorted_nodes;
+    else
+    {
+        inference_graph->inv_index_map = NULL;
+        free(levels.sorted_nodes);
+    }
 }
@@ -1,12 +1,307 @@
 #include <lockpick/graph/inference/ocl/infer.h>
 #include <lockpick/ocl/ocl.h>
 #include <lockpick/affirmf.h>
+#include <stdlib.h>
 
 
-void lpg_inference_graph_infer_random_inputs_ocl(lpg_inference_graph_t *inference_graph)
+/**
+ * lpg_inference_ocl_session_create - creates persistent OpenCL inference session
+ * @context:    OpenCL context or NULL to create one with 'lp_ocl_create_context'
+ *
+ * Builds the inference program for the first device of @context. Program binaries are cached
+ * on disk, see 'lp_ocl_build_program_cached', so only the first session created for particular
+ * device and program source pays for compilation. @context is retained by the session until its release.
+ *
+ * Return: Pointer to created session object
+*/
+lpg_inference_ocl_session_t *lpg_inference_ocl_session_create(cl_context context)
 {
+    size_t session_size = sizeof(lpg_inference_ocl_session_t);
+    lpg_inference_ocl_session_t *session = (lpg_inference_ocl_session_t*)malloc(session_size);
+    affirm_bad_malloc(session,"OpenCL inference session",session_size);
+
+    if(context)
+        affirmf(clRetainContext(context) == CL_SUCCESS,"Failed to retain OpenCL context");
+    else
+        context = lp_ocl_create_context();
+
+    session->context = context;
+    session->device = lp_ocl_context_device(context);
+
+    cl_int errcode;
+    session->queue = clCreateCommandQueueWithProperties(context,session->device,NULL,&errcode);
+    affirmf(errcode == CL_SUCCESS,"Failed to create command queue");
+
+    session->program = lp_ocl_build_program_cached(context,session->device,LPG_INFERENCE_OCL_SOURCE_PATH,LPG_INFERENCE_OCL_BUILD_OPTIONS);
+
+    session->kernel = clCreateKernel(session->program,LPG_INFERENCE_OCL_KERNEL_NAME,&errcode);
+    affirmf(errcode == CL_SUCCESS,"Failed to create kernel '%s'",LPG_INFERENCE_OCL_KERNEL_NAME);
+
+    session->narrow_kernel = clCreateKernel(session->program,LPG_INFERENCE_OCL_NARROW_KERNEL_NAME,&errcode);
+    affirmf(errcode == CL_SUCCESS,"Failed to create kernel '%s'",LPG_INFERENCE_OCL_NARROW_KERNEL_NAME);
+
+    session->graphs = lp_vector_create(1,sizeof(lpg_inference_ocl_graph_t*));
+
+    session->input_values = NULL;
+    session->values = NULL;
+    session->output = NULL;
+    session->input_values_size = 0;
+    session->values_size = 0;
+    session->output_size = 0;
+
+    return session;
+}
+
+
+static void __lpg_inference_ocl_graph_release(lpg_inference_ocl_graph_t *ocl_graph)
+{
+    clReleaseMemObject(ocl_graph->sorted_nodes);
+    clReleaseMemObject(ocl_graph->node_slots);
+    clReleaseMemObject(ocl_graph->output_nodes);
+    free(ocl_graph);
+}
+
+
+/**
+ * lpg_inference_ocl_session_release - releases OpenCL inference session
+ * @session:    pointer to session object
+ *
+ * Device copies of uploaded graphs are released as well, host inference graphs are not.
+ *
+ * Return: None
+*/
+void lpg_inference_ocl_session_release(lpg_inference_ocl_session_t *session)
+{
+    affirm_nullptr(session,"OpenCL inference session");
+
+    for(size_t graph_i = 0; graph_i < session->graphs->size; ++graph_i)
+        __lpg_inference_ocl_graph_release(lp_vector_at_type(session->graphs,graph_i,lpg_inference_ocl_graph_t*));
+    lp_vector_release(session->graphs);
+
+    if(session->input_values)
+        clReleaseMemObject(session->input_values);
+    if(session->values)
+        clReleaseMemObject(session->values);
+    if(session->output)
+        clReleaseMemObject(session->output);
+
+    clReleaseKernel(session->kernel);
+    clReleaseKernel(session->narrow_kernel);
+    clReleaseProgram(session->program);
+    clReleaseCommandQueue(session->queue);
+    clReleaseContext(session->context);
+    free(session);
+}
+
+
+/**
+ * lpg_inference_ocl_session_upload - returns device-resident copy of inference graph
+ * @session:            pointer to session object
+ * @inference_graph:    pointer to inference graph object
+ *
+ * The graph is uploaded on the first request and kept on the device until the session is released
+ * or the graph is evicted with 'lpg_inference_ocl_session_evict'. Uploaded graphs are identified by
+ * @id of inference graphs, which is never reused, so a graph allocated at the address of a released
+ * one never gets its stale copy. Copies of released graphs are kept until eviction.
+ * The number of graphs per session is expected to be small, so they are looked up linearly.
+ * Node types are validated before upload, as the kernel has no means to report unknown ones.
+ * Graphs having narrow packed nodes are uploaded with them, which halves their size on the device.
+ *
+ * Return: Pointer to device-resident graph owned by @session
+*/
+const lpg_inference_ocl_graph_t *lpg_inference_ocl_session_upload(lpg_inference_ocl_session_t *session, const lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(session,"OpenCL inference session");
+    affirm_nullptr(inference_graph,"inference graph");
+
+    for(size_t graph_i = 0; graph_i < session->graphs->size; ++graph_i)
+    {
+        lpg_inference_ocl_graph_t *ocl_graph = lp_vector_at_type(session->graphs,graph_i,lpg_inference_ocl_graph_t*);
+        if(ocl_graph->inference_graph_id == inference_graph->id)
+            return ocl_graph;
+    }
+
+    for(size_t node_i = 0; node_i < inference_graph->nodes_num; ++node_i)
+    {
+        cl_char type = lpg_node_packed_type(inference_graph->sorted_nodes+node_i);
+        if(node_i < inference_graph->inputs_size)
+            affirmf(type == LPG_NODE_PACKED_TYPE_INPUT,"Expected input node at position %zd, got type %d",node_i,type);
+        else
+            affirmf(type != LPG_NODE_PACKED_TYPE_INPUT && type >= 0 && type < LPG_NODE_PACKED_TYPES_NUM,
+                "Unsupported type %d of node at position %zd",type,node_i);
+    }
+
+    size_t ocl_graph_size = sizeof(lpg_inference_ocl_graph_t);
+    lpg_inference_ocl_graph_t *ocl_graph = (lpg_inference_ocl_graph_t*)malloc(ocl_graph_size);
+    affirm_bad_malloc(ocl_graph,"device-resident inference graph",ocl_graph_size);
+
+    ocl_graph->inference_graph_id = inference_graph->id;
+
+    ocl_graph->narrow = inference_graph->narrow_nodes != NULL;
+
+    cl_int errcode;
+    size_t sorted_nodes_size = inference_graph->nodes_num*(ocl_graph->narrow ? sizeof(lpg_node_packed_narrow_t) : sizeof(lpg_node_packed_t));
+    const void *sorted_nodes = ocl_graph->narrow ? (const void*)inference_graph->narrow_nodes : (const void*)inference_graph->sorted_nodes;
+    ocl_graph->sorted_nodes = clCreateBuffer(session->context,CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,sorted_nodes_size,(void*)sorted_nodes,&errcode);
+    affirmf(errcode == CL_SUCCESS,"Failed to create sorted nodes buffer of size %zd",sorted_nodes_size);
+
+    size_t node_slots_size = inference_graph->nodes_num*sizeof(lpg_inference_graph_uindex_t);
+    ocl_graph->node_slots = clCreateBuffer(session->context,CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,node_slots_size,inference_graph->node_slots,&errcode);
+    affirmf(errcode == CL_SUCCESS,"Failed to create node slots buffer of size %zd",node_slots_size);
+
+    size_t output_nodes_size = inference_graph->outputs_size*sizeof(lpg_inference_graph_uindex_t);
+    ocl_graph->output_nodes = clCreateBuffer(session->context,CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,output_nodes_size,inference_graph->output_nodes,&errcode);
+    affirmf(errcode == CL_SUCCESS,"Failed to create output nodes buffer of size %zd",output_nodes_size);
+
+    lp_vector_push_back(session->graphs,&ocl_graph);
+
+    return ocl_graph;
+}
+
+
+/**
+ * lpg_inference_ocl_session_evict - releases device-resident copy of inference graph
+ * @session:            pointer to session object
+ * @inference_graph:    pointer to inference graph object
+ *
+ * Does nothing if @inference_graph was never uploaded to @session.
+ *
+ * Return: None
+*/
+void lpg_inference_ocl_session_evict(lpg_inference_ocl_session_t *session, const lpg_inference_graph_t *inference_graph)
+{
+    affirm_nullptr(session,"OpenCL inference session");
     affirm_nullptr(inference_graph,"inference graph");
 
-    cl_context context = lp_ocl_create_context();
-    
+    for(size_t graph_i = 0; graph_i < session->graphs->size; ++graph_i)
+    {
+        lpg_inference_ocl_graph_t *ocl_graph = lp_vector_at_type(session->graphs,graph_i,lpg_inference_ocl_graph_t*);
+        if(ocl_graph->inference_graph_id == inference_graph->id)
+        {
+            __lpg_inference_ocl_graph_release(ocl_graph);
+            lp_vector_remove_i(session->graphs,graph_i);
+            return;
+        }
+    }
+}
+
+
+/**
+ * __lpg_inference_ocl_session_reserve - makes sure batch buffer of session is large enough
+ * @session:        pointer to session object
+ * @buffer:         pointer to one of batch buffers of @session
+ * @buffer_size:    pointer to the size of @buffer
+ * @required_size:  required size in bytes
+ * @flags:          memory flags of @buffer
+ *
+ * Return: None
+*/
+static void __lpg_inference_ocl_session_reserve(lpg_inference_ocl_session_t *session, cl_mem *buffer, size_t *buffer_size, size_t required_size, cl_mem_flags flags)
+{
+    if(*buffer_size >= required_size)
+        return;
+
+    if(*buffer)
+        clReleaseMemObject(*buffer);
+
+    cl_int errcode;
+    *buffer = clCreateBuffer(session->context,flags,required_size,NULL,&errcode);
+    affirmf(errcode == CL_SUCCESS,"Failed to create batch buffer of size %zd",required_size);
+    *buffer_size = required_size;
+}
+
+
+/**
+ * lpg_inference_graph_infer_ocl_into - evaluates inference graph on OpenCL device into caller-provided buffer
+ * @session:            pointer to session object
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ * @output:             buffer for bit-sliced values of output nodes
+ *
+ * Same as 'lpg_inference_graph_infer_ocl', but writes into @output, which must hold @words_num
+ * words per output node of the underlying graph.
+ *
+ * Return: None
+*/
+void lpg_inference_graph_infer_ocl_into(
+    lpg_inference_ocl_session_t *session,
+    const lpg_inference_graph_t *inference_graph,
+    const uint64_t *input_values,
+    size_t words_num,
+    uint64_t *output)
+{
+    affirm_nullptr(session,"OpenCL inference session");
+    affirm_nullptr(inference_graph,"inference graph");
+    affirm_nullptr(input_values,"input values");
+    affirm_nullptr(output,"output values");
+    affirmf(words_num > 0,"Number of words per node must be greater than zero");
+
+    const lpg_inference_ocl_graph_t *ocl_graph = lpg_inference_ocl_session_upload(session,inference_graph);
+
+    cl_uint nodes_num = inference_graph->nodes_num;
+    cl_uint inputs_size = inference_graph->inputs_size;
+    cl_uint outputs_size = inference_graph->outputs_size;
+    cl_uint words_num_arg = words_num;
+
+    size_t input_values_size = inputs_size*words_num*sizeof(uint64_t);
+    size_t values_size = inference_graph->slots_num*words_num*sizeof(uint64_t);
+    size_t output_size = outputs_size*words_num*sizeof(uint64_t);
+
+    __lpg_inference_ocl_session_reserve(session,&session->input_values,&session->input_values_size,input_values_size,CL_MEM_READ_ONLY);
+    __lpg_inference_ocl_session_reserve(session,&session->values,&session->values_size,values_size,CL_MEM_READ_WRITE);
+    __lpg_inference_ocl_session_reserve(session,&session->output,&session->output_size,output_size,CL_MEM_WRITE_ONLY);
+
+    // Queue is in-order, so the kernel observes both transfers
+    affirmf(clEnqueueWriteBuffer(session->queue,session->input_values,CL_FALSE,0,input_values_size,input_values,0,NULL,NULL) == CL_SUCCESS,
+        "Failed to write input values");
+
+    cl_kernel kernel = ocl_graph->narrow ? session->narrow_kernel : session->kernel;
+    affirmf(clSetKernelArg(kernel,0,sizeof(cl_uint),&nodes_num) == CL_SUCCESS &&
+            clSetKernelArg(kernel,1,sizeof(cl_uint),&inputs_size) == CL_SUCCESS &&
+            clSetKernelArg(kernel,2,sizeof(cl_uint),&outputs_size) == CL_SUCCESS &&
+            clSetKernelArg(kernel,3,sizeof(cl_uint),&words_num_arg) == CL_SUCCESS &&
+            clSetKernelArg(kernel,4,sizeof(cl_mem),&ocl_graph->sorted_nodes) == CL_SUCCESS &&
+            clSetKernelArg(kernel,5,sizeof(cl_mem),&ocl_graph->node_slots) == CL_SUCCESS &&
+            clSetKernelArg(kernel,6,sizeof(cl_mem),&ocl_graph->output_nodes) == CL_SUCCESS &&
+            clSetKernelArg(kernel,7,sizeof(cl_mem),&session->input_values) == CL_SUCCESS &&
+            clSetKernelArg(kernel,8,sizeof(cl_mem),&session->values) == CL_SUCCESS &&
+            clSetKernelArg(kernel,9,sizeof(cl_mem),&session->output) == CL_SUCCESS,
+        "Failed to set inference kernel arguments");
+
+    size_t global_size = words_num;
+    affirmf(clEnqueueNDRangeKernel(session->queue,kernel,1,NULL,&global_size,NULL,0,NULL,NULL) == CL_SUCCESS,
+        "Failed to enqueue inference kernel");
+
+    // Blocking read also guarantees that @input_values are not accessed after return
+    affirmf(clEnqueueReadBuffer(session->queue,session->output,CL_TRUE,0,output_size,output,0,NULL,NULL) == CL_SUCCESS,
+        "Failed to read output values");
+}
+
+
+/**
+ * lpg_inference_graph_infer_ocl - evaluates inference graph over a batch of bit-sliced input vectors on OpenCL device
+ * @session:            pointer to session object
+ * @inference_graph:    pointer to inference graph object
+ * @input_values:       bit-sliced values of input nodes
+ * @words_num:          number of bit-sliced words per node
+ *
+ * OpenCL counterpart of 'lpg_inference_graph_infer_host_batch' with identical layout of @input_values
+ * and of the returned buffer. All @words_num*64 input vectors are evaluated within a single kernel launch
+ * with one work-item per word. @inference_graph is uploaded to the device on the first call, see
+ * 'lpg_inference_ocl_session_upload'.
+ *
+ * Return: Allocated buffer of bit-sliced output values, which must be freed by the caller
+*/
+uint64_t *lpg_inference_graph_infer_ocl(lpg_inference_ocl_session_t *session, const lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num)
+{
+    affirm_nullptr(inference_graph,"inference graph");
+
+    size_t outputs_size = inference_graph->outputs_size;
+    uint64_t *output = (uint64_t*)malloc(outputs_size*words_num*sizeof(uint64_t));
+    affirm_bad_malloc(output,"bit-sliced output values",outputs_size*words_num*sizeof(uint64_t));
+
+    lpg_inference_graph_infer_ocl_into(session,inference_graph,input_values,words_num,output);
+
+    return output;
 }
@@ -1,7 +1,159 @@
 #include <lockpick/graph/inference/packed_node.h>
 
 
-kernel void lpg_inference_graph_infer_ocl(short outputs_num, global lpg_node_packed_t *graph, global uint *result)
+inline uchar lpg_node_packed_type(const lpg_node_packed_t *node)
 {
+    return (lpg_inference_graph_uindex_t)node->__type & __LPG_NODE_PACKED_TYPE_MASK;
+}
 
-}
\ No newline at end of file
+
+/*
+    Evaluates packed node for a single bit-sliced word.
+*/
+inline ulong __lpg_inference_ocl_node_value(
+    lpg_node_packed_t node,
+    global const lpg_inference_graph_uindex_t *node_slots,
+    global const ulong *values,
+    uint words_num,
+    size_t word_i)
+{
+    ulong value;
+
+    switch(lpg_node_packed_type(&node))
+    {
+        case LPG_NODE_PACKED_TYPE_AND:
+            value = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[0]]*words_num+word_i] &
+                    values[node_slots[(lpg_inference_graph_uindex_t)node.parents[1]]*words_num+word_i];
+            break;
+
+        case LPG_NODE_PACKED_TYPE_OR:
+            value = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[0]]*words_num+word_i] |
+                    values[node_slots[(lpg_inference_graph_uindex_t)node.parents[1]]*words_num+word_i];
+            break;
+
+        case LPG_NODE_PACKED_TYPE_NOT:
+            value = ~values[node_slots[(lpg_inference_graph_uindex_t)node.parents[0]]*words_num+word_i];
+            break;
+
+        case LPG_NODE_PACKED_TYPE_XOR:
+            value = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[0]]*words_num+word_i] ^
+                    values[node_slots[(lpg_inference_graph_uindex_t)node.parents[1]]*words_num+word_i];
+            break;
+
+        case LPG_NODE_PACKED_TYPE_TRUE:
+            value = ~(ulong)0;
+            break;
+
+        case LPG_NODE_PACKED_TYPE_FALSE:
+            value = 0;
+            break;
+
+        case LPG_NODE_PACKED_TYPE_NAND:
+            value = ~(values[node_slots[(lpg_inference_graph_uindex_t)node.parents[0]]*words_num+word_i] &
+                      values[node_slots[(lpg_inference_graph_uindex_t)node.parents[1]]*words_num+word_i]);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_NOR:
+            value = ~(values[node_slots[(lpg_inference_graph_uindex_t)node.parents[0]]*words_num+word_i] |
+                      values[node_slots[(lpg_inference_graph_uindex_t)node.parents[1]]*words_num+word_i]);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_XNOR:
+            value = ~(values[node_slots[(lpg_inference_graph_uindex_t)node.parents[0]]*words_num+word_i] ^
+                      values[node_slots[(lpg_inference_graph_uindex_t)node.parents[1]]*words_num+word_i]);
+            break;
+
+        case LPG_NODE_PACKED_TYPE_ANDNOT:
+            value = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[0]]*words_num+word_i] &
+                    ~values[node_slots[(lpg_inference_graph_uindex_t)node.parents[1]]*words_num+word_i];
+            break;
+
+        case LPG_NODE_PACKED_TYPE_XOR3:
+        {
+            ulong a = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[0]]*words_num+word_i];
+            ulong b = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[1]]*words_num+word_i];
+            ulong c = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[2]]*words_num+word_i];
+            value = a ^ b ^ c;
+            break;
+        }
+
+        case LPG_NODE_PACKED_TYPE_MAJ:
+        {
+            ulong a = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[0]]*words_num+word_i];
+            ulong b = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[1]]*words_num+word_i];
+            ulong c = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[2]]*words_num+word_i];
+            value = (a & b) | (c & (a | b));
+            break;
+        }
+
+        case LPG_NODE_PACKED_TYPE_MUX:
+        {
+            ulong a = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[0]]*words_num+word_i];
+            ulong b = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[1]]*words_num+word_i];
+            ulong c = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[2]]*words_num+word_i];
+            value = a ^ ((a ^ b) & c);
+            break;
+        }
+
+        case LPG_NODE_PACKED_TYPE_ORNOT:
+            value = values[node_slots[(lpg_inference_graph_uindex_t)node.parents[0]]*words_num+word_i] |
+                    ~values[node_slots[(lpg_inference_graph_uindex_t)node.parents[1]]*words_num+word_i];
+            break;
+
+        // Unreachable: node types are validated on upload, see 'lpg_inference_ocl_session_upload'
+        case LPG_NODE_PACKED_TYPE_INPUT:
+        default:
+            value = 0;
+            break;
+    }
+
+    return value;
+}
+
+
+/*
+    Loads packed node of either layout as 'lpg_node_packed_t', see 'lpg_node_packed_narrow'.
+*/
+#define __LPG_INFERENCE_OCL_LOAD_WIDE(node)     (node)
+#define __LPG_INFERENCE_OCL_LOAD_NARROW(node)   __LPG_NODE_PACKED_WIDEN(node)
+
+
+/*
+    Generates kernel evaluating the whole graph for a single bit-sliced word per work-item.
+    Word 'w' of the node with slot 's' is stored at 'values[s*words_num+w]', so that neighbouring
+    work-items access neighbouring words. Slots of output nodes are never reused, so outputs are
+    gathered once all nodes are evaluated.
+*/
+#define __LPG_INFERENCE_OCL_KERNEL(name,packed_t,load)                                                  \
+kernel void name(                                                                                       \
+    uint nodes_num,                                                                                     \
+    uint inputs_size,                                                                                   \
+    uint outputs_size,                                                                                  \
+    uint words_num,                                                                                     \
+    global const packed_t *sorted_nodes,                                                                \
+    global const lpg_inference_graph_uindex_t *node_slots,                                              \
+    global const lpg_inference_graph_uindex_t *output_nodes,                                            \
+    global const ulong *input_values,                                                                   \
+    global ulong *values,                                                                               \
+    global ulong *output)                                                                               \
+{                                                                                                       \
+    size_t word_i = get_global_id(0);                                                                   \
+    if(word_i >= words_num)                                                                             \
+        return;                                                                                         \
+                                                                                                        \
+    /* Input nodes occupy the first slots in order */                                                   \
+    for(uint in_node_i = 0; in_node_i < inputs_size; ++in_node_i)                                       \
+        values[in_node_i*words_num+word_i] = input_values[in_node_i*words_num+word_i];                  \
+                                                                                                        \
+    for(uint node_i = inputs_size; node_i < nodes_num; ++node_i)                                        \
+        values[node_slots[node_i]*words_num+word_i] =                                                   \
+            __lpg_inference_ocl_node_value(load(sorted_nodes[node_i]),node_slots,values,words_num,word_i); \
+                                                                                                        \
+    for(uint out_i = 0; out_i < outputs_size; ++out_i)                                                  \
+        output[out_i*words_num+word_i] = values[node_slots[output_nodes[out_i]]*words_num+word_i];      \
+}
+
+
+__LPG_INFERENCE_OCL_KERNEL(lpg_inference_graph_infer_ocl,lpg_node_packed_t,__LPG_INFERENCE_OCL_LOAD_WIDE)
+
+__LPG_INFERENCE_OCL_KERNEL(lpg_inference_graph_infer_ocl_narrow,lpg_node_packed_narrow_t,__LPG_INFERENCE_OCL_LOAD_NARROW)
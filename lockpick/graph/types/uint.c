@@ -298,6 +298,26 @@ void lpg_uint_update_from_hex_str(lpg_uint_t *value, const char *hex_str)
 }
 
 
+/**
+ * __lpg_uint_assign_node_value - assigns value of constant node of uint
+ * @value:      uint object @node belongs to
+ * @node:       constant node to assign value of
+ * @node_value: new value of @node
+ *
+ * Literals are shared by every gate folded against them, so assigning one would silently
+ * change all of them. Such uints must be updated with fresh constants instead.
+ *
+ * Return: None
+*/
+static inline void __lpg_uint_assign_node_value(const lpg_uint_t *value, lpg_node_t *node, bool node_value)
+{
+    affirmf(!__lpg_node_is_literal(value->graph,node,false) && !__lpg_node_is_literal(value->graph,node,true),
+        "Attempt to assign value of a literal node, consider updating uint with fresh constant nodes");
+
+    __lpg_node_set_value(node,node_value);
+}
+
+
 /**
  * __lpg_uint_update_from_uint - update uint from long arithmetic uint value
  * @value:              uint object to update 
@@ -336,11 +356,11 @@ void __lpg_uint_update_from_uint(lpg_uint_t *value, const __lp_uint_word_t *uint
         size_t curr_uint_bit_i = node_i % __LP_UINT_BITS_PER_WORD;
 
         bool curr_bit_value = (uint_value[curr_uint_word_i] >> curr_uint_bit_i) & 0b1;
-        __lpg_node_set_value(nodes[node_i],curr_bit_value);
+        __lpg_uint_assign_node_value(value,nodes[node_i],curr_bit_value);
     }
 
     for(; node_i < value->width; ++node_i)
-        __lpg_node_set_value(nodes[node_i],false);
+        __lpg_uint_assign_node_value(value,nodes[node_i],false);
 }
 
 
@@ -419,13 +439,13 @@ void lpg_uint_assign_from_hex_str(lpg_uint_t *value, const char *hex_str)
                 goto end_for;
 
             bool curr_bit_value = (curr_hex >> bit_offset) & 0b1;
-            __lpg_node_set_value(nodes[node_i_off],curr_bit_value);
+            __lpg_uint_assign_node_value(value,nodes[node_i_off],curr_bit_value);
         }
     }
     end_for:
 
     for(size_t node_i = upper_bound; node_i < value->width; ++node_i)
-        __lpg_node_set_value(nodes[node_i],false);
+        __lpg_uint_assign_node_value(value,nodes[node_i],false);
 }
 
 
@@ -446,7 +466,7 @@ void lpg_uint_assign_from_rand(lpg_uint_t *value)
     lpg_node_t **nodes = lpg_uint_nodes(value);
 
     for(size_t node_i = 0; node_i < value->width; ++node_i)
-        __lpg_node_set_value(nodes[node_i],(bool)(rand()%2));
+        __lpg_uint_assign_node_value(value,nodes[node_i],(bool)(rand()%2));
 }
 
 
@@ -607,11 +627,32 @@ void lpg_uint_copy(lpg_uint_t *dest, lpg_uint_t *src)
     for(; node_i < upper_bound; ++node_i)
         dest_nodes[node_i] = src_nodes[node_i];
     
+    // Copy is a storage, values of which might be assigned later, so padding must not share the literal
     for(; node_i < dest->width; ++node_i)
         dest_nodes[node_i] = lpg_node_const(graph,false);
 }
 
 
+/**
+ * __lpg_uint_and_not - assembles conjunction of node with negation of another node
+ * @graph:      graph object
+ * @a:          node to conjunct
+ * @b:          node to negate
+ *
+ * Conjunction is folded without assembling the negation of @b whenever its result does not
+ * depend on @b, so that no unused negation is left dangling.
+ *
+ * Return: Node equivalent to conjunction of @a with negation of @b
+*/
+static inline lpg_node_t *__lpg_uint_and_not(lpg_graph_t *graph, lpg_node_t *a, lpg_node_t *b)
+{
+    if(__lpg_node_is_literal(graph,a,false) || a == b)
+        return lpg_node_literal(graph,false);
+
+    return lpg_node_and(graph,a,lpg_node_not(graph,b));
+}
+
+
 /**
  * __lpg_uint_add_right_wider - uint addition with wider right operand
  * @a:          left-side uint operand  
@@ -624,8 +665,8 @@ void lpg_uint_copy(lpg_uint_t *dest, lpg_uint_t *src)
  * @b must be greater than or equal in width to @a. If @b is wider, excess
  * upper bits are carried transparently during addition.
  *
- * The graph assembly for the addition algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * WARNING: No consistency checks are performed. @a, @b, and @result must 
  * belong to the same graph or behavior is undefined.
@@ -640,17 +681,19 @@ static inline void __lpg_uint_add_right_wider(lpg_uint_t *a, lpg_uint_t *b, lpg_
     lpg_node_t **b_nodes = lpg_uint_nodes(b);
     lpg_node_t **result_nodes = lpg_uint_nodes(result);
 
-    lpg_node_t *carry = lpg_node_const(graph,false);
+    lpg_node_t *carry = lpg_node_literal(graph,false);
     size_t a_upper_bound = MIN(a->width,result->width);
     size_t node_i = 0;
     for(; node_i < a_upper_bound; ++node_i)
     {
         lpg_node_t *terms_part = lpg_node_xor(graph,a_nodes[node_i],b_nodes[node_i]);
         result_nodes[node_i] = lpg_node_xor(graph,terms_part,carry);
-        carry = lpg_node_or(graph,
-                    lpg_node_and(graph,terms_part,carry),
-                    lpg_node_and(graph,a_nodes[node_i],b_nodes[node_i])
-                );
+        // Carry out of the top bit of @result would be left unused, so it is never assembled
+        if(node_i+1 < result->width)
+            carry = lpg_node_or(graph,
+                        lpg_node_and(graph,terms_part,carry),
+                        lpg_node_and(graph,a_nodes[node_i],b_nodes[node_i])
+                    );
     }
 
     size_t b_upper_bound = MIN(b->width,result->width);
@@ -661,21 +704,20 @@ static inline void __lpg_uint_add_right_wider(lpg_uint_t *a, lpg_uint_t *b, lpg_
                     carry,
                     b_nodes[node_i]
                 );
-        carry =
-            lpg_node_and(graph,
-                carry,
-                b_nodes[node_i]
-            );
+        if(node_i+1 < result->width)
+            carry =
+                lpg_node_and(graph,
+                    carry,
+                    b_nodes[node_i]
+                );
     }
 
     if(node_i < result->width)
         result_nodes[node_i] = carry;
-    else
-        lpg_graph_release_node(graph,carry);
     ++node_i;
 
     for(; node_i < result->width; ++node_i)
-        result_nodes[node_i] = lpg_node_const(graph,false);
+        result_nodes[node_i] = lpg_node_literal(graph,false);
 }
 
 
@@ -688,8 +730,8 @@ static inline void __lpg_uint_add_right_wider(lpg_uint_t *a, lpg_uint_t *b, lpg_
  * Performs uint addition between @a and @b, storing the result
  * in @result nodes buffer.
  * 
- * The graph assembly for the addition algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * @a, @b, and @result must belong to the same graph.
  *
@@ -717,8 +759,8 @@ void lpg_uint_add(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_t *result)
  * Performs uint addition between @a and @b, storing the result
  * in @a nodes buffer.
  * 
- * The graph assembly for the addition algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * @a, @b must belong to the same graph.
  *
@@ -735,27 +777,31 @@ void lpg_uint_add_ip(lpg_uint_t *a, lpg_uint_t *b)
     lpg_node_t **a_nodes = lpg_uint_nodes(a);
     lpg_node_t **b_nodes = lpg_uint_nodes(b);
 
-    lpg_node_t *carry = lpg_node_const(graph,false);
+    lpg_node_t *carry = lpg_node_literal(graph,false);
     size_t upper_bound = MIN(a->width,b->width);
     size_t node_i = 0;
     for(; node_i < upper_bound; ++node_i)
     {
-        lpg_node_t *terms_part = lpg_node_xor(graph,a_nodes[node_i],b_nodes[node_i]);
-        lpg_node_t *terms_conj = lpg_node_and(graph,a_nodes[node_i],b_nodes[node_i]);
+        // Operands are saved, since @b might be a view of @a
+        lpg_node_t *saved_dest = a_nodes[node_i];
+        lpg_node_t *saved_src = b_nodes[node_i];
+        lpg_node_t *terms_part = lpg_node_xor(graph,saved_dest,saved_src);
         a_nodes[node_i] = lpg_node_xor(graph,terms_part,carry);
-        carry = lpg_node_or(graph,
-                    lpg_node_and(graph,terms_part,carry),
-                    terms_conj
-                );
+        // Carry out of the top bit of @a would be left unused, so it is never assembled
+        if(node_i+1 < a->width)
+            carry = lpg_node_or(graph,
+                        lpg_node_and(graph,terms_part,carry),
+                        lpg_node_and(graph,saved_dest,saved_src)
+                    );
     }
 
     for(; node_i < a->width; ++node_i)
     {
         lpg_node_t *saved_dest = a_nodes[node_i];
         a_nodes[node_i] = lpg_node_xor(graph,a_nodes[node_i],carry);
-        carry = lpg_node_and(graph,saved_dest,carry);
+        if(node_i+1 < a->width)
+            carry = lpg_node_and(graph,saved_dest,carry);
     }
-    lpg_graph_release_node(graph,carry);
 }
 
 
@@ -768,8 +814,8 @@ void lpg_uint_add_ip(lpg_uint_t *a, lpg_uint_t *b)
  * Performs uint subtraction between @a and @b, storing the result
  * in @result nodes buffer.
  * 
- * The graph assembly for the subtraction algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * @a, @b, and @result must belong to the same graph.
  *
@@ -788,23 +834,19 @@ void lpg_uint_sub(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_t *result)
     lpg_node_t **b_nodes = lpg_uint_nodes(b);
     lpg_node_t **result_nodes = lpg_uint_nodes(result);
 
-    lpg_node_t *carry = lpg_node_const(graph,false);
+    lpg_node_t *carry = lpg_node_literal(graph,false);
     size_t common_upper_bound = MIN(MIN(a->width,b->width),result->width);
     size_t node_i = 0;
     for(; node_i < common_upper_bound; ++node_i)
     {
         lpg_node_t *terms_part = lpg_node_xor(graph,a_nodes[node_i],b_nodes[node_i]);
         result_nodes[node_i] = lpg_node_xor(graph,terms_part,carry);
-        carry = lpg_node_or(graph,
-                    lpg_node_and(graph,
-                        lpg_node_not(graph,terms_part),
-                        carry
-                    ),
-                    lpg_node_and(graph,
-                        lpg_node_not(graph,a_nodes[node_i]),
-                        b_nodes[node_i]
-                    )
-                );
+        // Borrow out of the top bit of @result would be left unused, so it is never assembled
+        if(node_i+1 < result->width)
+            carry = lpg_node_or(graph,
+                        __lpg_uint_and_not(graph,carry,terms_part),
+                        __lpg_uint_and_not(graph,b_nodes[node_i],a_nodes[node_i])
+                    );
     }
 
     if(a->width < b->width)
@@ -813,7 +855,8 @@ void lpg_uint_sub(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_t *result)
         for(; node_i < upper_bound; ++node_i)
         {
             result_nodes[node_i] = lpg_node_xor(graph,b_nodes[node_i],carry);
-            carry = lpg_node_or(graph,b_nodes[node_i],carry);
+            if(node_i+1 < result->width)
+                carry = lpg_node_or(graph,b_nodes[node_i],carry);
         }
     }
     else
@@ -822,18 +865,13 @@ void lpg_uint_sub(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_t *result)
         for(; node_i < upper_bound; ++node_i)
         {
             result_nodes[node_i] = lpg_node_xor(graph,a_nodes[node_i],carry);
-            carry = lpg_node_and(graph,
-                        lpg_node_not(graph,a_nodes[node_i]),
-                        carry
-                    );
+            if(node_i+1 < result->width)
+                carry = __lpg_uint_and_not(graph,carry,a_nodes[node_i]);
         }
     }
 
-    if(node_i == result->width)
-        lpg_graph_release_node(graph,carry);
-    else
-        for(; node_i < result->width; ++node_i)
-            result_nodes[node_i] = carry;
+    for(; node_i < result->width; ++node_i)
+        result_nodes[node_i] = carry;
 }
 
 
@@ -845,8 +883,8 @@ void lpg_uint_sub(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_t *result)
  * Performs uint subtraction between @a and @b, storing the result
  * in @a nodes buffer.
  * 
- * The graph assembly for the subtraction algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * @a, @b must belong to the same graph.
  *
@@ -863,37 +901,31 @@ void lpg_uint_sub_ip(lpg_uint_t *a, lpg_uint_t *b)
     lpg_node_t **a_nodes = lpg_uint_nodes(a);
     lpg_node_t **b_nodes = lpg_uint_nodes(b);
 
-    lpg_node_t *carry = lpg_node_const(graph,false);
+    lpg_node_t *carry = lpg_node_literal(graph,false);
     size_t upper_bound = MIN(a->width,b->width);
     size_t node_i = 0;
     for(; node_i < upper_bound; ++node_i)
     {
-        lpg_node_t *terms_part = lpg_node_xor(graph,a_nodes[node_i],b_nodes[node_i]);
-        lpg_node_t *carry_conj_part = lpg_node_and(graph,
-                                        lpg_node_not(graph,a_nodes[node_i]),
-                                        b_nodes[node_i]
-                                    );
+        // Operands are saved, since @b might be a view of @a
+        lpg_node_t *saved_dest = a_nodes[node_i];
+        lpg_node_t *saved_src = b_nodes[node_i];
+        lpg_node_t *terms_part = lpg_node_xor(graph,saved_dest,saved_src);
         a_nodes[node_i] = lpg_node_xor(graph,terms_part,carry);
-        carry = lpg_node_or(graph,
-                    lpg_node_and(graph,
-                        lpg_node_not(graph,terms_part),
-                        carry
-                    ),
-                    carry_conj_part
-                );
+        // Borrow out of the top bit of @a would be left unused, so it is never assembled
+        if(node_i+1 < a->width)
+            carry = lpg_node_or(graph,
+                        __lpg_uint_and_not(graph,carry,terms_part),
+                        __lpg_uint_and_not(graph,saved_src,saved_dest)
+                    );
     }
     
     for(; node_i < a->width; ++node_i)
     {
         lpg_node_t *curr_dest_node = a_nodes[node_i];
         a_nodes[node_i] = lpg_node_xor(graph,a_nodes[node_i],carry);
-        carry = lpg_node_and(graph,
-                    lpg_node_not(graph,curr_dest_node),
-                    carry
-                );
+        if(node_i+1 < a->width)
+            carry = __lpg_uint_and_not(graph,carry,curr_dest_node);
     }
-
-    lpg_graph_release_node(graph,carry);
 }
 
 
@@ -906,8 +938,8 @@ void lpg_uint_sub_ip(lpg_uint_t *a, lpg_uint_t *b)
  * Performs uint bitwise and between @a and @b, storing the result
  * in @result nodes buffer.
  * 
- * The graph assembly for the bitwise and algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * @a, @b, and @result must belong to the same graph.
  *
@@ -932,7 +964,7 @@ void lpg_uint_and(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_t *result)
         result_nodes[node_i] = lpg_node_and(graph,a_nodes[node_i],b_nodes[node_i]);
     
     for(; node_i < result->width; ++node_i)
-        result_nodes[node_i] = lpg_node_const(graph,false);
+        result_nodes[node_i] = lpg_node_literal(graph,false);
 }
 
 
@@ -965,7 +997,7 @@ void lpg_uint_and_ip(lpg_uint_t *a, lpg_uint_t *b)
         a_nodes[node_i] = lpg_node_and(graph,a_nodes[node_i],b_nodes[node_i]);
     
     for(; node_i < a->width; ++node_i)
-        a_nodes[node_i] = lpg_node_const(graph,false);
+        a_nodes[node_i] = lpg_node_literal(graph,false);
 }
 
 
@@ -978,8 +1010,8 @@ void lpg_uint_and_ip(lpg_uint_t *a, lpg_uint_t *b)
  * Performs uint bitwise or between @a and @b, storing the result
  * in @result nodes buffer.
  * 
- * The graph assembly for the bitwise or algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * @a, @b, and @result must belong to the same graph.
  *
@@ -1020,7 +1052,7 @@ void lpg_uint_or(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_t *result)
         result_nodes[node_i] = max_term_nodes[node_i];
     
     for(; node_i < result->width; ++node_i)
-        result_nodes[node_i] = lpg_node_const(graph,false);
+        result_nodes[node_i] = lpg_node_literal(graph,false);
 }
 
 
@@ -1063,8 +1095,8 @@ void lpg_uint_or_ip(lpg_uint_t *a, lpg_uint_t *b)
  * Performs uint bitwise xor between @a and @b, storing the result
  * in @result nodes buffer.
  * 
- * The graph assembly for the bitwise xor algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * @a, @b, and @result must belong to the same graph.
  *
@@ -1105,7 +1137,7 @@ void lpg_uint_xor(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_t *result)
         result_nodes[node_i] = max_term_nodes[node_i];
     
     for(; node_i < result->width; ++node_i)
-        result_nodes[node_i] = lpg_node_const(graph,false);
+        result_nodes[node_i] = lpg_node_literal(graph,false);
 }
 
 
@@ -1170,13 +1202,13 @@ void lpg_uint_lshift(lpg_uint_t *a, size_t shift, lpg_uint_t *result)
     shift = MIN(shift,result->width);
     int64_t node_i = result->width-1;
     for(; node_i >= (int64_t)(a->width+shift); --node_i)
-        result_nodes[node_i] = lpg_node_const(graph,false);
+        result_nodes[node_i] = lpg_node_literal(graph,false);
 
     for(; node_i >= (int64_t)shift; --node_i)
         result_nodes[node_i] = a_nodes[node_i-shift];
     
     for(; node_i >= 0; --node_i)
-        result_nodes[node_i] = lpg_node_const(graph,false);
+        result_nodes[node_i] = lpg_node_literal(graph,false);
 }
 
 
@@ -1210,7 +1242,7 @@ void lpg_uint_lshift_ip(lpg_uint_t *a, size_t shift)
         a_nodes[node_i] = a_nodes[node_i-shift];
     
     for(; node_i >= 0; --node_i)
-        a_nodes[node_i] = lpg_node_const(graph,false);
+        a_nodes[node_i] = lpg_node_literal(graph,false);
 }
 
 
@@ -1246,7 +1278,7 @@ void lpg_uint_rshift(lpg_uint_t *a, size_t shift, lpg_uint_t *result)
         result_nodes[node_i] = a_nodes[node_i+shift];
     
     for(; node_i < result->width; ++node_i)
-        result_nodes[node_i] = lpg_node_const(graph,false);
+        result_nodes[node_i] = lpg_node_literal(graph,false);
 }
 
 
@@ -1265,7 +1297,7 @@ void lpg_uint_rshift_ip(lpg_uint_t *a, size_t shift)
         a_nodes[node_i] = a_nodes[node_i+shift];
     
     for(; node_i < a->width; ++node_i)
-        a_nodes[node_i] = lpg_node_const(graph,false);
+        a_nodes[node_i] = lpg_node_literal(graph,false);
 }
 
 
@@ -1278,8 +1310,8 @@ void lpg_uint_rshift_ip(lpg_uint_t *a, size_t shift)
  * Performs uint multiplication between @a and @b using regular school algorithm,
  * storing the result in @result nodes buffer.
  * 
- * The graph assembly for the multiplication algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * @a, @b, and @result must belong to the same graph.
  *
@@ -1291,7 +1323,7 @@ void __lpg_uint_mul_school(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_t *result)
 
     lpg_node_t **b_nodes = lpg_uint_nodes(b);
 
-    lpg_uint_update_from_hex_str(result,"0");
+    lpg_uint_update_fill_with_single(result,lpg_node_literal(graph,false));
 
     size_t upper_bound = MIN(result->width,b->width);
     lpg_uint_t *a_shifted = lpg_uint_allocate(graph,result->width);
@@ -1365,8 +1397,8 @@ static inline size_t __lpg_uint_add_ops_width(size_t a_width, size_t b_width)
  * Performs uint multiplication between @a and @b using karatsuba algorithm,
  * storing the result in @result nodes buffer.
  * 
- * The graph assembly for the multiplication algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * @a must be greater than or equal in width to @b.
  * 
@@ -1383,7 +1415,7 @@ void __lpg_uint_mul_karatsuba_left_wider(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_
     size_t b_tr_width = MIN(result->width,b->width);
     lpg_uint_t *b_tr = lpg_uint_allocate_as_uint_view(graph,b,0,b_tr_width);
 
-    lpg_uint_update_from_hex_str(result,"0");
+    lpg_uint_update_fill_with_single(result,lpg_node_literal(graph,false));
 
     /*
         'a' always has equal or higher width than 'b',
@@ -1483,8 +1515,8 @@ void __lpg_uint_mul_karatsuba_left_wider(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_
  * Performs uint multiplication between @a and @b using karatsuba algorithm,
  * storing the result in @result nodes buffer.
  * 
- * The graph assembly for the multiplication algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * @a, @b, and @result must belong to the same graph.
  *
@@ -1527,6 +1559,28 @@ inline bool __lpg_uint_is_mul_karatsuba(size_t a_width, size_t b_width, size_t r
 }
 
 
+/**
+ * __lpg_uint_significant_width - returns width of uint without upper false literals
+ * @value:      uint object
+ *
+ * Multiplication of zero-extended operands, which are common among Karatsuba's sums
+ * of halves, would otherwise assemble partial sums, which are then folded away by
+ * multiplication by zero and left dangling.
+ *
+ * Return: Number of lower bits of @value up to the highest one, which is not a false literal
+*/
+static inline size_t __lpg_uint_significant_width(const lpg_uint_t *value)
+{
+    lpg_node_t **nodes = lpg_uint_nodes(value);
+
+    size_t width = value->width;
+    while(width > 0 && __lpg_node_is_literal(value->graph,nodes[width-1],false))
+        --width;
+
+    return width;
+}
+
+
 /**
  * lpg_uint_mul - uint multiplication operation
  * @a:          left-side uint operand  
@@ -1536,13 +1590,16 @@ inline bool __lpg_uint_is_mul_karatsuba(size_t a_width, size_t b_width, size_t r
  * Performs uint multiplication between @a and @b, storing the result
  * in @result nodes buffer.
  * 
- * The graph assembly for the multiplication algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * This chooses multiplication algorithm according to '__lpg_uint_is_mul_karatsuba'
  * predicate. If predicate is 'true' then multiplication is performed using Karatsuba
  * algorithm and regular school algorithm otherwise.
  * 
+ * Upper bits of operands, which are false literals, are dropped before choosing the algorithm,
+ * see '__lpg_uint_significant_width'.
+ * 
  * @a, @b, and @result must belong to the same graph.
  *
  * Return: None
@@ -1554,10 +1611,26 @@ void lpg_uint_mul(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_t *result)
     affirm_nullptr(result,"result");
     __lpg_uint_validate_operand_graphs_binary(a,b);
 
-    if(__lpg_uint_is_mul_karatsuba(a->width,b->width,result->width))
-        __lpg_uint_mul_karatsuba(a,b,result);
+    lpg_graph_t *graph = a->graph;
+
+    size_t a_width = __lpg_uint_significant_width(a);
+    size_t b_width = __lpg_uint_significant_width(b);
+    if(a_width == 0 || b_width == 0)
+    {
+        lpg_uint_update_fill_with_single(result,lpg_node_literal(graph,false));
+        return;
+    }
+
+    lpg_uint_t *a_sig = lpg_uint_allocate_as_uint_view(graph,a,0,a_width);
+    lpg_uint_t *b_sig = lpg_uint_allocate_as_uint_view(graph,b,0,b_width);
+
+    if(__lpg_uint_is_mul_karatsuba(a_width,b_width,result->width))
+        __lpg_uint_mul_karatsuba(a_sig,b_sig,result);
     else
-        __lpg_uint_mul_school(a,b,result);
+        __lpg_uint_mul_school(a_sig,b_sig,result);
+
+    lpg_uint_release(a_sig);
+    lpg_uint_release(b_sig);
 }
 
 
@@ -1569,8 +1642,8 @@ void lpg_uint_mul(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_t *result)
  * Performs uint multiplication between @a and @b, storing the result
  * in @a nodes buffer.
  * 
- * The graph assembly for the multiplication algorithm may allocate constant nodes.
- * The caller is responsible to optimize them in any moment after operation.
+ * Constant bits are represented with literals of the graph, so gates over them
+ * are folded during assembly, see 'lpg_node_literal'.
  * 
  * @a, @b must belong to the same graph.
  *
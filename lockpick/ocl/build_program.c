@@ -0,0 +1,491 @@
+#include <lockpick/ocl/ocl.h>
+#include <lockpick/affirmf.h>
+#include <lockpick/define.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define __LP_OCL_INCLUDE_MAX_DEPTH 8
+
+
+/**
+ * __lp_ocl_read_source - reads whole OpenCL source file
+ * @source_path:    path to the source file
+ * @source_size:    resulting size of the source in bytes
+ *
+ * Return: Allocated null-terminated source string, which must be freed by the caller
+*/
+static char *__lp_ocl_read_source(const char *source_path, size_t *source_size)
+{
+    FILE *source_file = fopen(source_path,"rb");
+    affirmf(source_file,"Failed to open OpenCL source file '%s'",source_path);
+
+    affirmf(!fseek(source_file,0,SEEK_END),"Failed to seek OpenCL source file '%s'",source_path);
+    long file_size = ftell(source_file);
+    affirmf(file_size >= 0,"Failed to get size of OpenCL source file '%s'",source_path);
+    rewind(source_file);
+
+    char *source = (char*)malloc(file_size+1);
+    affirm_bad_malloc(source,"OpenCL source string",file_size+1);
+    affirmf(fread(source,1,file_size,source_file) == (size_t)file_size,
+        "Failed to read OpenCL source file '%s'",source_path);
+    source[file_size] = '\0';
+
+    fclose(source_file);
+
+    *source_size = file_size;
+    return source;
+}
+
+
+/**
+ * lp_ocl_context_device - fetches the first device of OpenCL context
+ * @context:    OpenCL context
+ *
+ * Return: Device associated with @context
+*/
+cl_device_id lp_ocl_context_device(cl_context context)
+{
+    cl_device_id device;
+    affirmf(clGetContextInfo(context,CL_CONTEXT_DEVICES,sizeof(cl_device_id),&device,NULL) == CL_SUCCESS,
+        "Failed to fetch device of OpenCL context");
+
+    return device;
+}
+
+
+/**
+ * __lp_ocl_build_program_check - builds OpenCL program and reports build log on failure
+ * @program:        program created from source or binary
+ * @device:         device to build program for
+ * @source_path:    path to the source file used in error messages
+ * @options:        build options passed to the OpenCL compiler
+ *
+ * Return: None
+*/
+static void __lp_ocl_build_program_check(cl_program program, cl_device_id device, const char *source_path, const char *options)
+{
+    if(clBuildProgram(program,1,&device,options,NULL,NULL) == CL_SUCCESS)
+        return;
+
+    size_t log_size;
+    affirmf(clGetProgramBuildInfo(program,device,CL_PROGRAM_BUILD_LOG,0,NULL,&log_size) == CL_SUCCESS,
+        "Failed to build program from source file '%s' and to fetch build log size",source_path);
+
+    char *log = (char*)malloc(log_size);
+    affirm_bad_malloc(log,"program build log",log_size);
+    affirmf(clGetProgramBuildInfo(program,device,CL_PROGRAM_BUILD_LOG,log_size,log,NULL) == CL_SUCCESS,
+        "Failed to build program from source file '%s' and to fetch build log",source_path);
+
+    errorf("Failed to build program from source file '%s':\n%s",source_path,log);
+}
+
+
+/**
+ * __lp_ocl_build_program_from_source - builds OpenCL program from already read source
+ * @context:        OpenCL context
+ * @device:         device to build program for
+ * @source:         source string
+ * @source_size:    size of @source in bytes
+ * @source_path:    path to the source file used in error messages
+ * @options:        build options passed to the OpenCL compiler
+ *
+ * Return: Built program
+*/
+static cl_program __lp_ocl_build_program_from_source(
+    cl_context context,
+    cl_device_id device,
+    const char *source,
+    size_t source_size,
+    const char *source_path,
+    const char *options)
+{
+    cl_int errcode;
+    cl_program program = clCreateProgramWithSource(context,1,&source,&source_size,&errcode);
+    affirmf(errcode == CL_SUCCESS,"Failed to create program from source file '%s'",source_path);
+
+    __lp_ocl_build_program_check(program,device,source_path,options);
+
+    return program;
+}
+
+
+/**
+ * lp_ocl_build_program - builds OpenCL program from source file
+ * @context:        OpenCL context
+ * @device:         device to build program for
+ * @source_path:    path to the source file
+ * @options:        build options passed to the OpenCL compiler
+ *
+ * On build failure the build log is included into the error message.
+ *
+ * Return: Built program
+*/
+cl_program lp_ocl_build_program(cl_context context, cl_device_id device, const char *source_path, const char *options)
+{
+    size_t source_size;
+    char *source = __lp_ocl_read_source(source_path,&source_size);
+
+    cl_program program = __lp_ocl_build_program_from_source(context,device,source,source_size,source_path,options);
+    free(source);
+
+    return program;
+}
+
+
+static uint64_t __lp_ocl_fnv1a_u64(uint64_t hash, const void *data, size_t size)
+{
+    const cl_uchar *bytes = (const cl_uchar*)data;
+    for(size_t byte_i = 0; byte_i < size; ++byte_i)
+    {
+        hash ^= bytes[byte_i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+
+/**
+ * __lp_ocl_resolve_include - resolves path of header included by OpenCL source
+ * @name:           name of the header as written in the include directive
+ * @source_dir:     directory of the including file, searched first for quoted includes, or NULL
+ * @options:        build options, '-I' directories of which are searched
+ * @path:           resulting path of the header
+ *
+ * Return: 'true' if readable header is found, 'false' otherwise
+*/
+static bool __lp_ocl_resolve_include(const char *name, const char *source_dir, const char *options, char *path)
+{
+    int path_len;
+    if(source_dir)
+    {
+        path_len = snprintf(path,PATH_MAX,"%s/%s",source_dir,name);
+        if(path_len >= 0 && path_len < PATH_MAX && !access(path,R_OK))
+            return true;
+    }
+
+    const char *option = options;
+    while((option = strstr(option,"-I")))
+    {
+        option += 2;
+        while(*option == ' ')
+            ++option;
+
+        size_t dir_len = strcspn(option," ");
+        path_len = snprintf(path,PATH_MAX,"%.*s/%s",(int)dir_len,option,name);
+        if(path_len >= 0 && path_len < PATH_MAX && !access(path,R_OK))
+            return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * __lp_ocl_hash_includes - hashes contents of headers included by OpenCL source
+ * @hash:           hash to continue
+ * @source:         source string
+ * @source_size:    size of @source in bytes
+ * @source_dir:     directory of @source or NULL if unknown
+ * @options:        build options, '-I' directories of which are searched
+ * @depth:          current depth of nested includes
+ *
+ * Included headers are hashed recursively, so a change of a layout shared by host and kernels
+ * invalidates cached binaries. Headers, which are not found, like host-only ones guarded by
+ * preprocessor conditions, contribute only their names.
+ *
+ * Return: Updated hash
+*/
+static uint64_t __lp_ocl_hash_includes(uint64_t hash, const char *source, size_t source_size, const char *source_dir, const char *options, uint32_t depth)
+{
+    const char *source_end = source+source_size;
+    for(const char *line = source; line < source_end; )
+    {
+        const char *line_end = memchr(line,'\n',source_end-line);
+        if(!line_end)
+            line_end = source_end;
+
+        const char *directive = line;
+        while(directive < line_end && (*directive == ' ' || *directive == '\t'))
+            ++directive;
+
+        if(directive < line_end && *directive == '#')
+        {
+            ++directive;
+            while(directive < line_end && (*directive == ' ' || *directive == '\t'))
+                ++directive;
+
+            if(line_end-directive > 7 && !strncmp(directive,"include",7))
+            {
+                const char *name_begin = directive+7;
+                while(name_begin < line_end && *name_begin != '<' && *name_begin != '"')
+                    ++name_begin;
+
+                const char *name_end = name_begin < line_end ? memchr(name_begin+1,*name_begin == '<' ? '>' : '"',line_end-name_begin-1) : NULL;
+                if(name_end && name_end-name_begin-1 < PATH_MAX)
+                {
+                    char name[PATH_MAX];
+                    memcpy(name,name_begin+1,name_end-name_begin-1);
+                    name[name_end-name_begin-1] = '\0';
+                    hash = __lp_ocl_fnv1a_u64(hash,name,strlen(name)+1);
+
+                    char path[PATH_MAX];
+                    const char *include_dir = *name_begin == '"' ? source_dir : NULL;
+                    if(depth < __LP_OCL_INCLUDE_MAX_DEPTH && __lp_ocl_resolve_include(name,include_dir,options,path))
+                    {
+                        size_t header_size;
+                        char *header = __lp_ocl_read_source(path,&header_size);
+                        hash = __lp_ocl_fnv1a_u64(hash,header,header_size);
+
+                        char *header_dir = strrchr(path,'/');
+                        *header_dir = '\0';
+                        hash = __lp_ocl_hash_includes(hash,header,header_size,path,options,depth+1);
+                        free(header);
+                    }
+                }
+            }
+        }
+
+        line = line_end+1;
+    }
+
+    return hash;
+}
+
+
+/**
+ * __lp_ocl_program_cache_dir - prepares directory of cached program binaries
+ * @cache_dir:      resulting path of the directory
+ *
+ * Directory is set by LP_OCL_CACHE_DIR_ENV_NAME environment variable, otherwise LP_OCL_CACHE_SUBDIR_NAME
+ * is used under $XDG_CACHE_HOME or '~/.cache'. Since cached binaries are loaded as is, the directory
+ * is used only if it is owned by the current user and is not writable by anyone else.
+ *
+ * Return: 'true' if cache directory is available, 'false' otherwise
+*/
+static bool __lp_ocl_program_cache_dir(char *cache_dir)
+{
+    int cache_dir_len;
+    const char *env_cache_dir = getenv(LP_OCL_CACHE_DIR_ENV_NAME);
+    if(env_cache_dir)
+        cache_dir_len = snprintf(cache_dir,PATH_MAX,"%s",env_cache_dir);
+    else
+    {
+        char base_dir[PATH_MAX];
+        const char *xdg_cache_home = getenv("XDG_CACHE_HOME");
+        const char *home = getenv("HOME");
+        int base_dir_len;
+        if(xdg_cache_home && *xdg_cache_home)
+            base_dir_len = snprintf(base_dir,PATH_MAX,"%s",xdg_cache_home);
+        else if(home && *home)
+            base_dir_len = snprintf(base_dir,PATH_MAX,"%s/.cache",home);
+        else
+            return false;
+
+        if(base_dir_len < 0 || base_dir_len >= PATH_MAX || (mkdir(base_dir,0700) && errno != EEXIST))
+            return false;
+
+        cache_dir_len = snprintf(cache_dir,PATH_MAX,"%s/%s",base_dir,LP_OCL_CACHE_SUBDIR_NAME);
+    }
+
+    if(cache_dir_len < 0 || cache_dir_len >= PATH_MAX || (mkdir(cache_dir,0700) && errno != EEXIST))
+        return false;
+
+    // Directory planted by another user could contain arbitrary binaries
+    struct stat cache_dir_stat;
+    return !lstat(cache_dir,&cache_dir_stat) && S_ISDIR(cache_dir_stat.st_mode) &&
+           cache_dir_stat.st_uid == getuid() && !(cache_dir_stat.st_mode & (S_IWGRP|S_IWOTH));
+}
+
+
+/**
+ * __lp_ocl_program_cache_path - composes path of cached program binary
+ * @device:         device program is built for
+ * @source:         source string
+ * @source_size:    size of @source in bytes
+ * @source_path:    path to the source file
+ * @options:        build options
+ * @cache_path:     resulting path
+ *
+ * Cache key is composed of device UUID and of hash of the source, headers it includes, build options
+ * and driver version, so binaries are rebuilt after changes of any of them.
+ *
+ * Return: 'true' if cache directory is available and path fits into PATH_MAX, 'false' otherwise
+*/
+static bool __lp_ocl_program_cache_path(cl_device_id device, const char *source, size_t source_size, const char *source_path, const char *options, char *cache_path)
+{
+    char cache_dir[PATH_MAX];
+    if(!__lp_ocl_program_cache_dir(cache_dir))
+        return false;
+
+    cl_uchar device_uuid[CL_UUID_SIZE_KHR];
+    affirmf(clGetDeviceInfo(device,CL_DEVICE_UUID_KHR,CL_UUID_SIZE_KHR,device_uuid,NULL) == CL_SUCCESS,
+        "Failed to fetch device uuid");
+
+    char device_uuid_hex[CL_UUID_SIZE_KHR*(LP_BITS_PER_BYTE/LP_BITS_PER_HEX)+1];
+    __lp_ocl_device_uuid_to_hex_str(device_uuid,device_uuid_hex,sizeof(device_uuid_hex));
+
+    char driver_version[256];
+    affirmf(clGetDeviceInfo(device,CL_DRIVER_VERSION,sizeof(driver_version),driver_version,NULL) == CL_SUCCESS,
+        "Failed to fetch driver version");
+    driver_version[sizeof(driver_version)-1] = '\0';
+
+    char source_dir[PATH_MAX];
+    const char *source_dir_end = strrchr(source_path,'/');
+    int source_dir_len = source_dir_end ? snprintf(source_dir,PATH_MAX,"%.*s",(int)(source_dir_end-source_path),source_path)
+                                        : snprintf(source_dir,PATH_MAX,".");
+    if(source_dir_len < 0 || source_dir_len >= PATH_MAX)
+        return false;
+
+    // FNV-1a offset basis
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = __lp_ocl_fnv1a_u64(hash,source,source_size);
+    hash = __lp_ocl_hash_includes(hash,source,source_size,source_dir,options,0);
+    hash = __lp_ocl_fnv1a_u64(hash,options,strlen(options)+1);
+    hash = __lp_ocl_fnv1a_u64(hash,driver_version,strlen(driver_version));
+
+    int cache_path_len = snprintf(cache_path,PATH_MAX,"%s/%s_%016" PRIx64 ".bin",cache_dir,device_uuid_hex,hash);
+
+    // Truncated path would refer to a wrong file, caching is skipped instead
+    return cache_path_len >= 0 && cache_path_len < PATH_MAX;
+}
+
+
+/**
+ * __lp_ocl_load_program_binary - creates and builds OpenCL program from cached binary
+ * @context:        OpenCL context
+ * @device:         device to build program for
+ * @cache_path:     path to the cached binary
+ * @options:        build options passed to the OpenCL compiler
+ *
+ * Return: Built program or NULL if binary is missing or rejected by the driver
+*/
+static cl_program __lp_ocl_load_program_binary(cl_context context, cl_device_id device, const char *cache_path, const char *options)
+{
+    FILE *binary_file = fopen(cache_path,"rb");
+    if(!binary_file)
+        return NULL;
+
+    cl_program program = NULL;
+    if(fseek(binary_file,0,SEEK_END))
+        goto close_file;
+
+    long binary_size = ftell(binary_file);
+    if(binary_size <= 0)
+        goto close_file;
+    rewind(binary_file);
+
+    cl_uchar *binary = (cl_uchar*)malloc(binary_size);
+    affirm_bad_malloc(binary,"OpenCL program binary",binary_size);
+
+    if(fread(binary,1,binary_size,binary_file) == (size_t)binary_size)
+    {
+        size_t binary_size_arg = binary_size;
+        const cl_uchar *binary_arg = binary;
+        cl_int binary_status,errcode;
+        program = clCreateProgramWithBinary(context,1,&device,&binary_size_arg,&binary_arg,&binary_status,&errcode);
+
+        if(errcode != CL_SUCCESS || binary_status != CL_SUCCESS)
+        {
+            if(errcode == CL_SUCCESS)
+                clReleaseProgram(program);
+            program = NULL;
+        }
+        else if(clBuildProgram(program,1,&device,options,NULL,NULL) != CL_SUCCESS)
+        {
+            clReleaseProgram(program);
+            program = NULL;
+        }
+    }
+
+    free(binary);
+
+    close_file:
+    fclose(binary_file);
+
+    return program;
+}
+
+
+/**
+ * __lp_ocl_store_program_binary - writes binary of built OpenCL program into cache
+ * @program:        program built for a single device
+ * @cache_path:     path to write the binary to
+ *
+ * Binary is written into a temporary file, which is then renamed, so concurrent processes never
+ * observe partially written binaries. Failures are ignored, since cache is optional.
+ *
+ * Return: None
+*/
+static void __lp_ocl_store_program_binary(cl_program program, const char *cache_path)
+{
+    size_t binary_size;
+    if(clGetProgramInfo(program,CL_PROGRAM_BINARY_SIZES,sizeof(size_t),&binary_size,NULL) != CL_SUCCESS || binary_size == 0)
+        return;
+
+    cl_uchar *binary = (cl_uchar*)malloc(binary_size);
+    affirm_bad_malloc(binary,"OpenCL program binary",binary_size);
+
+    if(clGetProgramInfo(program,CL_PROGRAM_BINARIES,sizeof(cl_uchar*),&binary,NULL) == CL_SUCCESS)
+    {
+        char tmp_path[PATH_MAX];
+        int tmp_path_len = snprintf(tmp_path,PATH_MAX,"%s.%d.tmp",cache_path,(int)getpid());
+
+        FILE *binary_file = tmp_path_len >= 0 && tmp_path_len < PATH_MAX ? fopen(tmp_path,"wb") : NULL;
+        if(binary_file)
+        {
+            bool written = fwrite(binary,1,binary_size,binary_file) == binary_size;
+            written = !fclose(binary_file) && written;
+            if(!written || rename(tmp_path,cache_path))
+                unlink(tmp_path);
+        }
+    }
+
+    free(binary);
+}
+
+
+/**
+ * lp_ocl_build_program_cached - builds OpenCL program from source file reusing cached binaries
+ * @context:        OpenCL context
+ * @device:         device to build program for
+ * @source_path:    path to the source file
+ * @options:        build options passed to the OpenCL compiler
+ *
+ * Same as 'lp_ocl_build_program', but binaries of built programs are stored in cache directory, see
+ * '__lp_ocl_program_cache_dir', and are loaded instead of compiling the source on subsequent calls.
+ * Binaries rejected by the driver are rebuilt from source.
+ *
+ * Return: Built program
+*/
+cl_program lp_ocl_build_program_cached(cl_context context, cl_device_id device, const char *source_path, const char *options)
+{
+    size_t source_size;
+    char *source = __lp_ocl_read_source(source_path,&source_size);
+
+    char cache_path[PATH_MAX];
+    bool cache_available = __lp_ocl_program_cache_path(device,source,source_size,source_path,options,cache_path);
+
+    cl_program program = NULL;
+    if(cache_available)
+        program = __lp_ocl_load_program_binary(context,device,cache_path,options);
+
+    if(!program)
+    {
+        program = __lp_ocl_build_program_from_source(context,device,source,source_size,source_path,options);
+        if(cache_available)
+            __lp_ocl_store_program_binary(program,cache_path);
+    }
+
+    free(source);
+
+    return program;
+}
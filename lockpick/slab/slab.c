@@ -346,4 +346,37 @@ void lp_slab_exec(lp_slab_t *slab, void (*callback)(void *entry_ptr, void *args)
         for(; curr_entry != end_slab; curr_entry += entry_size)
             callback(curr_entry,args);
     }
-}
\ No newline at end of file
+}
+
+
+/**
+ * lp_slab_capacity - returns maximum number of entries slab can hold
+ * @slab:       slab instance
+ * 
+ * Returns total number of entries, i.e. the upper bound of values returned by 'lp_slab_index'.
+*/
+size_t lp_slab_capacity(const lp_slab_t *slab)
+{
+    affirmf(slab,"Expected valid slab pointer but null was given");
+
+    return slab->__total_entries;
+}
+
+
+/**
+ * lp_slab_index - returns position of entry within slab buffer
+ * @slab:           slab instance
+ * @entry_ptr:      pointer on entry allocated within @slab
+ * 
+ * Positions are dense and stable for the whole lifetime of the entry, so they can be
+ * used to address flat arrays of 'lp_slab_capacity' size instead of hashing entry pointers.
+ * 
+ * Returns index of entry within [0, lp_slab_capacity).
+*/
+size_t lp_slab_index(const lp_slab_t *slab, const void *entry_ptr)
+{
+    size_t index = ((const char*)entry_ptr - (const char*)slab->__buffer)/slab->__entry_size;
+    affirmf_debug(index < slab->__total_entries,"Entry %p does not belong to slab %p",entry_ptr,(const void*)slab);
+
+    return index;
+}
@@ -0,0 +1,148 @@
+#include <lockpick/test.h>
+#include <lockpick/graph/frozen.h>
+#include <lockpick/graph/count.h>
+#include <lockpick/graph/traverse.h>
+#include <lockpick/graph/tsort.h>
+#include <lockpick/graph/types/uint.h>
+#include <stdlib.h>
+
+#define __LPG_TEST_FROZEN_MAX_GRAPH_NODES 100000
+#define __LPG_TEST_FROZEN_NOT_SORTED SIZE_MAX
+
+
+typedef struct __test_graph_frozen_order
+{
+    size_t *positions;
+    size_t nodes_num;
+} __test_graph_frozen_order_t;
+
+
+static void __test_graph_frozen_leave_cb(const lpg_frozen_graph_t *frozen, lpg_frozen_index_t slot, bool is_input, void *args)
+{
+    __test_graph_frozen_order_t *order = args;
+    order->positions[slot] = order->nodes_num++;
+}
+
+
+/*
+    Checks that every node of @positions, which is not an input, follows all its parents.
+*/
+static bool __test_graph_frozen_is_sorted(const lpg_frozen_graph_t *frozen, const size_t *positions)
+{
+    for(size_t slot = 0; slot < frozen->slots_num; ++slot)
+    {
+        if(positions[slot] == __LPG_TEST_FROZEN_NOT_SORTED || lp_bitset_test(frozen->is_input,slot))
+            continue;
+
+        for(lpg_frozen_index_t parent_i = frozen->parents_offsets[slot]; parent_i < frozen->parents_offsets[slot+1]; ++parent_i)
+        {
+            size_t parent_position = positions[frozen->parents[parent_i]];
+            if(parent_position == __LPG_TEST_FROZEN_NOT_SORTED || parent_position >= positions[slot])
+                return false;
+        }
+    }
+
+    return true;
+}
+
+
+/*
+    Builds product of two inputs along with unused conjunction of them, which leaves 'width' dangling nodes,
+    and checks that the frozen form mirrors the graph and yields the same results as the graph itself.
+*/
+void __test_graph_frozen(size_t width)
+{
+    lpg_graph_t *graph = lpg_graph_create("test",2*width,2*width,__LPG_TEST_FROZEN_MAX_GRAPH_NODES);
+    lpg_uint_t *graph_a = lpg_uint_allocate_as_buffer_view(graph,graph->inputs,width);
+    lpg_uint_t *graph_b = lpg_uint_allocate_as_buffer_view(graph,graph->inputs+width,width);
+    lpg_uint_t *graph_dangling = lpg_uint_allocate(graph,width);
+    lpg_uint_t *graph_res = lpg_uint_allocate_as_buffer_view(graph,graph->outputs,2*width);
+    lpg_uint_and(graph_a,graph_b,graph_dangling);
+    lpg_uint_mul(graph_a,graph_b,graph_res);
+
+    lpg_frozen_graph_t *frozen = lpg_graph_freeze(graph);
+    size_t *positions = (size_t*)malloc(frozen->slots_num*sizeof(size_t));
+    lpg_frozen_index_t *sorted_slots = NULL;
+
+    lp_slab_t *slab = __lpg_graph_slab(graph);
+    size_t frozen_nodes_num = 0;
+    for(size_t slot = 0; slot < frozen->slots_num; ++slot)
+    {
+        if(frozen->types[slot] == LPG_FROZEN_SLOT_FREE)
+            continue;
+        ++frozen_nodes_num;
+
+        lpg_node_t *node = lpg_frozen_graph_node(frozen,slot);
+        LP_TEST_ASSERT(frozen->types[slot] == node->type,"width: %zd; Type of slot %zd differs from its node",width,slot);
+        LP_TEST_ASSERT(lpg_frozen_graph_slot(frozen,node) == slot,"width: %zd; Node of slot %zd is mapped back to another slot",width,slot);
+
+        size_t parents_num = lpg_frozen_graph_get_parents_num(frozen,slot);
+        LP_TEST_ASSERT(parents_num == lpg_node_get_parents_num(node),"width: %zd; Slot %zd has %zd parents instead of %zd",
+            width,slot,parents_num,lpg_node_get_parents_num(node));
+        for(size_t parent_i = 0; parent_i < parents_num; ++parent_i)
+            LP_TEST_ASSERT(frozen->parents[frozen->parents_offsets[slot]+parent_i] == lp_slab_index(slab,lpg_node_parents(node)[parent_i]),
+                "width: %zd; Parent %zd of slot %zd differs from its node",width,parent_i,slot);
+
+        size_t children_num = lpg_frozen_graph_get_children_num(frozen,slot);
+        LP_TEST_ASSERT(children_num == lpg_node_get_children_num(node),"width: %zd; Slot %zd has %zd children instead of %zd",
+            width,slot,children_num,lpg_node_get_children_num(node));
+        for(size_t child_i = 0; child_i < children_num; ++child_i)
+            LP_TEST_ASSERT(frozen->children[frozen->children_offsets[slot]+child_i] == lp_slab_index(slab,lp_vector_at_type(node->children,child_i,lpg_node_t*)),
+                "width: %zd; Child %zd of slot %zd differs from its node",width,child_i,slot);
+    }
+
+    size_t nodes_num = lpg_graph_nodes_count_super(graph);
+    LP_TEST_ASSERT(frozen_nodes_num == nodes_num,"width: %zd; Frozen graph has %zd nodes, expected: %zd",width,frozen_nodes_num,nodes_num);
+
+    size_t reachable_num = lpg_graph_nodes_count(graph);
+    size_t frozen_reachable_num = lpg_frozen_graph_nodes_count(frozen);
+    LP_TEST_ASSERT(frozen_reachable_num == reachable_num,"width: %zd; Counted %zd nodes, expected: %zd",width,frozen_reachable_num,reachable_num);
+
+    size_t dangling_num = lpg_graph_count_dangling_nodes(graph);
+    size_t frozen_dangling_num = lpg_frozen_graph_count_dangling_nodes(frozen);
+    LP_TEST_ASSERT(dangling_num == width && frozen_dangling_num == dangling_num,
+        "width: %zd; Counted %zd dangling nodes, expected: %zd",width,frozen_dangling_num,dangling_num);
+
+    for(size_t slot = 0; slot < frozen->slots_num; ++slot)
+        positions[slot] = __LPG_TEST_FROZEN_NOT_SORTED;
+    __test_graph_frozen_order_t order = {positions,0};
+    lpg_frozen_graph_traverse(frozen,NULL,NULL,__test_graph_frozen_leave_cb,&order);
+    LP_TEST_ASSERT(order.nodes_num == reachable_num,"width: %zd; Traversal left %zd nodes, expected: %zd",width,order.nodes_num,reachable_num);
+    LP_TEST_ASSERT(__test_graph_frozen_is_sorted(frozen,positions),"width: %zd; Traversal left nodes out of topological order",width);
+
+    size_t sorted_num;
+    lpg_frozen_graph_tsort(frozen,&sorted_slots,&sorted_num);
+    size_t expected_sorted_num = reachable_num+lpg_graph_count_redundant_inputs(graph);
+    LP_TEST_ASSERT(sorted_num == expected_sorted_num,"width: %zd; Sorted %zd nodes, expected: %zd",width,sorted_num,expected_sorted_num);
+
+    for(size_t slot = 0; slot < frozen->slots_num; ++slot)
+        positions[slot] = __LPG_TEST_FROZEN_NOT_SORTED;
+    for(size_t sorted_i = 0; sorted_i < sorted_num; ++sorted_i)
+    {
+        lpg_frozen_index_t slot = sorted_slots[sorted_i];
+        LP_TEST_ASSERT(positions[slot] == __LPG_TEST_FROZEN_NOT_SORTED,"width: %zd; Slot %u is sorted twice",width,slot);
+        LP_TEST_ASSERT(sorted_i >= frozen->inputs_size || slot == frozen->inputs[sorted_i],
+            "width: %zd; Sorted slots do not start with inputs",width);
+        positions[slot] = sorted_i;
+    }
+    LP_TEST_ASSERT(__test_graph_frozen_is_sorted(frozen,positions),"width: %zd; Slots are not sorted topologically",width);
+
+    lp_test_cleanup:
+    free(sorted_slots);
+    free(positions);
+    lpg_frozen_graph_release(frozen);
+    lpg_graph_release(graph);
+    lpg_uint_release(graph_a);
+    lpg_uint_release(graph_b);
+    lpg_uint_release(graph_dangling);
+    lpg_uint_release(graph_res);
+}
+
+
+void lp_test_graph_frozen()
+{
+    for(size_t width = 1; width <= 16; ++width)
+        LP_TEST_STEP_INTO(__test_graph_frozen(width));
+
+    lp_test_cleanup:
+}
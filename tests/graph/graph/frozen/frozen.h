@@ -0,0 +1,6 @@
+#ifndef _LOCKPICK_TESTS_GRAPH_GRAPH_FROZEN_H
+#define _LOCKPICK_TESTS_GRAPH_GRAPH_FROZEN_H
+
+void lp_test_graph_frozen();
+
+#endif  // _LOCKPICK_TESTS_GRAPH_GRAPH_FROZEN_H
@@ -0,0 +1,238 @@
+#include <lockpick/test.h>
+#include <lockpick/graph/optimize.h>
+#include <lockpick/graph/compute.h>
+#include <lockpick/graph/count.h>
+#include <lockpick/graph/types/uint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define __LPG_TEST_OPTIMIZE_MAX_GRAPH_NODES 100000
+#define __LPG_TEST_OPTIMIZE_SAMPLES_NUM 16
+
+
+static uint64_t __test_graph_optimize_eval(lpg_graph_t *graph, uint64_t input_values)
+{
+    for(size_t in_i = 0; in_i < graph->inputs_size; ++in_i)
+        __lpg_node_set_value(graph->inputs[in_i],(input_values >> in_i) & 1);
+
+    lpg_graph_compute(graph);
+
+    uint64_t output_values = 0;
+    for(size_t out_i = 0; out_i < graph->outputs_size; ++out_i)
+        output_values |= (uint64_t)lpg_node_value(graph->outputs[out_i]) << out_i;
+
+    return output_values;
+}
+
+
+static size_t __test_graph_optimize_nodes_num(lpg_graph_t *graph)
+{
+    lp_slab_t *slab = __lpg_graph_slab(graph);
+    return slab->__total_entries-slab->__total_free;
+}
+
+
+/*
+    For every bit 'i' of inputs 'x' and 'y' builds the following gates:
+
+        dangling = x & y
+        d1 = x ^ y, d2 = y ^ x
+        outputs[i] = d1 | (x & 0)
+        outputs[width+i] = d2 & ~(~y & 1)
+
+    where constants are placeholders created with 'lpg_node_const', so none of the gates is folded during assembly.
+    Every pass removes a known number of nodes per bit: the sweep removes the dangling gate, freezing replaces both
+    placeholders with literals, constant propagation removes both conjunctions with them and the disjunction, double
+    negation removal leaves '~(~y)' as 'y' and dedup merges 'd2' into 'd1'.
+*/
+void __test_graph_optimize_passes(size_t width, bool strash)
+{
+    lpg_graph_t *graph = lpg_graph_create("test",2*width,2*width,__LPG_TEST_OPTIMIZE_MAX_GRAPH_NODES);
+
+    for(size_t bit_i = 0; bit_i < width; ++bit_i)
+    {
+        lpg_node_t *x = graph->inputs[bit_i];
+        lpg_node_t *y = graph->inputs[width+bit_i];
+
+        lpg_node_and(graph,x,y);
+        lpg_node_t *d1 = lpg_node_xor(graph,x,y);
+        lpg_node_t *d2 = lpg_node_xor(graph,y,x);
+        lpg_node_t *masked = lpg_node_and(graph,x,lpg_node_const(graph,false));
+        lpg_node_t *negated = lpg_node_not(graph,lpg_node_and(graph,lpg_node_not(graph,y),lpg_node_const(graph,true)));
+
+        graph->outputs[bit_i] = lpg_node_or(graph,d1,masked);
+        graph->outputs[width+bit_i] = lpg_node_and(graph,d2,negated);
+    }
+
+    if(strash)
+        lpg_graph_enable_strash(graph);
+
+    uint64_t samples[__LPG_TEST_OPTIMIZE_SAMPLES_NUM];
+    uint64_t expected[__LPG_TEST_OPTIMIZE_SAMPLES_NUM];
+    for(size_t sample_i = 0; sample_i < __LPG_TEST_OPTIMIZE_SAMPLES_NUM; ++sample_i)
+    {
+        samples[sample_i] = (((uint64_t)rand() << 32) ^ rand()) & ((1ULL << 2*width)-1);
+        expected[sample_i] = __test_graph_optimize_eval(graph,samples[sample_i]);
+    }
+
+    const lpg_graph_pass_t passes[] = {
+        LPG_GRAPH_PASS_SWEEP,
+        LPG_GRAPH_PASS_FREEZE_CONSTANTS,
+        LPG_GRAPH_PASS_CONST_PROP,
+        LPG_GRAPH_PASS_DOUBLE_NEGATION,
+        LPG_GRAPH_PASS_DEDUP
+    };
+    size_t removed[LPG_GRAPH_PASSES_NUM];
+    size_t total_removed = lpg_graph_optimize(graph,passes,sizeof(passes)/sizeof(passes[0]),removed);
+
+    LP_TEST_ASSERT(removed[LPG_GRAPH_PASS_SWEEP] == width,
+        "width: %zd; Sweep removed %zd nodes, expected: %zd",width,removed[LPG_GRAPH_PASS_SWEEP],width);
+    LP_TEST_ASSERT(removed[LPG_GRAPH_PASS_FREEZE_CONSTANTS] == 2*width,
+        "width: %zd; Freezing removed %zd nodes, expected: %zd",width,removed[LPG_GRAPH_PASS_FREEZE_CONSTANTS],2*width);
+    LP_TEST_ASSERT(removed[LPG_GRAPH_PASS_CONST_PROP] == 3*width,
+        "width: %zd; Constant propagation removed %zd nodes, expected: %zd",width,removed[LPG_GRAPH_PASS_CONST_PROP],3*width);
+    LP_TEST_ASSERT(removed[LPG_GRAPH_PASS_DOUBLE_NEGATION] == 2*width,
+        "width: %zd; Double negation removal removed %zd nodes, expected: %zd",width,removed[LPG_GRAPH_PASS_DOUBLE_NEGATION],2*width);
+    LP_TEST_ASSERT(removed[LPG_GRAPH_PASS_DEDUP] == width,
+        "width: %zd; Dedup removed %zd nodes, expected: %zd",width,removed[LPG_GRAPH_PASS_DEDUP],width);
+    LP_TEST_ASSERT(total_removed == 9*width,"width: %zd; Removed %zd nodes in total, expected: %zd",width,total_removed,9*width);
+
+    // Inputs, both literals and two gates per bit
+    size_t nodes_num = __test_graph_optimize_nodes_num(graph);
+    LP_TEST_ASSERT(nodes_num == 4*width+2,"width: %zd; Expected %zd nodes, got: %zd",width,4*width+2,nodes_num);
+
+    size_t dangling_num = lpg_graph_count_dangling_nodes(graph);
+    LP_TEST_ASSERT(dangling_num == 0,"width: %zd; Optimized graph has %zd dangling nodes",width,dangling_num);
+
+    for(size_t sample_i = 0; sample_i < __LPG_TEST_OPTIMIZE_SAMPLES_NUM; ++sample_i)
+    {
+        uint64_t actual = __test_graph_optimize_eval(graph,samples[sample_i]);
+        LP_TEST_ASSERT(actual == expected[sample_i],"width: %zd; For inputs 0x%lx expected outputs 0x%lx, got: 0x%lx",
+            width,samples[sample_i],expected[sample_i],actual);
+    }
+
+    if(strash)
+    {
+        // Rewired nodes must be rehashed under their new operands
+        for(size_t bit_i = 0; bit_i < width; ++bit_i)
+        {
+            lpg_node_t *x = graph->inputs[bit_i];
+            lpg_node_t *y = graph->inputs[width+bit_i];
+            lpg_node_t *d = lpg_node_xor(graph,y,x);
+            LP_TEST_ASSERT(d == graph->outputs[bit_i],"width: %zd; Bit %zd of 'x^y' is not shared",width,bit_i);
+            LP_TEST_ASSERT(lpg_node_and(graph,y,d) == graph->outputs[width+bit_i],"width: %zd; Bit %zd of '(x^y)&y' is not shared",width,bit_i);
+        }
+    }
+
+    total_removed = lpg_graph_optimize(graph,NULL,0,NULL);
+    LP_TEST_ASSERT(total_removed == 0,"width: %zd; Optimized graph lost %zd more nodes",width,total_removed);
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+}
+
+
+/*
+    Builds 'a*b+c', where 'c' is a random constant assigned with 'lpg_uint_update_from_hex_str', so the adder is
+    assembled over placeholders. The default pipeline must keep them, so 'c' is reassigned after it, and only
+    freezing them lets constant propagation simplify the adder.
+*/
+void __test_graph_optimize_mul_add(size_t width)
+{
+    lpg_graph_t *graph = lpg_graph_create("test",2*width,2*width,__LPG_TEST_OPTIMIZE_MAX_GRAPH_NODES);
+    lpg_uint_t *graph_a = lpg_uint_allocate_as_buffer_view(graph,graph->inputs,width);
+    lpg_uint_t *graph_b = lpg_uint_allocate_as_buffer_view(graph,graph->inputs+width,width);
+    lpg_uint_t *graph_prod = lpg_uint_allocate(graph,2*width);
+    lpg_uint_t *graph_c = lpg_uint_allocate(graph,2*width);
+    lpg_uint_t *graph_res = lpg_uint_allocate_as_buffer_view(graph,graph->outputs,2*width);
+
+    uint64_t mask = (1ULL << width)-1;
+    uint64_t res_mask = (1ULL << 2*width)-1;
+    uint64_t c = (((uint64_t)rand() << 32) ^ rand()) & res_mask;
+    char c_hex[32];
+    snprintf(c_hex,sizeof(c_hex),"%lx",c);
+
+    lpg_uint_mul(graph_a,graph_b,graph_prod);
+    lpg_uint_update_from_hex_str(graph_c,c_hex);
+    lpg_uint_add(graph_prod,graph_c,graph_res);
+
+    size_t nodes_num_before = __test_graph_optimize_nodes_num(graph);
+    size_t removed[LPG_GRAPH_PASSES_NUM];
+    size_t total_removed = lpg_graph_optimize(graph,NULL,0,removed);
+    size_t nodes_num_after = __test_graph_optimize_nodes_num(graph);
+
+    size_t removed_sum = 0;
+    for(uint32_t pass = 0; pass < LPG_GRAPH_PASSES_NUM; ++pass)
+        removed_sum += removed[pass];
+
+    LP_TEST_ASSERT(removed_sum == total_removed,"width: %zd; Passes removed %zd nodes, but %zd were reported",width,removed_sum,total_removed);
+    LP_TEST_ASSERT(removed[LPG_GRAPH_PASS_FREEZE_CONSTANTS] == 0,"width: %zd; Default pipeline froze constants",width);
+    LP_TEST_ASSERT(nodes_num_after <= nodes_num_before,
+        "width: %zd; Graph grew from %zd to %zd nodes",width,nodes_num_before,nodes_num_after);
+
+    // Placeholders are kept, so the constant can still be changed
+    c = (((uint64_t)rand() << 32) ^ rand()) & res_mask;
+    snprintf(c_hex,sizeof(c_hex),"%lx",c);
+    lpg_uint_assign_from_hex_str(graph_c,c_hex);
+
+    for(size_t sample_i = 0; sample_i < __LPG_TEST_OPTIMIZE_SAMPLES_NUM; ++sample_i)
+    {
+        uint64_t a = rand() & mask;
+        uint64_t b = rand() & mask;
+        uint64_t expected = (a*b+c) & res_mask;
+        uint64_t actual = __test_graph_optimize_eval(graph,a | (b << width));
+        LP_TEST_ASSERT(actual == expected,"width: %zd; Before freezing expected %lu*%lu+%lu = %lu, got: %lu",width,a,b,c,expected,actual);
+    }
+
+    const lpg_graph_pass_t passes[] = {
+        LPG_GRAPH_PASS_FREEZE_CONSTANTS,
+        LPG_GRAPH_PASS_CONST_PROP,
+        LPG_GRAPH_PASS_DOUBLE_NEGATION,
+        LPG_GRAPH_PASS_DEDUP
+    };
+    nodes_num_before = nodes_num_after;
+    total_removed = lpg_graph_optimize(graph,passes,sizeof(passes)/sizeof(passes[0]),removed);
+    nodes_num_after = __test_graph_optimize_nodes_num(graph);
+
+    LP_TEST_ASSERT(removed[LPG_GRAPH_PASS_FREEZE_CONSTANTS] == 2*width,
+        "width: %zd; Freezing removed %zd nodes, expected: %zd",width,removed[LPG_GRAPH_PASS_FREEZE_CONSTANTS],2*width);
+    LP_TEST_ASSERT(removed[LPG_GRAPH_PASS_CONST_PROP] > 0,"width: %zd; Constant propagation removed no nodes",width);
+    // Passes may allocate literals and negations, so the graph shrinks by at most the number of removed nodes
+    LP_TEST_ASSERT(nodes_num_after < nodes_num_before && nodes_num_before-nodes_num_after <= total_removed,
+        "width: %zd; Graph changed from %zd to %zd nodes, while %zd were reported",width,nodes_num_before,nodes_num_after,total_removed);
+
+    size_t dangling_num = lpg_graph_count_dangling_nodes(graph);
+    LP_TEST_ASSERT(dangling_num == 0,"width: %zd; Optimized graph has %zd dangling nodes",width,dangling_num);
+
+    for(size_t sample_i = 0; sample_i < __LPG_TEST_OPTIMIZE_SAMPLES_NUM; ++sample_i)
+    {
+        uint64_t a = rand() & mask;
+        uint64_t b = rand() & mask;
+        uint64_t expected = (a*b+c) & res_mask;
+        uint64_t actual = __test_graph_optimize_eval(graph,a | (b << width));
+        LP_TEST_ASSERT(actual == expected,"width: %zd; Expected %lu*%lu+%lu = %lu, got: %lu",width,a,b,c,expected,actual);
+    }
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_uint_release(graph_a);
+    lpg_uint_release(graph_b);
+    lpg_uint_release(graph_prod);
+    lpg_uint_release(graph_c);
+    lpg_uint_release(graph_res);
+}
+
+
+void lp_test_graph_optimize()
+{
+    srand(0);
+
+    for(size_t width = 1; width <= 16; ++width)
+    {
+        LP_TEST_STEP_INTO(__test_graph_optimize_passes(width,false));
+        LP_TEST_STEP_INTO(__test_graph_optimize_passes(width,true));
+        LP_TEST_STEP_INTO(__test_graph_optimize_mul_add(width));
+    }
+
+    lp_test_cleanup:
+}
@@ -0,0 +1,6 @@
+#ifndef _LOCKPICK_TESTS_GRAPH_GRAPH_OPTIMIZE_H
+#define _LOCKPICK_TESTS_GRAPH_GRAPH_OPTIMIZE_H
+
+void lp_test_graph_optimize();
+
+#endif  // _LOCKPICK_TESTS_GRAPH_GRAPH_OPTIMIZE_H
@@ -3,6 +3,7 @@
 #include <lockpick/graph/count.h>
 #include <lockpick/graph/types/uint.h>
 #include <lockpick/htable.h>
+#include <lockpick/define.h>
 
 #define __LPG_TEST_TSORT_MAX_GRAPH_NODES 100000
 
@@ -57,6 +58,56 @@ bool __test_graph_tsort(size_t in_width, size_t out_width)
 }
 
 
+bool __test_graph_tsort_levels(size_t in_width, size_t out_width)
+{
+    lpg_graph_t *graph = lpg_graph_create("test",in_width,out_width,__LPG_TEST_TSORT_MAX_GRAPH_NODES);
+    lpg_uint_t *uint_a = lpg_uint_allocate_as_buffer_view(graph,graph->inputs,in_width/2);
+    lpg_uint_t *uint_b = lpg_uint_allocate_as_buffer_view(graph,graph->inputs+in_width/2,in_width/2);
+    lpg_uint_t *uint_res = lpg_uint_allocate_as_buffer_view(graph,graph->outputs,out_width);
+    lpg_uint_mul(uint_a,uint_b,uint_res);
+
+    size_t expected_nodes_num = lpg_graph_nodes_count(graph);
+
+    lpg_node_t **sorted_nodes;
+    size_t nodes_num;
+    uint32_t *node_levels;
+    lpg_graph_tsort_levels(graph,&sorted_nodes,&nodes_num,&node_levels);
+
+    // Levels of already checked nodes addressed by slab slots, zero marks not yet checked nodes
+    lp_slab_t *slab = __lpg_graph_slab(graph);
+    uint32_t *checked_levels = (uint32_t*)calloc(lp_slab_capacity(slab),sizeof(uint32_t));
+
+    bool failed = nodes_num != expected_nodes_num;
+    for(size_t node_i = 0; node_i < nodes_num && !failed; ++node_i)
+    {
+        lpg_node_t *curr_node = sorted_nodes[node_i];
+        size_t parents_num = node_i < graph->inputs_size ? 0 : lpg_node_get_parents_num(curr_node);
+        lpg_node_t **parents = lpg_node_parents(curr_node);
+
+        uint32_t expected_level = 0;
+        for(size_t parent_i = 0; parent_i < parents_num; ++parent_i)
+        {
+            uint32_t parent_checked_level = checked_levels[lp_slab_index(slab,parents[parent_i])];
+            failed |= parent_checked_level == 0;
+            expected_level = MAX(expected_level,parent_checked_level);
+        }
+
+        failed |= node_levels[node_i] != expected_level;
+        checked_levels[lp_slab_index(slab,curr_node)] = expected_level+1;
+    }
+
+    free(checked_levels);
+    lpg_graph_release(graph);
+    lpg_uint_release(uint_a);
+    lpg_uint_release(uint_b);
+    lpg_uint_release(uint_res);
+    free(sorted_nodes);
+    free(node_levels);
+
+    return failed;
+}
+
+
 void lp_test_graph_tsort()
 {
     for(size_t in_width = 2; in_width <= 18; in_width += 2)
@@ -65,5 +116,11 @@ void lp_test_graph_tsort()
                 "Sorting error in test %zd, in_width: %zd, out_width: %zd",
                 in_width,out_width);
     
+    for(size_t in_width = 2; in_width <= 18; in_width += 2)
+        for(size_t out_width = in_width/2; out_width <= in_width; ++out_width)
+            LP_TEST_ASSERT(!__test_graph_tsort_levels(in_width,out_width),
+                "Level sorting error, in_width: %zd, out_width: %zd",
+                in_width,out_width);
+    
     lp_test_cleanup:
 }
\ No newline at end of file
@@ -1,12 +1,213 @@
+#include "infer.h"
 #include <lockpick/test.h>
 #include <lockpick/graph/inference/host/infer.h>
+#include <lockpick/graph/inference/host/jit.h>
+#include <lockpick/graph/inference/host/session.h>
+#include <lockpick/graph/inference/cone.h>
+#include <lockpick/graph/inference/soa.h>
+#include <lockpick/graph/inference/serialize.h>
+#include <lockpick/graph/inference/stream.h>
 #include <lockpick/graph/compute.h>
 #include <lockpick/graph/types/uint.h>
+#include <lockpick/uint.h>
 #include <lockpick/bitset.h>
 #include <malloc.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 #define __LPG_TEST_OCL_GRAPH_MAX_GRAPH_NODES 100000
+#define __LPG_TEST_INFER_HOST_BATCH_WORDS_NUM 2
+#define __LPG_TEST_INFER_HOST_BATCH_VECTORS_STEP 7
+#define __LPG_TEST_INFER_HOST_BATCH_MT_THREADS_NUM 3
+#define __LPG_TEST_INFER_HOST_CONTEXT_RUNS_NUM 8
+#define __LPG_TEST_INFER_HOST_WIDE_INDEX_MAX_GRAPH_NODES 1000000
+#define __LPG_TEST_INFER_HOST_WIDE_INDEX_OPERAND_WIDTH 256
+#define __LPG_TEST_INFER_HOST_WIDE_INDEX_NARROW_OUTPUTS_NUM 16
+
+
+typedef void (*__test_inference_graph_uint_op_t)(lpg_uint_t *a, lpg_uint_t *b, lpg_uint_t *result);
+
+
+/*
+    Applies 'op' to two halves of inputs of 'graph' and writes 'res_width' nodes of result into 'res_nodes'.
+*/
+static void __test_inference_graph_build(lpg_graph_t *graph, __test_inference_graph_uint_op_t op, lpg_node_t **res_nodes, size_t res_width)
+{
+    size_t operand_width = graph->inputs_size/2;
+    lpg_uint_t *uint_a = lpg_uint_allocate_as_buffer_view(graph,graph->inputs,operand_width);
+    lpg_uint_t *uint_b = lpg_uint_allocate_as_buffer_view(graph,graph->inputs+operand_width,operand_width);
+    lpg_uint_t *uint_res = lpg_uint_allocate_as_buffer_view(graph,res_nodes,res_width);
+    op(uint_a,uint_b,uint_res);
+
+    lpg_uint_release(uint_a);
+    lpg_uint_release(uint_b);
+    lpg_uint_release(uint_res);
+}
+
+
+/*
+    Creates graph, outputs of which hold product of two halves of its inputs.
+*/
+lpg_graph_t *__test_inference_graph_create_mul(size_t in_width, size_t out_width)
+{
+    lpg_graph_t *graph = lpg_graph_create("test",in_width,out_width,__LPG_TEST_OCL_GRAPH_MAX_GRAPH_NODES);
+    __test_inference_graph_build(graph,lpg_uint_mul,graph->outputs,out_width);
+
+    return graph;
+}
+
+
+static void __test_inference_graph_assign_rand_inputs(lpg_graph_t *graph)
+{
+    lpg_uint_t *uint_inputs = lpg_uint_allocate_as_buffer_view(graph,graph->inputs,graph->inputs_size);
+    lpg_uint_assign_from_rand(uint_inputs);
+    lpg_uint_release(uint_inputs);
+}
+
+
+static uint64_t *__test_inference_graph_rand_words(size_t words_num)
+{
+    uint64_t *words = (uint64_t*)malloc(words_num*sizeof(uint64_t));
+    for(size_t word_i = 0; word_i < words_num; ++word_i)
+        words[word_i] = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
+
+    return words;
+}
+
+
+static uint64_t *__test_inference_engine_batch(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, void *args)
+{
+    if(!args)
+        return lpg_inference_graph_infer_host_batch(inference_graph,input_values,words_num);
+    return lpg_inference_graph_infer_host_batch_isa(inference_graph,input_values,words_num,*(lpg_inference_host_isa_t*)args);
+}
+
+
+static uint64_t *__test_inference_engine_batch_mt(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, void *args)
+{
+    return __lpg_inference_graph_infer_host_batch_mt(inference_graph,input_values,words_num,__LPG_TEST_INFER_HOST_BATCH_MT_THREADS_NUM);
+}
+
+
+static uint64_t *__test_inference_engine_soa(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, void *args)
+{
+    if(!args)
+        return lpg_inference_graph_infer_host_soa(inference_graph,input_values,words_num);
+    return lpg_inference_graph_infer_host_soa_isa(inference_graph,input_values,words_num,*(lpg_inference_host_isa_t*)args);
+}
+
+
+static uint64_t *__test_inference_engine_stream(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, void *args)
+{
+    return lpg_inference_graph_infer_host_stream(inference_graph,input_values,words_num);
+}
+
+
+static uint64_t *__test_inference_engine_jit(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, void *args)
+{
+    return lpg_inference_graph_infer_host_jit(inference_graph,input_values,words_num);
+}
+
+
+/*
+    Host engines, batch ones come first. Ones with instruction set selection expect pointer to 'lpg_inference_host_isa_t' as their arguments
+    or NULL for the best supported one.
+*/
+static const __test_inference_engine_t __test_inference_host_engines[] = {
+    {"batch",       __test_inference_engine_batch},
+    {"batch_mt",    __test_inference_engine_batch_mt},
+    {"soa",         __test_inference_engine_soa},
+    {"stream",      __test_inference_engine_stream}
+};
+
+static const __test_inference_engine_t __test_inference_jit_engine = {"jit",__test_inference_engine_jit};
+
+
+/*
+    Infers the same random words of inputs with every engine of 'engines' on 'inference_graph' and compares
+    outputs with those of the scalar batch engine on 'reference_graph', which may be the same graph.
+    'args' are passed to every engine.
+*/
+void __test_inference_graph_compare_engines(lpg_inference_graph_t *reference_graph, lpg_inference_graph_t *inference_graph,
+    const __test_inference_engine_t *engines, size_t engines_num, size_t words_num, void *args)
+{
+    size_t inputs_size = reference_graph->inputs_size;
+    size_t outputs_size = reference_graph->outputs_size;
+    uint64_t *input_values = __test_inference_graph_rand_words(inputs_size*words_num);
+    uint64_t *true_output = lpg_inference_graph_infer_host_batch_isa(reference_graph,input_values,words_num,LPG_INFERENCE_HOST_ISA_SCALAR);
+    uint64_t *computed_output = NULL;
+
+    for(size_t engine_i = 0; engine_i < engines_num; ++engine_i)
+    {
+        computed_output = engines[engine_i].infer(inference_graph,input_values,words_num,args);
+
+        for(size_t word_i = 0; word_i < outputs_size*words_num; ++word_i)
+            LP_TEST_ASSERT(true_output[word_i] == computed_output[word_i],
+                "Output word %zd of %s engine expected: %lx, got: %lx. (inputs: %zd, outputs: %zd, words_num: %zd)",
+                word_i,engines[engine_i].name,true_output[word_i],computed_output[word_i],inputs_size,outputs_size,words_num);
+
+        free(computed_output);
+        computed_output = NULL;
+    }
+
+    lp_test_cleanup:
+    free(input_values);
+    free(true_output);
+    free(computed_output);
+}
+
+
+/*
+    Compares 'engines' on product of two halves of inputs, see '__test_inference_graph_compare_engines'.
+*/
+void __test_inference_graph_compare_engines_mul(size_t in_width, size_t out_width, size_t words_num, lpg_inference_order_t order,
+    const __test_inference_engine_t *engines, size_t engines_num, void *args)
+{
+    lpg_graph_t *graph = __test_inference_graph_create_mul(in_width,out_width);
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create_ordered(graph,false,order);
+
+    LP_TEST_STEP_INTO(__test_inference_graph_compare_engines(inference_graph,inference_graph,engines,engines_num,words_num,args));
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+/*
+    Checks that input nodes occupy the beginning of sorted nodes and every parent belongs to one of previous levels.
+*/
+void __test_inference_graph_check_levels(const lpg_inference_graph_t *inference_graph)
+{
+    size_t *level_offsets = inference_graph->level_offsets;
+    size_t *node_levels = (size_t*)malloc(MAX(1,inference_graph->nodes_num)*sizeof(size_t));
+
+    LP_TEST_ASSERT(level_offsets[0] == 0 && level_offsets[inference_graph->levels_num] == inference_graph->nodes_num,
+        "Level offsets must span the whole sorted array. (nodes: %zd)",inference_graph->nodes_num);
+    for(size_t level_i = 0; level_i < inference_graph->levels_num; ++level_i)
+    {
+        LP_TEST_ASSERT(level_offsets[level_i] < level_offsets[level_i+1],"Level %zd is empty. (nodes: %zd)",level_i,inference_graph->nodes_num);
+        for(size_t node_i = level_offsets[level_i]; node_i < level_offsets[level_i+1]; ++node_i)
+        {
+            node_levels[node_i] = level_i;
+            const lpg_node_packed_t *node = &inference_graph->sorted_nodes[node_i];
+            LP_TEST_ASSERT((node_i < inference_graph->inputs_size) == (lpg_node_packed_type(node) == LPG_NODE_PACKED_TYPE_INPUT),
+                "Input nodes must occupy the beginning of sorted nodes. (nodes: %zd)",inference_graph->nodes_num);
+
+            uint16_t parents_num = lpg_node_packed_get_parents_num(node);
+            for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+            {
+                size_t parent_node_i = (lpg_inference_graph_uindex_t)node->parents[parent_i];
+                LP_TEST_ASSERT(parent_node_i < level_offsets[level_i] && node_levels[parent_node_i] < level_i,
+                    "Parent of node %zd must belong to one of previous levels. (nodes: %zd)",node_i,inference_graph->nodes_num);
+            }
+        }
+    }
+
+    lp_test_cleanup:
+    free(node_levels);
+}
 
 
 void __test_inference_graph_infer_host(size_t in_width, size_t out_width)
@@ -63,7 +264,878 @@ void test_inference_graph_infer_host()
 }
 
 
+void __test_inference_graph_infer_host_context(size_t in_width, size_t out_width)
+{
+    lpg_graph_t *graph = __test_inference_graph_create_mul(in_width,out_width);
+
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create(graph,false);
+    lpg_inference_host_context_t *context = lpg_inference_host_context_create(inference_graph);
+    lp_bitset_t *input_values = lp_bitset_create(graph->inputs_size);
+    lp_bitset_t *into_output = lp_bitset_create(graph->outputs_size);
+    lp_bitset_t *true_output = NULL;
+
+    for(size_t run_i = 0; run_i < __LPG_TEST_INFER_HOST_CONTEXT_RUNS_NUM; ++run_i)
+    {
+        for(size_t in_node_i = 0; in_node_i < graph->inputs_size; ++in_node_i)
+            lp_bitset_update(input_values,in_node_i,rand() & 1);
+
+        true_output = lpg_inference_graph_infer_host(inference_graph,input_values);
+        const lp_bitset_t *ctx_output = lpg_inference_graph_infer_host_ctx(context,input_values);
+        lpg_inference_graph_infer_host_into(context,input_values,into_output);
+
+        for(size_t out_node_i = 0; out_node_i < graph->outputs_size; ++out_node_i)
+        {
+            bool true_out_value = lp_bitset_test(true_output,out_node_i);
+            bool ctx_out_value = lp_bitset_test(ctx_output,out_node_i);
+            bool into_out_value = lp_bitset_test(into_output,out_node_i);
+
+            LP_TEST_ASSERT(ctx_out_value == true_out_value && into_out_value == true_out_value,
+                "Output at index %zd expected: %d, got: %d (context), %d (into). (in_width: %zd, out_width: %zd)",
+                out_node_i,(uint32_t)true_out_value,(uint32_t)ctx_out_value,(uint32_t)into_out_value,in_width,out_width);
+        }
+
+        lp_bitset_release(true_output);
+        true_output = NULL;
+    }
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lp_bitset_release(input_values);
+    lp_bitset_release(into_output);
+    if(true_output)
+        lp_bitset_release(true_output);
+    lpg_inference_host_context_release(context);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+void test_inference_graph_infer_host_context()
+{
+    for(size_t in_width = 2; in_width <= 18; in_width += 2)
+        for(size_t out_width = in_width/2; out_width <= in_width; ++out_width)
+            LP_TEST_STEP_INTO(__test_inference_graph_infer_host_context(in_width,out_width));
+    
+    lp_test_cleanup:
+}
+
+
+void __test_inference_graph_infer_host_batch(size_t in_width, size_t out_width, size_t words_num)
+{
+    lpg_graph_t *graph = __test_inference_graph_create_mul(in_width,out_width);
+
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create(graph,false);
+
+    uint64_t *input_values = __test_inference_graph_rand_words(graph->inputs_size*words_num);
+
+    uint64_t *computed_output = lpg_inference_graph_infer_host_batch_isa(inference_graph,input_values,words_num,LPG_INFERENCE_HOST_ISA_SCALAR);
+
+    LP_TEST_ASSERT(inference_graph->narrow_nodes,
+        "Graph of %zd nodes must fit into 16-bit indices. (in_width: %zd, out_width: %zd)",inference_graph->nodes_num,in_width,out_width);
+    for(size_t node_i = 0; node_i < inference_graph->nodes_num; ++node_i)
+    {
+        lpg_node_packed_t widened_node = __LPG_NODE_PACKED_WIDEN(inference_graph->narrow_nodes[node_i]);
+        LP_TEST_ASSERT(!memcmp(&widened_node,&inference_graph->sorted_nodes[node_i],sizeof(lpg_node_packed_t)),
+            "Narrow node at index %zd differs from sorted one. (in_width: %zd, out_width: %zd)",node_i,in_width,out_width);
+    }
+
+    size_t vectors_num = words_num*LPG_INFERENCE_HOST_BATCH_WORD_WIDTH;
+    for(size_t vec_i = 0; vec_i < vectors_num; vec_i += __LPG_TEST_INFER_HOST_BATCH_VECTORS_STEP)
+    {
+        size_t word_i = vec_i / LPG_INFERENCE_HOST_BATCH_WORD_WIDTH;
+        size_t bit_i = vec_i % LPG_INFERENCE_HOST_BATCH_WORD_WIDTH;
+        for(size_t in_node_i = 0; in_node_i < graph->inputs_size; ++in_node_i)
+        {
+            bool in_value = (input_values[in_node_i*words_num+word_i] >> bit_i) & 1;
+            __lpg_node_set_value(graph->inputs[in_node_i],in_value);
+        }
+        lpg_graph_compute(graph);
+
+        for(size_t out_node_i = 0; out_node_i < graph->outputs_size; ++out_node_i)
+        {
+            bool batch_out_value = (computed_output[out_node_i*words_num+word_i] >> bit_i) & 1;
+            bool true_out_value = lpg_node_value(graph->outputs[out_node_i]);
+
+            LP_TEST_ASSERT(batch_out_value == true_out_value,
+                "Output at index %zd for vector %zd expected: %d, got: %d. (in_width: %zd, out_width: %zd)",
+                out_node_i,vec_i,(uint32_t)true_out_value,(uint32_t)batch_out_value,in_width,out_width);
+        }
+    }
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    free(input_values);
+    free(computed_output);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+void test_inference_graph_infer_host_batch()
+{
+    for(size_t in_width = 2; in_width <= 18; in_width += 2)
+        for(size_t out_width = in_width/2; out_width <= in_width; ++out_width)
+            LP_TEST_STEP_INTO(__test_inference_graph_infer_host_batch(in_width,out_width,__LPG_TEST_INFER_HOST_BATCH_WORDS_NUM));
+    
+    lp_test_cleanup:
+}
+
+
+void __test_inference_graph_infer_host_batch_masked(size_t in_width, size_t out_width, size_t words_num)
+{
+    lpg_graph_t *graph = __test_inference_graph_create_mul(in_width,out_width);
+
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create(graph,false);
+
+    uint64_t *input_values = __test_inference_graph_rand_words(graph->inputs_size*words_num);
+
+    // Either a single random output or a random subset of outputs
+    lp_bitset_t *outputs_mask = lp_bitset_create(graph->outputs_size);
+    if(rand() & 1)
+        lp_bitset_set(outputs_mask,rand() % graph->outputs_size);
+    else
+        for(size_t out_i = 0; out_i < graph->outputs_size; ++out_i)
+            lp_bitset_update(outputs_mask,out_i,rand() & 1);
+
+    uint64_t *true_output = lpg_inference_graph_infer_host_batch(inference_graph,input_values,words_num);
+    uint64_t *computed_output = lpg_inference_graph_infer_host_batch_masked(inference_graph,input_values,words_num,outputs_mask);
+    lpg_inference_cone_t *cone = lpg_inference_graph_cone(inference_graph,outputs_mask);
+
+    LP_TEST_ASSERT(inference_graph->cones->size == 1,
+        "Cone must be cached after the first request. (in_width: %zd, out_width: %zd)",in_width,out_width);
+    LP_TEST_ASSERT(cone->nodes_num <= inference_graph->nodes_num,
+        "Cone cannot exceed the whole graph. (in_width: %zd, out_width: %zd)",in_width,out_width);
+
+    for(size_t out_i = 0; out_i < graph->outputs_size; ++out_i)
+    {
+        bool selected = lp_bitset_test(outputs_mask,out_i);
+        for(size_t word_i = out_i*words_num; word_i < (out_i+1)*words_num; ++word_i)
+            LP_TEST_ASSERT(computed_output[word_i] == (selected ? true_output[word_i] : 0),
+                "Output word %zd expected: %lx, got: %lx. (in_width: %zd, out_width: %zd, selected: %d)",
+                word_i,selected ? true_output[word_i] : 0,computed_output[word_i],in_width,out_width,(uint32_t)selected);
+    }
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    free(input_values);
+    free(true_output);
+    free(computed_output);
+    lp_bitset_release(outputs_mask);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+void test_inference_graph_infer_host_batch_masked()
+{
+    for(size_t in_width = 2; in_width <= 18; in_width += 2)
+        for(size_t out_width = in_width/2; out_width <= in_width; ++out_width)
+            LP_TEST_STEP_INTO(__test_inference_graph_infer_host_batch_masked(in_width,out_width,__LPG_TEST_INFER_HOST_BATCH_WORDS_NUM));
+    
+    lp_test_cleanup:
+}
+
+
+void test_inference_graph_engines()
+{
+    static const lpg_inference_host_isa_t isas[] = {
+        LPG_INFERENCE_HOST_ISA_SCALAR,
+        LPG_INFERENCE_HOST_ISA_AVX2,
+        LPG_INFERENCE_HOST_ISA_AVX512
+    };
+    static const lpg_inference_order_t orders[] = {
+        LPG_INFERENCE_ORDER_LEVELS,
+        LPG_INFERENCE_ORDER_DFS
+    };
+    // Word counts both aligned and unaligned to vector register widths, single word takes the gather path of wide kernels
+    static const size_t words_nums[] = {1, 3, 8, 13};
+
+    for(size_t isa_i = 0; isa_i < __array_size(isas); ++isa_i)
+    {
+        if(!lpg_inference_host_isa_supported(isas[isa_i]))
+            continue;
+
+        lpg_inference_host_isa_t isa = isas[isa_i];
+        for(size_t order_i = 0; order_i < __array_size(orders); ++order_i)
+            for(size_t words_num_i = 0; words_num_i < __array_size(words_nums); ++words_num_i)
+                for(size_t in_width = 2; in_width <= 18; in_width += 2)
+                    for(size_t out_width = in_width/2; out_width <= in_width; ++out_width)
+                        LP_TEST_STEP_INTO(__test_inference_graph_compare_engines_mul(in_width,out_width,words_nums[words_num_i],orders[order_i],
+                            __test_inference_host_engines,__array_size(__test_inference_host_engines),&isa));
+    }
+
+    lp_test_cleanup:
+}
+
+
+void __test_inference_graph_caches(size_t in_width, size_t out_width)
+{
+    lpg_graph_t *graph = __test_inference_graph_create_mul(in_width,out_width);
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create(graph,false);
+
+    lpg_inference_soa_t *soa = lpg_inference_graph_soa(inference_graph);
+    lpg_inference_stream_t *stream = lpg_inference_graph_stream(inference_graph);
+    lpg_inference_jit_t *jit = lpg_inference_graph_jit(inference_graph);
+
+    LP_TEST_ASSERT(inference_graph->soa == soa && lpg_inference_graph_soa(inference_graph) == soa,
+        "Structure-of-arrays layout must be cached after the first request. (in_width: %zd, out_width: %zd)",in_width,out_width);
+    LP_TEST_ASSERT(soa->gates_num == inference_graph->nodes_num-graph->inputs_size,
+        "Number of gates expected: %zd, got: %zd. (in_width: %zd, out_width: %zd)",
+        inference_graph->nodes_num-graph->inputs_size,soa->gates_num,in_width,out_width);
+    for(size_t group_i = 0; group_i < soa->groups_num; ++group_i)
+        LP_TEST_ASSERT(soa->group_offsets[group_i] < soa->group_offsets[group_i+1] && soa->group_types[group_i] < LPG_INFERENCE_SOA_GATE_TYPES_NUM,
+            "Group %zd is either empty or has invalid type %d. (in_width: %zd, out_width: %zd)",
+            group_i,(uint32_t)soa->group_types[group_i],in_width,out_width);
+
+    LP_TEST_ASSERT(inference_graph->stream == stream && lpg_inference_graph_stream(inference_graph) == stream,
+        "Stream must be cached after the first request. (in_width: %zd, out_width: %zd)",in_width,out_width);
+    LP_TEST_ASSERT(stream->nodes_num == inference_graph->nodes_num && stream->inputs_size == inference_graph->inputs_size &&
+                   stream->size < inference_graph->nodes_num*sizeof(lpg_node_packed_narrow_t),
+        "Stream of %zd bytes is not smaller than %zd packed nodes. (in_width: %zd, out_width: %zd)",
+        stream->size,inference_graph->nodes_num,in_width,out_width);
+
+    LP_TEST_ASSERT(inference_graph->jit == jit && lpg_inference_graph_jit(inference_graph) == jit,
+        "Compiled graph must be cached. (in_width: %zd, out_width: %zd)",in_width,out_width);
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+void test_inference_graph_caches()
+{
+    // Compilation is expensive, so only the narrowest and the widest outputs are checked
+    for(size_t in_width = 2; in_width <= 18; in_width += 2)
+    {
+        LP_TEST_STEP_INTO(__test_inference_graph_caches(in_width,in_width/2));
+        LP_TEST_STEP_INTO(__test_inference_graph_caches(in_width,in_width));
+    }
+
+    lp_test_cleanup:
+}
+
+
+static size_t __test_inference_graph_count_type(const lpg_inference_graph_t *inference_graph, cl_char type)
+{
+    size_t type_nodes_num = 0;
+    for(size_t node_i = 0; node_i < inference_graph->nodes_num; ++node_i)
+        type_nodes_num += lpg_node_packed_type(&inference_graph->sorted_nodes[node_i]) == type;
+
+    return type_nodes_num;
+}
+
+
+void __test_inference_graph_fuse(size_t in_width, size_t out_width, size_t words_num, lpg_inference_host_isa_t isa)
+{
+    // Difference exercises negated operands of gates, extra outputs cover every pattern of fusion
+    size_t extra_outputs_size = 11;
+    lpg_graph_t *graph = lpg_graph_create("test",in_width,out_width+extra_outputs_size,__LPG_TEST_OCL_GRAPH_MAX_GRAPH_NODES);
+    __test_inference_graph_build(graph,lpg_uint_sub,graph->outputs,out_width);
+
+    lpg_node_t *a = graph->inputs[0];
+    lpg_node_t *b = graph->inputs[in_width-1];
+    lpg_node_t **extra_outputs = graph->outputs+out_width;
+    extra_outputs[0] = lpg_node_not(graph,lpg_node_and(graph,a,b));
+    extra_outputs[1] = lpg_node_not(graph,lpg_node_or(graph,a,b));
+    extra_outputs[2] = lpg_node_not(graph,lpg_node_xor(graph,a,b));
+    extra_outputs[3] = lpg_node_or(graph,lpg_node_not(graph,a),b);
+    extra_outputs[4] = lpg_node_xor(graph,a,lpg_node_not(graph,b));
+    extra_outputs[5] = lpg_node_and(graph,lpg_node_not(graph,a),lpg_node_not(graph,b));
+    extra_outputs[6] = lpg_node_or(graph,lpg_node_not(graph,a),lpg_node_not(graph,b));
+    extra_outputs[7] = lpg_node_xor(graph,lpg_node_not(graph,a),lpg_node_not(graph,b));
+
+    // Sum and carry of a full adder share 'a^c', selection picks 'b' if 'c' is set
+    lpg_node_t *c = graph->inputs[1];
+    lpg_node_t *a_xor_c = lpg_node_xor(graph,a,c);
+    extra_outputs[8] = lpg_node_xor(graph,a_xor_c,b);
+    extra_outputs[9] = lpg_node_or(graph,lpg_node_and(graph,a_xor_c,b),lpg_node_and(graph,a,c));
+    extra_outputs[10] = lpg_node_or(graph,lpg_node_and(graph,a,lpg_node_not(graph,c)),lpg_node_and(graph,b,c));
+
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create(graph,false);
+    lpg_inference_graph_t *fused_graph = lpg_inference_graph_fuse(inference_graph);
+
+    size_t outputs_size = graph->outputs_size;
+    lp_bitset_t *input_bits = NULL;
+    lp_bitset_t *computed_bits = NULL;
+    lp_bitset_t *true_bits = NULL;
+    lpg_inference_host_session_t *session = NULL;
+
+    LP_TEST_ASSERT(fused_graph->nodes_num < inference_graph->nodes_num && fused_graph->levels_num <= inference_graph->levels_num,
+        "Fused graph of %zd nodes is not smaller than original one of %zd nodes. (in_width: %zd, out_width: %zd)",
+        fused_graph->nodes_num,inference_graph->nodes_num,in_width,out_width);
+
+    // Ternary patterns degenerate once 'b' and 'c' are the same input
+    if(in_width > 2)
+    {
+        static const cl_char ternary_types[] = {LPG_NODE_PACKED_TYPE_XOR3, LPG_NODE_PACKED_TYPE_MAJ, LPG_NODE_PACKED_TYPE_MUX};
+        for(size_t type_i = 0; type_i < __array_size(ternary_types); ++type_i)
+            LP_TEST_ASSERT(__test_inference_graph_count_type(fused_graph,ternary_types[type_i]) > 0,
+                "Fused graph has no nodes of type %d. (in_width: %zd, out_width: %zd)",
+                (uint32_t)ternary_types[type_i],in_width,out_width);
+    }
+
+    LP_TEST_STEP_INTO(__test_inference_graph_compare_engines(inference_graph,fused_graph,
+        __test_inference_host_engines,__array_size(__test_inference_host_engines),words_num,&isa));
+
+    input_bits = lp_bitset_create(graph->inputs_size);
+    for(size_t in_node_i = 0; in_node_i < graph->inputs_size; ++in_node_i)
+        lp_bitset_update(input_bits,in_node_i,rand() & 1);
+
+    true_bits = lpg_inference_graph_infer_host(inference_graph,input_bits);
+    computed_bits = lpg_inference_graph_infer_host(fused_graph,input_bits);
+    session = lpg_inference_host_session_create(fused_graph,input_bits);
+
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+    {
+        bool true_bit = lp_bitset_test(true_bits,out_i);
+        LP_TEST_ASSERT(lp_bitset_test(computed_bits,out_i) == true_bit &&
+                       lp_bitset_test(lpg_inference_host_session_output(session),out_i) == true_bit,
+            "Output at index %zd expected: %d. (in_width: %zd, out_width: %zd)",out_i,(uint32_t)true_bit,in_width,out_width);
+    }
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    if(input_bits)
+        lp_bitset_release(input_bits);
+    if(true_bits)
+        lp_bitset_release(true_bits);
+    if(computed_bits)
+        lp_bitset_release(computed_bits);
+    if(session)
+        lpg_inference_host_session_release(session);
+    lpg_inference_graph_release(fused_graph);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+void test_inference_graph_fuse()
+{
+    static const lpg_inference_host_isa_t isas[] = {
+        LPG_INFERENCE_HOST_ISA_SCALAR,
+        LPG_INFERENCE_HOST_ISA_AVX2,
+        LPG_INFERENCE_HOST_ISA_AVX512
+    };
+    // Single word takes the gather path of wide structure-of-arrays kernels
+    static const size_t words_nums[] = {1, 3, 8};
+
+    for(size_t isa_i = 0; isa_i < __array_size(isas); ++isa_i)
+    {
+        if(!lpg_inference_host_isa_supported(isas[isa_i]))
+            continue;
+
+        for(size_t words_num_i = 0; words_num_i < __array_size(words_nums); ++words_num_i)
+            // Every input must be used, so the difference is as wide as operands
+            for(size_t in_width = 2; in_width <= 32; in_width += 2)
+                LP_TEST_STEP_INTO(__test_inference_graph_fuse(in_width,in_width/2,words_nums[words_num_i],isas[isa_i]));
+    }
+
+    lp_test_cleanup:
+}
+
+
+void __test_inference_graph_fuse_adder(size_t width)
+{
+    lpg_graph_t *graph = lpg_graph_create("test",2*width,width,__LPG_TEST_OCL_GRAPH_MAX_GRAPH_NODES);
+    __test_inference_graph_build(graph,lpg_uint_add,graph->outputs,width);
+
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create(graph,false);
+    lpg_inference_graph_t *fused_graph = lpg_inference_graph_fuse(inference_graph);
+
+    // Lowest bit has no carry in, highest one has no carry out, every bit in between is a full adder
+    size_t xor3_nodes_num = __test_inference_graph_count_type(fused_graph,LPG_NODE_PACKED_TYPE_XOR3);
+    size_t maj_nodes_num = __test_inference_graph_count_type(fused_graph,LPG_NODE_PACKED_TYPE_MAJ);
+    LP_TEST_ASSERT(xor3_nodes_num == width-1 && maj_nodes_num == width-2,
+        "Expected %zd XOR3 and %zd MAJ nodes, got: %zd and %zd. (width: %zd)",width-1,width-2,xor3_nodes_num,maj_nodes_num,width);
+    LP_TEST_ASSERT(fused_graph->nodes_num == 2*width+2*width-1,
+        "Fused adder expected to have %zd nodes, got: %zd. (width: %zd)",4*width-1,fused_graph->nodes_num,width);
+
+    LP_TEST_STEP_INTO(__test_inference_graph_compare_engines(inference_graph,fused_graph,
+        __test_inference_host_engines,__array_size(__test_inference_host_engines),3,NULL));
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_inference_graph_release(fused_graph);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+void test_inference_graph_fuse_adder()
+{
+    for(size_t width = 2; width <= 32; ++width)
+        LP_TEST_STEP_INTO(__test_inference_graph_fuse_adder(width));
+
+    lp_test_cleanup:
+}
+
+
+void __test_inference_graph_output_nodes(size_t in_width, size_t out_width, size_t words_num, lpg_inference_order_t order)
+{
+    // Outputs are the product in reversed order, the same product bits again and the first input
+    size_t outputs_size = 2*out_width+1;
+    lpg_graph_t *graph = lpg_graph_create("test",in_width,outputs_size,__LPG_TEST_OCL_GRAPH_MAX_GRAPH_NODES);
+    __test_inference_graph_build(graph,lpg_uint_mul,graph->outputs+out_width,out_width);
+    for(size_t out_i = 0; out_i < out_width; ++out_i)
+        graph->outputs[out_i] = graph->outputs[2*out_width-1-out_i];
+    graph->outputs[2*out_width] = graph->inputs[0];
+
+    __test_inference_graph_assign_rand_inputs(graph);
+    lpg_graph_compute(graph);
+
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create_ordered(graph,true,order);
+
+    lp_bitset_t *input_values = lp_bitset_create(graph->inputs_size);
+    uint64_t *input_words = (uint64_t*)malloc(graph->inputs_size*words_num*sizeof(uint64_t));
+    for(size_t in_node_i = 0; in_node_i < graph->inputs_size; ++in_node_i)
+    {
+        bool in_value = lpg_node_value(graph->inputs[in_node_i]);
+        lp_bitset_update(input_values,in_node_i,in_value);
+        for(size_t word_i = 0; word_i < words_num; ++word_i)
+            input_words[in_node_i*words_num+word_i] = in_value ? ~(uint64_t)0 : 0;
+    }
+
+    // Only the repeated outputs and the input, so that the first outputs of shared nodes are not selected
+    lp_bitset_t *outputs_mask = lp_bitset_create(outputs_size);
+    for(size_t out_i = out_width; out_i < outputs_size; ++out_i)
+        lp_bitset_set(outputs_mask,out_i);
+
+    lp_bitset_t *computed_output = lpg_inference_graph_infer_host(inference_graph,input_values);
+    lpg_inference_host_session_t *session = lpg_inference_host_session_create(inference_graph,input_values);
+    uint64_t *computed_words[] = {
+        lpg_inference_graph_infer_host_batch(inference_graph,input_words,words_num),
+        lpg_inference_graph_infer_host_batch_masked(inference_graph,input_words,words_num,outputs_mask),
+        __lpg_inference_graph_infer_host_batch_mt(inference_graph,input_words,words_num,__LPG_TEST_INFER_HOST_BATCH_MT_THREADS_NUM),
+        lpg_inference_graph_infer_host_soa(inference_graph,input_words,words_num),
+        lpg_inference_graph_infer_host_stream(inference_graph,input_words,words_num)
+    };
+
+    for(size_t out_i = 0; out_i < outputs_size; ++out_i)
+    {
+        lpg_node_t *out_node;
+        lpg_inference_graph_inv_index_map_find(inference_graph,inference_graph->output_nodes[out_i],&out_node);
+        LP_TEST_ASSERT(out_node == graph->outputs[out_i],
+            "Output %zd refers to wrong node. (in_width: %zd, out_width: %zd, order: %d)",out_i,in_width,out_width,(uint32_t)order);
+
+        bool true_out_value = lpg_node_value(graph->outputs[out_i]);
+        LP_TEST_ASSERT(lp_bitset_test(computed_output,out_i) == true_out_value &&
+                       lp_bitset_test(lpg_inference_host_session_output(session),out_i) == true_out_value,
+            "Output at index %zd expected: %d. (in_width: %zd, out_width: %zd, order: %d)",
+            out_i,(uint32_t)true_out_value,in_width,out_width,(uint32_t)order);
+
+        for(size_t engine_i = 0; engine_i < __array_size(computed_words); ++engine_i)
+        {
+            bool selected = engine_i != 1 || lp_bitset_test(outputs_mask,out_i);
+            uint64_t true_word = selected && true_out_value ? ~(uint64_t)0 : 0;
+            for(size_t word_i = out_i*words_num; word_i < (out_i+1)*words_num; ++word_i)
+                LP_TEST_ASSERT(computed_words[engine_i][word_i] == true_word,
+                    "Output word %zd of engine %zd expected: %lx, got: %lx. (in_width: %zd, out_width: %zd, order: %d)",
+                    word_i,engine_i,true_word,computed_words[engine_i][word_i],in_width,out_width,(uint32_t)order);
+        }
+    }
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lp_bitset_release(input_values);
+    free(input_words);
+    lp_bitset_release(outputs_mask);
+    lp_bitset_release(computed_output);
+    lpg_inference_host_session_release(session);
+    for(size_t engine_i = 0; engine_i < __array_size(computed_words); ++engine_i)
+        free(computed_words[engine_i]);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+void test_inference_graph_output_nodes()
+{
+    static const lpg_inference_order_t orders[] = {
+        LPG_INFERENCE_ORDER_LEVELS,
+        LPG_INFERENCE_ORDER_DFS
+    };
+
+    for(size_t order_i = 0; order_i < __array_size(orders); ++order_i)
+        for(size_t in_width = 2; in_width <= 18; in_width += 4)
+            for(size_t out_width = in_width/2; out_width <= in_width; ++out_width)
+                LP_TEST_STEP_INTO(__test_inference_graph_output_nodes(in_width,out_width,__LPG_TEST_INFER_HOST_BATCH_WORDS_NUM,orders[order_i]));
+
+    lp_test_cleanup:
+}
+
+
+static uint64_t *__test_inference_engine_batch_mt_threads(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, void *args)
+{
+    return __lpg_inference_graph_infer_host_batch_mt(inference_graph,input_values,words_num,*(uint32_t*)args);
+}
+
+
+void __test_inference_graph_infer_host_batch_mt(size_t in_width, size_t out_width, size_t words_num, lpg_inference_order_t order, uint32_t threads_num)
+{
+    static const __test_inference_engine_t engines[] = {
+        {"batch_mt",    __test_inference_engine_batch_mt_threads}
+    };
+    lpg_graph_t *graph = __test_inference_graph_create_mul(in_width,out_width);
+
+    // Sequentially created graph serves as a reference for the one sorted and packed in parallel
+    lpg_inference_graph_t *reference_graph = lpg_inference_graph_create(graph,false);
+    lpg_inference_graph_t *inference_graph = __lpg_inference_graph_create_mt(graph,false,order,threads_num);
+
+    LP_TEST_STEP_INTO(__test_inference_graph_check_levels(inference_graph));
+    LP_TEST_STEP_INTO(__test_inference_graph_compare_engines(reference_graph,inference_graph,engines,__array_size(engines),words_num,&threads_num));
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_inference_graph_release(reference_graph);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+void test_inference_graph_infer_host_batch_mt()
+{
+    lpg_inference_order_t orders[] = {
+        LPG_INFERENCE_ORDER_LEVELS,
+        LPG_INFERENCE_ORDER_LEVELS_LOCALITY,
+        LPG_INFERENCE_ORDER_DFS
+    };
+
+    for(size_t order_i = 0; order_i < __array_size(orders); ++order_i)
+        for(size_t in_width = 2; in_width <= 18; in_width += 2)
+            for(size_t out_width = in_width/2; out_width <= in_width; ++out_width)
+                LP_TEST_STEP_INTO(__test_inference_graph_infer_host_batch_mt(in_width,out_width,__LPG_TEST_INFER_HOST_BATCH_WORDS_NUM,
+                    orders[order_i],__LPG_TEST_INFER_HOST_BATCH_MT_THREADS_NUM));
+    
+    lp_test_cleanup:
+}
+
+
+void __test_inference_graph_order(size_t in_width, size_t out_width, size_t words_num, lpg_inference_order_t order)
+{
+    lpg_graph_t *graph = __test_inference_graph_create_mul(in_width,out_width);
+
+    lpg_inference_graph_t *reference_graph = lpg_inference_graph_create(graph,false);
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create_ordered(graph,false,order);
+
+    LP_TEST_ASSERT(inference_graph->nodes_num == reference_graph->nodes_num,
+        "Number of nodes expected: %zd, got: %zd. (in_width: %zd, out_width: %zd, order: %d)",
+        reference_graph->nodes_num,inference_graph->nodes_num,in_width,out_width,(int)order);
+    LP_TEST_STEP_INTO(__test_inference_graph_check_levels(inference_graph));
+    LP_TEST_ASSERT(lpg_inference_graph_avg_parent_distance(inference_graph) >= 1,
+        "Average parent distance must be at least 1. (in_width: %zd, out_width: %zd, order: %d)",in_width,out_width,(int)order);
+
+    // Batch engines only, the rest do not depend on the order of nodes within levels
+    LP_TEST_STEP_INTO(__test_inference_graph_compare_engines(reference_graph,inference_graph,__test_inference_host_engines,2,words_num,NULL));
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_inference_graph_release(reference_graph);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+void test_inference_graph_order()
+{
+    static const lpg_inference_order_t orders[] = {
+        LPG_INFERENCE_ORDER_LEVELS,
+        LPG_INFERENCE_ORDER_LEVELS_LOCALITY,
+        LPG_INFERENCE_ORDER_DFS
+    };
+
+    for(size_t order_i = 0; order_i < __array_size(orders); ++order_i)
+        for(size_t in_width = 2; in_width <= 18; in_width += 4)
+            for(size_t out_width = in_width/2; out_width <= in_width; out_width += 2)
+                LP_TEST_STEP_INTO(__test_inference_graph_order(in_width,out_width,__LPG_TEST_INFER_HOST_BATCH_WORDS_NUM,orders[order_i]));
+    
+    lp_test_cleanup:
+}
+
+
+void __test_inference_graph_create_cone(size_t in_width, size_t out_width, size_t words_num, lpg_inference_order_t order)
+{
+    lpg_graph_t *graph = lpg_graph_create("test",in_width,out_width,__LPG_TEST_OCL_GRAPH_MAX_GRAPH_NODES);
+    // Nodes of the sum share the slab and children of inputs, but are not reachable from outputs
+    lpg_uint_t *uint_unused = lpg_uint_allocate(graph,in_width/2);
+    __test_inference_graph_build(graph,lpg_uint_add,lpg_uint_nodes(uint_unused),in_width/2);
+    __test_inference_graph_build(graph,lpg_uint_mul,graph->outputs,out_width);
+
+    lpg_inference_graph_t *reference_graph = lpg_inference_graph_create_ordered(graph,false,order);
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create_cone(graph,true,order);
+
+    LP_TEST_ASSERT(inference_graph->nodes_num == reference_graph->nodes_num,
+        "Number of nodes expected: %zd, got: %zd. (in_width: %zd, out_width: %zd, order: %d)",
+        reference_graph->nodes_num,inference_graph->nodes_num,in_width,out_width,(int)order);
+
+    // Levels of both builders are the same up to the order of nodes inside them
+    if(order != LPG_INFERENCE_ORDER_DFS)
+    {
+        LP_TEST_ASSERT(inference_graph->levels_num == reference_graph->levels_num,
+            "Number of levels expected: %zd, got: %zd. (in_width: %zd, out_width: %zd, order: %d)",
+            reference_graph->levels_num,inference_graph->levels_num,in_width,out_width,(int)order);
+        for(size_t level_i = 0; level_i <= inference_graph->levels_num; ++level_i)
+            LP_TEST_ASSERT(inference_graph->level_offsets[level_i] == reference_graph->level_offsets[level_i],
+                "Offset of level %zd expected: %zd, got: %zd. (in_width: %zd, out_width: %zd, order: %d)",level_i,
+                reference_graph->level_offsets[level_i],inference_graph->level_offsets[level_i],in_width,out_width,(int)order);
+    }
+
+    LP_TEST_STEP_INTO(__test_inference_graph_check_levels(inference_graph));
+    for(size_t node_i = 0; node_i < inference_graph->nodes_num; ++node_i)
+    {
+        lpg_node_t *graph_node;
+        lpg_inference_graph_index_t index;
+        lpg_inference_graph_inv_index_map_find(inference_graph,node_i,&graph_node);
+        lpg_inference_graph_index_map_find(inference_graph,graph_node,&index);
+        LP_TEST_ASSERT((lpg_inference_graph_uindex_t)index == node_i,
+            "Index map and inverse index map of node %zd disagree. (in_width: %zd, out_width: %zd, order: %d)",node_i,in_width,out_width,(int)order);
+    }
+
+    LP_TEST_STEP_INTO(__test_inference_graph_compare_engines(reference_graph,inference_graph,__test_inference_host_engines,1,words_num,NULL));
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_uint_release(uint_unused);
+    lpg_inference_graph_release(reference_graph);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+void test_inference_graph_create_cone()
+{
+    static const lpg_inference_order_t orders[] = {
+        LPG_INFERENCE_ORDER_LEVELS,
+        LPG_INFERENCE_ORDER_LEVELS_LOCALITY,
+        LPG_INFERENCE_ORDER_DFS
+    };
+
+    for(size_t order_i = 0; order_i < __array_size(orders); ++order_i)
+        for(size_t in_width = 2; in_width <= 18; in_width += 4)
+            for(size_t out_width = in_width/2; out_width <= in_width; out_width += 2)
+                LP_TEST_STEP_INTO(__test_inference_graph_create_cone(in_width,out_width,__LPG_TEST_INFER_HOST_BATCH_WORDS_NUM,orders[order_i]));
+
+    lp_test_cleanup:
+}
+
+
+void __test_inference_graph_serialize(size_t in_width, size_t out_width, size_t words_num, lpg_inference_order_t order)
+{
+    lpg_graph_t *graph = __test_inference_graph_create_mul(in_width,out_width);
+
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create_ordered(graph,false,order);
+
+    lpg_inference_graph_t *loaded_graph = NULL;
+
+    char path[] = "/tmp/lockpick_test_inference_XXXXXX";
+    int fd = mkstemp(path);
+    LP_TEST_ASSERT(fd >= 0,"Failed to create temporary file");
+    close(fd);
+
+    lpg_inference_graph_save(inference_graph,path);
+    loaded_graph = lpg_inference_graph_load(path);
+    // Mapping must survive removal of the file
+    unlink(path);
+
+    LP_TEST_ASSERT(loaded_graph->mapping && !loaded_graph->graph,
+        "Loaded graph must be mapped and have no underlying graph. (in_width: %zd, out_width: %zd)",in_width,out_width);
+    LP_TEST_ASSERT(loaded_graph->nodes_num == inference_graph->nodes_num &&
+                   loaded_graph->inputs_size == graph->inputs_size &&
+                   loaded_graph->outputs_size == graph->outputs_size &&
+                   loaded_graph->levels_num == inference_graph->levels_num &&
+                   loaded_graph->slots_num == inference_graph->slots_num,
+        "Sizes of loaded graph differ from saved one. (in_width: %zd, out_width: %zd)",in_width,out_width);
+    LP_TEST_ASSERT(!memcmp(loaded_graph->sorted_nodes,inference_graph->sorted_nodes,inference_graph->nodes_num*sizeof(lpg_node_packed_t)) &&
+                   !memcmp(loaded_graph->level_offsets,inference_graph->level_offsets,(inference_graph->levels_num+1)*sizeof(size_t)) &&
+                   !memcmp(loaded_graph->output_nodes,inference_graph->output_nodes,graph->outputs_size*sizeof(lpg_inference_graph_uindex_t)) &&
+                   loaded_graph->narrow_nodes && inference_graph->narrow_nodes &&
+                   !memcmp(loaded_graph->narrow_nodes,inference_graph->narrow_nodes,inference_graph->nodes_num*sizeof(lpg_node_packed_narrow_t)),
+        "Nodes, levels or outputs of loaded graph differ from saved ones. (in_width: %zd, out_width: %zd)",in_width,out_width);
+
+    LP_TEST_STEP_INTO(__test_inference_graph_compare_engines(inference_graph,loaded_graph,
+        __test_inference_host_engines,__array_size(__test_inference_host_engines),words_num,NULL));
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_inference_graph_release(inference_graph);
+    if(loaded_graph)
+        lpg_inference_graph_release(loaded_graph);
+}
+
+
+void test_inference_graph_serialize()
+{
+    static const lpg_inference_order_t orders[] = {
+        LPG_INFERENCE_ORDER_LEVELS,
+        LPG_INFERENCE_ORDER_DFS
+    };
+
+    for(size_t order_i = 0; order_i < __array_size(orders); ++order_i)
+        for(size_t in_width = 2; in_width <= 18; in_width += 4)
+            for(size_t out_width = in_width/2; out_width <= in_width; ++out_width)
+                LP_TEST_STEP_INTO(__test_inference_graph_serialize(in_width,out_width,__LPG_TEST_INFER_HOST_BATCH_WORDS_NUM,orders[order_i]));
+
+    lp_test_cleanup:
+}
+
+
+void test_inference_graph_infer_host_jit()
+{
+    // Compilation is expensive, so only the narrowest and the widest outputs are checked
+    for(size_t in_width = 2; in_width <= 18; in_width += 2)
+    {
+        LP_TEST_STEP_INTO(__test_inference_graph_compare_engines_mul(in_width,in_width/2,__LPG_TEST_INFER_HOST_BATCH_WORDS_NUM,
+            LPG_INFERENCE_ORDER_LEVELS,&__test_inference_jit_engine,1,NULL));
+        LP_TEST_STEP_INTO(__test_inference_graph_compare_engines_mul(in_width,in_width,__LPG_TEST_INFER_HOST_BATCH_WORDS_NUM,
+            LPG_INFERENCE_ORDER_LEVELS,&__test_inference_jit_engine,1,NULL));
+    }
+
+    lp_test_cleanup:
+}
+
+
+void __test_inference_graph_slots(size_t in_width, size_t out_width)
+{
+    lpg_graph_t *graph = __test_inference_graph_create_mul(in_width,out_width);
+
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create(graph,false);
+    size_t slots_num = inference_graph->slots_num;
+    const lpg_inference_graph_uindex_t *node_slots = inference_graph->node_slots;
+
+    // Node, value of which is currently stored inside each slot
+    size_t *slot_owners = (size_t*)malloc(inference_graph->nodes_num*sizeof(size_t));
+
+    LP_TEST_ASSERT(slots_num > 0 && slots_num <= inference_graph->nodes_num,
+        "Number of slots %zd must be within (0, %zd]. (in_width: %zd, out_width: %zd)",
+        slots_num,inference_graph->nodes_num,in_width,out_width);
+
+    for(size_t node_i = 0; node_i < inference_graph->nodes_num; ++node_i)
+    {
+        LP_TEST_ASSERT(node_slots[node_i] < slots_num,
+            "Slot of node %zd is out of range. (in_width: %zd, out_width: %zd)",node_i,in_width,out_width);
+        if(node_i < graph->inputs_size)
+            LP_TEST_ASSERT(node_slots[node_i] == node_i,
+                "Input node %zd must occupy its own slot. (in_width: %zd, out_width: %zd)",node_i,in_width,out_width);
+
+        const lpg_node_packed_t *node = &inference_graph->sorted_nodes[node_i];
+        uint16_t parents_num = lpg_node_packed_get_parents_num(node);
+        for(uint16_t parent_i = 0; parent_i < parents_num; ++parent_i)
+        {
+            size_t parent_node_i = (lpg_inference_graph_uindex_t)node->parents[parent_i];
+            LP_TEST_ASSERT(slot_owners[node_slots[parent_node_i]] == parent_node_i,
+                "Value of parent %zd of node %zd is overwritten before use. (in_width: %zd, out_width: %zd)",
+                parent_node_i,node_i,in_width,out_width);
+        }
+
+        slot_owners[node_slots[node_i]] = node_i;
+    }
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    free(slot_owners);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+void test_inference_graph_slots()
+{
+    for(size_t in_width = 2; in_width <= 18; in_width += 2)
+        for(size_t out_width = in_width/2; out_width <= in_width; ++out_width)
+            LP_TEST_STEP_INTO(__test_inference_graph_slots(in_width,out_width));
+    
+    lp_test_cleanup:
+}
+
+
+/*
+    Product of random operands is computed with 'lp_uint' rather than with 'lpg_graph_compute', which
+    is too slow for graphs of this size. The graph exceeds 16-bit indices, while the cone of the lowest
+    bits of the product fits into them, so both index widths are selected from the same graph.
+*/
+void test_inference_graph_infer_host_wide_index()
+{
+    size_t operand_width = __LPG_TEST_INFER_HOST_WIDE_INDEX_OPERAND_WIDTH;
+    lpg_graph_t *graph = lpg_graph_create("test",2*operand_width,2*operand_width,__LPG_TEST_INFER_HOST_WIDE_INDEX_MAX_GRAPH_NODES);
+    __test_inference_graph_build(graph,lpg_uint_mul,graph->outputs,2*operand_width);
+
+    // Both operands are stored back to back, so bits of the buffer match input nodes
+    size_t operand_words_num = operand_width/__LP_UINT_BITS_PER_WORD;
+    uint64_t *operands = __test_inference_graph_rand_words(2*operand_words_num);
+    __lp_uint_word_t product[2*__LPG_TEST_INFER_HOST_WIDE_INDEX_OPERAND_WIDTH/__LP_UINT_BITS_PER_WORD];
+    __lp_uint_mul(operands,operand_words_num,operands+operand_words_num,operand_words_num,product,__array_size(product));
+
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create(graph,false);
+    lp_bitset_t *input_values = lp_bitset_create(graph->inputs_size);
+    uint64_t *input_words = (uint64_t*)malloc(graph->inputs_size*sizeof(uint64_t));
+    for(size_t in_node_i = 0; in_node_i < graph->inputs_size; ++in_node_i)
+    {
+        bool in_value = (operands[in_node_i/__LP_UINT_BITS_PER_WORD] >> (in_node_i%__LP_UINT_BITS_PER_WORD)) & 1;
+        lp_bitset_update(input_values,in_node_i,in_value);
+        input_words[in_node_i] = in_value ? ~0ULL : 0;
+    }
+
+    lp_bitset_t *computed_output = NULL;
+    uint64_t *computed_output_words = NULL;
+    uint64_t *computed_output_mt_words = NULL;
+    uint64_t *computed_output_masked_words = NULL;
+    lp_bitset_t *outputs_mask = NULL;
+    LP_TEST_ASSERT(inference_graph->nodes_num > LPG_INFERENCE_GRAPH_NARROW_MAX_NODES_NUM && !inference_graph->narrow_nodes,
+        "Graph must not fit into 16-bit indices, got %zd nodes",inference_graph->nodes_num);
+
+    outputs_mask = lp_bitset_create(graph->outputs_size);
+    for(size_t out_node_i = 0; out_node_i < __LPG_TEST_INFER_HOST_WIDE_INDEX_NARROW_OUTPUTS_NUM; ++out_node_i)
+        lp_bitset_set(outputs_mask,out_node_i);
+    lpg_inference_cone_t *cone = lpg_inference_graph_cone(inference_graph,outputs_mask);
+    LP_TEST_ASSERT(cone->narrow_nodes,"Cone of %zd nodes must fit into 16-bit indices",cone->nodes_num);
+
+    computed_output = lpg_inference_graph_infer_host(inference_graph,input_values);
+    computed_output_words = lpg_inference_graph_infer_host_batch(inference_graph,input_words,1);
+    computed_output_mt_words = __lpg_inference_graph_infer_host_batch_mt(inference_graph,input_words,1,__LPG_TEST_INFER_HOST_BATCH_MT_THREADS_NUM);
+    computed_output_masked_words = lpg_inference_graph_infer_host_batch_masked(inference_graph,input_words,1,outputs_mask);
+    for(size_t out_node_i = 0; out_node_i < graph->outputs_size; ++out_node_i)
+    {
+        bool computed_out_value = lp_bitset_test(computed_output,out_node_i);
+        bool true_out_value = (product[out_node_i/__LP_UINT_BITS_PER_WORD] >> (out_node_i%__LP_UINT_BITS_PER_WORD)) & 1;
+        uint64_t true_out_word = true_out_value ? ~0ULL : 0;
+
+        LP_TEST_ASSERT(computed_out_value == true_out_value,
+            "Output at index %zd expected: %d, got: %d",
+            out_node_i,(uint32_t)true_out_value,(uint32_t)computed_out_value);
+        LP_TEST_ASSERT(computed_output_words[out_node_i] == true_out_word,
+            "Batch output at index %zd expected: %lx, got: %lx",
+            out_node_i,true_out_word,computed_output_words[out_node_i]);
+        LP_TEST_ASSERT(computed_output_mt_words[out_node_i] == true_out_word,
+            "Multithreaded batch output at index %zd expected: %lx, got: %lx",
+            out_node_i,true_out_word,computed_output_mt_words[out_node_i]);
+        if(out_node_i < __LPG_TEST_INFER_HOST_WIDE_INDEX_NARROW_OUTPUTS_NUM)
+            LP_TEST_ASSERT(computed_output_masked_words[out_node_i] == true_out_word,
+                "Masked batch output at index %zd expected: %lx, got: %lx",
+                out_node_i,true_out_word,computed_output_masked_words[out_node_i]);
+    }
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    free(operands);
+    lp_bitset_release(input_values);
+    free(input_words);
+    if(computed_output)
+        lp_bitset_release(computed_output);
+    free(computed_output_words);
+    free(computed_output_mt_words);
+    free(computed_output_masked_words);
+    if(outputs_mask)
+        lp_bitset_release(outputs_mask);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
 void lp_test_inference_graph_infer_host()
 {
     LP_TEST_RUN(test_inference_graph_infer_host());
+    LP_TEST_RUN(test_inference_graph_infer_host_context());
+    LP_TEST_RUN(test_inference_graph_slots());
+    LP_TEST_RUN(test_inference_graph_infer_host_batch());
+    LP_TEST_RUN(test_inference_graph_infer_host_batch_masked());
+    LP_TEST_RUN(test_inference_graph_engines());
+    LP_TEST_RUN(test_inference_graph_caches());
+    LP_TEST_RUN(test_inference_graph_fuse());
+    LP_TEST_RUN(test_inference_graph_fuse_adder());
+    LP_TEST_RUN(test_inference_graph_infer_host_batch_mt());
+    LP_TEST_RUN(test_inference_graph_order());
+    LP_TEST_RUN(test_inference_graph_create_cone());
+    LP_TEST_RUN(test_inference_graph_output_nodes());
+    LP_TEST_RUN(test_inference_graph_infer_host_jit());
+    LP_TEST_RUN(test_inference_graph_serialize());
+    LP_TEST_RUN(test_inference_graph_infer_host_wide_index());
 }
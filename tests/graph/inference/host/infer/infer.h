@@ -1,6 +1,24 @@
 #ifndef _LOCKPICK_TESTS_GRAPH_INFERENCE_HOST_INFER_H
 #define _LOCKPICK_TESTS_GRAPH_INFERENCE_HOST_INFER_H
 
+#include <lockpick/graph/inference/inference_graph.h>
+
+
+typedef uint64_t *(*__test_inference_engine_cb_t)(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, void *args);
+
+typedef struct __test_inference_engine
+{
+    const char *name;
+    __test_inference_engine_cb_t infer;
+} __test_inference_engine_t;
+
+
+lpg_graph_t *__test_inference_graph_create_mul(size_t in_width, size_t out_width);
+void __test_inference_graph_compare_engines(lpg_inference_graph_t *reference_graph, lpg_inference_graph_t *inference_graph,
+    const __test_inference_engine_t *engines, size_t engines_num, size_t words_num, void *args);
+void __test_inference_graph_compare_engines_mul(size_t in_width, size_t out_width, size_t words_num, lpg_inference_order_t order,
+    const __test_inference_engine_t *engines, size_t engines_num, void *args);
+
 void lp_test_inference_graph_infer_host();
 
 #endif  // _LOCKPICK_TESTS_GRAPH_INFERENCE_HOST_INFER_H
\ No newline at end of file
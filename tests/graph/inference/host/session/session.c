@@ -0,0 +1,89 @@
+#include <lockpick/test.h>
+#include <lockpick/graph/inference/host/session.h>
+#include <lockpick/graph/inference/host/infer.h>
+#include <lockpick/graph/types/uint.h>
+#include <lockpick/bitset.h>
+#include <malloc.h>
+#include <stdlib.h>
+
+#define __LPG_TEST_SESSION_MAX_GRAPH_NODES 100000
+#define __LPG_TEST_SESSION_UPDATES_NUM 32
+#define __LPG_TEST_SESSION_MAX_CHANGED_INPUTS 3
+
+
+void __test_inference_host_session(size_t in_width, size_t out_width)
+{
+    lpg_graph_t *graph = lpg_graph_create("test",in_width,out_width,__LPG_TEST_SESSION_MAX_GRAPH_NODES);
+    size_t operand_width = in_width/2;
+    lpg_uint_t *uint_a = lpg_uint_allocate_as_buffer_view(graph,graph->inputs,operand_width);
+    lpg_uint_t *uint_b = lpg_uint_allocate_as_buffer_view(graph,graph->inputs+operand_width,operand_width);
+    lpg_uint_t *uint_res = lpg_uint_allocate_as_buffer_view(graph,graph->outputs,out_width);
+    lpg_uint_mul(uint_a,uint_b,uint_res);
+
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create(graph,false);
+
+    lp_bitset_t *input_values = lp_bitset_create(graph->inputs_size);
+    for(size_t in_node_i = 0; in_node_i < graph->inputs_size; ++in_node_i)
+        lp_bitset_update(input_values,in_node_i,rand() & 1);
+
+    lpg_inference_host_session_t *session = lpg_inference_host_session_create(inference_graph,input_values);
+    lp_bitset_t *true_output = NULL;
+
+    for(size_t update_i = 0; update_i <= __LPG_TEST_SESSION_UPDATES_NUM; ++update_i)
+    {
+        const lp_bitset_t *session_output = lpg_inference_host_session_output(session);
+        if(update_i > 0)
+        {
+            size_t changed_inputs[__LPG_TEST_SESSION_MAX_CHANGED_INPUTS];
+            size_t changed_inputs_num = 1 + rand() % __LPG_TEST_SESSION_MAX_CHANGED_INPUTS;
+            for(size_t changed_i = 0; changed_i < changed_inputs_num; ++changed_i)
+            {
+                changed_inputs[changed_i] = rand() % graph->inputs_size;
+                lp_bitset_update(input_values,changed_inputs[changed_i],!lp_bitset_test(input_values,changed_inputs[changed_i]));
+            }
+            session_output = lpg_inference_host_session_update(session,changed_inputs,changed_inputs_num);
+        }
+
+        true_output = lpg_inference_graph_infer_host(inference_graph,input_values);
+
+        for(size_t out_node_i = 0; out_node_i < graph->outputs_size; ++out_node_i)
+        {
+            bool session_out_value = lp_bitset_test(session_output,out_node_i);
+            bool true_out_value = lp_bitset_test(true_output,out_node_i);
+
+            LP_TEST_ASSERT(session_out_value == true_out_value,
+                "Output at index %zd after update %zd expected: %d, got: %d. (in_width: %zd, out_width: %zd)",
+                out_node_i,update_i,(uint32_t)true_out_value,(uint32_t)session_out_value,in_width,out_width);
+        }
+
+        lp_bitset_release(true_output);
+        true_output = NULL;
+    }
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_uint_release(uint_a);
+    lpg_uint_release(uint_b);
+    lpg_uint_release(uint_res);
+    lp_bitset_release(input_values);
+    if(true_output)
+        lp_bitset_release(true_output);
+    lpg_inference_host_session_release(session);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+void test_inference_host_session()
+{
+    for(size_t in_width = 2; in_width <= 18; in_width += 2)
+        for(size_t out_width = in_width/2; out_width <= in_width; ++out_width)
+            LP_TEST_STEP_INTO(__test_inference_host_session(in_width,out_width));
+    
+    lp_test_cleanup:
+}
+
+
+void lp_test_inference_host_session()
+{
+    LP_TEST_RUN(test_inference_host_session());
+}
@@ -0,0 +1,6 @@
+#ifndef _LOCKPICK_TESTS_GRAPH_INFERENCE_HOST_SESSION_H
+#define _LOCKPICK_TESTS_GRAPH_INFERENCE_HOST_SESSION_H
+
+void lp_test_inference_host_session();
+
+#endif  // _LOCKPICK_TESTS_GRAPH_INFERENCE_HOST_SESSION_H
@@ -0,0 +1,94 @@
+#include "../../host/infer/infer.h"
+#include <lockpick/test.h>
+#include <lockpick/graph/inference/ocl/infer.h>
+#include <lockpick/graph/inference/host/infer.h>
+#include <lockpick/ocl/ocl.h>
+#include <stdlib.h>
+
+// Not a multiple of typical work-group sizes on purpose
+#define __LPG_TEST_INFER_OCL_WORDS_NUM 67
+
+
+static uint64_t *__test_inference_engine_ocl(lpg_inference_graph_t *inference_graph, const uint64_t *input_values, size_t words_num, void *args)
+{
+    return lpg_inference_graph_infer_ocl((lpg_inference_ocl_session_t*)args,inference_graph,input_values,words_num);
+}
+
+
+void __test_inference_graph_infer_ocl(lpg_inference_ocl_session_t *session, size_t in_width, size_t out_width, size_t words_num)
+{
+    // The second run reuses device-resident graph and batch buffers of the session
+    static const __test_inference_engine_t engines[] = {
+        {"ocl",         __test_inference_engine_ocl},
+        {"ocl resident",__test_inference_engine_ocl}
+    };
+    lpg_graph_t *graph = __test_inference_graph_create_mul(in_width,out_width);
+    lpg_inference_graph_t *inference_graph = lpg_inference_graph_create(graph,false);
+
+    LP_TEST_STEP_INTO(__test_inference_graph_compare_engines(inference_graph,inference_graph,engines,sizeof(engines)/sizeof(engines[0]),words_num,session));
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_inference_ocl_session_evict(session,inference_graph);
+    lpg_inference_graph_release(inference_graph);
+}
+
+
+static void __test_inference_graph_find_first_device(cl_platform_id platform, cl_device_id device, cl_uint index, cl_device_id *first_device)
+{
+    if(!*first_device)
+        *first_device = device;
+}
+
+
+/*
+    Uses device selected by environment if any, otherwise the first available one,
+    so that the kernel is exercised wherever OpenCL runtime is present.
+*/
+static cl_context __test_inference_graph_create_ocl_context()
+{
+    if(getenv(LP_OCL_DEVICE_UUID_ENV_NAME))
+        return lp_ocl_create_context();
+
+    cl_uint platforms_num = 0;
+    if(clGetPlatformIDs(0,NULL,&platforms_num) != CL_SUCCESS || platforms_num == 0)
+        return NULL;
+
+    cl_device_id device = NULL;
+    lp_ocl_traverse_devices(
+        NULL,NULL,
+        (device_cb_t)__test_inference_graph_find_first_device,&device);
+    if(!device)
+        return NULL;
+
+    cl_int errcode;
+    cl_context context = clCreateContext(NULL,1,&device,NULL,NULL,&errcode);
+    return errcode == CL_SUCCESS ? context : NULL;
+}
+
+
+void test_inference_graph_infer_ocl()
+{
+    lpg_inference_ocl_session_t *session = NULL;
+    cl_context context = __test_inference_graph_create_ocl_context();
+    // No OpenCL device available, nothing to check
+    if(!context)
+        return;
+
+    session = lpg_inference_ocl_session_create(context);
+    clReleaseContext(context);
+
+    for(size_t in_width = 2; in_width <= 18; in_width += 2)
+        for(size_t out_width = in_width/2; out_width <= in_width; ++out_width)
+            LP_TEST_STEP_INTO(__test_inference_graph_infer_ocl(session,in_width,out_width,__LPG_TEST_INFER_OCL_WORDS_NUM));
+
+    lp_test_cleanup:
+    if(session)
+        lpg_inference_ocl_session_release(session);
+}
+
+
+void lp_test_inference_graph_infer_ocl()
+{
+    LP_TEST_RUN(test_inference_graph_infer_ocl());
+}
@@ -0,0 +1,6 @@
+#ifndef _LOCKPICK_TESTS_GRAPH_INFERENCE_OCL_INFER_H
+#define _LOCKPICK_TESTS_GRAPH_INFERENCE_OCL_INFER_H
+
+void lp_test_inference_graph_infer_ocl();
+
+#endif  // _LOCKPICK_TESTS_GRAPH_INFERENCE_OCL_INFER_H
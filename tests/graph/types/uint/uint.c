@@ -451,6 +451,214 @@ TEST_GRAPH_UINT_SHIFT_OP(rshift,20,64,10)
 TEST_GRAPH_UINT_SHIFT_OP_INPLACE(rshift,20,64,10)
 
 
+void __test_graph_uint_strash(size_t width)
+{
+    const uint32_t tests_num = 3;
+
+    lpg_graph_t *graph = lpg_graph_create("test",2*width,3*width,__LPG_TEST_UINT_MAX_GRAPH_NODES);
+    lpg_graph_enable_strash(graph);
+    char *original_hex_str = (char*)malloc(MAX_HEXES_NUM+1);
+    char *converted_hex_str = (char*)malloc(MAX_HEXES_NUM+1);
+    lpg_uint_t *graph_a = lpg_uint_allocate_as_buffer_view(graph,graph->inputs,width);
+    lpg_uint_t *graph_b = lpg_uint_allocate_as_buffer_view(graph,graph->inputs+width,width);
+    lpg_uint_t *graph_res_and = lpg_uint_allocate_as_buffer_view(graph,graph->outputs,width);
+    lpg_uint_t *graph_res_dup = lpg_uint_allocate_as_buffer_view(graph,graph->outputs+width,width);
+    lpg_uint_t *graph_res_obt = lpg_uint_allocate_as_buffer_view(graph,graph->outputs+2*width,width);
+    lpg_uint_and(graph_a,graph_b,graph_res_and);
+    lpg_uint_and(graph_b,graph_a,graph_res_dup);
+    lpg_uint_mul(graph_a,graph_b,graph_res_obt);
+
+    // Operands of binary nodes are unordered, so the second conjunction must reuse nodes of the first one
+    for(size_t node_i = 0; node_i < width; ++node_i)
+        LP_TEST_ASSERT(graph->outputs[node_i] == graph->outputs[width+node_i],
+            "width: %zd; Output %zd is duplicated",width,node_i);
+
+    size_t dangling_nodes = lpg_graph_count_dangling_nodes(graph);
+    LP_TEST_ASSERT(dangling_nodes == 0,
+        "width: %zd; Found %zd dangling nodes after full graph assembly",width,dangling_nodes);
+
+    for(uint32_t test_i = 0; test_i < tests_num; ++test_i)
+    {
+        LP_TEST_STEP_INTO(
+            __test_graph_uint_gen_and_test_mul_plain(
+                graph,graph_a,graph_b,graph_res_obt,
+                original_hex_str,converted_hex_str)
+        );
+    }
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_uint_release(graph_a);
+    lpg_uint_release(graph_b);
+    lpg_uint_release(graph_res_and);
+    lpg_uint_release(graph_res_dup);
+    lpg_uint_release(graph_res_obt);
+    free(original_hex_str);
+    free(converted_hex_str);
+}
+
+
+void test_graph_uint_strash()
+{
+    for(size_t width = 1; width <= 16; ++width)
+    {
+        LP_TEST_STEP_INTO(__test_graph_uint_strash(width));
+    }
+    LP_TEST_STEP_INTO(__test_graph_uint_strash(32));
+    lp_test_cleanup:
+}
+
+
+void __test_graph_uint_strash_shared_carry(size_t width)
+{
+    const uint32_t tests_num = 3;
+
+    lpg_graph_t *graph = lpg_graph_create("test",2*width,2*width,__LPG_TEST_UINT_MAX_GRAPH_NODES);
+    lpg_graph_enable_strash(graph);
+    char *original_hex_str = (char*)malloc(MAX_HEXES_NUM+1);
+    char *converted_hex_str = (char*)malloc(MAX_HEXES_NUM+1);
+    lpg_uint_t *graph_a = lpg_uint_allocate_as_buffer_view(graph,graph->inputs,width);
+    lpg_uint_t *graph_b = lpg_uint_allocate_as_buffer_view(graph,graph->inputs+width,width);
+    lpg_uint_t *graph_conj = lpg_uint_allocate(graph,width);
+    lpg_uint_t *graph_res_obt = lpg_uint_allocate_as_buffer_view(graph,graph->outputs,width);
+    lpg_uint_t *graph_res_conj = lpg_uint_allocate_as_buffer_view(graph,graph->outputs+width,width);
+
+    // Intermediate conjunction is not an output yet, so nothing but the sum keeps it alive
+    lpg_uint_and(graph_a,graph_b,graph_conj);
+    lpg_uint_add(graph_a,graph_b,graph_res_obt);
+
+    // Lookup does not assemble nodes, so a released node could not be replaced by a new one in its slot
+    lpg_node_t **conj_nodes = lpg_uint_nodes(graph_conj);
+    for(size_t node_i = 0; node_i < width; ++node_i)
+        LP_TEST_ASSERT(__lpg_graph_strash_find(graph,LPG_NODE_TYPE_AND,graph->inputs[node_i],graph->inputs[width+node_i]) == conj_nodes[node_i],
+            "width: %zd; Bit %zd of intermediate conjunction was released by addition",width,node_i);
+
+    lpg_uint_copy(graph_res_conj,graph_conj);
+
+    size_t dangling_nodes = lpg_graph_count_dangling_nodes(graph);
+    LP_TEST_ASSERT(dangling_nodes == 0,
+        "width: %zd; Found %zd dangling nodes after full graph assembly",width,dangling_nodes);
+
+    for(uint32_t test_i = 0; test_i < tests_num; ++test_i)
+    {
+        LP_TEST_STEP_INTO(
+            __test_graph_uint_gen_and_test_add_plain(
+                graph,graph_a,graph_b,graph_res_obt,
+                original_hex_str,converted_hex_str)
+        );
+    }
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_uint_release(graph_a);
+    lpg_uint_release(graph_b);
+    lpg_uint_release(graph_conj);
+    lpg_uint_release(graph_res_obt);
+    lpg_uint_release(graph_res_conj);
+    free(original_hex_str);
+    free(converted_hex_str);
+}
+
+
+void test_graph_uint_strash_shared_carry()
+{
+    for(size_t width = 1; width <= 16; ++width)
+    {
+        LP_TEST_STEP_INTO(__test_graph_uint_strash_shared_carry(width));
+    }
+    lp_test_cleanup:
+}
+
+
+void __test_graph_uint_fold(size_t width)
+{
+    lpg_graph_t *graph = lpg_graph_create("test",width,4*width,__LPG_TEST_UINT_MAX_GRAPH_NODES);
+    lpg_node_t *zero_node = lpg_node_literal(graph,false);
+    lpg_uint_t *graph_a = lpg_uint_allocate_as_buffer_view(graph,graph->inputs,width);
+    lpg_uint_t *graph_zero = lpg_uint_allocate(graph,width);
+    lpg_uint_update_fill_with_single(graph_zero,zero_node);
+    lpg_uint_t *graph_res_and = lpg_uint_allocate_as_buffer_view(graph,graph->outputs,width);
+    lpg_uint_t *graph_res_or = lpg_uint_allocate_as_buffer_view(graph,graph->outputs+width,width);
+    lpg_uint_t *graph_res_xor = lpg_uint_allocate_as_buffer_view(graph,graph->outputs+2*width,width);
+    lpg_uint_t *graph_res_mul = lpg_uint_allocate_as_buffer_view(graph,graph->outputs+3*width,width);
+    lpg_uint_and(graph_a,graph_zero,graph_res_and);
+    lpg_uint_or(graph_a,graph_zero,graph_res_or);
+    lpg_uint_xor(graph_a,graph_a,graph_res_xor);
+
+    for(size_t node_i = 0; node_i < width; ++node_i)
+    {
+        LP_TEST_ASSERT(graph->outputs[node_i] == zero_node,"width: %zd; Bit %zd of 'a&0' is not folded",width,node_i);
+        LP_TEST_ASSERT(graph->outputs[width+node_i] == graph->inputs[node_i],"width: %zd; Bit %zd of 'a|0' is not folded",width,node_i);
+        LP_TEST_ASSERT(graph->outputs[2*width+node_i] == zero_node,"width: %zd; Bit %zd of 'a^a' is not folded",width,node_i);
+    }
+
+    // Nothing but inputs and the literal may be allocated
+    lp_slab_t *slab = __lpg_graph_slab(graph);
+    size_t nodes_num = slab->__total_entries-slab->__total_free;
+    LP_TEST_ASSERT(nodes_num == width+1,"width: %zd; Expected %zd nodes, got: %zd",width,width+1,nodes_num);
+
+    // Operand of false literals has no significant bits, so the product is folded before any gate is assembled
+    lpg_uint_mul(graph_a,graph_zero,graph_res_mul);
+    for(size_t node_i = 0; node_i < width; ++node_i)
+        LP_TEST_ASSERT(graph->outputs[3*width+node_i] == zero_node,"width: %zd; Bit %zd of 'a*0' is not folded",width,node_i);
+
+    nodes_num = slab->__total_entries-slab->__total_free;
+    LP_TEST_ASSERT(nodes_num == width+1,"width: %zd; Expected %zd nodes after 'a*0', got: %zd",width,width+1,nodes_num);
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_uint_release(graph_a);
+    lpg_uint_release(graph_zero);
+    lpg_uint_release(graph_res_and);
+    lpg_uint_release(graph_res_or);
+    lpg_uint_release(graph_res_xor);
+    lpg_uint_release(graph_res_mul);
+}
+
+
+void test_graph_uint_fold()
+{
+    for(size_t width = 1; width <= 32; ++width)
+    {
+        LP_TEST_STEP_INTO(__test_graph_uint_fold(width));
+    }
+    lp_test_cleanup:
+}
+
+
+void __test_graph_uint_copy_padding(size_t width)
+{
+    lpg_graph_t *graph = lpg_graph_create("test",width,width,__LPG_TEST_UINT_MAX_GRAPH_NODES);
+    lpg_node_t *zero_node = lpg_node_literal(graph,false);
+    lpg_uint_t *graph_a = lpg_uint_allocate_as_buffer_view(graph,graph->inputs,width);
+    lpg_uint_t *graph_wide = lpg_uint_allocate(graph,2*width);
+    lpg_uint_copy(graph_wide,graph_a);
+
+    // Padding of a copy may be assigned, which must not affect gates folded against the literal
+    lpg_node_t **wide_nodes = lpg_uint_nodes(graph_wide);
+    for(size_t node_i = width; node_i < 2*width; ++node_i)
+        LP_TEST_ASSERT(wide_nodes[node_i] != zero_node,"width: %zd; Padding bit %zd of copy is the literal",width,node_i);
+
+    lpg_uint_assign_from_hex_str(graph_wide,"ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    LP_TEST_ASSERT(!lpg_node_value(zero_node),"width: %zd; Value of false literal was changed",width);
+
+    lp_test_cleanup:
+    lpg_graph_release(graph);
+    lpg_uint_release(graph_a);
+    lpg_uint_release(graph_wide);
+}
+
+
+void test_graph_uint_copy_padding()
+{
+    for(size_t width = 1; width <= 32; ++width)
+    {
+        LP_TEST_STEP_INTO(__test_graph_uint_copy_padding(width));
+    }
+    lp_test_cleanup:
+}
+
+
 void test_graph_uint_hex_str()
 {
     for(size_t width = 1; width <= 64; ++width)
@@ -489,4 +697,9 @@ void lp_test_graph_uint()
 
     LP_TEST_RUN(test_graph_uint_rshift());
     LP_TEST_RUN(test_graph_uint_rshift_inplace());
+
+    LP_TEST_RUN(test_graph_uint_strash());
+    LP_TEST_RUN(test_graph_uint_strash_shared_carry());
+    LP_TEST_RUN(test_graph_uint_fold());
+    LP_TEST_RUN(test_graph_uint_copy_padding());
 }
\ No newline at end of file
@@ -14,7 +14,11 @@
 #include "graph/types/uint/uint.h"
 #include "graph/graph/tsort/tsort.h"
 #include "graph/graph/properties/count/count.h"
+#include "graph/graph/optimize/optimize.h"
+#include "graph/graph/frozen/frozen.h"
 #include "graph/inference/host/infer/infer.h"
+#include "graph/inference/host/session/session.h"
+#include "graph/inference/ocl/infer/infer.h"
 #include <lockpick/test.h>
 #include <lockpick/lockpick.h>
 #include <lockpick/logger.h>
@@ -41,6 +45,10 @@ int main()
     //LP_TEST_RUN(lp_test_graph_uint(),1);
     //LP_TEST_RUN(lp_test_graph_tsort(),1);
     //LP_TEST_RUN(lp_test_graph_count(),1);
+    //LP_TEST_RUN(lp_test_graph_optimize(),1);
+    //LP_TEST_RUN(lp_test_graph_frozen(),1);
     //LP_TEST_RUN(lp_test_inference_graph_infer_host(),1);
+    //LP_TEST_RUN(lp_test_inference_host_session(),1);
+    //LP_TEST_RUN(lp_test_inference_graph_infer_ocl(),1);
     LP_TEST_END();
 }
\ No newline at end of file